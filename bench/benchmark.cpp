@@ -0,0 +1,1238 @@
+#include "game.hpp"
+#include "board.hpp"
+#include "snake.hpp"
+#include "game_stepper.hpp"
+#include "direction.hpp"
+#include "batch_stepper.hpp"
+#include "observation.hpp"
+#include "simd.hpp"
+#include "snake_capi.h"
+#include "startup_timer.hpp"
+#include "score_journal.hpp"
+#include "score_record.hpp"
+#include "score_analytics.hpp"
+#include "allocation_counter.hpp"
+#include "game_session.hpp"
+#include "session_host.hpp"
+#include "pcg32.hpp"
+#include "reachability.hpp"
+#include "policy.hpp"
+#include "score_page_cache.hpp"
+#include "io_worker.hpp"
+#include "rewind_buffer.hpp"
+#include "env_server.hpp"
+#include "env_client.hpp"
+#include "heatmap.hpp"
+#include "distance_field.hpp"
+#include "replay_archive.hpp"
+#include "leaderboard_index.hpp"
+#include "small_board_solver.hpp"
+#include "transposition_table.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+/**
+ * @brief Picks a serpentine path from the bottom row upward, it never revisits a cell so the game only ends at the top wall
+ *
+ * @param game The game to pick a move for
+ * @return Directions::Direction
+ */
+static Directions::Direction serpentineDirection(const Game &game)
+{
+    const Point &head{game.getSnake().getHead()};
+    const bool movingRight{(game.getBoard().getHeight() - head.y) % 2 == 0};
+    if (movingRight)
+        return head.x == game.getBoard().getWidth() ? Directions::Direction::UP : Directions::Direction::RIGHT;
+    return head.x == 0 ? Directions::Direction::UP : Directions::Direction::LEFT;
+}
+
+/**
+ * @brief Measures the average time of a game step
+ *
+ * @param width The board width
+ * @param height The board height
+ * @param makeStepper Creates the stepper to measure
+ * @param totalSteps The number of steps to measure
+ * @return double Nanoseconds per step
+ */
+static double measureSteps(int width, int height, const function<unique_ptr<GameStepper>(Game &)> &makeStepper, int64_t totalSteps)
+{
+    Clock::duration elapsed{};
+    int64_t steps{0};
+    while (steps < totalSteps)
+    {
+        // Games are created outside of the measured time
+        Game game(make_unique<Board>(width, height), make_unique<Snake>(Point(5, height), 5));
+        auto stepper{makeStepper(game)};
+
+        const auto start{Clock::now()};
+        while (!game.isGameOver() && steps < totalSteps)
+        {
+            stepper->step(serpentineDirection(game));
+            ++steps;
+        }
+        elapsed += Clock::now() - start;
+    }
+    return chrono::duration<double, nano>(elapsed).count() / static_cast<double>(steps);
+}
+
+/**
+ * @brief Compares the specialized board geometry with the generic one
+ *
+ */
+static void benchmarkBoardGeometry()
+{
+    constexpr int64_t STEPS{2'000'000};
+    const int sizes[][2]{{30, 20}, {50, 30}, {80, 40}};
+    cout << "Board geometry (ns per step)\n";
+    for (const auto &size : sizes)
+    {
+        const double specialized{measureSteps(size[0], size[1], makeGameStepper, STEPS)};
+        const double generic{measureSteps(size[0], size[1], makeGenericGameStepper, STEPS)};
+        cout << "  " << size[0] << 'x' << size[1] << " dispatched " << specialized << " generic " << generic << '\n';
+    }
+}
+
+/**
+ * @brief Compares batched stepping with stepping each game through Snake
+ *
+ */
+static void benchmarkBatchStepping()
+{
+    constexpr int GAMES{1024};
+    constexpr int STEPS{2'000};
+    constexpr int WIDTH{30};
+    constexpr int HEIGHT{20};
+
+    // The scalar path steps every game through its own Snake
+    const double scalar{measureSteps(WIDTH, HEIGHT, makeGameStepper, static_cast<int64_t>(GAMES) * 200)};
+    cout << "Batch stepping " << GAMES << " games " << WIDTH << 'x' << HEIGHT << " (ns per game step)\n";
+    cout << "  Snake per game " << scalar << '\n';
+
+    const SimdLevel best{detectSimdLevel()};
+    vector<SimdLevel> levels{SimdLevel::SCALAR};
+#if SNAKE_HAS_X86_KERNELS
+    levels.push_back(SimdLevel::SSE2);
+    if (best == SimdLevel::AVX2)
+        levels.push_back(SimdLevel::AVX2);
+#endif
+    for (const auto level : levels)
+    {
+        BatchStepper batch(GAMES, WIDTH, HEIGHT, 5);
+        batch.setSimdLevel(level);
+        vector<Directions::Direction> moves(GAMES);
+        const auto start{Clock::now()};
+        for (int step{0}; step < STEPS; ++step)
+        {
+            for (int game{0}; game < GAMES; ++game)
+            {
+                const int x{batch.getHeadX(game)};
+                const bool movingRight{(HEIGHT - batch.getHeadY(game)) % 2 == 0};
+                if (movingRight)
+                    moves[game] = x == WIDTH ? Directions::Direction::UP : Directions::Direction::RIGHT;
+                else
+                    moves[game] = x == 0 ? Directions::Direction::UP : Directions::Direction::LEFT;
+            }
+            batch.step(moves.data());
+        }
+        const double elapsed{chrono::duration<double, nano>(Clock::now() - start).count()};
+        cout << "  batch " << getSimdLevelName(level) << ' ' << elapsed / (static_cast<double>(GAMES) * STEPS) << '\n';
+    }
+}
+
+/**
+ * @brief Measures the cost of calling the game through the shared library's C interface
+ *
+ */
+static void benchmarkCApi()
+{
+    constexpr int64_t CALLS{20'000'000};
+    constexpr int GAMES{20'000};
+    cout << "C interface (ns per call)\n";
+
+    // A trivial call shows the cost of crossing the boundary
+    snake_game *handle{snake_create(30, 20, 5, 1)};
+    volatile int sink{0};
+    auto start{Clock::now()};
+    for (int64_t call{0}; call < CALLS; ++call)
+        sink = snake_get_score(handle);
+    cout << "  get score " << chrono::duration<double, nano>(Clock::now() - start).count() / CALLS << '\n';
+
+    // The same games stepped through the boundary and directly, each game runs right until it hits the wall
+    int64_t steps{0};
+    start = Clock::now();
+    for (int seed{0}; seed < GAMES; ++seed)
+    {
+        snake_reset(handle, static_cast<uint32_t>(seed));
+        while (!snake_is_over(handle))
+        {
+            snake_step(handle, SNAKE_RIGHT);
+            ++steps;
+        }
+    }
+    const double viaC{chrono::duration<double, nano>(Clock::now() - start).count() / static_cast<double>(steps)};
+    snake_destroy(handle);
+
+    start = Clock::now();
+    for (int seed{0}; seed < GAMES; ++seed)
+    {
+        Game game(make_unique<Board>(30, 20), make_unique<Snake>(Point(5, 20), 5), 200.0, "Captain", static_cast<uint32_t>(seed));
+        auto stepper{makeGameStepper(game)};
+        while (!game.isGameOver())
+            stepper->step(Directions::Direction::RIGHT);
+    }
+    const double direct{chrono::duration<double, nano>(Clock::now() - start).count() / static_cast<double>(steps)};
+    cout << "  reset and step c " << viaC << " direct " << direct << '\n';
+}
+
+/**
+ * @brief The work a headless process does before its first step and first frame, run in a fresh process
+ *
+ */
+static void runStartupChild()
+{
+    Game game(make_unique<Board>(30, 20), make_unique<Snake>(Point(5, 20), 5));
+    auto stepper{makeGameStepper(game)};
+    stepper->step(Directions::Direction::UP);
+    StartupTimer::mark(StartupTimer::Milestone::FIRST_STEP);
+    volatile size_t sink{game.toString().size()};
+    StartupTimer::mark(StartupTimer::Milestone::FIRST_FRAME);
+    (void)sink;
+    cout << StartupTimer::getMilliseconds(StartupTimer::Milestone::FIRST_STEP) << ' '
+         << StartupTimer::getMilliseconds(StartupTimer::Milestone::FIRST_FRAME) << '\n';
+}
+
+/**
+ * @brief Measures the time from process startup to the first step and first frame over many fresh processes
+ *
+ */
+static void benchmarkStartup(const char *program)
+{
+    constexpr int PROCESSES{50};
+    cout << "Startup (ms, mean of " << PROCESSES << " processes)\n";
+
+    double firstStep{0};
+    double firstFrame{0};
+    int measured{0};
+    const string command{string("\"") + program + "\" startup-child"};
+    for (int process{0}; process < PROCESSES; ++process)
+    {
+#if defined(_WIN32)
+        FILE *child{_popen(command.c_str(), "r")};
+#else
+        FILE *child{popen(command.c_str(), "r")};
+#endif
+        if (!child)
+            break;
+        double step;
+        double frame;
+        if (fscanf(child, "%lf %lf", &step, &frame) == 2)
+        {
+            firstStep += step;
+            firstFrame += frame;
+            ++measured;
+        }
+#if defined(_WIN32)
+        _pclose(child);
+#else
+        pclose(child);
+#endif
+    }
+
+    if (measured == 0)
+    {
+        cout << "  could not run " << command << '\n';
+        return;
+    }
+    cout << "  first step " << firstStep / measured << " first frame " << firstFrame / measured << '\n';
+}
+
+/**
+ * @brief Measures score inserts from many processes with many threads each, then checks the journal
+ *
+ */
+static void benchmarkScoreJournal()
+{
+#if defined(_WIN32)
+    cout << "Score journal benchmark needs fork\n";
+#else
+    constexpr int PROCESSES{8};
+    constexpr int THREADS{4};
+    constexpr int RECORDS{5'000};
+    cout << "Score journal (inserts per second, " << PROCESSES << " processes of " << THREADS << " threads)\n";
+
+    const string path{(filesystem::temp_directory_path() / "snake_bench_scores.dat").string()};
+    const pair<const char *, ScoreJournal::SyncPolicy> policies[]{{"never", ScoreJournal::SyncPolicy::NEVER},
+                                                                  {"interval", ScoreJournal::SyncPolicy::INTERVAL},
+                                                                  {"every commit", ScoreJournal::SyncPolicy::EVERY_COMMIT}};
+    for (const auto &[name, policy] : policies)
+    {
+        filesystem::remove(path);
+        const auto start{Clock::now()};
+        for (int process{0}; process < PROCESSES; ++process)
+        {
+            if (fork() != 0)
+                continue;
+
+            // Each child appends its records from every thread and exits
+            ScoreJournal journal(path, {policy, chrono::milliseconds(50)});
+            vector<thread> threads;
+            for (int thread{0}; thread < THREADS; ++thread)
+                threads.emplace_back([&journal, process, thread]
+                                     {
+                                         ScoreRecord record{"player-" + to_string(process) + '-' + to_string(thread), 30, 20, 200.0, 5, 0, 1};
+                                         for (int index{0}; index < RECORDS; ++index)
+                                         {
+                                             record.score = index;
+                                             journal.append(record);
+                                         } });
+            for (auto &thread : threads)
+                thread.join();
+            _exit(0);
+        }
+        while (wait(nullptr) > 0)
+            ;
+        const double seconds{chrono::duration<double>(Clock::now() - start).count()};
+
+        const auto counts{ScoreJournal::read(path, [](const ScoreRecord &)
+                                             { return true; })};
+        cout << "  " << name << ' ' << static_cast<int64_t>(PROCESSES * THREADS * RECORDS / seconds) << " records " << counts.framed
+             << " malformed " << counts.malformed << '\n';
+    }
+    filesystem::remove(path);
+#endif
+}
+
+/**
+ * @brief Measures leaderboard queries over a generated score file
+ *
+ */
+static void benchmarkScoreAnalytics()
+{
+    constexpr int ROWS{5'000'000};
+    constexpr int PLAYERS{100'000};
+    cout << "Score analytics (" << ROWS << " rows)\n";
+
+    // Scores spread over a few board settings, players and days
+    const string path{(filesystem::temp_directory_path() / "snake_bench_analytics.dat").string()};
+    {
+        ofstream file(path, ofstream::binary | ofstream::trunc);
+        minstd_rand random{1};
+        const int sizes[][2]{{30, 20}, {50, 30}, {20, 20}};
+        for (int row{0}; row < ROWS; ++row)
+        {
+            const auto &size{sizes[random() % 3]};
+            const ScoreRecord record{"player" + to_string(random() % PLAYERS), size[0], size[1], 100.0 + 50 * (random() % 3), 5, static_cast<int>(random() % 100) * 10,
+                                     1'600'000'000 + static_cast<int64_t>(random() % (365 * 86400))};
+            file << encodeScoreLine(record);
+        }
+    }
+
+    for (const bool verifyChecksums : {true, false})
+    {
+        ScoreQuery query;
+        query.verifyChecksums = verifyChecksums;
+        const auto start{Clock::now()};
+        const ScoreReport report{ScoreAnalytics::analyze(path, query)};
+        const double seconds{chrono::duration<double>(Clock::now() - start).count()};
+        cout << "  " << (verifyChecksums ? "checksums " : "no checksums ") << seconds << "s " << static_cast<int64_t>(ROWS / seconds) << " rows/s, "
+             << report.buckets.size() << " buckets " << report.playerBests.size() << " players\n";
+    }
+    filesystem::remove(path);
+}
+
+/**
+ * @brief Measures ranking a live score by rescanning the score file against the leaderboard index
+ *
+ */
+static void benchmarkLeaderboard()
+{
+    constexpr int ROWS{1'000'000};
+    constexpr int QUERIES{1'000'000};
+    cout << "Leaderboard (" << ROWS << " rows)\n";
+
+    const string path{(filesystem::temp_directory_path() / "snake_bench_leaderboard.dat").string()};
+    {
+        ofstream file(path, ofstream::binary | ofstream::trunc);
+        minstd_rand random{1};
+        const int sizes[][2]{{30, 20}, {50, 30}, {20, 20}};
+        for (int row{0}; row < ROWS; ++row)
+        {
+            const auto &size{sizes[random() % 3]};
+            file << encodeScoreLine(ScoreRecord{"player", size[0], size[1], 100.0 + 50 * (random() % 3), 5, static_cast<int>(random() % 600) * 10, 1});
+        }
+    }
+
+    // A rescan is what ranking by reading the file would cost on every apple
+    auto start{Clock::now()};
+    size_t above{0};
+    ScoreJournal::read(path, [&above](const ScoreRecord &record)
+                       {
+                           above += record.width == 30 && record.height == 20 && record.gameSpeed == 150.0 && record.score > 2000;
+                           return true; });
+    const double rescanMilliseconds{chrono::duration<double, milli>(Clock::now() - start).count()};
+
+    LeaderboardIndex leaderboard;
+    start = Clock::now();
+    leaderboard.load(path);
+    const double loadMilliseconds{chrono::duration<double, milli>(Clock::now() - start).count()};
+
+    minstd_rand random{2};
+    size_t rankSum{0};
+    start = Clock::now();
+    for (int query{0}; query < QUERIES; ++query)
+        rankSum += leaderboard.getRank(LeaderboardConfiguration{30, 20, 150.0}, static_cast<int>(random() % 6000)).rank;
+    const double rankNanoseconds{chrono::duration<double, nano>(Clock::now() - start).count() / QUERIES};
+
+    start = Clock::now();
+    for (int query{0}; query < QUERIES; ++query)
+        leaderboard.add(ScoreRecord{"player", 30, 20, 150.0, 5, static_cast<int>(random() % 6000), 1});
+    const double addNanoseconds{chrono::duration<double, nano>(Clock::now() - start).count() / QUERIES};
+
+    cout << "  rescan " << rescanMilliseconds << "ms (" << above << " above), load " << loadMilliseconds << "ms\n";
+    cout << "  rank " << rankNanoseconds << "ns (rank sum " << rankSum << "), add " << addNanoseconds << "ns\n";
+    filesystem::remove(path);
+}
+
+/**
+ * @brief Measures flipping through score pages by reparsing the file against cached and prefetched pages
+ *
+ */
+static void benchmarkScorePages()
+{
+    constexpr int ROWS{200'000};
+    constexpr int PAGE_SIZE{5};
+    constexpr int FLIPS{200};
+    cout << "Score pages (" << ROWS << " rows, us per page flip)\n";
+
+    const string path{(filesystem::temp_directory_path() / "snake_bench_pages.dat").string()};
+    {
+        ofstream file(path, ofstream::binary | ofstream::trunc);
+        for (int row{0}; row < ROWS; ++row)
+            file << encodeScoreLine(ScoreRecord{"player" + to_string(row), 30, 20, 200.0, 5, row, 1'600'000'000});
+    }
+
+    // Flipping forward from the middle of the file, every page is new
+    const int firstPage{ROWS / PAGE_SIZE / 2};
+    const auto measureFlips = [&](const function<void(int)> &flip)
+    {
+        const auto start{Clock::now()};
+        for (int page{firstPage}; page < firstPage + FLIPS; ++page)
+            flip(page);
+        return chrono::duration<double, micro>(Clock::now() - start).count() / FLIPS;
+    };
+
+    // Reparse every page like the scores menu used to
+    const double reparsed{measureFlips([&](int page)
+                                       {
+                                           ScorePageCache uncached(path);
+                                           uncached.getPage(page, PAGE_SIZE); })};
+
+    // Parse the next page on the worker while the current one is shown, only showing the page is timed
+    ScorePageCache cache(path);
+    IoWorker worker;
+    cache.getPage(firstPage, PAGE_SIZE);
+    double prefetched{0};
+    for (int page{firstPage}; page < firstPage + FLIPS; ++page)
+    {
+        const auto start{Clock::now()};
+        cache.getPage(page, PAGE_SIZE);
+        prefetched += chrono::duration<double, micro>(Clock::now() - start).count() / FLIPS;
+        worker.submit([&cache, page]
+                      { cache.getPage(page + 1, PAGE_SIZE); })
+            .wait();
+    }
+
+    // Flip back through pages that are still cached
+    const double cached{measureFlips([&](int page)
+                                     { cache.getPage(firstPage + FLIPS - 1 - (page - firstPage) % 8, PAGE_SIZE); })};
+    cout << "  reparse " << reparsed << " prefetched " << prefetched << " cached " << cached << " (" << cache.getHitCount() << " hits " << cache.getMissCount() << " misses)\n";
+    filesystem::remove(path);
+}
+
+/**
+ * @brief Counts the heap allocations of steady state ticks at several board sizes
+ *
+ * @note A tick steps the game, records its move, sets the message for the outcome and builds and copies the frame,
+ * like the logic and render tasks do. The first ticks of each game warm up the storage and aren't counted. A last
+ * game circles without eating for longer than a board has cells, so the recorded moves outgrow the board.
+ * @return true if no tick allocated
+ */
+static bool benchmarkAllocations()
+{
+    constexpr int GAMES{4};
+    constexpr int WARM_UP_TICKS{100};
+    const int sizes[][2]{{10, 10}, {30, 20}, {50, 30}, {80, 40}, {200, 100}};
+    bool passed{true};
+    cout << "Allocations per tick\n";
+    for (const auto &size : sizes)
+    {
+        uint64_t ticks{0};
+        uint64_t allocations{0};
+        for (int round{0}; round < GAMES; ++round)
+        {
+            // Games are created and reserved outside of the counted ticks
+            Game game(make_unique<Board>(size[0], size[1]), make_unique<Snake>(Point(5, size[1]), 5), 200.0, "Captain", static_cast<uint32_t>(round));
+            game.reserve();
+            auto stepper{makeGameStepper(game)};
+            string frame;
+            frame.reserve(game.toString().capacity());
+            Replay replay;
+            startReplay(game, replay);
+            replay.reserveMoves();
+
+            int tick{0};
+            uint64_t before{AllocationCounter::getThreadCount()};
+            while (!game.isGameOver())
+            {
+                if (tick++ == WARM_UP_TICKS)
+                    before = AllocationCounter::getThreadCount();
+                const Directions::Direction direction{serpentineDirection(game)};
+                const StepOutcome outcome{stepper->step(direction)};
+                replay.addMove(direction);
+                switch (outcome)
+                {
+                case StepOutcome::ATE:
+                    game.setMessage("YUM!!!");
+                    replay.reserveMoves();
+                    break;
+                case StepOutcome::HIT_SELF:
+                    game.setMessage("GAMEOVER!\n\nYou ate your tail!");
+                    break;
+                case StepOutcome::HIT_WALL:
+                    game.setMessage("GAMEOVER!\n\nYou hit the wall!");
+                    break;
+                case StepOutcome::MOVED:
+                    game.setMessage("");
+                    break;
+                }
+                frame.assign(game.toString());
+            }
+            if (tick > WARM_UP_TICKS)
+            {
+                allocations += AllocationCounter::getThreadCount() - before;
+                ticks += tick - WARM_UP_TICKS;
+            }
+        }
+        cout << "  " << size[0] << 'x' << size[1] << ' ' << static_cast<double>(allocations) / static_cast<double>(max<uint64_t>(ticks, 1)) << " (" << allocations << " in " << ticks << " ticks)\n";
+        passed = passed && allocations == 0;
+    }
+
+    // Circle a small board's corner with the apple out of the way, recording every move
+    constexpr int CIRCLING_TICKS{30000};
+    const Directions::Direction loop[]{Directions::Direction::UP, Directions::Direction::LEFT, Directions::Direction::LEFT, Directions::Direction::LEFT,
+                                       Directions::Direction::DOWN, Directions::Direction::RIGHT, Directions::Direction::RIGHT, Directions::Direction::RIGHT};
+    Game game(make_unique<Board>(10, 10), make_unique<Snake>(Point(5, 10), 5));
+    game.setApple(Point{10, 0});
+    game.reserve();
+    auto stepper{makeGameStepper(game)};
+    Replay replay;
+    startReplay(game, replay);
+    replay.reserveMoves();
+    const uint64_t before{AllocationCounter::getThreadCount()};
+    int tick{0};
+    for (; tick < CIRCLING_TICKS && stepper->step(loop[tick % 8]) == StepOutcome::MOVED; ++tick)
+        replay.addMove(loop[tick % 8]);
+    const uint64_t allocations{AllocationCounter::getThreadCount() - before};
+    cout << "  10x10 circling " << static_cast<double>(allocations) / CIRCLING_TICKS << " (" << allocations << " in " << tick << " ticks)\n";
+    return passed && tick == CIRCLING_TICKS && allocations == 0;
+}
+
+/**
+ * @brief Keeps no scores, sessions in the benchmark never save
+ *
+ */
+class DiscardedSessionScores : public SessionScores
+{
+public:
+    future<void> saveScore(Game &) override
+    {
+        promise<void> saved;
+        saved.set_value();
+        return saved.get_future();
+    }
+    string getScorePage(int) override { return "No saved scores"; }
+};
+
+/**
+ * @brief Measures how late session timers run with many players connected to one host
+ *
+ * @note Every player starts a 100x20 game at the fast speed and keeps going right, so each session steps every
+ * 67 milliseconds and sends a frame after each step. The clients read every frame.
+ */
+static void benchmarkSessions()
+{
+#if !defined(_WIN32)
+    constexpr int SESSIONS{1000};
+    constexpr auto DURATION{chrono::seconds(5)};
+
+    // Each player needs a descriptor in the host and one in the benchmark
+    rlimit limit{};
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    getrlimit(RLIMIT_NOFILE, &limit);
+    const int sessionCount{static_cast<int>(min<rlim_t>(SESSIONS, (limit.rlim_cur - 64) / 2))};
+
+    const string path{(filesystem::temp_directory_path() / ("snake_bench_" + to_string(getpid()) + ".sock")).string()};
+    DiscardedSessionScores scores;
+    SessionHost host(SessionHostOptions{path}, scores);
+    thread reactor([&host]
+                   { host.run(); });
+
+    // Connect the players and start their games
+    vector<pollfd> clients;
+    for (int index{0}; index < sessionCount; ++index)
+    {
+        const int descriptor{socket(AF_UNIX, SOCK_STREAM, 0)};
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+        if (connect(descriptor, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            close(descriptor);
+            break;
+        }
+        constexpr string_view START{"\r100\r20\r1\r3\rd"};
+        [[maybe_unused]] const auto written{write(descriptor, START.data(), START.size())};
+        clients.push_back(pollfd{descriptor, POLLIN, 0});
+    }
+
+    // Read every frame until the time is up
+    uint64_t bytesRead{0};
+    char buffer[64 * 1024];
+    const auto end{Clock::now() + DURATION};
+    while (Clock::now() < end)
+    {
+        // Read in batches so the players cost the host as little of the machine as possible
+        this_thread::sleep_for(chrono::milliseconds(5));
+        if (poll(clients.data(), static_cast<nfds_t>(clients.size()), 10) <= 0)
+            continue;
+        for (auto &client : clients)
+            if (client.revents & POLLIN)
+                bytesRead += static_cast<uint64_t>(max<ssize_t>(read(client.fd, buffer, sizeof(buffer)), 0));
+    }
+
+    const size_t connected{host.getSessionCount()};
+    host.requestStop();
+    reactor.join();
+    for (const auto &client : clients)
+        close(client.fd);
+
+    const TickJitter jitter{host.getTickJitter()};
+    const double seconds{chrono::duration<double>(DURATION).count()};
+    cout << "Sessions " << connected << " players on " << thread::hardware_concurrency() << " cores for " << seconds << "s\n";
+    cout << "  " << static_cast<double>(jitter.ticks) / seconds << " timers/s, late by p50 " << jitter.p50Milliseconds << "ms p99 " << jitter.p99Milliseconds
+         << "ms max " << jitter.maxMilliseconds << "ms, " << static_cast<double>(bytesRead) / seconds / 1e6 << " MB/s of frames\n";
+#endif
+}
+
+/**
+ * @brief Measures the round trip of batched steps through an environment server against stepping the batch in process
+ *
+ * @note The server runs on a thread of the benchmark, the client reaches it through the socket and shared memory
+ * exactly as another process would
+ */
+static void benchmarkEnvServer()
+{
+#if defined(__linux__)
+    constexpr int STEPS{20'000};
+    constexpr int SIDE{10};
+
+    const string path{(filesystem::temp_directory_path() / ("snake_bench_env_" + to_string(getpid()) + ".sock")).string()};
+    EnvServer server(EnvServerOptions{path});
+    thread serverThread([&server]
+                        { server.run(); });
+
+    cout << "Env server " << SIDE << 'x' << SIDE << " boards over " << STEPS << " steps (us per batched step)\n";
+    for (const int gameCount : {1, 64, 1024})
+    {
+        EnvClient client(path, EnvRequest{static_cast<uint32_t>(gameCount), SIDE, SIDE, 3, 1});
+        Pcg32 random{1};
+        for (int step{0}; step < STEPS; ++step)
+        {
+            for (int game{0}; game < gameCount; ++game)
+                client.getActions()[game] = static_cast<uint8_t>(random.bounded(4));
+            client.step();
+        }
+        const EnvStepLatency latency{client.getStepLatency()};
+
+        // The same steps in process, without the doorbells
+        BatchStepper batch(gameCount, SIDE, SIDE, 3, 1);
+        BatchObservationWriter writer(batch);
+        vector<uint8_t> observations(gameCount * writer.getObservationSize());
+        vector<Directions::Direction> moves(gameCount);
+        writer.write(batch, observations.data());
+        const auto start{Clock::now()};
+        for (int step{0}; step < STEPS; ++step)
+        {
+            for (auto &move : moves)
+                move = static_cast<Directions::Direction>(random.bounded(4));
+            batch.step(moves.data());
+            writer.update(batch, observations.data());
+        }
+        const double inProcessMicroseconds{chrono::duration<double, micro>(Clock::now() - start).count() / STEPS};
+
+        cout << "  " << gameCount << " games round trip p50 " << latency.p50Microseconds << " p99 " << latency.p99Microseconds << " max " << latency.maxMicroseconds
+             << ", in process " << inProcessMicroseconds << '\n';
+    }
+
+    server.requestStop();
+    serverThread.join();
+#endif
+}
+
+/**
+ * @brief Measures the cost of counting heatmap events on the step throughput and of merging per thread heatmaps
+ *
+ */
+static void benchmarkHeatmap()
+{
+    constexpr int WIDTH{30};
+    constexpr int HEIGHT{20};
+    constexpr int64_t STEPS{5'000'000};
+    constexpr int MERGED_COUNT{16};
+    constexpr int MERGED_SIDE{200};
+
+    // Random moves are the cheapest policy, so they show the largest share of the step spent counting
+    const auto play = [=](Heatmap *heatmap)
+    {
+        Pcg32 random{1};
+        int64_t steps{0};
+        const auto start{Clock::now()};
+        while (steps < STEPS)
+        {
+            Game game(make_unique<Board>(WIDTH, HEIGHT), make_unique<Snake>(Point(4, HEIGHT), 4), 200.0, "Captain", random());
+            const auto stepper{makeGameStepper(game)};
+            if (heatmap)
+                heatmap->recordStart(game);
+            while (!game.isGameOver() && steps < STEPS)
+            {
+                const int previousHeadCell{game.getBoard().getCellIndex(game.getSnake().getHead())};
+                const StepOutcome outcome{stepper->step(static_cast<Directions::Direction>(random.bounded(4)))};
+                if (heatmap)
+                    heatmap->recordStep(game, outcome, previousHeadCell);
+                ++steps;
+            }
+        }
+        return chrono::duration<double, nano>(Clock::now() - start).count() / steps;
+    };
+    // Alternate the runs and keep the fastest of each so noise doesn't favour either
+    Heatmap heatmap(WIDTH, HEIGHT);
+    double plainNanoseconds{INFINITY};
+    double countedNanoseconds{INFINITY};
+    for (int run{0}; run < 3; ++run)
+    {
+        plainNanoseconds = min(plainNanoseconds, play(nullptr));
+        countedNanoseconds = min(countedNanoseconds, play(&heatmap));
+    }
+
+    const vector<Heatmap> heatmaps(MERGED_COUNT, Heatmap(MERGED_SIDE, MERGED_SIDE));
+    const auto start{Clock::now()};
+    const Heatmap merged{Heatmap::merge(heatmaps)};
+    const double mergeMilliseconds{chrono::duration<double, milli>(Clock::now() - start).count()};
+
+    cout << "Heatmap " << WIDTH << 'x' << HEIGHT << " over " << STEPS << " random steps (ns per step, " << heatmap.getTotal(HeatmapLayer::DEATHS) / 3 << " games)\n";
+    cout << "  plain " << plainNanoseconds << " counted " << countedNanoseconds << " overhead " << (countedNanoseconds / plainNanoseconds - 1) * 100 << "%\n";
+    cout << "  merging " << MERGED_COUNT << ' ' << MERGED_SIDE << 'x' << MERGED_SIDE << " heatmaps " << mergeMilliseconds << "ms\n";
+}
+
+/**
+ * @brief Compares drawing apple positions from Pcg32 with a Mersenne Twister and a distribution per draw
+ *
+ */
+static void benchmarkRandom()
+{
+    constexpr int DRAWS{20'000'000};
+    constexpr int WIDTH{30};
+    constexpr int HEIGHT{20};
+
+    // Sum the draws so they aren't optimized away
+    int64_t sum{0};
+    mt19937 twister{1};
+    auto start{Clock::now()};
+    for (int draw{0}; draw < DRAWS; ++draw)
+    {
+        uniform_int_distribution getX{1, WIDTH};
+        uniform_int_distribution getY{1, HEIGHT};
+        sum += getX(twister) + getY(twister);
+    }
+    const double twisterNanoseconds{chrono::duration<double, nano>(Clock::now() - start).count() / DRAWS};
+
+    Pcg32 pcg{1};
+    start = Clock::now();
+    for (int draw{0}; draw < DRAWS; ++draw)
+        sum += pcg.between(1, WIDTH) + pcg.between(1, HEIGHT);
+    const double pcgNanoseconds{chrono::duration<double, nano>(Clock::now() - start).count() / DRAWS};
+
+    cout << "Random apple positions (ns per position, checksum " << sum % 10 << ")\n";
+    cout << "  mt19937 " << twisterNanoseconds << " (" << sizeof(mt19937) << " bytes) pcg32 " << pcgNanoseconds << " (" << sizeof(Pcg32) << " bytes)\n";
+}
+
+/**
+ * @brief Measures keeping the free regions up to date against labelling them from scratch every tick
+ *
+ */
+static void benchmarkReachability()
+{
+    constexpr int SIDE{199};
+    constexpr int64_t MAX_STEPS{100'000};
+
+    // A snake chasing apples without walking into dead ends, so it grows long and winds around itself
+    Game game(make_unique<Board>(SIDE, SIDE), make_unique<Snake>(Point(10, SIDE / 2), 10), 200.0, "Captain", 1);
+    game.reserve();
+    const auto stepper{makeGameStepper(game)};
+    Reachability reachability(game.getBoard(), game.getSnake());
+    Reachability rebuilt(game.getBoard(), game.getSnake());
+    double updateNanoseconds{0};
+    double rebuildNanoseconds{0};
+    int64_t steps{0};
+    while (!game.isGameOver() && steps < MAX_STEPS)
+    {
+        const Snake &snake{game.getSnake()};
+        Directions::Direction direction{snake.getDirection()};
+        int closest{INT32_MAX};
+        for (int index{0}; index < Board::DIRECTION_COUNT; ++index)
+        {
+            const auto candidate{static_cast<Directions::Direction>(index)};
+            const Point destination{snake.getHead().getAdjacentPoint(candidate)};
+            const int distance{abs(destination.x - game.getApple().x) + abs(destination.y - game.getApple().y)};
+            if (reachability.canEscape(snake, candidate) && distance < closest)
+            {
+                closest = distance;
+                direction = candidate;
+            }
+        }
+        stepper->step(direction);
+        ++steps;
+
+        auto start{Clock::now()};
+        reachability.update(game.getSnake());
+        updateNanoseconds += chrono::duration<double, nano>(Clock::now() - start).count();
+
+        // Rebuilding is slow, so only every hundredth step is timed
+        if (steps % 100 == 0)
+        {
+            start = Clock::now();
+            rebuilt.rebuild(game.getSnake());
+            rebuildNanoseconds += chrono::duration<double, nano>(Clock::now() - start).count() * 100;
+        }
+    }
+
+    cout << "Reachability " << SIDE + 1 << 'x' << SIDE + 1 << " over " << steps << " steps, snake length " << game.getSnake().getBody().size() << " (ns per step)\n";
+    cout << "  incremental " << updateNanoseconds / steps << " rebuild " << rebuildNanoseconds / steps << '\n';
+}
+
+/**
+ * @brief Compares a queue of points searching around the snake's segment set with a bitboard distance field on a
+ * very large board
+ *
+ * @note Measured on one core of a Xeon at -O2: queue of points 46ms, bitboard 31ms. Expanding each level's rows in
+ * bands on 2 and 4 threads took 34ms and 37ms, a level only touches a few words per row so waiting for the other
+ * bands cost more than the rows saved, and was removed.
+ */
+static void benchmarkDistanceField()
+{
+    constexpr int SIDE{999};
+    constexpr int SNAKE_LENGTH{800};
+    constexpr int RUNS{5};
+
+    // A long snake across the middle of the board, searched from its head
+    const Board board(SIDE, SIDE);
+    const Snake snake(Point(SNAKE_LENGTH, SIDE / 2), SNAKE_LENGTH);
+    const Point source{snake.getHead()};
+    const auto timeRuns = [](const auto &search)
+    {
+        double fastest{INFINITY};
+        for (int run{0}; run < RUNS; ++run)
+        {
+            const auto start{Clock::now()};
+            search();
+            fastest = min(fastest, chrono::duration<double, milli>(Clock::now() - start).count());
+        }
+        return fastest;
+    };
+
+    size_t queueReached{0};
+    const double queueMilliseconds{timeRuns([&]
+                                            {
+                                                vector<int32_t> distances(static_cast<size_t>(board.getCellCount()), DistanceField::UNREACHABLE);
+                                                queue<Point> points;
+                                                points.push(source);
+                                                distances[board.getCellIndex(source)] = 0;
+                                                queueReached = 1;
+                                                while (!points.empty())
+                                                {
+                                                    const Point point{points.front()};
+                                                    points.pop();
+                                                    for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+                                                    {
+                                                        const Point neighbour{board.getNeighbour(point, static_cast<Directions::Direction>(direction))};
+                                                        if (!board.isInBoard(neighbour) || snake.isInSnake(neighbour) || distances[board.getCellIndex(neighbour)] != DistanceField::UNREACHABLE)
+                                                            continue;
+                                                        distances[board.getCellIndex(neighbour)] = distances[board.getCellIndex(point)] + 1;
+                                                        points.push(neighbour);
+                                                        ++queueReached;
+                                                    }
+                                                }
+                                            })};
+
+    cout << "Distance field " << SIDE + 1 << 'x' << SIDE + 1 << " from the head of a snake of length " << SNAKE_LENGTH << " (ms per field)\n";
+    cout << "  queue of points " << queueMilliseconds << " (" << queueReached << " cells)\n";
+    DistanceField field(board, snake);
+    const double bitboardMilliseconds{timeRuns([&]
+                                               { field.compute(source); })};
+    cout << "  bitboard " << bitboardMilliseconds << (field.getReachedCount() == queueReached ? "" : " (reached counts differ)") << '\n';
+}
+
+/**
+ * @brief Measures keeping and taking back the ticks of a long snake winding around a large board
+ *
+ */
+static void benchmarkRewind()
+{
+    constexpr int SIDE{199};
+    constexpr int64_t MAX_STEPS{100'000};
+    constexpr size_t HISTORY_LENGTH{50'000};
+
+    // The snake steers like the reachability benchmark so it grows long
+    Game game(make_unique<Board>(SIDE, SIDE), make_unique<Snake>(Point(10, SIDE / 2), 10), 200.0, "Captain", 1);
+    game.reserve();
+    const auto stepper{makeGameStepper(game)};
+    RewindBuffer rewindBuffer(game, *stepper, HISTORY_LENGTH);
+    Reachability reachability(game.getBoard(), game.getSnake());
+    double stepNanoseconds{0};
+    int64_t steps{0};
+    while (!game.isGameOver() && steps < MAX_STEPS)
+    {
+        const Snake &snake{game.getSnake()};
+        Directions::Direction direction{snake.getDirection()};
+        int closest{INT32_MAX};
+        for (int index{0}; index < Board::DIRECTION_COUNT; ++index)
+        {
+            const auto candidate{static_cast<Directions::Direction>(index)};
+            const Point destination{snake.getHead().getAdjacentPoint(candidate)};
+            const int distance{abs(destination.x - game.getApple().x) + abs(destination.y - game.getApple().y)};
+            if (reachability.canEscape(snake, candidate) && distance < closest)
+            {
+                closest = distance;
+                direction = candidate;
+            }
+        }
+        const auto start{Clock::now()};
+        rewindBuffer.step(direction);
+        stepNanoseconds += chrono::duration<double, nano>(Clock::now() - start).count();
+        reachability.update(game.getSnake());
+        ++steps;
+    }
+
+    const size_t length{game.getSnake().getBody().size()};
+    const auto start{Clock::now()};
+    const size_t undone{rewindBuffer.rewind(HISTORY_LENGTH)};
+    const double undoNanoseconds{chrono::duration<double, nano>(Clock::now() - start).count()};
+
+    cout << "Rewind " << SIDE + 1 << 'x' << SIDE + 1 << " over " << steps << " steps, snake length " << length << " (ns per tick)\n";
+    cout << "  step " << stepNanoseconds / steps << " undo " << undoNanoseconds / undone << " over " << undone << " ticks\n";
+    cout << "  history " << rewindBuffer.getMemoryUsage() << " bytes, one snake copy " << length * sizeof(Point) << " bytes\n";
+}
+
+/**
+ * @brief Measures archiving replays of played games and verifying them again on every core
+ *
+ */
+static void benchmarkReplays()
+{
+    constexpr int WIDTH{30};
+    constexpr int HEIGHT{20};
+    constexpr int GAMES{20'000};
+    constexpr int BATCH{1'000};
+    constexpr size_t MAX_MOVES{10'000};
+
+    // The snake avoids dead ends so games last like played ones
+    Pcg32 random{1};
+    vector<Replay> replays(GAMES);
+    int64_t moves{0};
+    for (auto &replay : replays)
+    {
+        replay.seed = random();
+        replay.width = WIDTH;
+        replay.height = HEIGHT;
+        replay.gameSpeed = 200.0;
+        replay.snakeLength = 4;
+        const auto game{createReplayGame(replay)};
+        const auto stepper{makeGameStepper(*game)};
+        Reachability reachability(game->getBoard(), game->getSnake());
+        while (!game->isGameOver() && replay.moveCount < MAX_MOVES)
+        {
+            const Snake &snake{game->getSnake()};
+            const Directions::Direction direction{reachability.pickMove(snake, random).value_or(snake.getDirection())};
+            stepper->step(direction);
+            reachability.update(snake);
+            replay.addMove(direction);
+        }
+        replay.score = game->getScore();
+        moves += static_cast<int64_t>(replay.moveCount);
+    }
+
+    const string path{(filesystem::temp_directory_path() / "snake_bench_replays.dat").string()};
+    filesystem::remove(path);
+    auto start{Clock::now()};
+    for (size_t first{0}; first < replays.size(); first += BATCH)
+        ReplayArchive::append(path, vector<Replay>(replays.begin() + static_cast<ptrdiff_t>(first), replays.begin() + static_cast<ptrdiff_t>(min(first + BATCH, replays.size()))));
+    const double appendSeconds{chrono::duration<double>(Clock::now() - start).count()};
+
+    start = Clock::now();
+    const ReplayArchive archive(path);
+    const double openMicroseconds{chrono::duration<double, micro>(Clock::now() - start).count()};
+
+    // Play every replay again with a thread per core, like SnakeReplayVerify
+    const unsigned threadCount{max(thread::hardware_concurrency(), 1u)};
+    atomic<size_t> nextReplay{0};
+    atomic<size_t> mismatches{0};
+    start = Clock::now();
+    {
+        vector<jthread> threads;
+        for (unsigned index{0}; index < threadCount; ++index)
+            threads.emplace_back([&]
+                                 {
+                                     Replay replay;
+                                     for (size_t replayIndex{nextReplay++}; replayIndex < archive.getReplayCount(); replayIndex = nextReplay++)
+                                     {
+                                         archive.getReplay(replayIndex, replay);
+                                         if (simulateReplay(replay).score != replay.score)
+                                             ++mismatches;
+                                     } });
+    }
+    const double verifySeconds{chrono::duration<double>(Clock::now() - start).count()};
+
+    cout << "Replays " << WIDTH << 'x' << HEIGHT << ", " << GAMES << " games of " << moves / GAMES << " moves, " << filesystem::file_size(path) / GAMES << " bytes each\n";
+    cout << "  append " << appendSeconds / GAMES * 1e6 << "us per replay in batches of " << BATCH << ", open " << openMicroseconds << "us\n";
+    cout << "  verify on " << threadCount << " threads " << GAMES / verifySeconds * 3600.0 / 1e6 << "M games/h, " << mismatches << " mismatches\n";
+    filesystem::remove(path);
+}
+
+/**
+ * @brief Measures solving a small board exactly with each replacement policy of a small transposition table
+ *
+ */
+static void benchmarkSolver()
+{
+    constexpr int DEPTH{30};
+    constexpr size_t SMALL_TABLE_BYTES{256 << 10};
+    constexpr size_t LARGE_TABLE_BYTES{64 << 20};
+    Replay root;
+    root.seed = 1;
+    root.width = 6;
+    root.height = 6;
+    root.gameSpeed = 200.0;
+    root.snakeLength = 3;
+    cout << "Solver (6x6, " << DEPTH << " moves deep)\n";
+
+    const auto measure = [&root](const char *name, size_t tableBytes, ReplacementPolicy policy, unsigned threadCount)
+    {
+        SmallBoardSolver solver(root, tableBytes, policy);
+        const SolverResult result{solver.solve(DEPTH, threadCount)};
+        const SolverStatistics &statistics{result.statistics};
+        cout << "  " << name << ": " << result.apples << " apples, " << statistics.nodes << " nodes in " << result.seconds * 1e3 << "ms ("
+             << static_cast<double>(statistics.nodes) / result.seconds / 1e6 << "M nodes/s), " << statistics.getHitRate() * 100 << "% hits, "
+             << statistics.getCutoffRate() * 100 << "% cutoffs, " << statistics.tableReplacements << " replaced, " << statistics.tableRejections << " rejected\n";
+    };
+    measure("always, 256KB", SMALL_TABLE_BYTES, ReplacementPolicy::ALWAYS, 1);
+    measure("depth preferred, 256KB", SMALL_TABLE_BYTES, ReplacementPolicy::DEPTH_PREFERRED, 1);
+    measure("two tier, 256KB", SMALL_TABLE_BYTES, ReplacementPolicy::TWO_TIER, 1);
+    measure("two tier, 64MB", LARGE_TABLE_BYTES, ReplacementPolicy::TWO_TIER, 1);
+    const unsigned threadCount{max(thread::hardware_concurrency(), 1u)};
+    measure(("two tier, 64MB, " + to_string(threadCount) + " threads").c_str(), LARGE_TABLE_BYTES, ReplacementPolicy::TWO_TIER, threadCount);
+}
+
+/**
+ * @brief Creates a dense or convolution layer of random weights
+ *
+ */
+static PolicyLayerDefinition createRandomLayer(PolicyLayerKind kind, PolicyPrecision precision, int inputs, int outputs, mt19937 &random)
+{
+    PolicyLayerDefinition layer{kind, precision, PolicyActivation::RELU, inputs, outputs, {}, {}};
+    const size_t weightCount{static_cast<size_t>(inputs) * outputs * (kind == PolicyLayerKind::CONV3X3 ? 9 : 1)};
+    normal_distribution<float> weights(0.0F, 1.0F / sqrt(static_cast<float>(weightCount / outputs)));
+    layer.weights.resize(weightCount);
+    for (auto &weight : layer.weights)
+        weight = weights(random);
+    layer.biases.assign(outputs, 0.01F);
+    return layer;
+}
+
+/**
+ * @brief Measures picking bot moves with policies of random weights, one game at a time and in batches
+ *
+ */
+static void benchmarkPolicy()
+{
+    constexpr int WIDTH{29};
+    constexpr int HEIGHT{19};
+    constexpr int GAMES{1024};
+    constexpr int SINGLE_DECISIONS{20'000};
+    constexpr int BATCHES{20};
+
+    // A perceptron in both precisions and a small convolutional network
+    mt19937 random(1);
+    const int inputs{4 * (WIDTH + 1) * (HEIGHT + 1)};
+    const auto createPerceptron = [&random, inputs](PolicyPrecision precision)
+    {
+        return PolicyDefinition{WIDTH, HEIGHT, false,
+                                {createRandomLayer(PolicyLayerKind::DENSE, precision, inputs, 128, random),
+                                 createRandomLayer(PolicyLayerKind::DENSE, precision, 128, 128, random),
+                                 createRandomLayer(PolicyLayerKind::DENSE, precision, 128, Policy::MOVE_COUNT, random)}};
+    };
+    PolicyDefinition convolutional{WIDTH, HEIGHT, false,
+                                   {createRandomLayer(PolicyLayerKind::CONV3X3, PolicyPrecision::FLOAT32, 4, 8, random),
+                                    createRandomLayer(PolicyLayerKind::DENSE, PolicyPrecision::FLOAT32, 8 * (WIDTH + 1) * (HEIGHT + 1), 64, random),
+                                    createRandomLayer(PolicyLayerKind::DENSE, PolicyPrecision::FLOAT32, 64, Policy::MOVE_COUNT, random)}};
+    const pair<const char *, PolicyDefinition> definitions[]{{"mlp float", createPerceptron(PolicyPrecision::FLOAT32)},
+                                                             {"mlp int8", createPerceptron(PolicyPrecision::INT8)},
+                                                             {"conv float", convolutional}};
+
+    // Games spread over the board by playing random moves that don't crash
+    vector<unique_ptr<Game>> games;
+    vector<const Game *> gamePointers;
+    for (int index{0}; index < GAMES; ++index)
+    {
+        games.push_back(make_unique<Game>(make_unique<Board>(WIDTH, HEIGHT), make_unique<Snake>(Point(5, HEIGHT / 2), 5), 200.0, "Captain", index));
+        const auto stepper{makeGameStepper(*games.back())};
+        Pcg32 moves(index);
+        Reachability reachability(games.back()->getBoard(), games.back()->getSnake());
+        for (int step{0}; step < index % 50; ++step)
+        {
+            const auto move{reachability.pickMove(games.back()->getSnake(), moves)};
+            if (!move)
+                break;
+            stepper->step(*move);
+            reachability.update(games.back()->getSnake());
+        }
+        gamePointers.push_back(games.back().get());
+    }
+
+    vector<SimdLevel> levels{SimdLevel::SCALAR};
+#if SNAKE_HAS_X86_KERNELS
+    if (detectSimdLevel() == SimdLevel::AVX2)
+        levels.push_back(SimdLevel::AVX2);
+#endif
+    const string path{(filesystem::temp_directory_path() / "snake_bench_policy.bin").string()};
+    cout << "Policy on " << WIDTH + 1 << 'x' << HEIGHT + 1 << " (us per decision)\n";
+    for (const auto &[name, definition] : definitions)
+    {
+        Policy::write(path, definition);
+        for (const auto level : levels)
+        {
+            Policy policy(path, level);
+            Directions::Direction move{};
+            auto start{Clock::now()};
+            for (int decision{0}; decision < SINGLE_DECISIONS; ++decision)
+                move = policy.decide(*games[decision % GAMES]);
+            const double single{chrono::duration<double, micro>(Clock::now() - start).count() / SINGLE_DECISIONS};
+
+            vector<Directions::Direction> moves(GAMES);
+            start = Clock::now();
+            for (int batch{0}; batch < BATCHES; ++batch)
+                policy.decideBatch(gamePointers.data(), GAMES, moves.data());
+            const double batched{chrono::duration<double, micro>(Clock::now() - start).count() / (static_cast<double>(BATCHES) * GAMES)};
+            cout << "  " << name << ' ' << getSimdLevelName(level) << " single " << single << " batch of " << GAMES << ' ' << batched
+                 << (move == moves[(SINGLE_DECISIONS - 1) % GAMES] ? "" : " (moves differ)") << '\n';
+        }
+    }
+    filesystem::remove(path);
+}
+
+/**
+ * @brief Runs the benchmarks named on the command line, or all of them
+ *
+ */
+int main(int argc, char *argv[])
+{
+    // Child processes of the startup benchmark
+    if (argc == 2 && string{argv[1]} == "startup-child")
+    {
+        runStartupChild();
+        return 0;
+    }
+
+    const auto shouldRun = [argc, argv](const string &name)
+    {
+        if (argc < 2)
+            return true;
+        for (int index{1}; index < argc; ++index)
+            if (name == argv[index])
+                return true;
+        return false;
+    };
+
+    if (shouldRun("geometry"))
+        benchmarkBoardGeometry();
+    if (shouldRun("batch"))
+        benchmarkBatchStepping();
+    if (shouldRun("capi"))
+        benchmarkCApi();
+    if (shouldRun("startup"))
+        benchmarkStartup(argv[0]);
+    if (shouldRun("journal"))
+        benchmarkScoreJournal();
+    if (shouldRun("analytics"))
+        benchmarkScoreAnalytics();
+    if (shouldRun("pages"))
+        benchmarkScorePages();
+    if (shouldRun("leaderboard"))
+        benchmarkLeaderboard();
+    if (shouldRun("sessions"))
+        benchmarkSessions();
+    if (shouldRun("env"))
+        benchmarkEnvServer();
+    if (shouldRun("heatmap"))
+        benchmarkHeatmap();
+    if (shouldRun("random"))
+        benchmarkRandom();
+    if (shouldRun("reachability"))
+        benchmarkReachability();
+    if (shouldRun("distance"))
+        benchmarkDistanceField();
+    if (shouldRun("policy"))
+        benchmarkPolicy();
+    if (shouldRun("rewind"))
+        benchmarkRewind();
+    if (shouldRun("replays"))
+        benchmarkReplays();
+    if (shouldRun("solver"))
+        benchmarkSolver();
+    if (shouldRun("allocations") && !benchmarkAllocations())
+    {
+        cerr << "Steady state ticks allocated\n";
+        return 1;
+    }
+    return 0;
+}
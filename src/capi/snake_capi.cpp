@@ -0,0 +1,274 @@
+#include "snake_capi.h"
+#include "game.hpp"
+#include "board.hpp"
+#include "snake.hpp"
+#include "game_stepper.hpp"
+#include "observation.hpp"
+#include "map_pack.hpp"
+#include "reachability.hpp"
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// The C values must match the C++ enums they are cast to
+static_assert(static_cast<int>(StepOutcome::MOVED) == SNAKE_MOVED && static_cast<int>(StepOutcome::ATE) == SNAKE_ATE);
+static_assert(static_cast<int>(StepOutcome::HIT_SELF) == SNAKE_HIT_SELF && static_cast<int>(StepOutcome::HIT_WALL) == SNAKE_HIT_WALL);
+static_assert(static_cast<int>(Directions::Direction::UP) == SNAKE_UP && static_cast<int>(Directions::Direction::LEFT) == SNAKE_LEFT);
+
+/**
+ * @brief The game behind a handle
+ *
+ */
+struct snake_game
+{
+    int width;
+    int height;
+    int startingLength;
+
+    /**
+     * @brief The board every game is copied from, copies share its neighbour table, and the snake's tail end at
+     * the start
+     *
+     */
+    unique_ptr<Board> board;
+    Point spawn;
+
+    unique_ptr<Game> game;
+    unique_ptr<GameStepper> stepper;
+    unique_ptr<ObservationWriter> observationWriter;
+
+    /**
+     * @brief The buffer the observation writer last wrote, incremental updates only apply to it
+     *
+     */
+    const void *lastObservation{nullptr};
+
+    /**
+     * @brief The free regions of the board, created by the first query and caught up by later ones so steps don't
+     * pay for them
+     *
+     */
+    unique_ptr<Reachability> reachability;
+
+    /**
+     * @brief Get the free regions as of the current step
+     *
+     */
+    Reachability &getReachability()
+    {
+        if (!reachability)
+            reachability = make_unique<Reachability>(game->getBoard(), game->getSnake());
+        else
+            reachability->update(game->getSnake());
+        return *reachability;
+    }
+
+    /**
+     * @brief Starts a new game with the seed
+     *
+     */
+    void start(uint32_t seed)
+    {
+        reachability.reset();
+        stepper.reset();
+        game = make_unique<Game>(make_unique<Board>(*board), make_unique<Snake>(Point(spawn.x + startingLength, spawn.y), startingLength), 200.0, "Captain", seed);
+        stepper = makeGameStepper(*game);
+        observationWriter = make_unique<ObservationWriter>(width, height);
+        lastObservation = nullptr;
+    }
+};
+
+/**
+ * @brief The last failure of the calling thread
+ *
+ */
+static thread_local string lastError;
+
+/**
+ * @brief Runs the function, converting exceptions to the failure value
+ *
+ */
+template <typename Function, typename Result>
+static Result guard(Function &&function, Result failure)
+{
+    try
+    {
+        return function();
+    }
+    catch (const exception &exception)
+    {
+        lastError = exception.what();
+    }
+    catch (...)
+    {
+        lastError = "unknown error";
+    }
+    return failure;
+}
+
+/**
+ * @brief Writes the observation, updating incrementally when the buffer was written last
+ *
+ */
+template <typename T>
+static int observe(snake_game *game, T *observation, size_t size)
+{
+    return guard([&]
+                 {
+                     if (!game || !observation)
+                         throw invalid_argument("game or observation is null");
+                     if (size < game->observationWriter->getObservationSize())
+                         throw invalid_argument("observation buffer is too small");
+                     if (game->lastObservation == observation)
+                         game->observationWriter->update(*game->game, observation);
+                     else
+                         game->observationWriter->write(*game->game, observation);
+                     game->lastObservation = observation;
+                     return 0; },
+                 -1);
+}
+
+extern "C"
+{
+    int snake_abi_version(void) { return SNAKE_ABI_VERSION; }
+
+    const char *snake_last_error(void) { return lastError.c_str(); }
+
+    snake_game *snake_create(int width, int height, int starting_length, uint32_t seed)
+    {
+        return guard([&]
+                     {
+                         if (width <= 0 || height <= 0)
+                             throw invalid_argument("board dimensions must be positive");
+                         if (starting_length <= 0 || starting_length > width)
+                             throw invalid_argument("starting length must fit in the board width");
+                         auto game{make_unique<snake_game>()};
+                         game->width = width;
+                         game->height = height;
+                         game->startingLength = starting_length;
+                         game->board = make_unique<Board>(width, height);
+                         game->spawn = Point{0, height};
+                         game->start(seed);
+                         return game.release(); },
+                     static_cast<snake_game *>(nullptr));
+    }
+
+    snake_game *snake_create_from_map(const char *map_pack_path, size_t map_index, int starting_length, uint32_t seed)
+    {
+        return guard([&]
+                     {
+                         if (!map_pack_path)
+                             throw invalid_argument("map pack path is null");
+
+                         // The pack is only needed to copy the map's board out of it
+                         const MapPack pack(map_pack_path);
+                         pack.createSnake(map_index, starting_length);
+                         const MapInfo info{pack.getMapInfo(map_index)};
+                         auto game{make_unique<snake_game>()};
+                         game->width = info.width;
+                         game->height = info.height;
+                         game->startingLength = starting_length;
+                         game->board = pack.createBoard(map_index);
+                         game->spawn = info.spawn;
+                         game->start(seed);
+                         return game.release(); },
+                     static_cast<snake_game *>(nullptr));
+    }
+
+    int snake_reset(snake_game *game, uint32_t seed)
+    {
+        return guard([&]
+                     {
+                         if (!game)
+                             throw invalid_argument("game is null");
+                         game->start(seed);
+                         return 0; },
+                     -1);
+    }
+
+    int snake_step(snake_game *game, int direction)
+    {
+        return guard([&]
+                     {
+                         if (!game)
+                             throw invalid_argument("game is null");
+                         if (direction < SNAKE_UP || direction > SNAKE_LEFT)
+                             throw invalid_argument("invalid direction");
+                         if (game->game->isGameOver())
+                             throw invalid_argument("game is over");
+                         return static_cast<int>(game->stepper->step(static_cast<Directions::Direction>(direction))); },
+                     static_cast<int>(SNAKE_ERROR));
+    }
+
+    int snake_is_over(const snake_game *game)
+    {
+        return guard([&]
+                     {
+                         if (!game)
+                             throw invalid_argument("game is null");
+                         return game->game->isGameOver() ? 1 : 0; },
+                     -1);
+    }
+
+    int snake_get_score(const snake_game *game)
+    {
+        return guard([&]
+                     {
+                         if (!game)
+                             throw invalid_argument("game is null");
+                         return game->game->getScore(); },
+                     -1);
+    }
+
+    int snake_get_length(const snake_game *game)
+    {
+        return guard([&]
+                     {
+                         if (!game)
+                             throw invalid_argument("game is null");
+                         return static_cast<int>(game->game->getSnake().getBody().size()); },
+                     -1);
+    }
+
+    int snake_reachable_cells(snake_game *game, int direction)
+    {
+        return guard([&]
+                     {
+                         if (!game)
+                             throw invalid_argument("game is null");
+                         if (direction < SNAKE_UP || direction > SNAKE_LEFT)
+                             throw invalid_argument("invalid direction");
+                         return game->getReachability().getReachableCount(game->game->getSnake(), static_cast<Directions::Direction>(direction)); },
+                     -1);
+    }
+
+    int snake_is_trapped(snake_game *game)
+    {
+        return guard([&]
+                     {
+                         if (!game)
+                             throw invalid_argument("game is null");
+                         return game->getReachability().isTrapped(game->game->getSnake()) ? 1 : 0; },
+                     -1);
+    }
+
+    size_t snake_observation_size(const snake_game *game)
+    {
+        return guard([&]
+                     {
+                         if (!game)
+                             throw invalid_argument("game is null");
+                         return game->observationWriter->getObservationSize(); },
+                     static_cast<size_t>(0));
+    }
+
+    int snake_observe_u8(snake_game *game, uint8_t *observation, size_t size) { return observe(game, observation, size); }
+
+    int snake_observe_f32(snake_game *game, float *observation, size_t size) { return observe(game, observation, size); }
+
+    void snake_destroy(snake_game *game) { delete game; }
+}
@@ -0,0 +1,124 @@
+#ifndef SNAKE_CAPI_H
+#define SNAKE_CAPI_H
+
+/**
+ * The stable C interface of the snake game rules.
+ *
+ * Games are opaque handles created by snake_create and released by snake_destroy. Functions never throw, failures
+ * are reported by the return value and described by snake_last_error. A handle must only be used by one thread at
+ * a time, separate handles are independent.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(SNAKE_CAPI_SHARED)
+#if defined(SNAKE_CAPI_EXPORTS)
+#define SNAKE_API __declspec(dllexport)
+#else
+#define SNAKE_API __declspec(dllimport)
+#endif
+#elif defined(__GNUC__) || defined(__clang__)
+#define SNAKE_API __attribute__((visibility("default")))
+#else
+#define SNAKE_API
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** The version of this interface, incremented on incompatible changes */
+#define SNAKE_ABI_VERSION 1
+
+/** A game handle */
+typedef struct snake_game snake_game;
+
+/** The directions the snake can move */
+typedef enum snake_direction
+{
+    SNAKE_UP = 0,
+    SNAKE_RIGHT = 1,
+    SNAKE_DOWN = 2,
+    SNAKE_LEFT = 3
+} snake_direction;
+
+/** The result of a step */
+typedef enum snake_outcome
+{
+    SNAKE_ERROR = -1,
+    SNAKE_MOVED = 0,
+    SNAKE_ATE = 1,
+    SNAKE_HIT_SELF = 2,
+    SNAKE_HIT_WALL = 3
+} snake_outcome;
+
+/** Returns SNAKE_ABI_VERSION of the loaded library */
+SNAKE_API int snake_abi_version(void);
+
+/** Describes the last failure on the calling thread */
+SNAKE_API const char *snake_last_error(void);
+
+/**
+ * Creates a game on a width x height board with a snake of starting_length in the bottom left corner.
+ * Apples are placed from the seed so equal seeds and moves replay equal games. Returns NULL on failure.
+ */
+SNAKE_API snake_game *snake_create(int width, int height, int starting_length, uint32_t seed);
+
+/**
+ * Creates a game on the map at map_index of a map pack file, with obstacles and wraparound as the map defines.
+ * The snake of starting_length starts at the map's spawn. Returns NULL on failure.
+ */
+SNAKE_API snake_game *snake_create_from_map(const char *map_pack_path, size_t map_index, int starting_length, uint32_t seed);
+
+/** Restarts the game with a new snake and seed. Returns 0 on success, -1 on failure */
+SNAKE_API int snake_reset(snake_game *game, uint32_t seed);
+
+/**
+ * Moves the snake one step. Reversing keeps the current direction. Returns a snake_outcome. Eating the apple on the
+ * last cell an apple can be placed in returns SNAKE_ATE and ends the game, the board is cleared.
+ */
+SNAKE_API int snake_step(snake_game *game, int direction);
+
+/** Returns 1 if the snake crashed or cleared the board, 0 if not and -1 on failure */
+SNAKE_API int snake_is_over(const snake_game *game);
+
+/** Returns the score, or -1 on failure */
+SNAKE_API int snake_get_score(const snake_game *game);
+
+/** Returns the snake length, or -1 on failure */
+SNAKE_API int snake_get_length(const snake_game *game);
+
+/**
+ * Returns the number of free cells connected to the cell the move leads to, including it, 0 if the move crashes
+ * and -1 on failure. Moving onto the tail counts the room the freed tail joins. Reversing counts going straight.
+ */
+SNAKE_API int snake_reachable_cells(snake_game *game, int direction);
+
+/**
+ * Returns 1 if every move crashes now or leads into a dead end smaller than the snake that its tail won't open in
+ * time, 0 if not and -1 on failure
+ */
+SNAKE_API int snake_is_trapped(snake_game *game);
+
+/** Returns the number of values in an observation, planes * (height + 1) * (width + 1), or 0 on failure */
+SNAKE_API size_t snake_observation_size(const snake_game *game);
+
+/**
+ * Writes the body, head, tail and apple planes of the game into the buffer. Consecutive calls on the same buffer
+ * after single steps only update the cells that changed. Returns 0 on success, -1 on failure.
+ */
+SNAKE_API int snake_observe_u8(snake_game *game, uint8_t *observation, size_t size);
+
+/** Same as snake_observe_u8 with float values */
+SNAKE_API int snake_observe_f32(snake_game *game, float *observation, size_t size);
+
+/** Releases the game, NULL is ignored */
+SNAKE_API void snake_destroy(snake_game *game);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,46 +3,99 @@
 
 #include "plog/Init.h"
 #include "plog/Formatters/TxtFormatter.h"
+#include "plog/Appenders/IAppender.h"
 #include "plog/Appenders/RollingFileAppender.h"
+#include <cstdlib>
 #include <filesystem>
 #include <string>
 #include <memory>
+#include <mutex>
 
-// The global platform specific game folder path
+namespace SnakeConfig
+{
+    /**
+     * @brief Get the platform specific game folder path
+     *
+     * @note Built once on first use
+     */
+    inline const std::string &getGameDirectory()
+    {
+        static const std::string gameDirectory{[]
+                                               {
 #if defined(_WIN32)
-const static auto GAME_DIRECTORY{std::string{getenv("HOMEDRIVE")} + std::string{getenv("HOMEPATH")} + "\\AppData\\Roaming\\SnakeCpp\\"};
+                                                   return std::string{getenv("HOMEDRIVE")} + std::string{getenv("HOMEPATH")} + "\\AppData\\Roaming\\SnakeCpp\\";
 #elif defined(__linux__)
-const static auto GAME_DIRECTORY{std::string{getenv("HOME")} + "/.SnakeCpp/"};
+                                                   return std::string{getenv("HOME")} + "/.SnakeCpp/";
 #elif defined(__APPLE__)
-const static auto GAME_DIRECTORY{std::string{getenv("HOME")} + "/Library/Application Support/SnakeCpp/"};
+                                                   return std::string{getenv("HOME")} + "/Library/Application Support/SnakeCpp/";
 #else
-const static auto GAME_DIRECTORY{std::string()};
+                                                   return std::string();
 #endif
+                                               }()};
+        return gameDirectory;
+    }
 
-// The global log file path
-const static auto LOG_FILE{GAME_DIRECTORY + "logs/snake.log"};
-static auto _appender{std::make_unique<plog::RollingFileAppender<plog::TxtFormatter>>(LOG_FILE.c_str(), 100'000'000, 5)};
+    /**
+     * @brief Get the log file path
+     */
+    inline const std::string &getLogFile()
+    {
+        static const std::string logFile{getGameDirectory() + "logs/snake.log"};
+        return logFile;
+    }
 
-namespace SnakeConfig
-{
     /**
-     * Creates game directories
+     * @brief Creates the game folders the first time it is called
+     *
+     * @throws const char* Thrown if the OS has no known game folder
      */
-    static void init()
+    inline void ensureGameDirectories()
     {
-        // Ensure game directory exists
-        if (GAME_DIRECTORY.empty())
-            throw "This OS is not supported. Unknown Game Directory";
-
-        // Create folders if they don't exist
-        if (!std::filesystem::is_directory(GAME_DIRECTORY))
-            std::filesystem::create_directory(GAME_DIRECTORY);
-        if (!std::filesystem::is_directory(GAME_DIRECTORY + "logs/"))
-            std::filesystem::create_directory(GAME_DIRECTORY + "logs/");
-
-        // Initialize logger
-        plog::init(plog::info, _appender.get());
+        static std::once_flag created;
+        std::call_once(created, []
+                       {
+                           // Ensure game directory exists
+                           if (getGameDirectory().empty())
+                               throw "This OS is not supported. Unknown Game Directory";
+
+                           // Create folders if they don't exist
+                           if (!std::filesystem::is_directory(getGameDirectory()))
+                               std::filesystem::create_directory(getGameDirectory());
+                           if (!std::filesystem::is_directory(getGameDirectory() + "logs/"))
+                               std::filesystem::create_directory(getGameDirectory() + "logs/"); });
+    }
+
+    /**
+     * @brief A log appender that creates the log folder and file when the first record is written
+     *
+     */
+    class LazyFileAppender : public plog::IAppender
+    {
+    private:
+        std::once_flag created;
+        std::unique_ptr<plog::RollingFileAppender<plog::TxtFormatter>> appender;
+
+    public:
+        void write(const plog::Record &record) override
+        {
+            std::call_once(created, [this]
+                           {
+                               ensureGameDirectories();
+                               appender = std::make_unique<plog::RollingFileAppender<plog::TxtFormatter>>(getLogFile().c_str(), 100'000'000, 5); });
+            appender->write(record);
+        }
+    };
+
+    /**
+     * @brief Initializes the logger
+     *
+     * @note No files or folders are touched until something is logged or saved
+     */
+    inline void init()
+    {
+        static LazyFileAppender appender;
+        plog::init(plog::info, &appender);
     }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -1,24 +1,82 @@
 #include "config.hpp"
 #include "menu_service.hpp"
+#include "session_host_service.hpp"
+#include "env_server_service.hpp"
+#include "file_service.hpp"
 #include "plog/Log.h"
+#include "startup_timer.hpp"
 #include <filesystem>
 #include <memory>
+#include <string>
 
 using namespace std;
 
 /**
  * @brief The main method of the program
  *
+ * @note Pass --dump-observations <folder> to dump the observations of every game as .npy files. Pass
+ * --host <socket path> to host games for players connecting to the unix socket instead of playing, and
+ * --workers <count> to set the number of threads running their sessions. Pass --map-pack <file> to play on a map
+ * of a map pack, the first one or the one picked with --map <index>. Pass --bot <policy file> to let a trained policy
+ * play instead of the keyboard. Pass --practice <ticks> to keep the last ticks of each game and take them back with R.
+ * Pass --env-server <socket path> to step batches of games for trainers in other processes through shared memory
+ * instead of playing.
  * @return int The exit status code
  */
-int main()
+int main(int argc, char *argv[])
 {
     try
     {
         SnakeConfig::init();
         PLOGI << "Starting Snake";
+
+        // Host sessions or serve environments instead of playing if requested
+        SessionHostOptions hostOptions;
+        EnvServerOptions envOptions;
+        for (int index{1}; index + 1 < argc; ++index)
+        {
+            if (string{argv[index]} == "--host")
+                hostOptions.socketPath = argv[++index];
+            else if (string{argv[index]} == "--workers")
+                hostOptions.workerCount = stoi(argv[++index]);
+            else if (string{argv[index]} == "--env-server")
+                envOptions.socketPath = argv[++index];
+        }
+        if (!envOptions.socketPath.empty())
+        {
+            EnvServerService().run(envOptions);
+            PLOGI << "Stopping Snake";
+            return 0;
+        }
+        if (!hostOptions.socketPath.empty())
+        {
+            SessionHostService().run(hostOptions);
+            PLOGI << "Stopping Snake";
+            return 0;
+        }
+
+        // Rank games against the saved scores once the file thread has read them
+        FileService::loadLeaderboardTask();
         auto menu_service(make_unique<MenuService>());
+        string mapPackPath;
+        size_t mapIndex{0};
+        for (int index{1}; index + 1 < argc; ++index)
+        {
+            if (string{argv[index]} == "--dump-observations")
+                menu_service->setObservationDumpDirectory(argv[++index]);
+            else if (string{argv[index]} == "--map-pack")
+                mapPackPath = argv[++index];
+            else if (string{argv[index]} == "--map")
+                mapIndex = stoul(argv[++index]);
+            else if (string{argv[index]} == "--bot")
+                menu_service->setBotPolicy(argv[++index]);
+            else if (string{argv[index]} == "--practice")
+                menu_service->setPracticeHistoryLength(stoul(argv[++index]));
+        }
+        if (!mapPackPath.empty())
+            menu_service->setMap(mapPackPath, mapIndex);
         menu_service->showMainMenuTask().wait();
+        PLOGI << StartupTimer::getSummary();
         PLOGI << "Stopping Snake";
         return 0;
     }
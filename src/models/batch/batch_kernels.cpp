@@ -0,0 +1,165 @@
+#include "batch_kernels.hpp"
+#include "simd.hpp"
+#include <cstdint>
+
+#if SNAKE_HAS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/**
+ * @brief Checks if the cell bit is set in the game's occupancy grid
+ *
+ */
+static inline bool isOccupied(const BatchKernelInput &input, int32_t game, int32_t cell)
+{
+    return (input.occupancy[game * input.wordsPerGame + (cell >> 5)] >> (cell & 31)) & 1u;
+}
+
+void classifyMovesScalar(const BatchKernelInput &input, const BatchKernelOutput &output)
+{
+    constexpr int32_t DELTA_X[4]{0, 1, 0, -1};
+    constexpr int32_t DELTA_Y[4]{-1, 0, 1, 0};
+
+    for (int32_t block{0}; block < input.count; block += 8)
+    {
+        uint8_t crash{0};
+        uint8_t eat{0};
+        uint8_t move{0};
+        for (int32_t lane{0}; lane < 8; ++lane)
+        {
+            const int32_t game{block + lane};
+            const int32_t nextX{input.headX[game] + DELTA_X[input.directions[game]]};
+            const int32_t nextY{input.headY[game] + DELTA_Y[input.directions[game]]};
+            const bool inBoard{static_cast<uint32_t>(nextX) <= static_cast<uint32_t>(input.width) && static_cast<uint32_t>(nextY) <= static_cast<uint32_t>(input.height)};
+            const int32_t cell{inBoard ? nextY * input.stride + nextX : 0};
+            const bool isApple{inBoard && nextX == input.appleX[game] && nextY == input.appleY[game]};
+            const bool hitSelf{inBoard && !isApple && cell != input.tailCells[game] && isOccupied(input, game, cell)};
+
+            output.nextCells[game] = cell;
+            crash |= static_cast<uint8_t>((!inBoard || hitSelf) << lane);
+            eat |= static_cast<uint8_t>(isApple << lane);
+            move |= static_cast<uint8_t>((inBoard && !isApple && !hitSelf) << lane);
+        }
+        output.crashMask[block / 8] = crash;
+        output.eatMask[block / 8] = eat;
+        output.moveMask[block / 8] = move;
+    }
+}
+
+#if SNAKE_HAS_X86_KERNELS
+
+/**
+ * @brief Multiplies 32 bit lanes keeping the low 32 bits, SSE2 has no _mm_mullo_epi32
+ *
+ */
+static inline __m128i multiplyLow(__m128i first, __m128i second)
+{
+    const __m128i even{_mm_mul_epu32(first, second)};
+    const __m128i odd{_mm_mul_epu32(_mm_srli_si128(first, 4), _mm_srli_si128(second, 4))};
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+void classifyMovesSse2(const BatchKernelInput &input, const BatchKernelOutput &output)
+{
+    const __m128i minusOne{_mm_set1_epi32(-1)};
+    const __m128i widthPlusOne{_mm_set1_epi32(input.width + 1)};
+    const __m128i heightPlusOne{_mm_set1_epi32(input.height + 1)};
+    const __m128i stride{_mm_set1_epi32(input.stride)};
+    const __m128i up{_mm_setzero_si128()};
+    const __m128i right{_mm_set1_epi32(1)};
+    const __m128i down{_mm_set1_epi32(2)};
+    const __m128i left{_mm_set1_epi32(3)};
+
+    for (int32_t block{0}; block < input.count; block += 8)
+    {
+        int crash{0};
+        int eat{0};
+        int move{0};
+        for (int32_t half{0}; half < 8; half += 4)
+        {
+            const int32_t game{block + half};
+            const __m128i headX{_mm_loadu_si128(reinterpret_cast<const __m128i *>(input.headX + game))};
+            const __m128i headY{_mm_loadu_si128(reinterpret_cast<const __m128i *>(input.headY + game))};
+            const __m128i direction{_mm_loadu_si128(reinterpret_cast<const __m128i *>(input.directions + game))};
+
+            // Comparisons produce -1 so the deltas are built by subtracting them
+            const __m128i nextX{_mm_add_epi32(headX, _mm_sub_epi32(_mm_cmpeq_epi32(direction, left), _mm_cmpeq_epi32(direction, right)))};
+            const __m128i nextY{_mm_add_epi32(headY, _mm_sub_epi32(_mm_cmpeq_epi32(direction, up), _mm_cmpeq_epi32(direction, down)))};
+
+            const __m128i inBoard{_mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(nextX, minusOne), _mm_cmpgt_epi32(widthPlusOne, nextX)),
+                                                _mm_and_si128(_mm_cmpgt_epi32(nextY, minusOne), _mm_cmpgt_epi32(heightPlusOne, nextY)))};
+            const __m128i cell{_mm_and_si128(_mm_add_epi32(multiplyLow(nextY, stride), nextX), inBoard)};
+            const __m128i isApple{_mm_and_si128(inBoard, _mm_and_si128(_mm_cmpeq_epi32(nextX, _mm_loadu_si128(reinterpret_cast<const __m128i *>(input.appleX + game))),
+                                                                       _mm_cmpeq_epi32(nextY, _mm_loadu_si128(reinterpret_cast<const __m128i *>(input.appleY + game)))))};
+            const __m128i isTail{_mm_cmpeq_epi32(cell, _mm_loadu_si128(reinterpret_cast<const __m128i *>(input.tailCells + game)))};
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output.nextCells + game), cell);
+
+            // SSE2 has no gather so occupancy is read per game
+            const int inBoardBits{_mm_movemask_ps(_mm_castsi128_ps(inBoard))};
+            const int candidateBits{inBoardBits & ~_mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(isApple, isTail)))};
+            int hitSelfBits{0};
+            for (int32_t lane{0}; lane < 4; ++lane)
+                if ((candidateBits >> lane) & 1 && isOccupied(input, game + lane, output.nextCells[game + lane]))
+                    hitSelfBits |= 1 << lane;
+
+            const int eatBits{_mm_movemask_ps(_mm_castsi128_ps(isApple))};
+            const int crashBits{(~inBoardBits | hitSelfBits) & 0xF};
+            crash |= crashBits << half;
+            eat |= eatBits << half;
+            move |= (inBoardBits & ~eatBits & ~hitSelfBits & 0xF) << half;
+        }
+        output.crashMask[block / 8] = static_cast<uint8_t>(crash);
+        output.eatMask[block / 8] = static_cast<uint8_t>(eat);
+        output.moveMask[block / 8] = static_cast<uint8_t>(move);
+    }
+}
+
+SNAKE_TARGET_AVX2 void classifyMovesAvx2(const BatchKernelInput &input, const BatchKernelOutput &output)
+{
+    const __m256i deltaX{_mm256_setr_epi32(0, 1, 0, -1, 0, 1, 0, -1)};
+    const __m256i deltaY{_mm256_setr_epi32(-1, 0, 1, 0, -1, 0, 1, 0)};
+    const __m256i minusOne{_mm256_set1_epi32(-1)};
+    const __m256i one{_mm256_set1_epi32(1)};
+    const __m256i thirtyOne{_mm256_set1_epi32(31)};
+    const __m256i widthPlusOne{_mm256_set1_epi32(input.width + 1)};
+    const __m256i heightPlusOne{_mm256_set1_epi32(input.height + 1)};
+    const __m256i stride{_mm256_set1_epi32(input.stride)};
+    const __m256i laneOffsets{_mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(input.wordsPerGame))};
+    const auto *occupancy{reinterpret_cast<const int *>(input.occupancy)};
+
+    for (int32_t game{0}; game < input.count; game += 8)
+    {
+        const __m256i headX{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(input.headX + game))};
+        const __m256i headY{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(input.headY + game))};
+        const __m256i direction{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(input.directions + game))};
+
+        // Table driven direction deltas
+        const __m256i nextX{_mm256_add_epi32(headX, _mm256_permutevar8x32_epi32(deltaX, direction))};
+        const __m256i nextY{_mm256_add_epi32(headY, _mm256_permutevar8x32_epi32(deltaY, direction))};
+
+        const __m256i inBoard{_mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(nextX, minusOne), _mm256_cmpgt_epi32(widthPlusOne, nextX)),
+                                               _mm256_and_si256(_mm256_cmpgt_epi32(nextY, minusOne), _mm256_cmpgt_epi32(heightPlusOne, nextY)))};
+        const __m256i cell{_mm256_and_si256(_mm256_add_epi32(_mm256_mullo_epi32(nextY, stride), nextX), inBoard)};
+
+        // Gather the occupancy word of each game, lanes outside the board are not loaded
+        const __m256i wordIndex{_mm256_add_epi32(_mm256_add_epi32(_mm256_set1_epi32(game * input.wordsPerGame), laneOffsets), _mm256_srli_epi32(cell, 5))};
+        const __m256i words{_mm256_mask_i32gather_epi32(_mm256_setzero_si256(), occupancy, wordIndex, inBoard, 4)};
+        const __m256i occupied{_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(cell, thirtyOne)), one), one)};
+
+        const __m256i isApple{_mm256_and_si256(inBoard, _mm256_and_si256(_mm256_cmpeq_epi32(nextX, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input.appleX + game))),
+                                                                         _mm256_cmpeq_epi32(nextY, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input.appleY + game)))))};
+        const __m256i isTail{_mm256_cmpeq_epi32(cell, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input.tailCells + game)))};
+        const __m256i hitSelf{_mm256_andnot_si256(_mm256_or_si256(isTail, isApple), occupied)};
+        const __m256i crash{_mm256_or_si256(_mm256_xor_si256(inBoard, minusOne), hitSelf)};
+        const __m256i move{_mm256_andnot_si256(_mm256_or_si256(crash, isApple), minusOne)};
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output.nextCells + game), cell);
+        output.crashMask[game / 8] = static_cast<uint8_t>(_mm256_movemask_ps(_mm256_castsi256_ps(crash)));
+        output.eatMask[game / 8] = static_cast<uint8_t>(_mm256_movemask_ps(_mm256_castsi256_ps(isApple)));
+        output.moveMask[game / 8] = static_cast<uint8_t>(_mm256_movemask_ps(_mm256_castsi256_ps(move)));
+    }
+}
+
+#endif
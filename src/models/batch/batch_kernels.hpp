@@ -0,0 +1,76 @@
+#ifndef BATCH_KERNELS_H
+#define BATCH_KERNELS_H
+
+#include "simd.hpp"
+#include <cstdint>
+
+/**
+ * @brief The packed state of a batch of games read by the move classification kernels
+ *
+ * @note Every array holds one entry per game and is padded to a multiple of 8 games
+ */
+struct BatchKernelInput
+{
+    const std::int32_t *headX;
+    const std::int32_t *headY;
+    const std::int32_t *directions;
+    const std::int32_t *appleX;
+    const std::int32_t *appleY;
+    const std::int32_t *tailCells;
+
+    /**
+     * @brief The bit packed occupancy grids, wordsPerGame words per game
+     *
+     */
+    const std::uint32_t *occupancy;
+    std::int32_t wordsPerGame;
+
+    std::int32_t width;
+    std::int32_t height;
+    std::int32_t stride;
+
+    /**
+     * @brief The number of games, a multiple of 8
+     *
+     */
+    std::int32_t count;
+};
+
+/**
+ * @brief The result of classifying the next move of every game
+ *
+ * @note Masks hold one bit per game, game i is bit i % 8 of byte i / 8
+ */
+struct BatchKernelOutput
+{
+    std::int32_t *nextCells;
+    std::uint8_t *crashMask;
+    std::uint8_t *eatMask;
+    std::uint8_t *moveMask;
+};
+
+/**
+ * @brief Computes the next head of every game and classifies it as a crash, an apple or a plain move
+ *
+ * @param input The batch state
+ * @param output The next head cells and the outcome masks
+ */
+void classifyMovesScalar(const BatchKernelInput &input, const BatchKernelOutput &output);
+
+#if SNAKE_HAS_X86_KERNELS
+/**
+ * @copydoc classifyMovesScalar
+ *
+ * @note Processes 4 games per instruction, occupancy is tested per game
+ */
+void classifyMovesSse2(const BatchKernelInput &input, const BatchKernelOutput &output);
+
+/**
+ * @copydoc classifyMovesScalar
+ *
+ * @note Processes 8 games per instruction including the occupancy gather
+ */
+void classifyMovesAvx2(const BatchKernelInput &input, const BatchKernelOutput &output);
+#endif
+
+#endif
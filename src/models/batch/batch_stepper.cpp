@@ -0,0 +1,174 @@
+#include "batch_stepper.hpp"
+#include "batch_kernels.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+BatchStepper::BatchStepper(int gameCount, int width, int height, int startingLength, uint32_t seed)
+    : gameCount(gameCount), paddedCount((gameCount + 7) / 8 * 8), width(width), height(height), stride(width + 1),
+      cellCount((width + 1) * (height + 1)), wordsPerGame(((width + 1) * (height + 1) + 31) / 32), startingLength(startingLength),
+      simdLevel(detectSimdLevel())
+{
+    if (gameCount <= 0 || width <= 0 || height <= 0)
+        throw invalid_argument("batch dimensions must be positive");
+    if (startingLength <= 0 || startingLength > width)
+        throw invalid_argument("starting length must fit in the board width");
+
+    // Padding games sit outside the board so they always classify as crashed and are never applied
+    headX.assign(paddedCount, -2);
+    headY.assign(paddedCount, -2);
+    directions.assign(paddedCount, 0);
+    appleX.assign(paddedCount, -1);
+    appleY.assign(paddedCount, -1);
+    tailCells.assign(paddedCount, -1);
+    occupancy.assign(static_cast<size_t>(paddedCount) * wordsPerGame, 0);
+    bodies.assign(static_cast<size_t>(gameCount) * cellCount, 0);
+    bodyStarts.assign(gameCount, 0);
+    bodyLengths.assign(gameCount, 0);
+    appleAreaLengths.assign(gameCount, 0);
+    scores.assign(gameCount, 0);
+    needsReset.assign(gameCount, 0);
+    nextCells.assign(paddedCount, 0);
+    crashMask.assign(paddedCount / 8, 0);
+    eatMask.assign(paddedCount / 8, 0);
+    moveMask.assign(paddedCount / 8, 0);
+    clearMask.assign(paddedCount / 8, 0);
+
+    // Each game draws from its own stream of the seed so games are independent of each other and reproducible
+    randoms.reserve(gameCount);
+    for (int game{0}; game < gameCount; ++game)
+        randoms.emplace_back(seed, static_cast<uint64_t>(game));
+
+    for (int game{0}; game < gameCount; ++game)
+        reset(game);
+}
+
+void BatchStepper::setOccupied(int game, int cell, bool isOccupied)
+{
+    auto &word{occupancy[static_cast<size_t>(game) * wordsPerGame + (cell >> 5)]};
+    if (isOccupied)
+        word |= 1u << (cell & 31);
+    else
+        word &= ~(1u << (cell & 31));
+}
+
+void BatchStepper::pushHead(int game, int x, int y)
+{
+    const int cell{y * stride + x};
+    int index{bodyStarts[game] + bodyLengths[game]};
+    if (index >= cellCount)
+        index -= cellCount;
+    bodies[static_cast<size_t>(game) * cellCount + index] = cell;
+    ++bodyLengths[game];
+    appleAreaLengths[game] += x >= 1 && y >= 1;
+    setOccupied(game, cell, true);
+    headX[game] = x;
+    headY[game] = y;
+}
+
+void BatchStepper::popTail(int game)
+{
+    setOccupied(game, tailCells[game], false);
+    appleAreaLengths[game] -= tailCells[game] % stride >= 1 && tailCells[game] / stride >= 1;
+    if (++bodyStarts[game] == cellCount)
+        bodyStarts[game] = 0;
+    --bodyLengths[game];
+}
+
+void BatchStepper::placeApple(int game)
+{
+    // Apples are placed in the same area as Game::getRandomVacantPoint, once the snake fills it the board is cleared
+    if (appleAreaLengths[game] >= width * height)
+    {
+        appleX[game] = -1;
+        appleY[game] = -1;
+        clearMask[game >> 3] |= static_cast<uint8_t>(1u << (game & 7));
+        needsReset[game] = 1;
+        return;
+    }
+
+    int x;
+    int y;
+    do
+    {
+        x = randoms[game].between(1, width);
+        y = randoms[game].between(1, height);
+    } while (isOccupied(game, y * stride + x));
+    appleX[game] = x;
+    appleY[game] = y;
+}
+
+void BatchStepper::reset(int game)
+{
+    fill_n(occupancy.begin() + static_cast<size_t>(game) * wordsPerGame, wordsPerGame, 0u);
+    bodyStarts[game] = 0;
+    bodyLengths[game] = 0;
+    appleAreaLengths[game] = 0;
+    scores[game] = 0;
+    needsReset[game] = 0;
+    directions[game] = static_cast<int32_t>(Directions::Direction::RIGHT);
+
+    // Matches the snake GameService starts a new game with
+    for (int x{0}; x < startingLength; ++x)
+        pushHead(game, x, height);
+    tailCells[game] = bodies[static_cast<size_t>(game) * cellCount];
+    placeApple(game);
+}
+
+void BatchStepper::step(const Directions::Direction *moves)
+{
+    // Reset games that crashed during the last step and apply the new directions
+    for (int game{0}; game < gameCount; ++game)
+    {
+        if (needsReset[game])
+            reset(game);
+        const auto move{static_cast<int32_t>(moves[game])};
+        if (((directions[game] + 2) & 3) != move)
+            directions[game] = move;
+    }
+
+    // Classify every game in one pass
+    const BatchKernelInput input{headX.data(), headY.data(), directions.data(), appleX.data(), appleY.data(), tailCells.data(),
+                                 occupancy.data(), wordsPerGame, width, height, stride, paddedCount};
+    const BatchKernelOutput output{nextCells.data(), crashMask.data(), eatMask.data(), moveMask.data()};
+    switch (simdLevel)
+    {
+#if SNAKE_HAS_X86_KERNELS
+    case SimdLevel::AVX2:
+        classifyMovesAvx2(input, output);
+        break;
+    case SimdLevel::SSE2:
+        classifyMovesSse2(input, output);
+        break;
+#endif
+    default:
+        classifyMovesScalar(input, output);
+        break;
+    }
+
+    // Apply the moves
+    fill(clearMask.begin(), clearMask.end(), uint8_t{0});
+    for (int game{0}; game < gameCount; ++game)
+    {
+        const int nextX{headX[game] + Directions::DELTA_X[directions[game]]};
+        const int nextY{headY[game] + Directions::DELTA_Y[directions[game]]};
+        if (didMove(game))
+        {
+            popTail(game);
+            pushHead(game, nextX, nextY);
+            tailCells[game] = bodies[static_cast<size_t>(game) * cellCount + bodyStarts[game]];
+        }
+        else if (didEat(game))
+        {
+            pushHead(game, nextX, nextY);
+            scores[game] += APPLE_SCORE;
+            placeApple(game);
+        }
+        else
+        {
+            needsReset[game] = 1;
+        }
+    }
+}
@@ -0,0 +1,191 @@
+#ifndef BATCH_STEPPER_H
+#define BATCH_STEPPER_H
+
+#include "batch_kernels.hpp"
+#include "direction.hpp"
+#include "pcg32.hpp"
+#include "simd.hpp"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Steps many games of the same board size together
+ *
+ * @note The games are stored as packed arrays so a single kernel call classifies the next move of every game.
+ * Games that crashed or filled every cell apples are placed in are reset automatically on the next step.
+ */
+class BatchStepper
+{
+public:
+    /**
+     * @brief The score gained for eating an apple
+     *
+     */
+    constexpr static int APPLE_SCORE{10};
+
+private:
+    int gameCount;
+    int paddedCount;
+    int width;
+    int height;
+    int stride;
+    int cellCount;
+    int wordsPerGame;
+    int startingLength;
+
+    /**
+     * @brief The packed per game state read by the kernels
+     *
+     */
+    std::vector<std::int32_t> headX;
+    std::vector<std::int32_t> headY;
+    std::vector<std::int32_t> directions;
+    std::vector<std::int32_t> appleX;
+    std::vector<std::int32_t> appleY;
+    std::vector<std::int32_t> tailCells;
+    std::vector<std::uint32_t> occupancy;
+
+    /**
+     * @brief The snake bodies as ring buffers of cell indices, cellCount entries per game
+     *
+     */
+    std::vector<std::int32_t> bodies;
+    std::vector<std::int32_t> bodyStarts;
+    std::vector<std::int32_t> bodyLengths;
+
+    /**
+     * @brief The cells of each snake inside the area apples are placed in, the board is cleared once it is full
+     *
+     */
+    std::vector<std::int32_t> appleAreaLengths;
+
+    std::vector<std::int32_t> scores;
+    std::vector<std::uint8_t> needsReset;
+    std::vector<Pcg32> randoms;
+
+    /**
+     * @brief The kernel output of the last step
+     *
+     */
+    std::vector<std::int32_t> nextCells;
+    std::vector<std::uint8_t> crashMask;
+    std::vector<std::uint8_t> eatMask;
+    std::vector<std::uint8_t> moveMask;
+    std::vector<std::uint8_t> clearMask;
+
+    /**
+     * @brief The kernel used to classify moves
+     *
+     */
+    SimdLevel simdLevel;
+
+    void setOccupied(int game, int cell, bool isOccupied);
+    void pushHead(int game, int x, int y);
+    void popTail(int game);
+    void placeApple(int game);
+
+public:
+    /**
+     * @brief Construct a new Batch Stepper object
+     *
+     * @param gameCount The number of games to step together
+     * @param width The width of every board
+     * @param height The height of every board
+     * @param startingLength The initial length of every snake
+     * @param seed The seed for placing apples
+     */
+    BatchStepper(int gameCount, int width, int height, int startingLength, std::uint32_t seed = 1);
+
+    /**
+     * @brief Resets the game to a new snake and apple
+     *
+     * @param game The game index
+     */
+    void reset(int game);
+
+    /**
+     * @brief Steps every game one move
+     *
+     * @param moves The direction to move each game, reversing keeps the current direction
+     */
+    void step(const Directions::Direction *moves);
+
+    /**
+     * @brief Selects the kernel, levels the CPU does not support must not be selected
+     *
+     * @param level The simd level
+     */
+    void setSimdLevel(SimdLevel level) { simdLevel = level; }
+
+    /**
+     * @brief Get the Simd Level object
+     *
+     * @return SimdLevel
+     */
+    SimdLevel getSimdLevel() const { return simdLevel; }
+
+    int getGameCount() const { return gameCount; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getHeadX(int game) const { return headX[game]; }
+    int getHeadY(int game) const { return headY[game]; }
+    int getAppleX(int game) const { return appleX[game]; }
+    int getAppleY(int game) const { return appleY[game]; }
+    int getScore(int game) const { return scores[game]; }
+    int getLength(int game) const { return bodyLengths[game]; }
+    Directions::Direction getDirection(int game) const { return static_cast<Directions::Direction>(directions[game]); }
+    int getTailCell(int game) const { return tailCells[game]; }
+
+    /**
+     * @brief Get a cell of the snake body
+     *
+     * @param game The game index
+     * @param index The segment index counted from the tail
+     * @return int The cell index, y * (width + 1) + x
+     */
+    int getBodyCell(int game, int index) const
+    {
+        const int ringIndex{bodyStarts[game] + index};
+        return bodies[static_cast<std::size_t>(game) * cellCount + (ringIndex >= cellCount ? ringIndex - cellCount : ringIndex)];
+    }
+
+    /**
+     * @brief Checks if the cell of the game is occupied by its snake
+     *
+     * @param game The game index
+     * @param cell The cell index, y * (width + 1) + x
+     */
+    bool isOccupied(int game, int cell) const { return (occupancy[game * wordsPerGame + (cell >> 5)] >> (cell & 31)) & 1u; }
+
+    /**
+     * @brief Whether the game crashed during the last step
+     *
+     */
+    bool didCrash(int game) const { return (crashMask[game >> 3] >> (game & 7)) & 1; }
+
+    /**
+     * @brief Whether the game ate an apple during the last step
+     *
+     */
+    bool didEat(int game) const { return (eatMask[game >> 3] >> (game & 7)) & 1; }
+
+    /**
+     * @brief Whether the game made a plain move during the last step
+     *
+     */
+    bool didMove(int game) const { return (moveMask[game >> 3] >> (game & 7)) & 1; }
+
+    /**
+     * @brief Whether the game ate the last apple that fit during the last step, leaving no cell for another
+     *
+     */
+    bool didClear(int game) const { return (clearMask[game >> 3] >> (game & 7)) & 1; }
+
+    /**
+     * @brief Whether the game ended during the last step, by crashing or clearing the board, it restarts on the next
+     *
+     */
+    bool isDone(int game) const { return didCrash(game) || didClear(game); }
+};
+
+#endif
@@ -0,0 +1,31 @@
+#include "binary_format.hpp"
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+using namespace std;
+
+/**
+ * @brief The CRC-32 lookup table for the reflected polynomial 0xEDB88320
+ *
+ */
+static constexpr array<uint32_t, 256> CRC32_TABLE{[]
+                                                  {
+                                                      array<uint32_t, 256> table{};
+                                                      for (uint32_t index{0}; index < 256; ++index)
+                                                      {
+                                                          uint32_t value{index};
+                                                          for (int bit{0}; bit < 8; ++bit)
+                                                              value = (value >> 1) ^ (value & 1 ? 0xEDB88320u : 0u);
+                                                          table[index] = value;
+                                                      }
+                                                      return table;
+                                                  }()};
+
+uint32_t computeCrc32(string_view bytes)
+{
+    uint32_t crc{0xFFFFFFFFu};
+    for (const auto byte : bytes)
+        crc = CRC32_TABLE[(crc ^ static_cast<uint8_t>(byte)) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
@@ -0,0 +1,46 @@
+#ifndef BINARY_FORMAT_H
+#define BINARY_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Computes the CRC-32 (IEEE) checksum of the bytes
+ *
+ * @param bytes The bytes to check
+ * @return std::uint32_t
+ */
+std::uint32_t computeCrc32(std::string_view bytes);
+
+/**
+ * @brief Reads a little endian number
+ *
+ * @param bytes At least sizeof(T) bytes
+ * @return T
+ */
+template <typename T>
+T readLittle(const char *bytes)
+{
+    std::uint64_t value{0};
+    for (std::size_t index{0}; index < sizeof(T); ++index)
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(bytes[index])) << (8 * index);
+    return static_cast<T>(value);
+}
+
+/**
+ * @brief Appends a little endian number
+ *
+ * @param bytes The bytes to append to
+ * @param number The number
+ */
+template <typename T>
+void appendLittle(std::string &bytes, T number)
+{
+    const auto value{static_cast<std::uint64_t>(number)};
+    for (std::size_t index{0}; index < sizeof(T); ++index)
+        bytes += static_cast<char>((value >> (8 * index)) & 0xff);
+}
+
+#endif
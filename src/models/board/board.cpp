@@ -1,14 +1,35 @@
 #include "board.hpp"
+#include "direction.hpp"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <sstream>
 
 using namespace std;
 
-const string Board::createBoardString()
+Board::Board(int width, int height, BoardTopology topology, span<const uint8_t> obstacles)
+{
+    layout = make_shared<Layout>(Point{width, height}, topology);
+    if (obstacles.empty())
+        return;
+    if (obstacles.size() != static_cast<size_t>(getCellCount()))
+        throw invalid_argument("obstacles must have one byte per cell");
+    layout->obstacles.assign(obstacles.begin(), obstacles.end());
+}
+
+const string Board::createBoardString() const
 {
     // Create stream
     stringstream toReturn;
 
+    // Wrapped edges are drawn dotted because the snake passes through them
+    const Point &bottomRightCorner{layout->bottomRightCorner};
+    const bool isWrapped{layout->topology == BoardTopology::WRAPPED};
+    const char horizontalEdge{isWrapped ? '.' : '-'};
+    const char verticalEdge{isWrapped ? ':' : '|'};
+
     // Iterate through board
     for (int row{-1}; row <= bottomRightCorner.y + 1; row++)
     {
@@ -21,7 +42,7 @@ const string Board::createBoardString()
                 else if (column > bottomRightCorner.x)
                     toReturn << '\\';
                 else
-                    toReturn << '-';
+                    toReturn << horizontalEdge;
             }
             else if (row > bottomRightCorner.y)
             {
@@ -30,12 +51,14 @@ const string Board::createBoardString()
                 else if (column > bottomRightCorner.x)
                     toReturn << '/';
                 else
-                    toReturn << '-';
+                    toReturn << horizontalEdge;
             }
             else if (column < 0 || column > bottomRightCorner.x)
             {
-                toReturn << '|';
+                toReturn << verticalEdge;
             }
+            else if (isObstacle(Point{column, row}))
+                toReturn << '#';
             else
                 toReturn << ' ';
         }
@@ -46,12 +69,54 @@ const string Board::createBoardString()
     return toReturn.str();
 }
 
+void Board::createNeighbours() const
+{
+    const int width{getWidth()};
+    const int height{getHeight()};
+    const bool isWrapped{layout->topology == BoardTopology::WRAPPED};
+    auto &neighbours{layout->neighbours};
+    neighbours.resize(static_cast<size_t>(getCellCount()) * DIRECTION_COUNT);
+
+    // Resolve every move once so stepping needs no bounds checks
+    for (int y{0}; y <= height; ++y)
+    {
+        for (int x{0}; x <= width; ++x)
+        {
+            const Point point{x, y};
+            for (int direction{0}; direction < DIRECTION_COUNT; ++direction)
+            {
+                Point destination{point.getAdjacentPoint(static_cast<Directions::Direction>(direction))};
+                if (isWrapped)
+                    destination = Point{(destination.x + width + 1) % (width + 1), (destination.y + height + 1) % (height + 1)};
+                neighbours[static_cast<size_t>(getCellIndex(point)) * DIRECTION_COUNT + direction] = isInBoard(destination) ? getCellIndex(destination) : getWallCell();
+            }
+        }
+    }
+}
+
 const bool Board::isInBoard(const Point &pointToCheck) const
 {
-    return pointToCheck.x >= 0 && pointToCheck.x <= bottomRightCorner.x && pointToCheck.y >= 0 && pointToCheck.y <= bottomRightCorner.y;
+    const Point &bottomRightCorner{layout->bottomRightCorner};
+    return pointToCheck.x >= 0 && pointToCheck.x <= bottomRightCorner.x && pointToCheck.y >= 0 && pointToCheck.y <= bottomRightCorner.y &&
+           (layout->obstacles.empty() || layout->obstacles[getCellIndex(pointToCheck)] == 0);
+}
+
+bool Board::isObstacle(const Point &pointToCheck) const
+{
+    const Point &bottomRightCorner{layout->bottomRightCorner};
+    return !layout->obstacles.empty() && pointToCheck.x >= 0 && pointToCheck.x <= bottomRightCorner.x && pointToCheck.y >= 0 &&
+           pointToCheck.y <= bottomRightCorner.y && layout->obstacles[getCellIndex(pointToCheck)] != 0;
+}
+
+Point Board::getNeighbour(const Point &point, Directions::Direction direction) const
+{
+    const Point destination{point.getAdjacentPoint(direction)};
+    if (layout->topology == BoardTopology::WALLED)
+        return destination;
+    return Point{(destination.x + getWidth() + 1) % (getWidth() + 1), (destination.y + getHeight() + 1) % (getHeight() + 1)};
 }
 
 const int Board::getIndex(const Point &pointToGetIndexOf) const
 {
-    return ((bottomRightCorner.x + 4) * (pointToGetIndexOf.y + 1)) + (pointToGetIndexOf.x + 1);
-}
\ No newline at end of file
+    return ((layout->bottomRightCorner.x + 4) * (pointToGetIndexOf.y + 1)) + (pointToGetIndexOf.x + 1);
+}
@@ -2,34 +2,93 @@
 #define Board_H
 
 #include "point.hpp"
+#include "direction.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <vector>
+
+/**
+ * @brief What happens when the snake leaves the edge of the board
+ *
+ */
+enum class BoardTopology
+{
+    WALLED,
+    WRAPPED
+};
 
 /**
  * @brief The class representing the board the snake moves through
  *
+ * @note Cells are indexed row by row from Point(0,0) to the bottom right corner. Copies share the layout, so a board
+ * copied for every game of the same map only builds its neighbour table and string once.
  */
 class Board
 {
+public:
+    /**
+     * @brief The number of entries per cell in the neighbour table, one per direction
+     *
+     */
+    constexpr static int DIRECTION_COUNT{4};
+
 private:
     /**
-     * @brief The bottom right corner of the board
+     * @brief The parts of the board that never change, shared between copies
      *
-     * @note The board starts at Point(1,1) and includes the bottomRightCorner
      */
-    const Point bottomRightCorner;
+    struct Layout
+    {
+        /**
+         * @brief The bottom right corner of the board
+         *
+         * @note The board starts at Point(0,0) and includes the bottomRightCorner
+         */
+        Point bottomRightCorner;
+
+        BoardTopology topology;
+
+        /**
+         * @brief 1 for the cells blocked by an obstacle, one byte per cell
+         *
+         */
+        std::vector<std::uint8_t> obstacles;
+
+        /**
+         * @brief The cell reached by moving from each cell in each direction, or the wall cell if the move crashes
+         *
+         * @note Built on the first call to getNeighbours
+         */
+        std::vector<std::int32_t> neighbours;
+        std::once_flag neighboursCreated;
+
+        /**
+         * @brief A string representing the board
+         *
+         * @note Built on the first call to toString
+         */
+        std::string boardString;
+        std::once_flag boardStringCreated;
+    };
+
+    std::shared_ptr<Layout> layout;
 
     /**
      * @brief Create a Board String object
      *
      * @return const std::string
      */
-    const std::string createBoardString();
+    const std::string createBoardString() const;
 
     /**
-     * @brief A string representing the board
+     * @brief Fills the neighbour table with walls and wraparound resolved
      *
      */
-    const std::string boardString{createBoardString()};
+    void createNeighbours() const;
 
 public:
     /**
@@ -37,32 +96,99 @@ public:
      *
      * @return int
      */
-    const int getWidth() const { return bottomRightCorner.x; }
+    const int getWidth() const { return layout->bottomRightCorner.x; }
 
     /**
      * @brief Get the Height object
      *
      * @return int
      */
-    const int getHeight() const { return bottomRightCorner.y; }
+    const int getHeight() const { return layout->bottomRightCorner.y; }
+
+    /**
+     * @brief Get what happens at the edge of the board
+     *
+     * @return BoardTopology
+     */
+    BoardTopology getTopology() const { return layout->topology; }
+
+    /**
+     * @brief Get the number of cells in the board
+     *
+     * @return int
+     */
+    int getCellCount() const { return (getWidth() + 1) * (getHeight() + 1); }
+
+    /**
+     * @brief Get the index of the cell at the point
+     *
+     * @note Does no validation
+     * @param point The point in the board
+     * @return int
+     */
+    int getCellIndex(const Point &point) const { return point.y * (getWidth() + 1) + point.x; }
+
+    /**
+     * @brief Get the index the neighbour table uses for moves that crash, one past the last cell
+     *
+     * @return int
+     */
+    int getWallCell() const { return getCellCount(); }
 
     /**
      * @brief Construct a new Board object
      *
      * @param width The width of the board
      * @param height The height of the board
+     * @param topology What happens when the snake leaves the edge of the board
+     * @note Each board built here lays itself out on first use, copy a board instead to share its layout
+     * @param obstacles One byte per cell, non zero for the cells blocked by an obstacle, empty for none
+     * @throws std::invalid_argument Thrown if the obstacles don't have one byte per cell
      */
-    Board(int width, int height) : bottomRightCorner{width, height} {}
+    Board(int width, int height, BoardTopology topology = BoardTopology::WALLED, std::span<const std::uint8_t> obstacles = {});
 
     /**
-     * @brief Checks to see if the point is within the board boundaries
+     * @brief Checks to see if the point is a cell of the board the snake can move into
      *
      * @param pointToCheck The point to check
-     * @return true if the point is in the board
-     * @return false if the point is not in the board
+     * @return true if the point is in the board and not an obstacle
+     * @return false if the point is outside the board or an obstacle
      */
     const bool isInBoard(const Point &pointToCheck) const;
 
+    /**
+     * @brief Checks to see if the point is blocked by an obstacle
+     *
+     * @param pointToCheck The point to check
+     * @return true if the point is in the board and an obstacle
+     * @return false otherwise
+     */
+    bool isObstacle(const Point &pointToCheck) const;
+
+    /**
+     * @brief Get the point the snake reaches by moving from the point in the direction
+     *
+     * @note Wraps around the edges of a wrapped board, so the result is outside the board or an obstacle only if
+     * the move crashes
+     * @param point A point in the board
+     * @param direction The direction to move
+     * @return Point
+     */
+    Point getNeighbour(const Point &point, Directions::Direction direction) const;
+
+    /**
+     * @brief Get the neighbour table, DIRECTION_COUNT entries per cell indexed by cell * DIRECTION_COUNT + direction
+     *
+     * @note Each entry is the cell reached by the move, or getWallCell() if the move hits a wall or an obstacle
+     * @return const std::int32_t*
+     */
+    const std::int32_t *getNeighbours() const
+    {
+        std::call_once(layout->neighboursCreated, [this]
+                       { createNeighbours(); });
+        return layout->neighbours.data();
+    }
+
     /**
      * @brief Get the index of the point based on the board size
      *
@@ -77,7 +203,12 @@ public:
      *
      * @return const std::string&
      */
-    const std::string &toString() const { return boardString; }
+    const std::string &toString() const
+    {
+        std::call_once(layout->boardStringCreated, [this]
+                       { layout->boardString = createBoardString(); });
+        return layout->boardString;
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,197 @@
+#ifndef BOARD_GEOMETRY_H
+#define BOARD_GEOMETRY_H
+
+#include "point.hpp"
+#include <bitset>
+#include <vector>
+
+/**
+ * @brief Board geometry with the dimensions known at compile time
+ *
+ * @note Cells are indexed row by row, a board includes the cells from Point(0,0) to Point(Width,Height). The
+ * occupancy has one more cell past the board, the wall cell of Board's neighbour table, which is always occupied.
+ * @tparam Width The width of the board
+ * @tparam Height The height of the board
+ */
+template <int Width, int Height>
+struct FixedBoardGeometry
+{
+    /**
+     * @brief The number of cells in a row
+     *
+     */
+    constexpr static int STRIDE{Width + 1};
+
+    /**
+     * @brief The number of cells in the board
+     *
+     */
+    constexpr static int CELL_COUNT{(Width + 1) * (Height + 1)};
+
+    /**
+     * @brief The cells occupied by the snake and the wall cell
+     *
+     */
+    using Occupancy = std::bitset<CELL_COUNT + 1>;
+
+    /**
+     * @brief Get the Width object
+     *
+     * @return int
+     */
+    constexpr static int getWidth() { return Width; }
+
+    /**
+     * @brief Get the Height object
+     *
+     * @return int
+     */
+    constexpr static int getHeight() { return Height; }
+
+    /**
+     * @brief Checks to see if the point is within the board boundaries
+     *
+     * @param pointToCheck The point to check
+     */
+    constexpr static bool isInBoard(const Point &pointToCheck)
+    {
+        return static_cast<unsigned>(pointToCheck.x) <= static_cast<unsigned>(Width) && static_cast<unsigned>(pointToCheck.y) <= static_cast<unsigned>(Height);
+    }
+
+    /**
+     * @brief Get the index of the cell at the point
+     *
+     * @note Does no validation
+     * @param point The point in the board
+     */
+    constexpr static int getCellIndex(const Point &point) { return point.y * STRIDE + point.x; }
+
+    /**
+     * @brief Get the point of the cell
+     *
+     * @param cell The index of a cell in the board
+     */
+    constexpr static Point getCellPoint(int cell) { return Point{cell % STRIDE, cell / STRIDE}; }
+
+    /**
+     * @brief Get the index of the wall cell
+     *
+     */
+    constexpr static int getWallCell() { return CELL_COUNT; }
+
+    /**
+     * @brief Creates an occupancy with only the wall cell occupied
+     *
+     * @return Occupancy
+     */
+    static Occupancy createOccupancy()
+    {
+        Occupancy occupancy{};
+        occupancy[CELL_COUNT] = true;
+        return occupancy;
+    }
+};
+
+/**
+ * @brief Board geometry with the dimensions known at runtime
+ *
+ * @note The generic fallback for board sizes without a FixedBoardGeometry
+ */
+struct DynamicBoardGeometry
+{
+    /**
+     * @brief The cells occupied by the snake and the wall cell
+     *
+     */
+    using Occupancy = std::vector<bool>;
+
+    /**
+     * @brief The width of the board
+     *
+     */
+    int width;
+
+    /**
+     * @brief The height of the board
+     *
+     */
+    int height;
+
+    /**
+     * @brief Get the Width object
+     *
+     * @return int
+     */
+    int getWidth() const { return width; }
+
+    /**
+     * @brief Get the Height object
+     *
+     * @return int
+     */
+    int getHeight() const { return height; }
+
+    /**
+     * @brief Checks to see if the point is within the board boundaries
+     *
+     * @param pointToCheck The point to check
+     */
+    bool isInBoard(const Point &pointToCheck) const
+    {
+        return static_cast<unsigned>(pointToCheck.x) <= static_cast<unsigned>(width) && static_cast<unsigned>(pointToCheck.y) <= static_cast<unsigned>(height);
+    }
+
+    /**
+     * @brief Get the index of the cell at the point
+     *
+     * @note Does no validation
+     * @param point The point in the board
+     */
+    int getCellIndex(const Point &point) const { return point.y * (width + 1) + point.x; }
+
+    /**
+     * @brief Get the point of the cell
+     *
+     * @param cell The index of a cell in the board
+     */
+    Point getCellPoint(int cell) const { return Point{cell % (width + 1), cell / (width + 1)}; }
+
+    /**
+     * @brief Get the index of the wall cell
+     *
+     */
+    int getWallCell() const { return (width + 1) * (height + 1); }
+
+    /**
+     * @brief Creates an occupancy with only the wall cell occupied
+     *
+     * @return Occupancy
+     */
+    Occupancy createOccupancy() const
+    {
+        Occupancy occupancy(static_cast<std::size_t>(getWallCell() + 1));
+        occupancy[getWallCell()] = true;
+        return occupancy;
+    }
+};
+
+/**
+ * @brief Calls the function with the geometry specialized for the board size
+ *
+ * @note Board sizes used by the menus get a FixedBoardGeometry, all others use DynamicBoardGeometry
+ * @param width The width of the board
+ * @param height The height of the board
+ * @param function Called with the geometry
+ * @return The result of the function
+ */
+template <typename Function>
+auto dispatchBoardGeometry(const int width, const int height, Function &&function)
+{
+    if (width == 30 && height == 20)
+        return function(FixedBoardGeometry<30, 20>{});
+    if (width == 50 && height == 30)
+        return function(FixedBoardGeometry<50, 30>{});
+    return function(DynamicBoardGeometry{width, height});
+}
+
+#endif
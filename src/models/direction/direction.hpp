@@ -1,6 +1,8 @@
 #ifndef DIRECTION_H
 #define DIRECTION_H
 
+#include <array>
+
 class Directions
 {
 public:
@@ -12,7 +14,27 @@ public:
         LEFT
     };
 
-    const static bool areOppositeDirections(Direction first, Direction second);
+    /**
+     * @brief The change in x when moving in each direction, indexed by Direction
+     *
+     */
+    constexpr static std::array<int, 4> DELTA_X{0, 1, 0, -1};
+
+    /**
+     * @brief The change in y when moving in each direction, indexed by Direction
+     *
+     */
+    constexpr static std::array<int, 4> DELTA_Y{-1, 0, 1, 0};
+
+    /**
+     * @brief Checks if the directions point opposite ways
+     *
+     * @note Opposite directions are two steps apart in the Direction enum
+     */
+    constexpr static bool areOppositeDirections(Direction first, Direction second)
+    {
+        return ((static_cast<int>(first) + 2) & 3) == static_cast<int>(second);
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
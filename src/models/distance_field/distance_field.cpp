@@ -0,0 +1,223 @@
+#include "distance_field.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+DistanceField::DistanceField(const Board &board, const Snake &snake)
+    : board(board), columns(board.getWidth() + 1), rows(board.getHeight() + 1), wordsPerRow((columns + 63) / 64),
+      isWrapped(board.getTopology() == BoardTopology::WRAPPED)
+{
+    const size_t wordCount{static_cast<size_t>(rows) * wordsPerRow};
+    open.resize(wordCount);
+    grid.resize(wordCount * GRID_LAYERS);
+    emptyRow.resize(static_cast<size_t>(wordsPerRow) * GRID_LAYERS);
+    for (auto &ranges : wordRanges)
+        ranges.resize(static_cast<size_t>(rows));
+    distances.assign(static_cast<size_t>(board.getCellCount()), UNREACHABLE);
+    rebuild(snake);
+}
+
+void DistanceField::setOpen(const Point &point, bool isOpen)
+{
+    const size_t word{static_cast<size_t>(point.y) * wordsPerRow + static_cast<size_t>(point.x / 64)};
+    const uint64_t bit{uint64_t{1} << (point.x % 64)};
+    open[word] = isOpen ? open[word] | bit : open[word] & ~bit;
+}
+
+void DistanceField::rebuild(const Snake &snake)
+{
+    // Every cell but the obstacles is open, then the snake closes its cells
+    fill(open.begin(), open.end(), 0);
+    for (int y{0}; y < rows; ++y)
+        for (int x{0}; x < columns; ++x)
+            if (!board.isObstacle(Point{x, y}))
+                setOpen(Point{x, y}, true);
+    for (const auto &point : snake.getBody())
+        if (board.isInBoard(point))
+            setOpen(point, false);
+
+    const auto &body{snake.getBody()};
+    lastHead = body.back();
+    lastTail = body.front();
+    lastLength = body.size();
+}
+
+void DistanceField::update(const Snake &snake)
+{
+    if (snake.getIsCrashed())
+        return;
+    const auto &body{snake.getBody()};
+    const Point &head{body.back()};
+    const Point &tail{body.front()};
+    if (head == lastHead && tail == lastTail && body.size() == lastLength)
+        return;
+
+    // Anything but one move or growth since the last update is rebuilt from scratch
+    const bool hasMoved{tail != lastTail};
+    const auto isNeighbour = [this](const Point &point, const Point &other)
+    {
+        for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+            if (board.getNeighbour(point, static_cast<Directions::Direction>(direction)) == other)
+                return true;
+        return false;
+    };
+    const bool isOneStep{hasMoved ? body.size() == lastLength && isNeighbour(lastTail, tail) : body.size() == lastLength + 1};
+    if (!isOneStep || body.size() < 2 || body[body.size() - 2] != lastHead || !board.isInBoard(head))
+    {
+        rebuild(snake);
+        return;
+    }
+
+    // The tail leaves before the head arrives, so the head can take the old tail
+    if (hasMoved)
+        setOpen(lastTail, true);
+    setOpen(head, false);
+    lastHead = head;
+    lastTail = tail;
+    lastLength = body.size();
+}
+
+bool DistanceField::expandRow(int row, int32_t distance, size_t &found)
+{
+    // Wrapped boards take the rows above the first and below the last from the other edge
+    const int lastWord{wordsPerRow - 1};
+    const int rowAbove{row > 0 ? row - 1 : (isWrapped ? rows - 1 : -1)};
+    const int rowBelow{row + 1 < rows ? row + 1 : (isWrapped ? 0 : -1)};
+    const size_t currentLayer{static_cast<size_t>(distance - 1) & 1};
+    const size_t nextLayer{currentLayer ^ 1};
+    const auto getRow = [this](int gridRow) { return grid.data() + static_cast<size_t>(gridRow) * wordsPerRow * GRID_LAYERS; };
+    uint64_t *const current{getRow(row)};
+    const uint64_t *const above{rowAbove >= 0 ? getRow(rowAbove) : emptyRow.data()};
+    const uint64_t *const below{rowBelow >= 0 ? getRow(rowBelow) : emptyRow.data()};
+    int32_t *const rowDistances{distances.data() + static_cast<size_t>(row) * columns};
+    const auto getFrontier = [currentLayer](const uint64_t *gridRow, int word) { return gridRow[static_cast<size_t>(word) * GRID_LAYERS + currentLayer]; };
+
+    // Clear what the layer held from two levels ago, then only the words next to the frontier can be reached
+    const WordRange *const currentWords{wordRanges[currentLayer].data()};
+    WordRange &nextRange{wordRanges[nextLayer][static_cast<size_t>(row)]};
+    for (int word{nextRange.first}; word <= nextRange.last; ++word)
+        current[static_cast<size_t>(word) * GRID_LAYERS + nextLayer] = 0;
+    const WordRange &currentRange{currentWords[row]};
+    WordRange range;
+    const auto include = [&range](int first, int last)
+    {
+        range = range.isEmpty() ? WordRange{first, last} : WordRange{min(range.first, first), max(range.last, last)};
+    };
+    if (!currentRange.isEmpty())
+    {
+        // The row's own cells only spill into the next word out if they sit on its edge
+        include(currentRange.first - static_cast<int>(getFrontier(current, currentRange.first) & 1), currentRange.last + static_cast<int>(getFrontier(current, currentRange.last) >> 63));
+        if (isWrapped)
+            include(0, lastWord);
+    }
+    if (rowAbove >= 0 && !currentWords[rowAbove].isEmpty())
+        include(currentWords[rowAbove].first, currentWords[rowAbove].last);
+    if (rowBelow >= 0 && !currentWords[rowBelow].isEmpty())
+        include(currentWords[rowBelow].first, currentWords[rowBelow].last);
+    if (range.isEmpty())
+    {
+        nextRange = WordRange{};
+        return false;
+    }
+    range = {max(range.first, 0), min(range.last, lastWord)};
+
+    // The first and last columns of a wrapped board are neighbours too
+    uint64_t firstWrapped{0};
+    uint64_t lastWrapped{0};
+    if (isWrapped && !currentRange.isEmpty())
+    {
+        const int lastColumnBit{(columns - 1) % 64};
+        firstWrapped = (getFrontier(current, lastWord) >> lastColumnBit) & 1;
+        lastWrapped = (getFrontier(current, 0) & 1) << lastColumnBit;
+    }
+
+    int firstFound{-1};
+    int lastFound{-1};
+    int foundCount{0};
+    for (int word{range.first}; word <= range.last; ++word)
+    {
+        // A cell is reached from the cells left and right of it, carrying bits across words, and above and below
+        const uint64_t middle{getFrontier(current, word)};
+        uint64_t reached{(middle << 1) | (middle >> 1) | getFrontier(above, word) | getFrontier(below, word)};
+        reached |= word > 0 ? getFrontier(current, word - 1) >> 63 : firstWrapped;
+        reached |= word < lastWord ? getFrontier(current, word + 1) << 63 : lastWrapped;
+
+        uint64_t *const cell{current + static_cast<size_t>(word) * GRID_LAYERS};
+        uint64_t newCells{reached & cell[UNVISITED_LAYER]};
+        cell[nextLayer] = newCells;
+        cell[UNVISITED_LAYER] &= ~newCells;
+        foundCount += popcount(newCells);
+        firstFound = firstFound < 0 && newCells != 0 ? word : firstFound;
+        lastFound = newCells != 0 ? word : lastFound;
+        int32_t *const cellDistances{rowDistances + static_cast<size_t>(word) * 64};
+        for (; newCells != 0; newCells &= newCells - 1)
+            cellDistances[countr_zero(newCells)] = distance;
+    }
+    nextRange = firstFound < 0 ? WordRange{} : WordRange{firstFound, lastFound};
+    found += static_cast<size_t>(foundCount);
+    return !nextRange.isEmpty();
+}
+
+size_t DistanceField::compute(const Point &source)
+{
+    if (!board.isInBoard(source))
+        throw invalid_argument("the source must be in the board");
+    fill(distances.begin(), distances.end(), UNREACHABLE);
+    for (size_t word{0}; word < open.size(); ++word)
+    {
+        grid[word * GRID_LAYERS] = 0;
+        grid[word * GRID_LAYERS + 1] = 0;
+        grid[word * GRID_LAYERS + UNVISITED_LAYER] = open[word];
+    }
+    for (auto &ranges : wordRanges)
+        fill(ranges.begin(), ranges.end(), WordRange{});
+
+    // The first level expands the source from layer 0
+    const size_t sourceWord{static_cast<size_t>(source.y) * wordsPerRow + static_cast<size_t>(source.x / 64)};
+    const uint64_t sourceBit{uint64_t{1} << (source.x % 64)};
+    grid[sourceWord * GRID_LAYERS] = sourceBit;
+    grid[sourceWord * GRID_LAYERS + UNVISITED_LAYER] &= ~sourceBit;
+    wordRanges[0][static_cast<size_t>(source.y)] = {source.x / 64, source.x / 64};
+    distances[static_cast<size_t>(board.getCellIndex(source))] = 0;
+    reachedCount = 1;
+
+    // A level only reaches the rows next to the frontier, and must also clear the rows of the level before it in
+    // the layer it reuses. A wrapped board can reach around the edges so expands every row.
+    int frontierFirst{source.y};
+    int frontierLast{source.y};
+    int expandFirst{0};
+    int expandLast{rows - 1};
+    const auto setExpandRange = [&](int newFirst, int newLast)
+    {
+        if (!isWrapped)
+        {
+            expandFirst = max(min(newFirst - 1, frontierFirst), 0);
+            expandLast = min(max(newLast + 1, frontierLast), rows - 1);
+        }
+        frontierFirst = newFirst;
+        frontierLast = newLast;
+    };
+    setExpandRange(source.y, source.y);
+
+    // Expand a level at a time until one finds no cells
+    for (int32_t distance{1};; ++distance)
+    {
+        int newFirst{rows};
+        int newLast{-1};
+        for (int row{expandFirst}; row <= expandLast; ++row)
+            if (expandRow(row, distance, reachedCount))
+            {
+                newFirst = min(newFirst, row);
+                newLast = row;
+            }
+        if (newLast < 0)
+            break;
+        setExpandRange(newFirst, newLast);
+    }
+    return reachedCount;
+}
@@ -0,0 +1,154 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include "board.hpp"
+#include "point.hpp"
+#include "snake.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief The number of moves from a cell to every cell of a board, avoiding the snake and obstacles
+ *
+ * @note The free cells are a bitgrid, one row of 64 bit words per board row, kept up to date as the snake moves.
+ * A breadth first search expands its whole frontier at once: each level shifts the frontier rows left and right
+ * and ORs in the rows above and below, then keeps the open cells not found yet, 64 cells per operation. Only
+ * the words near the frontier are expanded. Distances are indexed like Board::getCellIndex.
+ */
+class DistanceField
+{
+public:
+    /**
+     * @brief The distance of cells the search can't reach
+     *
+     */
+    constexpr static std::int32_t UNREACHABLE{-1};
+
+private:
+    /**
+     * @brief The first and last words of a row holding any cells, first past last if none
+     *
+     */
+    struct WordRange
+    {
+        int first{0};
+        int last{-1};
+
+        bool isEmpty() const { return last < first; }
+    };
+
+    const Board &board;
+    int columns;
+    int rows;
+    int wordsPerRow;
+    bool isWrapped;
+
+    /**
+     * @brief 1 for the cells free of obstacles and the snake, padding bits past the last column are 0
+     *
+     */
+    std::vector<std::uint64_t> open;
+
+    /**
+     * @brief The frontiers of the last level and the level being expanded, alternating between the first two layers
+     * by level, and the open cells not found yet, interleaved by word so a level touches one cache line per word
+     *
+     */
+    constexpr static std::size_t GRID_LAYERS{3};
+    constexpr static std::size_t UNVISITED_LAYER{2};
+    std::vector<std::uint64_t> grid;
+
+    /**
+     * @brief A row of no cells, standing in for the rows past the edges of a walled board
+     *
+     */
+    std::vector<std::uint64_t> emptyRow;
+
+    /**
+     * @brief The words of each row holding cells of each frontier layer, so a level skips the rest of the row
+     *
+     */
+    std::array<std::vector<WordRange>, 2> wordRanges;
+
+    std::vector<std::int32_t> distances;
+    std::size_t reachedCount{0};
+
+    /**
+     * @brief The snake as of the last update
+     *
+     */
+    Point lastHead;
+    Point lastTail;
+    std::size_t lastLength{0};
+
+    /**
+     * @brief Sets or clears the open bit of the point
+     *
+     */
+    void setOpen(const Point &point, bool isOpen);
+
+    /**
+     * @brief Expands the last level's frontier into a row of the next, giving the new cells the distance
+     *
+     * @return true if any cell was found
+     */
+    bool expandRow(int row, std::int32_t distance, std::size_t &found);
+
+public:
+    /**
+     * @brief Construct a new Distance Field object with the snake's cells blocked
+     *
+     * @param board The board, which must outlive the field
+     * @param snake The snake on the board
+     */
+    DistanceField(const Board &board, const Snake &snake);
+
+    /**
+     * @brief Blocks the snake's cells from scratch
+     *
+     * @param snake The snake on the board
+     */
+    void rebuild(const Snake &snake);
+
+    /**
+     * @brief Catches up with the snake
+     *
+     * @note A single move or growth since the last update only touches the head and the freed tail, anything else
+     * rebuilds
+     * @param snake The snake on the board
+     */
+    void update(const Snake &snake);
+
+    /**
+     * @brief Finds the distance from the cell to every cell
+     *
+     * @note The source may be blocked, like the head or the tail, the search starts from it anyway
+     * @param source A point in the board
+     * @return std::size_t The number of cells reached, including the source
+     */
+    std::size_t compute(const Point &source);
+
+    /**
+     * @brief Get the distance found by the last compute
+     *
+     * @param point A point in the board
+     * @return std::int32_t UNREACHABLE if the cell can't be reached
+     */
+    std::int32_t getDistance(const Point &point) const { return distances[static_cast<std::size_t>(board.getCellIndex(point))]; }
+
+    /**
+     * @brief Get the distances found by the last compute, indexed like Board::getCellIndex
+     *
+     */
+    const std::vector<std::int32_t> &getDistances() const { return distances; }
+
+    /**
+     * @brief Get the number of cells reached by the last compute
+     *
+     */
+    std::size_t getReachedCount() const { return reachedCount; }
+};
+
+#endif
@@ -0,0 +1,177 @@
+#include "env_client.hpp"
+#include "env_region.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/**
+ * @brief The width of a latency histogram bucket
+ *
+ */
+constexpr int64_t LATENCY_BUCKET_NANOSECONDS{100};
+
+/**
+ * @brief How often a waiting step checks whether the server left
+ *
+ */
+constexpr chrono::milliseconds POLL_INTERVAL{100};
+
+/**
+ * @brief The longest the server takes to set up the region
+ *
+ */
+constexpr int REGION_TIMEOUT_SECONDS{10};
+
+EnvStepLatency EnvClient::getStepLatency() const
+{
+    EnvStepLatency latency;
+    for (const auto bucket : latencyHistogram)
+        latency.steps += bucket;
+    latency.maxMicroseconds = static_cast<double>(maxLatencyNanoseconds) / 1e3;
+    if (latency.steps == 0)
+        return latency;
+
+    // Report the upper edge of the bucket each percentile falls in
+    const auto percentile = [this, &latency](double fraction)
+    {
+        const auto rank{static_cast<uint64_t>(fraction * static_cast<double>(latency.steps - 1))};
+        uint64_t seen{0};
+        for (size_t index{0}; index < latencyHistogram.size(); ++index)
+        {
+            seen += latencyHistogram[index];
+            if (seen > rank)
+                return min(static_cast<double>((index + 1) * LATENCY_BUCKET_NANOSECONDS) / 1e3, latency.maxMicroseconds);
+        }
+        return latency.maxMicroseconds;
+    };
+    latency.p50Microseconds = percentile(0.50);
+    latency.p99Microseconds = percentile(0.99);
+    return latency;
+}
+
+#if defined(__linux__)
+
+EnvClient::EnvClient(const string &socketPath, const EnvRequest &request)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+        throw runtime_error("invalid socket path " + socketPath);
+    memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    descriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (descriptor < 0)
+        throw runtime_error("unable to create socket: " + string(strerror(errno)));
+    const auto fail = [this](const string &error)
+    {
+        close(descriptor);
+        throw runtime_error(error);
+    };
+    if (connect(descriptor, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+        fail("unable to connect to " + socketPath + ": " + strerror(errno));
+    if (send(descriptor, &request, sizeof(request), MSG_NOSIGNAL) != sizeof(request))
+        fail("unable to send the request: " + string(strerror(errno)));
+
+    // The server answers with a status byte and the region's descriptor
+    const timeval regionTimeout{REGION_TIMEOUT_SECONDS, 0};
+    setsockopt(descriptor, SOL_SOCKET, SO_RCVTIMEO, &regionTimeout, sizeof(regionTimeout));
+    char status{0};
+    iovec payload{&status, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+    msghdr message{};
+    message.msg_iov = &payload;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    if (recvmsg(descriptor, &message, MSG_CMSG_CLOEXEC) != 1 || status != 1)
+        fail("the server rejected the request");
+    const cmsghdr *const rights{CMSG_FIRSTHDR(&message)};
+    if (!rights || rights->cmsg_level != SOL_SOCKET || rights->cmsg_type != SCM_RIGHTS || rights->cmsg_len != CMSG_LEN(sizeof(int)))
+        fail("the server sent no region");
+    int region;
+    memcpy(&region, CMSG_DATA(rights), sizeof(int));
+
+    struct stat regionStatus;
+    void *memory{MAP_FAILED};
+    if (fstat(region, &regionStatus) == 0 && regionStatus.st_size >= static_cast<off_t>(sizeof(EnvRegionHeader)))
+    {
+        regionSize = static_cast<size_t>(regionStatus.st_size);
+        memory = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, region, 0);
+    }
+    close(region);
+    if (memory == MAP_FAILED)
+        fail("unable to map the region");
+
+    // Check the arrays fit in the region before trusting the header
+    header = static_cast<EnvRegionHeader *>(memory);
+    const uint64_t gameCount{header->gameCount};
+    const bool isValid{memcmp(header->magic, ENV_REGION_MAGIC, sizeof(ENV_REGION_MAGIC)) == 0 && header->version == ENV_REGION_VERSION &&
+                       header->regionSize == regionSize && gameCount == request.gameCount && header->width == request.width && header->height == request.height &&
+                       header->actionsOffset + gameCount <= regionSize && header->observationsOffset + gameCount * header->observationSize <= regionSize &&
+                       header->rewardsOffset + gameCount * sizeof(float) <= regionSize && header->rewardsOffset % alignof(float) == 0 && header->donesOffset + gameCount <= regionSize};
+    if (!isValid)
+    {
+        munmap(memory, regionSize);
+        fail("the server sent an invalid region");
+    }
+    auto *const bytes{static_cast<uint8_t *>(memory)};
+    actions = bytes + header->actionsOffset;
+    observations = bytes + header->observationsOffset;
+    rewards = reinterpret_cast<const float *>(bytes + header->rewardsOffset);
+    dones = bytes + header->donesOffset;
+}
+
+EnvClient::~EnvClient()
+{
+    header->isClosed.store(1);
+    ringDoorbell(header->requestSequence);
+    munmap(header, regionSize);
+    close(descriptor);
+}
+
+void EnvClient::step()
+{
+    const uint32_t seen{header->responseSequence.load(memory_order_acquire)};
+    const auto start{chrono::steady_clock::now()};
+    ringDoorbell(header->requestSequence);
+    while (!waitDoorbell(header->responseSequence, seen, POLL_INTERVAL))
+    {
+        // The server leaves without ringing if it stops, and can't if it died
+        pollfd entry{descriptor, POLLIN, 0};
+        if (header->isClosed.load() != 0 || poll(&entry, 1, 0) > 0)
+            throw runtime_error("the environment server stopped");
+    }
+
+    const int64_t nanoseconds{chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()};
+    ++latencyHistogram[min(static_cast<size_t>(nanoseconds / LATENCY_BUCKET_NANOSECONDS), latencyHistogram.size() - 1)];
+    maxLatencyNanoseconds = max(maxLatencyNanoseconds, nanoseconds);
+}
+
+#else
+
+EnvClient::EnvClient(const string &, const EnvRequest &)
+{
+    throw runtime_error("the environment server needs futexes");
+}
+
+EnvClient::~EnvClient() = default;
+void EnvClient::step() {}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef ENV_CLIENT_H
+#define ENV_CLIENT_H
+
+#include "env_region.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief The round trip times of batched steps seen by a client
+ *
+ */
+struct EnvStepLatency
+{
+    std::uint64_t steps{0};
+    double p50Microseconds{0};
+    double p99Microseconds{0};
+    double maxMicroseconds{0};
+};
+
+/**
+ * @brief A batch of games stepped by an environment server in another process
+ *
+ * @note The arrays are the shared region itself, so actions are written and observations read in place. Not
+ * thread safe. Only available on Linux.
+ */
+class EnvClient
+{
+private:
+    int descriptor{-1};
+    EnvRegionHeader *header{nullptr};
+    std::size_t regionSize{0};
+
+    std::uint8_t *actions{nullptr};
+    const std::uint8_t *observations{nullptr};
+    const float *rewards{nullptr};
+    const std::uint8_t *dones{nullptr};
+
+    /**
+     * @brief The number of round trips by each tenth of a microsecond, the last bucket is everything slower
+     *
+     */
+    std::array<std::uint64_t, 10001> latencyHistogram{};
+    std::int64_t maxLatencyNanoseconds{0};
+
+public:
+    /**
+     * @brief Connects to a server and maps the region of a new batch
+     *
+     * @param socketPath The server's socket
+     * @param request The batch to step
+     * @throws std::runtime_error Thrown if the server can't be reached, rejects the batch or sends a bad region
+     */
+    EnvClient(const std::string &socketPath, const EnvRequest &request);
+
+    /**
+     * @brief Destroy the Env Client object, telling the server the batch is done
+     *
+     */
+    ~EnvClient();
+
+    EnvClient(const EnvClient &) = delete;
+    EnvClient &operator=(const EnvClient &) = delete;
+
+    /**
+     * @brief Steps every game with the actions written and waits for the results
+     *
+     * @throws std::runtime_error Thrown if the server stopped
+     */
+    void step();
+
+    int getGameCount() const { return static_cast<int>(header->gameCount); }
+    int getWidth() const { return static_cast<int>(header->width); }
+    int getHeight() const { return static_cast<int>(header->height); }
+    std::size_t getObservationSize() const { return header->observationSize; }
+
+    /**
+     * @brief Get the direction of each game for the next step, 0 up, 1 right, 2 down, 3 left
+     *
+     */
+    std::uint8_t *getActions() { return actions; }
+
+    /**
+     * @brief Get the observations of every game one after another, getObservationSize() values each
+     *
+     */
+    const std::uint8_t *getObservations() const { return observations; }
+
+    /**
+     * @brief Get the reward of each game for the last step
+     *
+     */
+    const float *getRewards() const { return rewards; }
+
+    /**
+     * @brief Get whether each game crashed during the last step, those restart on the next step
+     *
+     */
+    const std::uint8_t *getDones() const { return dones; }
+
+    /**
+     * @brief Get the round trip times of the steps so far
+     *
+     * @return EnvStepLatency
+     */
+    EnvStepLatency getStepLatency() const;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef ENV_REGION_H
+#define ENV_REGION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The bytes starting every environment region
+ *
+ */
+constexpr char ENV_REGION_MAGIC[8]{'S', 'N', 'A', 'K', 'E', 'E', 'N', 'V'};
+constexpr std::uint32_t ENV_REGION_VERSION{1};
+
+/**
+ * @brief The alignment of the arrays of a region, a cache line so the two sides don't share lines needlessly
+ *
+ */
+constexpr std::size_t ENV_REGION_ALIGNMENT{64};
+
+/**
+ * @brief The batch a client asks for when it connects, sent once over the socket in native byte order
+ *
+ */
+struct EnvRequest
+{
+    std::uint32_t gameCount{0};
+    std::uint32_t width{0};
+    std::uint32_t height{0};
+    std::uint32_t startingLength{0};
+    std::uint64_t seed{0};
+};
+
+/**
+ * @brief The start of a shared memory region holding a batch of games
+ *
+ * @note The arrays follow at the offsets from the start of the region. actions holds a direction (0 up, 1 right,
+ * 2 down, 3 left) per game written by the client. observations holds the BatchObservationWriter planes of every
+ * game as uint8_t, rewards holds a float per game (1 for an apple, -1 for a crash, 0 otherwise) and dones holds 1
+ * for the games that crashed or filled the board, which restart on the next step. The client steps by writing actions and ringing
+ * requestSequence, the server steps every game and rings responseSequence once the arrays are written. The
+ * doorbells are futex words, so a step is one wakeup each way and nothing is copied between the processes.
+ */
+struct EnvRegionHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t gameCount;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t observationSize;
+    std::uint32_t reserved;
+    std::uint64_t actionsOffset;
+    std::uint64_t observationsOffset;
+    std::uint64_t rewardsOffset;
+    std::uint64_t donesOffset;
+    std::uint64_t regionSize;
+
+    /**
+     * @brief The number of steps asked for by the client, rung after writing actions
+     *
+     */
+    alignas(ENV_REGION_ALIGNMENT) std::atomic<std::uint32_t> requestSequence;
+
+    /**
+     * @brief The number of steps done by the server, rung after writing observations, rewards and dones
+     *
+     */
+    alignas(ENV_REGION_ALIGNMENT) std::atomic<std::uint32_t> responseSequence;
+
+    /**
+     * @brief Set by the side leaving, the other side stops waiting on the doorbells
+     *
+     */
+    std::atomic<std::uint32_t> isClosed;
+};
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "doorbells must be lock free to be shared between processes");
+
+/**
+ * @brief Rounds the offset up to ENV_REGION_ALIGNMENT
+ *
+ */
+constexpr std::uint64_t alignEnvOffset(std::uint64_t offset) { return (offset + ENV_REGION_ALIGNMENT - 1) / ENV_REGION_ALIGNMENT * ENV_REGION_ALIGNMENT; }
+
+/**
+ * @brief Increments the doorbell and wakes the other side if it is waiting on it
+ *
+ * @note Everything written before ringing is visible to the side that sees the new value
+ * @param doorbell A doorbell of a shared region
+ */
+void ringDoorbell(std::atomic<std::uint32_t> &doorbell);
+
+/**
+ * @brief Waits until the doorbell is rung past the value seen
+ *
+ * @param doorbell A doorbell of a shared region
+ * @param seen The value seen last
+ * @param timeout The longest wait
+ * @return true if the doorbell changed
+ * @return false if the wait timed out
+ */
+bool waitDoorbell(const std::atomic<std::uint32_t> &doorbell, std::uint32_t seen, std::chrono::milliseconds timeout);
+
+#endif
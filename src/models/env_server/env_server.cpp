@@ -0,0 +1,349 @@
+#include "env_server.hpp"
+#include "env_region.hpp"
+#include "batch_stepper.hpp"
+#include "observation.hpp"
+#include "direction.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/**
+ * @brief How often waiting threads check whether the server stopped or the client left
+ *
+ */
+constexpr chrono::milliseconds POLL_INTERVAL{100};
+
+/**
+ * @brief The longest a new client takes to send its request
+ *
+ */
+constexpr int REQUEST_TIMEOUT_SECONDS{5};
+
+/**
+ * @brief The largest region handed to a client
+ *
+ */
+constexpr uint64_t MAX_REGION_SIZE{uint64_t{1} << 32};
+
+/**
+ * @brief A connected client and the thread stepping its games
+ *
+ */
+struct EnvServer::Client
+{
+    const uint64_t id;
+    const int descriptor;
+    thread worker;
+    atomic<bool> isFinished{false};
+
+    Client(uint64_t id, int descriptor) : id(id), descriptor(descriptor) {}
+};
+
+#if defined(__linux__)
+
+/**
+ * @brief Calls the futex operation on a doorbell, which is shared between processes so the operation isn't private
+ *
+ */
+static long callFutex(const atomic<uint32_t> &doorbell, int operation, uint32_t value, const timespec *timeout)
+{
+    return syscall(SYS_futex, reinterpret_cast<const uint32_t *>(&doorbell), operation, value, timeout, nullptr, 0);
+}
+
+void ringDoorbell(atomic<uint32_t> &doorbell)
+{
+    doorbell.fetch_add(1, memory_order_release);
+    callFutex(doorbell, FUTEX_WAKE, INT_MAX, nullptr);
+}
+
+bool waitDoorbell(const atomic<uint32_t> &doorbell, uint32_t seen, chrono::milliseconds timeout)
+{
+    const auto deadline{chrono::steady_clock::now() + timeout};
+    while (doorbell.load(memory_order_acquire) == seen)
+    {
+        // The kernel only sleeps while the word still holds the value seen, so a ring can't be missed
+        const auto remaining{chrono::duration_cast<chrono::nanoseconds>(deadline - chrono::steady_clock::now())};
+        if (remaining.count() <= 0)
+            return false;
+        const timespec relative{static_cast<time_t>(remaining.count() / 1'000'000'000), static_cast<long>(remaining.count() % 1'000'000'000)};
+        callFutex(doorbell, FUTEX_WAIT, seen, &relative);
+    }
+    return true;
+}
+
+/**
+ * @brief Checks if the peer of a socket that receives nothing after connecting has closed it
+ *
+ */
+static bool isPeerClosed(int descriptor)
+{
+    pollfd entry{descriptor, POLLIN, 0};
+    if (poll(&entry, 1, 0) <= 0)
+        return false;
+    char byte;
+    return recv(descriptor, &byte, 1, MSG_PEEK | MSG_DONTWAIT) <= 0;
+}
+
+EnvServer::EnvServer(EnvServerOptions options) : options(std::move(options))
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (this->options.socketPath.empty() || this->options.socketPath.size() >= sizeof(address.sun_path))
+        throw runtime_error("invalid socket path " + this->options.socketPath);
+    memcpy(address.sun_path, this->options.socketPath.c_str(), this->options.socketPath.size() + 1);
+
+    // Replace a socket left behind by a server that didn't shut down, but never another kind of file
+    struct stat status;
+    if (stat(this->options.socketPath.c_str(), &status) == 0)
+    {
+        if (!S_ISSOCK(status.st_mode))
+            throw runtime_error(this->options.socketPath + " exists and is not a socket");
+        unlink(this->options.socketPath.c_str());
+    }
+
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+        throw runtime_error("unable to create socket: " + string(strerror(errno)));
+    if (bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0)
+    {
+        const string error{strerror(errno)};
+        close(listener);
+        throw runtime_error("unable to listen on " + this->options.socketPath + ": " + error);
+    }
+}
+
+EnvServer::~EnvServer()
+{
+    isStopRequested.store(true);
+    reapClients(true);
+    close(listener);
+    unlink(options.socketPath.c_str());
+}
+
+void EnvServer::run()
+{
+    while (!isStopRequested.load())
+    {
+        pollfd entry{listener, POLLIN, 0};
+        if (poll(&entry, 1, static_cast<int>(POLL_INTERVAL.count())) > 0)
+            acceptClients();
+        reapClients(false);
+    }
+
+    // The client threads see the stop request at their next wakeup
+    reapClients(true);
+    isStopRequested.store(false);
+}
+
+void EnvServer::acceptClients()
+{
+    const int descriptor{accept4(listener, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK)};
+    if (descriptor < 0)
+        return;
+    if (clients.size() >= options.maxClients)
+    {
+        close(descriptor);
+        rejectedCount.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+
+    // The client's thread owns the socket until it finishes
+    fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL) & ~O_NONBLOCK);
+    auto &client{*clients.emplace_back(make_unique<Client>(nextClientId++, descriptor))};
+    client.worker = thread(&EnvServer::serveClient, this, ref(client));
+    clientCount.store(clients.size(), memory_order_relaxed);
+}
+
+void EnvServer::reapClients(bool isStopping)
+{
+    erase_if(clients, [isStopping](const unique_ptr<Client> &client)
+             {
+                 if (!isStopping && !client->isFinished.load())
+                     return false;
+                 client->worker.join();
+                 return true; });
+    clientCount.store(clients.size(), memory_order_relaxed);
+}
+
+void EnvServer::serveClient(Client &client)
+{
+    // Close the socket and mark the client finished however serving ends
+    const auto finish = [this, &client](bool isRejected)
+    {
+        if (isRejected)
+            rejectedCount.fetch_add(1, memory_order_relaxed);
+        close(client.descriptor);
+        client.isFinished.store(true);
+    };
+
+    // A client that doesn't send its whole request in time is dropped
+    EnvRequest request;
+    const timeval requestTimeout{REQUEST_TIMEOUT_SECONDS, 0};
+    setsockopt(client.descriptor, SOL_SOCKET, SO_RCVTIMEO, &requestTimeout, sizeof(requestTimeout));
+    if (recv(client.descriptor, &request, sizeof(request), MSG_WAITALL) != sizeof(request))
+        return finish(true);
+
+    // Lay out the arrays after the header
+    const uint64_t observationSize{(static_cast<uint64_t>(request.width) + 1) * (static_cast<uint64_t>(request.height) + 1) * ObservationWriter(1, 1).getPlaneCount()};
+    const uint64_t actionsOffset{alignEnvOffset(sizeof(EnvRegionHeader))};
+    const uint64_t observationsOffset{alignEnvOffset(actionsOffset + request.gameCount)};
+    const uint64_t rewardsOffset{alignEnvOffset(observationsOffset + request.gameCount * observationSize)};
+    const uint64_t donesOffset{alignEnvOffset(rewardsOffset + request.gameCount * sizeof(float))};
+    const uint64_t regionSize{alignEnvOffset(donesOffset + request.gameCount)};
+    const bool isValid{request.gameCount > 0 && request.gameCount <= options.maxGameCount && request.width > 0 && request.width <= options.maxSide &&
+                       request.height > 0 && request.height <= options.maxSide && request.startingLength > 0 && request.startingLength <= request.width &&
+                       regionSize <= MAX_REGION_SIZE};
+    if (!isValid)
+    {
+        const char status{0};
+        send(client.descriptor, &status, 1, MSG_NOSIGNAL);
+        return finish(true);
+    }
+
+    // Unlink the region right away so only the descriptor reaches it and it can't be left behind
+    const string name{"/snake-env-" + to_string(getpid()) + "-" + to_string(client.id)};
+    const int region{shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600)};
+    if (region < 0)
+        return finish(true);
+    shm_unlink(name.c_str());
+    void *memory{ftruncate(region, static_cast<off_t>(regionSize)) == 0 ? mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, region, 0) : MAP_FAILED};
+    if (memory == MAP_FAILED)
+    {
+        close(region);
+        return finish(true);
+    }
+    auto *const bytes{static_cast<uint8_t *>(memory)};
+
+    BatchStepper batch(static_cast<int>(request.gameCount), static_cast<int>(request.width), static_cast<int>(request.height), static_cast<int>(request.startingLength), static_cast<uint32_t>(request.seed));
+    BatchObservationWriter writer(batch);
+    auto *const header{new (memory) EnvRegionHeader{}};
+    memcpy(header->magic, ENV_REGION_MAGIC, sizeof(ENV_REGION_MAGIC));
+    header->version = ENV_REGION_VERSION;
+    header->gameCount = request.gameCount;
+    header->width = request.width;
+    header->height = request.height;
+    header->observationSize = static_cast<uint32_t>(writer.getObservationSize());
+    header->actionsOffset = actionsOffset;
+    header->observationsOffset = observationsOffset;
+    header->rewardsOffset = rewardsOffset;
+    header->donesOffset = donesOffset;
+    header->regionSize = regionSize;
+    uint8_t *const actions{bytes + actionsOffset};
+    uint8_t *const observations{bytes + observationsOffset};
+    auto *const rewards{reinterpret_cast<float *>(bytes + rewardsOffset)};
+    uint8_t *const dones{bytes + donesOffset};
+    for (int game{0}; game < batch.getGameCount(); ++game)
+        actions[game] = static_cast<uint8_t>(batch.getDirection(game));
+    writer.write(batch, observations);
+
+    // Pass the region with a status byte, the client maps it itself
+    const char status{1};
+    iovec payload{const_cast<char *>(&status), 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+    msghdr message{};
+    message.msg_iov = &payload;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr *const rights{CMSG_FIRSTHDR(&message)};
+    rights->cmsg_level = SOL_SOCKET;
+    rights->cmsg_type = SCM_RIGHTS;
+    rights->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(rights), &region, sizeof(int));
+    const bool isSent{sendmsg(client.descriptor, &message, MSG_NOSIGNAL) == 1};
+    close(region);
+
+    // Step on each ring until the client leaves or the server stops
+    vector<Directions::Direction> moves(batch.getGameCount());
+    // The client can ring as soon as it has the region, so the count starts from the fresh header
+    uint32_t seen{0};
+    while (isSent && !isStopRequested.load(memory_order_relaxed))
+    {
+        if (!waitDoorbell(header->requestSequence, seen, POLL_INTERVAL))
+        {
+            if (header->isClosed.load() != 0 || isPeerClosed(client.descriptor))
+                break;
+            continue;
+        }
+        seen = header->requestSequence.load(memory_order_acquire);
+        if (header->isClosed.load() != 0)
+            break;
+
+        for (int game{0}; game < batch.getGameCount(); ++game)
+            moves[game] = static_cast<Directions::Direction>(actions[game] & 3);
+        batch.step(moves.data());
+        writer.update(batch, observations);
+        for (int game{0}; game < batch.getGameCount(); ++game)
+        {
+            rewards[game] = batch.didEat(game) ? 1.0F : batch.didCrash(game) ? -1.0F : 0.0F;
+            dones[game] = batch.isDone(game) ? 1 : 0;
+        }
+        ringDoorbell(header->responseSequence);
+        stepCount.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Tell a client still waiting that no more steps are coming
+    header->isClosed.store(1);
+    callFutex(header->responseSequence, FUTEX_WAKE, INT_MAX, nullptr);
+    munmap(memory, regionSize);
+    finish(!isSent);
+}
+
+#else
+
+void ringDoorbell(atomic<uint32_t> &doorbell)
+{
+    doorbell.fetch_add(1, memory_order_release);
+}
+
+bool waitDoorbell(const atomic<uint32_t> &doorbell, uint32_t seen, chrono::milliseconds timeout)
+{
+    const auto deadline{chrono::steady_clock::now() + timeout};
+    while (doorbell.load(memory_order_acquire) == seen)
+    {
+        if (chrono::steady_clock::now() >= deadline)
+            return false;
+        this_thread::yield();
+    }
+    return true;
+}
+
+EnvServer::EnvServer(EnvServerOptions options) : options(std::move(options))
+{
+    throw runtime_error("the environment server needs futexes");
+}
+
+EnvServer::~EnvServer() = default;
+void EnvServer::run() {}
+void EnvServer::acceptClients() {}
+void EnvServer::reapClients(bool) {}
+void EnvServer::serveClient(Client &) {}
+
+#endif
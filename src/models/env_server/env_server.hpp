@@ -0,0 +1,142 @@
+#ifndef ENV_SERVER_H
+#define ENV_SERVER_H
+
+#include "env_region.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The settings of an environment server
+ *
+ */
+struct EnvServerOptions
+{
+    /**
+     * @brief The path of the unix socket clients connect to
+     *
+     */
+    std::string socketPath;
+
+    /**
+     * @brief The most clients connected at once, later connections are closed
+     *
+     */
+    std::size_t maxClients{64};
+
+    /**
+     * @brief The most games a client can ask for
+     *
+     */
+    std::uint32_t maxGameCount{65536};
+
+    /**
+     * @brief The largest board width and height a client can ask for
+     *
+     */
+    std::uint32_t maxSide{256};
+};
+
+/**
+ * @brief Steps batches of games for trainers in other processes through shared memory
+ *
+ * @note Clients connect to a unix socket and send an EnvRequest. Each gets its own POSIX shared memory region laid
+ * out as described by EnvRegionHeader, passed back as a descriptor over the socket, and its own thread stepping a
+ * BatchStepper straight into the region. The region is unlinked as soon as it is created, so it is only reachable
+ * through the descriptor and goes away with the last process mapping it. Only available on Linux, where the
+ * doorbells are futexes.
+ */
+class EnvServer
+{
+private:
+    struct Client;
+
+    EnvServerOptions options;
+    int listener{-1};
+    std::atomic<bool> isStopRequested{false};
+
+    /**
+     * @brief The connected clients, only used by the thread running the server
+     *
+     */
+    std::vector<std::unique_ptr<Client>> clients;
+    std::uint64_t nextClientId{1};
+
+    std::atomic<std::size_t> clientCount{0};
+    std::atomic<std::uint64_t> stepCount{0};
+    std::atomic<std::uint64_t> rejectedCount{0};
+
+    /**
+     * @brief Accepts waiting connections and starts their threads
+     *
+     */
+    void acceptClients();
+
+    /**
+     * @brief Joins the threads of the clients that left
+     *
+     */
+    void reapClients(bool isStopping);
+
+    /**
+     * @brief Sets up the client's region and steps its games until it leaves or the server stops
+     *
+     */
+    void serveClient(Client &client);
+
+public:
+    /**
+     * @brief Construct a new Env Server object listening on the socket
+     *
+     * @param options The server settings
+     * @throws std::runtime_error Thrown if the socket can't be created or the system has no futexes
+     */
+    explicit EnvServer(EnvServerOptions options);
+
+    /**
+     * @brief Destroy the Env Server object, disconnecting every client
+     *
+     */
+    ~EnvServer();
+
+    EnvServer(const EnvServer &) = delete;
+    EnvServer &operator=(const EnvServer &) = delete;
+
+    /**
+     * @brief Runs the server on the calling thread until stop is requested
+     *
+     */
+    void run();
+
+    /**
+     * @brief Makes run return
+     *
+     * @note Safe to call from any thread and from signal handlers
+     */
+    void requestStop() noexcept { isStopRequested.store(true); }
+
+    /**
+     * @brief Get the number of connected clients
+     *
+     */
+    std::size_t getClientCount() const { return clientCount.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the number of batched steps served since the server started
+     *
+     */
+    std::uint64_t getStepCount() const { return stepCount.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the number of connections closed for an invalid request or over the client limit
+     *
+     */
+    std::uint64_t getRejectedCount() const { return rejectedCount.load(std::memory_order_relaxed); }
+};
+
+#endif
@@ -1,34 +1,145 @@
 #include "game.hpp"
-#include "utility.hpp"
+#include <algorithm>
+#include <charconv>
+#include <iterator>
 #include <string>
-#include <regex>
+#include <string_view>
 #include <vector>
 #include <stdexcept>
+#include <memory>
 
 using namespace std;
 
-void Game::setMessage(const string &message)
+/**
+ * @brief The characters a message is sized for at least, regardless of the board size
+ *
+ */
+constexpr size_t MIN_MESSAGE_CAPACITY{256};
+
+/**
+ * @brief The characters needed to print any score
+ *
+ */
+constexpr size_t SCORE_DIGITS{12};
+
+/**
+ * @brief The most digits of a rank, and the most characters the rank adds to the score header
+ *
+ */
+constexpr size_t RANK_DIGITS{20};
+constexpr size_t RANK_CAPACITY{14 + 2 * RANK_DIGITS};
+
+/**
+ * @brief Finds the longest message line starting at the position
+ *
+ * @note A line is at most maxLength characters that aren't newlines, followed by a space, a newline or the end of
+ * the message. The space or newline is part of the line.
+ * @param message The message
+ * @param start The index the line starts at
+ * @param maxLength The most characters before the space or newline
+ * @param allowEmpty Whether a line with no characters matches
+ * @param lineLength Set to the length of the line found
+ * @return true if a line starts at the position
+ */
+static bool findLineAt(string_view message, size_t start, size_t maxLength, bool allowEmpty, size_t &lineLength)
 {
-    // Clear current matches
-    matches.clear();
+    const size_t newline{message.find('\n', start)};
+    const size_t available{min(maxLength, (newline == string_view::npos ? message.size() : newline) - start)};
 
-    // Regex to limit message segments to 2/3 width of board, segments do not split words
-    const sregex_iterator start = sregex_iterator(message.begin(), message.end(), messageSplitterRegex);
-    const sregex_iterator end = sregex_iterator();
+    // Try the longest line first, shortening it until it ends on a space, a newline or the end
+    for (size_t length{available + 1}; length-- > 0;)
+    {
+        const size_t end{start + length};
+        if (end == message.size())
+        {
+            if (length == 0 && !allowEmpty)
+                return false;
+            lineLength = length;
+            return true;
+        }
+        if (message[end] == '\n' || message[end] == ' ')
+        {
+            lineLength = length + 1;
+            return true;
+        }
+    }
+    return false;
+}
 
-    // Collect string matches
-    for (sregex_iterator match = start; match != end; ++match)
-        matches.push_back(match->str());
+void Game::setMessage(string_view message)
+{
+    // Clear current lines
+    messageLines.clear();
 
-    // Assign message
-    this->message = message;
+    // Empty messages have nothing to split
+    if (message.empty())
+    {
+        this->message.clear();
+        return;
+    }
+
+    // Assign message, the lines index into it
+    this->message.assign(message);
+    message = this->message;
+
+    // Limit lines to 2/3 width of board, lines do not split words. The lines are the matches the regex
+    // [^\n]{0,maxLength}(?:\n|\ |$) finds when searched for repeatedly, including the empty ones
+    const size_t maxLength{static_cast<size_t>(board->getWidth() * 2.0 / 3.0)};
+    size_t position{0};
+    bool lastWasEmpty{false};
+    while (position <= message.size())
+    {
+        bool found{false};
+        size_t length{0};
+
+        // After an empty line, an empty line can't be found at the same position again
+        if (lastWasEmpty)
+        {
+            found = findLineAt(message, position, maxLength, false, length);
+            if (!found && position++ == message.size())
+                break;
+        }
+
+        // Search forward for the next line
+        while (!found && position <= message.size())
+        {
+            found = findLineAt(message, position, maxLength, true, length);
+            if (!found)
+                ++position;
+        }
+        if (!found)
+            break;
+
+        messageLines.push_back(MessageLine{position, length});
+        lastWasEmpty = length == 0;
+        position += length;
+    }
+}
+
+void Game::reserve()
+{
+    // Null check
+    if (!snake || !board)
+        throw invalid_argument("snake or board is null");
+
+    // The snake can grow to cover every cell
+    const size_t cellCount{static_cast<size_t>(board->getWidth() + 1) * static_cast<size_t>(board->getHeight() + 1)};
+    snake->reserve(cellCount + 1);
+
+    // Messages longer than the board can't be displayed anyway, lines are never more than the characters plus one
+    const size_t messageCapacity{max(cellCount, MIN_MESSAGE_CAPACITY)};
+    message.reserve(messageCapacity);
+    messageLines.reserve(messageCapacity + 1);
+
+    // The frame is the score header with the rank and the board
+    gameAsString.reserve(SCORE_DIGITS + 8 + RANK_CAPACITY + board->toString().size());
 }
 
 const bool Game::isGameOver() const
 {
     if (!snake)
         throw invalid_argument("snake is null");
-    return snake->getIsCrashed();
+    return snake->getIsCrashed() || isCleared;
 }
 
 const Point Game::getRandomVacantPoint() const
@@ -37,14 +148,13 @@ const Point Game::getRandomVacantPoint() const
     if (!board)
         throw invalid_argument("board is null");
 
-    // Get a new location not in the snake
+    // Get a new location not in the snake or an obstacle
     Point newPoint;
     do
     {
-        uniform_int_distribution getX{1, board->getWidth()};
-        uniform_int_distribution getY{1, board->getHeight()};
-        newPoint = Point{getX(Utility::getRandom()), getY(Utility::getRandom())};
-    } while (snake->isInSnake(newPoint));
+        const int x{random.between(1, board->getWidth())};
+        newPoint = Point{x, random.between(1, board->getHeight())};
+    } while (snake->isInSnake(newPoint) || board->isObstacle(newPoint));
 
     // Return the new point
     return newPoint;
@@ -56,8 +166,20 @@ const string &Game::toString()
     if (!snake || !board)
         throw invalid_argument("snake or board is null");
 
-    // Start with the score header
-    gameAsString = "Score: " + to_string(score) + '\n';
+    // Start with the score header, written in place so reserved frames are reused
+    char scoreDigits[SCORE_DIGITS];
+    const auto scoreEnd{to_chars(begin(scoreDigits), end(scoreDigits), score).ptr};
+    gameAsString.assign("Score: ");
+    gameAsString.append(scoreDigits, scoreEnd);
+    if (rank > 0)
+    {
+        char rankDigits[RANK_DIGITS];
+        gameAsString += "   Rank: #";
+        gameAsString.append(rankDigits, to_chars(begin(rankDigits), end(rankDigits), rank).ptr);
+        gameAsString += " of ";
+        gameAsString.append(rankDigits, to_chars(begin(rankDigits), end(rankDigits), rankedCount).ptr);
+    }
+    gameAsString += '\n';
 
     // Get length of string while it has just the score header
     short prefixLength{static_cast<short>(gameAsString.length())};
@@ -69,23 +191,24 @@ const string &Game::toString()
     gameAsString[board->getIndex(apple) + prefixLength] = '@';
 
     // Add snake segments
-    for (auto segment : snake->getBody())
+    for (const auto &segment : snake->getBody())
         gameAsString[board->getIndex(segment) + prefixLength] = '*';
 
     // Replace the snake head segment with appropriate direction or X char
-    gameAsString[board->getIndex(snake->getHead()) + prefixLength] = isGameOver() ? 'X' : snake->getDirectionAsChar();
+    gameAsString[board->getIndex(snake->getHead()) + prefixLength] = snake->getIsCrashed() ? 'X' : snake->getDirectionAsChar();
 
-    // Overwrite matches into board if a message exists
-    for (int index{0}; index < matches.size(); ++index)
+    // Overwrite message lines into board if a message exists
+    for (int index{0}; index < static_cast<int>(messageLines.size()); ++index)
     {
-        // Get match specific information
-        const int matchLength{static_cast<int>(matches[index].length())};
-        const Point matchStart{(board->getWidth() - matchLength + 1) / 2, (board->getHeight() / 5) + index};
-        const bool matchEndsWithNewline{matches[index][matches[index].length() - 1] == '\n'};
+        // Get line specific information
+        const string_view line{string_view{message}.substr(messageLines[index].start, messageLines[index].length)};
+        const int lineLength{static_cast<int>(line.length())};
+        const Point lineStart{(board->getWidth() - lineLength + 1) / 2, (board->getHeight() / 5) + index};
+        const bool lineEndsWithNewline{!line.empty() && line.back() == '\n'};
 
         // Add each character skipping the \n character
-        for (int matchIndex{0}; matchIndex < (matchEndsWithNewline ? matchLength - 1 : matchLength); ++matchIndex)
-            gameAsString[board->getIndex(matchStart) + matchIndex + prefixLength] = matches[index][matchIndex];
+        for (int lineIndex{0}; lineIndex < (lineEndsWithNewline ? lineLength - 1 : lineLength); ++lineIndex)
+            gameAsString[board->getIndex(lineStart) + lineIndex + prefixLength] = line[lineIndex];
     }
 
     // Return generated string reference
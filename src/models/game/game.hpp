@@ -4,10 +4,14 @@
 #include "point.hpp"
 #include "snake.hpp"
 #include "board.hpp"
+#include "pcg32.hpp"
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <memory>
-#include <regex>
+#include <cstdint>
+#include <random>
 #include <vector>
 
 /**
@@ -33,6 +37,14 @@ private:
      */
     int score{0};
 
+    /**
+     * @brief The rank of the score among the saved scores of the same board and speed, shown after the score, 0
+     * to show none
+     *
+     */
+    std::size_t rank{0};
+    std::size_t rankedCount{0};
+
     /**
      * @brief The snake playing the game
      *
@@ -45,6 +57,18 @@ private:
      */
     std::unique_ptr<Board> board;
 
+    /**
+     * @brief The seed the random number generator started from, so the game can be played again
+     *
+     */
+    std::uint32_t seed;
+
+    /**
+     * @brief The random number generator for placing apples, owned by the game so games never share one
+     *
+     */
+    mutable Pcg32 random;
+
     /**
      * @brief The apple the snake is after
      *
@@ -52,10 +76,29 @@ private:
     Point apple;
 
     /**
-     * @brief Regex for splitting message
+     * @brief Whether the snake filled every cell an apple can be placed in, which ends the game
+     *
+     */
+    bool isCleared{false};
+
+    /**
+     * @brief A line of the message
      *
      */
-    const std::regex messageSplitterRegex{"[^\\n]{0," + std::to_string(static_cast<int>(board->getWidth() * 2.0 / 3.0)) + "}(?:\\n|\\ |$)"};
+    struct MessageLine
+    {
+        /**
+         * @brief The index of the first character in the message
+         *
+         */
+        std::size_t start;
+
+        /**
+         * @brief The number of characters including the space or newline that ended the line
+         *
+         */
+        std::size_t length;
+    };
 
     /**
      * @brief A message for the player
@@ -65,10 +108,10 @@ private:
     std::string message{};
 
     /**
-     * @brief Message split into lines based on board width using messageSplitterRegex
+     * @brief Message split into lines of at most 2/3 of the board width
      *
      */
-    std::vector<std::string> matches;
+    std::vector<MessageLine> messageLines;
 
     /**
      * @brief The game as a string
@@ -144,6 +187,24 @@ public:
      */
     void setScore(const int score) { this->score = score; }
 
+    /**
+     * @brief Set the rank shown after the score
+     *
+     * @param rank The rank, 1 for the best, 0 to show none
+     * @param rankedCount The number of scores ranked, including this game's
+     */
+    void setRank(std::size_t rank, std::size_t rankedCount)
+    {
+        this->rank = rank;
+        this->rankedCount = rankedCount;
+    }
+
+    /**
+     * @brief Get the rank shown after the score, 0 if none is shown
+     *
+     */
+    std::size_t getRank() const { return rank; }
+
     /**
      * @brief Set the player's name
      *
@@ -166,18 +227,37 @@ public:
      *
      * @param message
      */
-    void setMessage(const std::string &message);
+    void setMessage(std::string_view message);
+
+    /**
+     * @brief Get the Message object
+     *
+     * @return const std::string&
+     */
+    const std::string &getMessage() const { return message; }
 
     /**
      * @brief Returns whether or not the game is over
      *
-     * @note The game is over when a crash point is set
+     * @note The game is over when a crash point is set or the board is cleared
      *
-     * @return true if there is a crash point
-     * @return false if crash point is still unset
+     * @return true if there is a crash point or no apple can be placed
+     * @return false if the game goes on
      */
     const bool isGameOver() const;
 
+    /**
+     * @brief Returns whether the snake filled every cell an apple can be placed in
+     *
+     */
+    bool getIsCleared() const { return isCleared; }
+
+    /**
+     * @brief Set whether the board is cleared, done by the stepper eating the last apple or taking it back
+     *
+     */
+    void setIsCleared(bool isCleared) { this->isCleared = isCleared; }
+
     /**
      * @brief Gets a random vacant point in the board
      *
@@ -185,6 +265,27 @@ public:
      */
     const Point getRandomVacantPoint() const;
 
+    /**
+     * @brief Get the game's random number generator, for random moves that should follow the game's seed
+     *
+     * @return Pcg32&
+     */
+    Pcg32 &getRandom() const { return random; }
+
+    /**
+     * @brief Get the seed the game's random number generator started from
+     *
+     */
+    std::uint32_t getSeed() const { return seed; }
+
+    /**
+     * @brief Sizes the snake, message and frame storage from the board dimensions
+     *
+     * @note Once reserved, moving the snake, setting messages that fit the board and building the frame don't
+     * allocate
+     */
+    void reserve();
+
     /**
      * @brief Returns a string representation of the game
      *
@@ -202,13 +303,23 @@ public:
      */
     const static std::string getScoreHeader() { return "Player Score\nDimensions Length Speed"; }
 
+    /**
+     * @brief Creates a seed that differs between games
+     *
+     * @return std::uint32_t
+     */
+    static std::uint32_t createSeed() { return std::random_device{}(); }
+
     /**
      * @brief Construct a new Game object
      *
      * @param board The new game's board
      * @param snake The new game's snake
+     * @param gameSpeed The milliseconds between logical steps
+     * @param playerName The name of the player
+     * @param seed The seed for placing apples
      */
-    Game(std::unique_ptr<Board> board, std::unique_ptr<Snake> snake, const double gameSpeed = 200.0, const std::string &playerName = "Captain") : board(std::move(board)), snake(std::move(snake)), apple(getRandomVacantPoint()), gameSpeed(gameSpeed), playerName(playerName) {}
+    Game(std::unique_ptr<Board> board, std::unique_ptr<Snake> snake, const double gameSpeed = 200.0, const std::string &playerName = "Captain", const std::uint32_t seed = createSeed()) : board(std::move(board)), snake(std::move(snake)), seed(seed), random(seed), apple(getRandomVacantPoint()), gameSpeed(gameSpeed), playerName(playerName) {}
 };
 
 #endif
\ No newline at end of file
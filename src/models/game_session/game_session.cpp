@@ -0,0 +1,542 @@
+#include "game_session.hpp"
+#include "board.hpp"
+#include "snake.hpp"
+#include "point.hpp"
+#include "step_message.hpp"
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+/**
+ * @brief How long the game over, saved and error screens are shown
+ *
+ */
+constexpr chrono::milliseconds MENU_PAUSE_TIME{3000};
+
+/**
+ * @brief How often a score being saved is checked on
+ *
+ */
+constexpr chrono::milliseconds SAVE_CHECK_INTERVAL{50};
+
+/**
+ * @brief The time between menu animation steps, and the pause after the menu snake crashes
+ *
+ */
+constexpr chrono::milliseconds ANIMATION_INTERVAL{200};
+constexpr chrono::milliseconds ANIMATION_CRASH_PAUSE{1000};
+
+/**
+ * @brief The byte a terminal sends for ctrl+c
+ *
+ */
+constexpr char INTERRUPT{'\x03'};
+
+/**
+ * @brief The generator stream of the session, apart from the menu game seeded with the same seed
+ *
+ */
+constexpr uint64_t SESSION_STREAM{1};
+
+/**
+ * @brief Converts the game speed to a clock duration
+ *
+ */
+static GameSession::Clock::duration toInterval(double milliseconds)
+{
+    return chrono::duration_cast<GameSession::Clock::duration>(chrono::duration<double, milli>(milliseconds));
+}
+
+/**
+ * @brief Parses the typed digits
+ *
+ * @return int The number, or -1 if the text isn't a number
+ */
+static int parseNumber(string_view text)
+{
+    int number{-1};
+    const auto result{from_chars(text.data(), text.data() + text.size(), number)};
+    return result.ec == errc{} && result.ptr == text.data() + text.size() ? number : -1;
+}
+
+/**
+ * @brief Maps w, a, s and d to the arrow keys' directions
+ *
+ * @return true if the character is a direction
+ */
+static bool toDirection(char character, Directions::Direction &direction)
+{
+    switch (tolower(static_cast<unsigned char>(character)))
+    {
+    case 'w':
+        direction = Directions::Direction::UP;
+        return true;
+    case 'd':
+        direction = Directions::Direction::RIGHT;
+        return true;
+    case 's':
+        direction = Directions::Direction::DOWN;
+        return true;
+    case 'a':
+        direction = Directions::Direction::LEFT;
+        return true;
+    default:
+        return false;
+    }
+}
+
+GameSession::GameSession(SessionScores &scores, uint32_t seed, Clock::time_point now)
+    : scores(scores),
+      menuGame(make_unique<Game>(make_unique<Board>(30, 20), make_unique<Snake>(Point(5, 20), 5), 200.0, "Captain", seed)),
+      menuReachability(make_unique<Reachability>(menuGame->getBoard(), menuGame->getSnake())),
+      random(seed, SESSION_STREAM),
+      animationDeadline(now + ANIMATION_INTERVAL)
+{
+    showMainMenu();
+}
+
+Game &GameSession::getShownGame() const
+{
+    switch (state)
+    {
+    case SessionState::WAITING_TO_START:
+    case SessionState::PLAYING:
+    case SessionState::PAUSED:
+    case SessionState::GAME_OVER:
+        return *game;
+    default:
+        return *menuGame;
+    }
+}
+
+void GameSession::setMenuMessage(string_view message)
+{
+    menuMessage.assign(message);
+    menuGame->setMessage(menuMessage);
+}
+
+void GameSession::showMainMenu()
+{
+    state = SessionState::MAIN_MENU;
+    stateDeadline = Clock::time_point::max();
+    setMenuMessage("Welcome to\nSnake!\n\nPress 'enter' to continue, 'down' to view scores, or 'q' to quit");
+}
+
+void GameSession::showPrompt(SessionState promptState, string_view text, size_t maxLength)
+{
+    state = promptState;
+    prompt.assign(text);
+    typed.clear();
+    maxTyped = maxLength;
+    setMenuMessage(prompt);
+}
+
+void GameSession::showScores()
+{
+    state = SessionState::SCORES;
+    try
+    {
+        setMenuMessage(scores.getScorePage(scorePage));
+    }
+    catch (const out_of_range &)
+    {
+        // Stay on the last page
+        scorePage = max(scorePage - 1, 0);
+        try
+        {
+            setMenuMessage(scores.getScorePage(scorePage));
+        }
+        catch (const exception &)
+        {
+            setMenuMessage("No saved scores");
+        }
+    }
+    catch (const exception &)
+    {
+        setMenuMessage("No saved scores");
+    }
+}
+
+void GameSession::showSaveResult(Clock::time_point now)
+{
+    if (pendingSave.wait_for(chrono::seconds(0)) != future_status::ready)
+    {
+        stateDeadline = now + SAVE_CHECK_INTERVAL;
+        return;
+    }
+    try
+    {
+        pendingSave.get();
+        setMenuMessage("Game saved");
+    }
+    catch (const exception &)
+    {
+        setMenuMessage("An error occurred while saving");
+    }
+    stateDeadline = now + MENU_PAUSE_TIME;
+}
+
+void GameSession::startGame()
+{
+    // Copy the last game's board when the size is unchanged, sharing its neighbour table and string
+    auto board{game && game->getBoard().getWidth() == boardWidth && game->getBoard().getHeight() == boardHeight ? make_unique<Board>(game->getBoard()) : make_unique<Board>(boardWidth, boardHeight)};
+    game = make_unique<Game>(std::move(board), make_unique<Snake>(Point(snakeLength, boardHeight), snakeLength), gameSpeed, "Captain", random());
+    game->reserve();
+    stepper = makeGameStepper(*game);
+    reachability = make_unique<Reachability>(game->getBoard(), game->getSnake());
+    queuedCount = 0;
+    lastQueuedDirection = game->getSnake().getDirection();
+    lastAte = 0;
+    hasPlayed = true;
+    state = SessionState::WAITING_TO_START;
+    game->setMessage("Welcome to\nSnake!\n\nMove the snake around the board, and eat as many apples as you can\n\nAvoid the walls and yourself\n\nWhen you crash, it's gameover!");
+}
+
+void GameSession::onPromptAnswered(Clock::time_point now)
+{
+    const int number{parseNumber(typed)};
+    switch (state)
+    {
+    case SessionState::PREVIOUS_SETTINGS_PROMPT:
+        if (typed == "y")
+            startGame();
+        else if (typed == "n")
+            showPrompt(SessionState::WIDTH_PROMPT, "Choose the board width\n(Between 30 and 200)", 10);
+        else
+            showPrompt(state, prompt, maxTyped);
+        return;
+    case SessionState::WIDTH_PROMPT:
+        if (number < 30 || number > 200)
+            break;
+        boardWidth = number;
+        showPrompt(SessionState::HEIGHT_PROMPT, "Choose the board height\n(Between 20 and 200)", 10);
+        return;
+    case SessionState::HEIGHT_PROMPT:
+        if (number < 20 || number > 200)
+            break;
+        boardHeight = number;
+        showPrompt(SessionState::LENGTH_PROMPT, "Choose the starting snake length\n\nSmall  1\nMedium 2\nLarge  3", 10);
+        return;
+    case SessionState::LENGTH_PROMPT:
+        if (number < 1 || number > 3)
+            break;
+        snakeLength = number == 1 ? 3 : number == 2 ? 5 : 8;
+        showPrompt(SessionState::SPEED_PROMPT, "Choose a game speed\n\nSlow   1\nMedium 2\nFast   3", 10);
+        return;
+    case SessionState::SPEED_PROMPT:
+        if (number < 1 || number > 3)
+            break;
+        gameSpeed = 1.0 / (5.0 * number) * 1000.0;
+        startGame();
+        return;
+    case SessionState::SAVE_PROMPT:
+        if (typed == "y")
+            showPrompt(SessionState::NAME_PROMPT, "Please enter your name:", 10);
+        else if (typed == "n")
+        {
+            state = SessionState::FAREWELL;
+            stateDeadline = now + MENU_PAUSE_TIME;
+            setMenuMessage("GAME OVER");
+        }
+        else
+            showPrompt(state, prompt, maxTyped);
+        return;
+    case SessionState::NAME_PROMPT:
+        state = SessionState::FAREWELL;
+        stateDeadline = now + SAVE_CHECK_INTERVAL;
+        setMenuMessage("Saving...");
+        game->setPlayerName(typed);
+        pendingSave = scores.saveScore(*game);
+        return;
+    default:
+        return;
+    }
+
+    // Ask again when the number is out of range
+    showPrompt(state, prompt, maxTyped);
+}
+
+void GameSession::onKey(Key key, char character, Clock::time_point now)
+{
+    Directions::Direction direction{};
+    const bool isDirection{key == Key::UP || key == Key::DOWN || key == Key::LEFT || key == Key::RIGHT || (key == Key::CHARACTER && toDirection(character, direction))};
+    if (key == Key::UP)
+        direction = Directions::Direction::UP;
+    else if (key == Key::DOWN)
+        direction = Directions::Direction::DOWN;
+    else if (key == Key::LEFT)
+        direction = Directions::Direction::LEFT;
+    else if (key == Key::RIGHT)
+        direction = Directions::Direction::RIGHT;
+    const bool isQuit{key == Key::ESCAPE || (key == Key::CHARACTER && tolower(static_cast<unsigned char>(character)) == 'q')};
+
+    switch (state)
+    {
+    case SessionState::MAIN_MENU:
+        if (key == Key::ENTER && hasPlayed)
+            showPrompt(SessionState::PREVIOUS_SETTINGS_PROMPT, "Would you like to play with the previous settings?\n'Y' for yes\n'N' for no", 1);
+        else if (key == Key::ENTER)
+            showPrompt(SessionState::WIDTH_PROMPT, "Choose the board width\n(Between 30 and 200)", 10);
+        else if (isDirection && direction == Directions::Direction::DOWN)
+        {
+            scorePage = 0;
+            showScores();
+        }
+        else if (isQuit)
+            state = SessionState::CLOSED;
+        return;
+
+    case SessionState::SCORES:
+        if (isQuit)
+            showMainMenu();
+        else if (isDirection && direction == Directions::Direction::RIGHT)
+        {
+            ++scorePage;
+            showScores();
+        }
+        else if (isDirection && direction == Directions::Direction::LEFT && scorePage > 0)
+        {
+            --scorePage;
+            showScores();
+        }
+        return;
+
+    case SessionState::PREVIOUS_SETTINGS_PROMPT:
+    case SessionState::WIDTH_PROMPT:
+    case SessionState::HEIGHT_PROMPT:
+    case SessionState::LENGTH_PROMPT:
+    case SessionState::SPEED_PROMPT:
+    case SessionState::SAVE_PROMPT:
+    case SessionState::NAME_PROMPT:
+        // Allow alpha numeric characters and backspace, escape leaves the game settings prompts. Names are kept as
+        // typed, the other answers are compared in lower case
+        if (key == Key::CHARACTER && isalnum(static_cast<unsigned char>(character)) && typed.size() < maxTyped)
+            typed += state == SessionState::NAME_PROMPT ? character : static_cast<char>(tolower(static_cast<unsigned char>(character)));
+        else if (key == Key::BACKSPACE && !typed.empty())
+            typed.pop_back();
+        else if (key == Key::ENTER && !typed.empty())
+        {
+            onPromptAnswered(now);
+            return;
+        }
+        else if (key == Key::ESCAPE && state != SessionState::SAVE_PROMPT && state != SessionState::NAME_PROMPT)
+        {
+            showMainMenu();
+            return;
+        }
+        else
+            return;
+        setMenuMessage(prompt + "\n\n\n" + typed);
+        return;
+
+    case SessionState::WAITING_TO_START:
+        if (!isDirection && key != Key::ESCAPE)
+            return;
+        game->setMessage("");
+        state = SessionState::PLAYING;
+        stepDeadline = now + toInterval(gameSpeed);
+        if (!isDirection)
+            return;
+        [[fallthrough]];
+
+    case SessionState::PLAYING:
+        if (key == Key::ESCAPE || (key == Key::CHARACTER && tolower(static_cast<unsigned char>(character)) == 'p'))
+        {
+            state = SessionState::PAUSED;
+            stepDeadline = Clock::time_point::max();
+            game->setMessage("PAUSED");
+        }
+        else if (isDirection && direction != lastQueuedDirection && !Directions::areOppositeDirections(lastQueuedDirection, direction) && queuedCount < queuedDirections.size())
+        {
+            // Queue a direction change, validated against the last queued direction
+            queuedDirections[queuedCount++] = direction;
+            lastQueuedDirection = direction;
+        }
+        return;
+
+    case SessionState::PAUSED:
+        if (key == Key::ESCAPE || (key == Key::CHARACTER && tolower(static_cast<unsigned char>(character)) == 'p'))
+        {
+            state = SessionState::PLAYING;
+            stepDeadline = now + toInterval(gameSpeed);
+            game->setMessage("");
+        }
+        return;
+
+    default:
+        return;
+    }
+}
+
+void GameSession::onInput(string_view input, Clock::time_point now)
+{
+    for (const char character : input)
+    {
+        if (state == SessionState::CLOSED)
+            return;
+        isFrameChanged = true;
+
+        // Arrow keys arrive as escape, [ or O, then a letter
+        if (escapeProgress == 1)
+        {
+            escapeProgress = 0;
+            if (character == '[' || character == 'O')
+            {
+                escapeProgress = 2;
+                continue;
+            }
+            onKey(Key::ESCAPE, '\x1b', now);
+        }
+        else if (escapeProgress == 2)
+        {
+            escapeProgress = 0;
+            if (character == 'A')
+                onKey(Key::UP, character, now);
+            else if (character == 'B')
+                onKey(Key::DOWN, character, now);
+            else if (character == 'C')
+                onKey(Key::RIGHT, character, now);
+            else if (character == 'D')
+                onKey(Key::LEFT, character, now);
+            continue;
+        }
+
+        if (character == '\x1b')
+            escapeProgress = 1;
+        else if (character == INTERRUPT)
+            state = SessionState::CLOSED;
+        else if (character == '\r' || character == '\n')
+            onKey(Key::ENTER, character, now);
+        else if (character == '\x7f' || character == '\b')
+            onKey(Key::BACKSPACE, character, now);
+        else
+            onKey(Key::CHARACTER, character, now);
+    }
+
+    // A lone escape at the end of the input is the escape key
+    if (escapeProgress == 1)
+    {
+        escapeProgress = 0;
+        onKey(Key::ESCAPE, '\x1b', now);
+    }
+}
+
+void GameSession::stepAnimation(Clock::time_point now)
+{
+    // Start a new animation once the last one crashed
+    if (menuGame->isGameOver())
+    {
+        menuReachability.reset();
+        menuGame = make_unique<Game>(make_unique<Board>(50, 30), make_unique<Snake>(Point(5, 20), 5), 200.0, "Captain", random());
+        menuGame->setMessage(menuMessage);
+        menuReachability = make_unique<Reachability>(menuGame->getBoard(), menuGame->getSnake());
+    }
+
+    // Find a random move that doesn't lead into a dead end, crashing if every move does
+    const auto move{menuReachability->pickMove(menuGame->getSnake(), random)};
+    const Directions::Direction nextDirection{move.value_or(static_cast<Directions::Direction>(random.bounded(4)))};
+    const Point destination{menuGame->getBoard().getNeighbour(menuGame->getSnake().getHead(), nextDirection)};
+
+    // Make the move
+    if (!move)
+        menuGame->getSnake().crash(nextDirection, destination);
+    else if (destination == menuGame->getApple())
+    {
+        menuGame->setApple(menuGame->getRandomVacantPoint());
+        menuGame->getSnake().grow(nextDirection, destination);
+        menuGame->setScore(menuGame->getScore() + GameStepper::APPLE_SCORE);
+    }
+    else
+        menuGame->getSnake().move(nextDirection, destination);
+    menuReachability->update(menuGame->getSnake());
+
+    animationDeadline = now + (menuGame->isGameOver() ? ANIMATION_CRASH_PAUSE : ANIMATION_INTERVAL);
+}
+
+void GameSession::stepGame(Clock::time_point now)
+{
+    // Consume at most one queued direction change per step
+    Directions::Direction direction{game->getSnake().getDirection()};
+    if (queuedCount > 0)
+    {
+        direction = queuedDirections[0];
+        move(queuedDirections.begin() + 1, queuedDirections.begin() + queuedCount, queuedDirections.begin());
+        --queuedCount;
+    }
+
+    // Apply the game rules and update the message
+    const StepOutcome outcome{stepper->step(direction)};
+    reachability->update(game->getSnake());
+    showStepMessage(*game, outcome, *reachability, lastAte);
+
+    // Show the crash before asking to save the score
+    if (game->isGameOver())
+    {
+        state = SessionState::GAME_OVER;
+        stepDeadline = Clock::time_point::max();
+        stateDeadline = now + MENU_PAUSE_TIME;
+        return;
+    }
+
+    // Keep a fixed rate, starting over if the step ran more than a whole interval late
+    const auto interval{toInterval(gameSpeed)};
+    stepDeadline += interval;
+    if (stepDeadline <= now)
+        stepDeadline = now + interval;
+}
+
+void GameSession::onTimer(Clock::time_point now)
+{
+    if (state == SessionState::CLOSED)
+        return;
+
+    const bool isMenuShown{&getShownGame() == menuGame.get()};
+    if (isMenuShown && now >= animationDeadline)
+    {
+        stepAnimation(now);
+        isFrameChanged = true;
+    }
+    if (now >= stepDeadline)
+    {
+        stepGame(now);
+        isFrameChanged = true;
+    }
+    if (now >= stateDeadline)
+    {
+        stateDeadline = Clock::time_point::max();
+        if (state == SessionState::GAME_OVER)
+        {
+            animationDeadline = now + ANIMATION_INTERVAL;
+            showPrompt(SessionState::SAVE_PROMPT, "Would you like to save your score?\n'Y' for yes\n'N' for no", 1);
+        }
+        else if (state == SessionState::FAREWELL && pendingSave.valid())
+            showSaveResult(now);
+        else if (state == SessionState::FAREWELL)
+            showMainMenu();
+        isFrameChanged = true;
+    }
+}
+
+GameSession::Clock::time_point GameSession::getDeadline() const
+{
+    if (state == SessionState::CLOSED)
+        return Clock::time_point::max();
+    const bool isMenuShown{&getShownGame() == menuGame.get()};
+    return min({isMenuShown ? animationDeadline : Clock::time_point::max(), stepDeadline, stateDeadline});
+}
+
+const string *GameSession::takeFrame()
+{
+    if (!isFrameChanged || state == SessionState::CLOSED)
+        return nullptr;
+    isFrameChanged = false;
+    return &getShownGame().toString();
+}
@@ -0,0 +1,317 @@
+#ifndef GAME_SESSION_H
+#define GAME_SESSION_H
+
+#include "game.hpp"
+#include "game_stepper.hpp"
+#include "direction.hpp"
+#include "pcg32.hpp"
+#include "reachability.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Where a session saves and reads scores
+ *
+ * @note Called from the worker running the session, so implementations must be thread safe
+ */
+class SessionScores
+{
+public:
+    virtual ~SessionScores() = default;
+
+    /**
+     * @brief Starts saving the score of the game, without blocking the session's worker
+     *
+     * @param game The finished game with the player's name set, read before returning
+     * @return std::future<void> Ready once the score is saved, throws if it couldn't be
+     */
+    virtual std::future<void> saveScore(Game &game) = 0;
+
+    /**
+     * @brief Get a page of scores as the message shown on the scores menu
+     *
+     * @param page The page, starting at 0
+     * @throws std::out_of_range Thrown if the page is past the last page
+     * @return std::string
+     */
+    virtual std::string getScorePage(int page) = 0;
+};
+
+/**
+ * @brief The screens of a session
+ *
+ */
+enum class SessionState
+{
+    MAIN_MENU,
+    SCORES,
+    PREVIOUS_SETTINGS_PROMPT,
+    WIDTH_PROMPT,
+    HEIGHT_PROMPT,
+    LENGTH_PROMPT,
+    SPEED_PROMPT,
+    WAITING_TO_START,
+    PLAYING,
+    PAUSED,
+    GAME_OVER,
+    SAVE_PROMPT,
+    NAME_PROMPT,
+    FAREWELL,
+    CLOSED
+};
+
+/**
+ * @brief One player's menus, prompts, game and score entry, driven by terminal input and timers
+ *
+ * @note The session never blocks or sleeps. The host passes it the bytes the player typed and calls onTimer once
+ * the deadline has passed, then sends the frame to the player's terminal. Keys are the bytes a terminal in raw
+ * mode sends: w, a, s, d or the arrow keys to move, enter to confirm, escape to go back or pause and q to quit.
+ */
+class GameSession
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    /**
+     * @brief The keys a session reacts to
+     *
+     */
+    enum class Key
+    {
+        UP,
+        DOWN,
+        LEFT,
+        RIGHT,
+        ENTER,
+        BACKSPACE,
+        ESCAPE,
+        CHARACTER
+    };
+
+    SessionScores &scores;
+    SessionState state{SessionState::MAIN_MENU};
+
+    /**
+     * @brief The game shown behind the menus, the snake moves randomly
+     *
+     */
+    std::unique_ptr<Game> menuGame;
+
+    /**
+     * @brief The free regions of the menu game's board, for steering the animation away from dead ends
+     *
+     */
+    std::unique_ptr<Reachability> menuReachability;
+
+    /**
+     * @brief The game being played, the stepper applying its rules and the free regions around the snake
+     *
+     */
+    std::unique_ptr<Game> game;
+    std::unique_ptr<GameStepper> stepper;
+    std::unique_ptr<Reachability> reachability;
+
+    /**
+     * @brief The random number generator for the menu animation and the seeds of new games
+     *
+     */
+    Pcg32 random;
+
+    /**
+     * @brief When the menu animation and the game step next
+     *
+     */
+    Clock::time_point animationDeadline;
+    Clock::time_point stepDeadline{Clock::time_point::max()};
+
+    /**
+     * @brief When the current screen moves on by itself
+     *
+     */
+    Clock::time_point stateDeadline{Clock::time_point::max()};
+
+    /**
+     * @brief The settings picked for the game, kept to offer them again
+     *
+     */
+    int boardWidth{0};
+    int boardHeight{0};
+    int snakeLength{0};
+    double gameSpeed{0};
+    bool hasPlayed{false};
+
+    /**
+     * @brief The message shown on the menu game, kept when the animation starts over
+     *
+     */
+    std::string menuMessage;
+
+    /**
+     * @brief The prompt shown and the characters typed so far
+     *
+     */
+    std::string prompt;
+    std::string typed;
+
+    /**
+     * @brief The score being saved while the farewell screen is shown
+     *
+     */
+    std::future<void> pendingSave;
+    std::size_t maxTyped{0};
+
+    /**
+     * @brief The page of the scores menu
+     *
+     */
+    int scorePage{0};
+
+    /**
+     * @brief The direction changes waiting for the next steps, at most one is applied per step
+     *
+     */
+    std::array<Directions::Direction, 4> queuedDirections{};
+    std::size_t queuedCount{0};
+    Directions::Direction lastQueuedDirection{Directions::Direction::RIGHT};
+
+    /**
+     * @brief The steps left before the YUM message is cleared
+     *
+     */
+    short lastAte{0};
+
+    /**
+     * @brief How far an escape sequence has been read: 0 none, 1 after escape, 2 after the bracket
+     *
+     */
+    int escapeProgress{0};
+
+    bool isFrameChanged{true};
+
+    /**
+     * @brief Get the game shown on the current screen
+     *
+     */
+    Game &getShownGame() const;
+
+    /**
+     * @brief Reacts to a key
+     *
+     */
+    void onKey(Key key, char character, Clock::time_point now);
+
+    /**
+     * @brief Sets the message of the menu game
+     *
+     */
+    void setMenuMessage(std::string_view message);
+
+    /**
+     * @brief Shows the main menu
+     *
+     */
+    void showMainMenu();
+
+    /**
+     * @brief Shows a prompt on the menu game and starts reading the answer
+     *
+     */
+    void showPrompt(SessionState promptState, std::string_view text, std::size_t maxLength);
+
+    /**
+     * @brief Shows the current page of scores
+     *
+     */
+    void showScores();
+
+    /**
+     * @brief Handles the answer typed at the current prompt
+     *
+     */
+    void onPromptAnswered(Clock::time_point now);
+
+    /**
+     * @brief Shows whether the score was saved once the save has finished, checking again shortly until it has
+     *
+     */
+    void showSaveResult(Clock::time_point now);
+
+    /**
+     * @brief Creates the game with the picked settings and waits for the first key
+     *
+     */
+    void startGame();
+
+    /**
+     * @brief Moves the menu snake one random step that avoids dead ends, crashing it if it has no safe move
+     *
+     */
+    void stepAnimation(Clock::time_point now);
+
+    /**
+     * @brief Applies the game rules for one step
+     *
+     */
+    void stepGame(Clock::time_point now);
+
+public:
+    /**
+     * @brief Construct a new Game Session object showing the main menu
+     *
+     * @param scores Where scores are saved and read, must outlive the session
+     * @param seed The seed for the menu animation and the games
+     * @param now The current time
+     */
+    GameSession(SessionScores &scores, std::uint32_t seed, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief Reacts to the bytes typed by the player
+     *
+     * @param input The bytes read from the player's terminal
+     * @param now The current time
+     */
+    void onInput(std::string_view input, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief Runs the animation, game steps and screen changes due at the time
+     *
+     * @param now The current time
+     */
+    void onTimer(Clock::time_point now = Clock::now());
+
+    /**
+     * @brief Get the time onTimer should be called next
+     *
+     * @return Clock::time_point Clock::time_point::max() if nothing is scheduled
+     */
+    Clock::time_point getDeadline() const;
+
+    /**
+     * @brief Get the current screen
+     *
+     * @return SessionState
+     */
+    SessionState getState() const { return state; }
+
+    /**
+     * @brief Returns whether the player has quit
+     *
+     */
+    bool isClosed() const { return state == SessionState::CLOSED; }
+
+    /**
+     * @brief Get the frame if it changed since it was last taken
+     *
+     * @return const std::string* The frame, or nullptr if it didn't change
+     */
+    const std::string *takeFrame();
+};
+
+#endif
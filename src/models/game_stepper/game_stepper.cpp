@@ -0,0 +1,16 @@
+#include "game_stepper.hpp"
+#include "board_geometry.hpp"
+#include <memory>
+
+using namespace std;
+
+unique_ptr<GameStepper> makeGameStepper(Game &game)
+{
+    return dispatchBoardGeometry(game.getBoard().getWidth(), game.getBoard().getHeight(), [&game](auto geometry) -> unique_ptr<GameStepper>
+                                 { return make_unique<BoardGameStepper<decltype(geometry)>>(game, geometry); });
+}
+
+unique_ptr<GameStepper> makeGenericGameStepper(Game &game)
+{
+    return make_unique<BoardGameStepper<DynamicBoardGeometry>>(game, DynamicBoardGeometry{game.getBoard().getWidth(), game.getBoard().getHeight()});
+}
@@ -0,0 +1,228 @@
+#ifndef GAME_STEPPER_H
+#define GAME_STEPPER_H
+
+#include "game.hpp"
+#include "board_geometry.hpp"
+#include "direction.hpp"
+#include "point.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+/**
+ * @brief The result of a single logic step
+ *
+ */
+enum class StepOutcome
+{
+    MOVED,
+    ATE,
+    HIT_SELF,
+    HIT_WALL
+};
+
+/**
+ * @brief Applies the game rules to a game one logic step at a time
+ *
+ */
+class GameStepper
+{
+public:
+    /**
+     * @brief The score gained for eating an apple
+     *
+     */
+    constexpr static int APPLE_SCORE{10};
+
+    virtual ~GameStepper() = default;
+
+    /**
+     * @brief Moves the snake one step in the direction and applies the game rules
+     *
+     * @param direction The direction to move
+     * @return StepOutcome What happened during the step
+     */
+    virtual StepOutcome step(Directions::Direction direction) = 0;
+
+    /**
+     * @brief Takes back the last step, restoring the snake, the cells it occupies, the score and the apple
+     *
+     * @note The game's random generator isn't rewound, the caller restores it if the snake ate
+     * @param outcome What the step did
+     * @param previousDirection The direction the snake faced before the step
+     * @param freedTail The tail the step moved off, ignored if the snake ate
+     */
+    virtual void undo(StepOutcome outcome, Directions::Direction previousDirection, const Point &freedTail) = 0;
+
+    /**
+     * @brief Get the cells an apple can be placed in, counting the apple's
+     *
+     */
+    virtual int getVacantAppleCells() const = 0;
+};
+
+/**
+ * @brief A game stepper specialized for the board geometry
+ *
+ * @tparam Geometry FixedBoardGeometry or DynamicBoardGeometry
+ */
+template <typename Geometry>
+class BoardGameStepper : public GameStepper
+{
+private:
+    /**
+     * @brief The game being stepped
+     *
+     */
+    Game &game;
+
+    /**
+     * @brief The geometry of the game's board
+     *
+     */
+    const Geometry geometry;
+
+    /**
+     * @brief The cells occupied by the snake, mirrors the snake body, plus the always occupied wall cell
+     *
+     */
+    typename Geometry::Occupancy occupancy;
+
+    /**
+     * @brief The board's neighbour table, walls and wraparound are resolved in it
+     *
+     */
+    const std::int32_t *neighbours;
+
+    /**
+     * @brief The cells an apple can be placed in, like Game::getRandomVacantPoint, and the number of them free of the
+     * snake. Once the snake eats the apple on the last one the board is cleared.
+     *
+     */
+    typename Geometry::Occupancy appleCells;
+    int vacantAppleCells{0};
+
+public:
+    /**
+     * @brief Construct a new Board Game Stepper object
+     *
+     * @param game The game to step, must outlive the stepper
+     * @param geometry The geometry of the game's board
+     */
+    BoardGameStepper(Game &game, const Geometry geometry)
+        : game(game), geometry(geometry), occupancy(geometry.createOccupancy()), neighbours(game.getBoard().getNeighbours()), appleCells(geometry.createOccupancy())
+    {
+        for (const auto &segment : game.getSnake().getBody())
+            if (geometry.isInBoard(segment))
+                occupancy[geometry.getCellIndex(segment)] = true;
+        const Board &board{game.getBoard()};
+        appleCells[geometry.getWallCell()] = false;
+        for (int y{1}; y <= board.getHeight(); ++y)
+            for (int x{1}; x <= board.getWidth(); ++x)
+            {
+                const int index{geometry.getCellIndex(Point{x, y})};
+                appleCells[index] = !board.isObstacle(Point{x, y});
+                vacantAppleCells += appleCells[index] && !occupancy[index];
+            }
+    }
+
+    StepOutcome step(Directions::Direction direction) override
+    {
+        Snake &snake{game.getSnake()};
+
+        // The snake can't reverse into itself, keep going straight instead
+        if (Directions::areOppositeDirections(snake.getDirection(), direction))
+            direction = snake.getDirection();
+
+        // Walls and obstacles lead to the always occupied wall cell, so one test covers every crash
+        const Point &head{snake.getHead()};
+        const int destinationIndex{neighbours[geometry.getCellIndex(head) * Board::DIRECTION_COUNT + static_cast<int>(direction)]};
+        const int tailIndex{geometry.getCellIndex(snake.getTail())};
+        if (occupancy[destinationIndex])
+        {
+            if (destinationIndex == geometry.getWallCell())
+            {
+                snake.crash(direction, game.getBoard().getNeighbour(head, direction));
+                return StepOutcome::HIT_WALL;
+            }
+
+            // Moving into the tail is allowed because the tail moves away
+            if (destinationIndex != tailIndex)
+            {
+                snake.crash(direction, geometry.getCellPoint(destinationIndex));
+                return StepOutcome::HIT_SELF;
+            }
+        }
+
+        const Point destination{geometry.getCellPoint(destinationIndex)};
+        if (destination == game.getApple())
+        {
+            snake.grow(direction, destination);
+            occupancy[destinationIndex] = true;
+            game.setScore(game.getScore() + APPLE_SCORE);
+
+            // The snake fills every apple cell, the game ends with the apple left under its head
+            if (--vacantAppleCells == 0)
+                game.setIsCleared(true);
+            else
+                game.setApple(game.getRandomVacantPoint());
+            return StepOutcome::ATE;
+        }
+
+        vacantAppleCells += appleCells[tailIndex] - appleCells[destinationIndex];
+        snake.move(direction, destination);
+        occupancy[tailIndex] = false;
+        occupancy[destinationIndex] = true;
+        return StepOutcome::MOVED;
+    }
+
+    void undo(StepOutcome outcome, Directions::Direction previousDirection, const Point &freedTail) override
+    {
+        Snake &snake{game.getSnake()};
+        const Point head{snake.getHead()};
+        switch (outcome)
+        {
+        case StepOutcome::ATE:
+            // The apple was where the head is
+            snake.undo(previousDirection, std::nullopt);
+            occupancy[geometry.getCellIndex(head)] = false;
+            game.setScore(game.getScore() - APPLE_SCORE);
+            game.setApple(head);
+            game.setIsCleared(false);
+            ++vacantAppleCells;
+            break;
+        case StepOutcome::MOVED:
+            // The head leaves before the tail comes back, so the tail can take the head's cell
+            snake.undo(previousDirection, freedTail);
+            occupancy[geometry.getCellIndex(head)] = false;
+            occupancy[geometry.getCellIndex(freedTail)] = true;
+            vacantAppleCells += appleCells[geometry.getCellIndex(head)] - appleCells[geometry.getCellIndex(freedTail)];
+            break;
+        case StepOutcome::HIT_SELF:
+        case StepOutcome::HIT_WALL:
+            // A crash leaves the occupancy as it was
+            snake.undo(previousDirection, freedTail);
+            break;
+        }
+    }
+
+    int getVacantAppleCells() const override { return vacantAppleCells; }
+};
+
+/**
+ * @brief Creates a stepper specialized for the game's board size
+ *
+ * @param game The game to step, must outlive the stepper
+ * @return std::unique_ptr<GameStepper>
+ */
+std::unique_ptr<GameStepper> makeGameStepper(Game &game);
+
+/**
+ * @brief Creates a stepper using the generic board geometry regardless of the board size
+ *
+ * @param game The game to step, must outlive the stepper
+ * @return std::unique_ptr<GameStepper>
+ */
+std::unique_ptr<GameStepper> makeGenericGameStepper(Game &game);
+
+#endif
@@ -0,0 +1,101 @@
+#include "heatmap.hpp"
+#include "npy_writer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief The fewest counts a merge thread sums, smaller heatmaps use fewer threads
+ *
+ */
+constexpr size_t MIN_MERGE_SLICE{16 * 1024};
+
+Heatmap::Heatmap(int width, int height) : width(width), height(height), cellCount(static_cast<size_t>(width + 1) * (height + 1))
+{
+    if (width <= 0 || height <= 0)
+        throw invalid_argument("heatmap dimensions must be positive");
+    counts.assign(LAYER_COUNT * cellCount, 0);
+}
+
+void Heatmap::recordStart(const Game &game)
+{
+    add(HeatmapLayer::VISITS, game.getBoard().getCellIndex(game.getSnake().getHead()));
+    add(HeatmapLayer::APPLES, game.getBoard().getCellIndex(game.getApple()));
+}
+
+uint64_t Heatmap::getTotal(HeatmapLayer layer) const
+{
+    const uint64_t *const layerCounts{getCounts(layer)};
+    return accumulate(layerCounts, layerCounts + cellCount, uint64_t{0});
+}
+
+Heatmap Heatmap::merge(const vector<Heatmap> &heatmaps, unsigned threadCount)
+{
+    if (heatmaps.empty())
+        throw invalid_argument("no heatmaps to merge");
+    for (const auto &heatmap : heatmaps)
+        if (heatmap.width != heatmaps.front().width || heatmap.height != heatmaps.front().height)
+            throw invalid_argument("heatmaps of different sizes can't be merged");
+
+    Heatmap merged(heatmaps.front().width, heatmaps.front().height);
+    const size_t countCount{merged.counts.size()};
+    if (threadCount == 0)
+        threadCount = max(thread::hardware_concurrency(), 1u);
+    threadCount = static_cast<unsigned>(clamp<size_t>(countCount / MIN_MERGE_SLICE, 1, threadCount));
+
+    // Sum a slice of every heatmap into the same slice of the result
+    const auto sumSlice = [&heatmaps, &merged](size_t start, size_t end)
+    {
+        uint64_t *const target{merged.counts.data()};
+        for (const auto &heatmap : heatmaps)
+            for (size_t index{start}; index < end; ++index)
+                target[index] += heatmap.counts[index];
+    };
+    vector<thread> threads;
+    const size_t sliceSize{(countCount + threadCount - 1) / threadCount};
+    for (unsigned index{1}; index < threadCount; ++index)
+        threads.emplace_back(sumSlice, min(index * sliceSize, countCount), min((index + 1) * sliceSize, countCount));
+    sumSlice(0, min(sliceSize, countCount));
+    for (auto &thread : threads)
+        thread.join();
+    return merged;
+}
+
+void Heatmap::writeNpy(const string &path) const
+{
+    NpyWriter writer(path, NpyWriter::DataType::UINT64, vector<size_t>{static_cast<size_t>(height + 1), static_cast<size_t>(width + 1)});
+    for (int layer{0}; layer < LAYER_COUNT; ++layer)
+        writer.append(getCounts(static_cast<HeatmapLayer>(layer)));
+    writer.close();
+}
+
+void Heatmap::writePgm(const string &path, HeatmapLayer layer) const
+{
+    ofstream file(path, ofstream::binary | ofstream::trunc);
+    if (file.fail())
+        throw invalid_argument("Failed to create pgm file at: " + path);
+
+    // 16 bit pixels are big endian
+    constexpr int MAX_VALUE{65535};
+    const uint64_t *const layerCounts{getCounts(layer)};
+    const double scale{MAX_VALUE / log1p(static_cast<double>(max<uint64_t>(*max_element(layerCounts, layerCounts + cellCount), 1)))};
+    file << "P5\n"
+         << width + 1 << ' ' << height + 1 << '\n'
+         << MAX_VALUE << '\n';
+    vector<char> pixels(cellCount * 2);
+    for (size_t cell{0}; cell < cellCount; ++cell)
+    {
+        const auto value{static_cast<uint16_t>(lround(log1p(static_cast<double>(layerCounts[cell])) * scale))};
+        pixels[cell * 2] = static_cast<char>(value >> 8);
+        pixels[cell * 2 + 1] = static_cast<char>(value & 0xFF);
+    }
+    file.write(pixels.data(), static_cast<streamsize>(pixels.size()));
+}
@@ -0,0 +1,161 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include "game.hpp"
+#include "game_stepper.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The events a heatmap counts per cell
+ *
+ */
+enum class HeatmapLayer
+{
+    /**
+     * @brief The cells the head entered
+     *
+     */
+    VISITS,
+
+    /**
+     * @brief The cells apples were placed in
+     *
+     */
+    APPLES,
+
+    /**
+     * @brief The cells the head was in when the snake crashed
+     *
+     */
+    DEATHS
+};
+
+/**
+ * @brief Counts of game events per cell of a board size
+ *
+ * @note Cells are indexed like Board::getCellIndex, (height + 1) rows of (width + 1) cells. Counting is a plain
+ * increment, so each thread keeps its own heatmap and they are merged once at the end instead of sharing atomic
+ * counters. Not thread safe.
+ */
+class Heatmap
+{
+public:
+    constexpr static int LAYER_COUNT{3};
+
+private:
+    int width;
+    int height;
+    std::size_t cellCount;
+
+    /**
+     * @brief The counts of every layer one after another
+     *
+     */
+    std::vector<std::uint64_t> counts;
+
+    /**
+     * @brief Get the index of the cell at the point, like Board::getCellIndex without going through the board
+     *
+     */
+    int getCellIndex(const Point &point) const { return point.y * (width + 1) + point.x; }
+
+public:
+    /**
+     * @brief Construct a new Heatmap object with every count at 0
+     *
+     * @param width The board width
+     * @param height The board height
+     * @throws std::invalid_argument Thrown if the dimensions are not positive
+     */
+    Heatmap(int width, int height);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    std::size_t getCellCount() const { return cellCount; }
+
+    /**
+     * @brief Counts an event in a cell
+     *
+     * @param layer The event
+     * @param cell The cell index, not validated
+     */
+    void add(HeatmapLayer layer, int cell) { ++counts[static_cast<std::size_t>(layer) * cellCount + static_cast<std::size_t>(cell)]; }
+
+    /**
+     * @brief Counts the starting head and apple of a game
+     *
+     * @param game A new game on a board of the heatmap's size
+     */
+    void recordStart(const Game &game);
+
+    /**
+     * @brief Counts the events of a step
+     *
+     * @param game The game after the step
+     * @param outcome What the step did
+     * @param previousHeadCell The cell of the head before the step
+     */
+    void recordStep(const Game &game, StepOutcome outcome, int previousHeadCell)
+    {
+        switch (outcome)
+        {
+        case StepOutcome::ATE:
+            add(HeatmapLayer::APPLES, getCellIndex(game.getApple()));
+            [[fallthrough]];
+        case StepOutcome::MOVED:
+            add(HeatmapLayer::VISITS, getCellIndex(game.getSnake().getHead()));
+            break;
+        case StepOutcome::HIT_SELF:
+        case StepOutcome::HIT_WALL:
+            add(HeatmapLayer::DEATHS, previousHeadCell);
+            break;
+        }
+    }
+
+    /**
+     * @brief Get the counts of a layer, getCellCount() of them
+     *
+     */
+    const std::uint64_t *getCounts(HeatmapLayer layer) const { return counts.data() + static_cast<std::size_t>(layer) * cellCount; }
+
+    /**
+     * @brief Get the sum of the counts of a layer
+     *
+     */
+    std::uint64_t getTotal(HeatmapLayer layer) const;
+
+    /**
+     * @brief Adds the counts of the heatmaps together
+     *
+     * @note Each thread sums a slice of the cells of every heatmap, so no counter is written by two threads
+     * @param heatmaps The heatmaps, all of the same size
+     * @param threadCount The threads summing, 0 for one per core
+     * @throws std::invalid_argument Thrown if there are no heatmaps or their sizes differ
+     * @return Heatmap
+     */
+    static Heatmap merge(const std::vector<Heatmap> &heatmaps, unsigned threadCount = 0);
+
+    /**
+     * @brief Writes the raw counts as a uint64 .npy array of shape (LAYER_COUNT, height + 1, width + 1)
+     *
+     * @param path The file to create
+     * @throws std::invalid_argument Thrown if the file can't be created
+     */
+    void writeNpy(const std::string &path) const;
+
+    /**
+     * @brief Writes a layer as a 16 bit binary PGM image, one pixel per cell
+     *
+     * @note Counts are scaled logarithmically so the busiest cell is white and cells never counted are black, a
+     * few cells are often counted far more than the rest
+     * @param path The file to create
+     * @param layer The layer
+     * @throws std::invalid_argument Thrown if the file can't be created
+     */
+    void writePgm(const std::string &path, HeatmapLayer layer) const;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "io_worker.hpp"
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+IoWorker::IoWorker() : thread(&IoWorker::run, this)
+{
+}
+
+IoWorker::~IoWorker()
+{
+    {
+        const lock_guard<mutex> lock(tasksMutex);
+        isStopping = true;
+    }
+    tasksChanged.notify_all();
+    thread.join();
+}
+
+void IoWorker::run()
+{
+    unique_lock<mutex> lock(tasksMutex);
+    while (true)
+    {
+        tasksChanged.wait(lock, [this]
+                          { return isStopping || !tasks.empty(); });
+        if (tasks.empty())
+            return;
+
+        // Run the operation without the lock so more can be queued meanwhile
+        auto task{std::move(tasks.front())};
+        tasks.pop_front();
+        isRunning = true;
+        lock.unlock();
+        task();
+        lock.lock();
+        isRunning = false;
+        tasksChanged.notify_all();
+    }
+}
+
+size_t IoWorker::getPendingCount()
+{
+    const lock_guard<mutex> lock(tasksMutex);
+    return tasks.size() + (isRunning ? 1 : 0);
+}
+
+void IoWorker::waitIdle()
+{
+    unique_lock<mutex> lock(tasksMutex);
+    tasksChanged.wait(lock, [this]
+                      { return tasks.empty() && !isRunning; });
+}
@@ -0,0 +1,92 @@
+#ifndef IO_WORKER_H
+#define IO_WORKER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief A thread running file operations one at a time in the order they were submitted
+ *
+ * @note Each operation returns a future, which holds the result or the exception thrown. Unlike std::async futures,
+ * dropping the future doesn't wait for the operation.
+ */
+class IoWorker
+{
+private:
+    std::mutex tasksMutex;
+    std::condition_variable tasksChanged;
+    std::deque<std::move_only_function<void()>> tasks;
+    bool isStopping{false};
+
+    /**
+     * @brief The operation running, for knowing when the worker is idle
+     *
+     */
+    bool isRunning{false};
+
+    std::thread thread;
+
+    /**
+     * @brief Runs the operations until the worker stops
+     *
+     */
+    void run();
+
+public:
+    /**
+     * @brief Starts the thread
+     *
+     */
+    IoWorker();
+
+    /**
+     * @brief Runs the operations submitted and stops the thread
+     *
+     */
+    ~IoWorker();
+
+    IoWorker(const IoWorker &) = delete;
+    IoWorker &operator=(const IoWorker &) = delete;
+
+    /**
+     * @brief Queues an operation
+     *
+     * @param operation Called without arguments on the worker thread
+     * @return std::future The operation's result
+     */
+    template <typename Operation>
+    std::future<std::invoke_result_t<Operation>> submit(Operation operation)
+    {
+        std::packaged_task<std::invoke_result_t<Operation>()> task(std::move(operation));
+        auto result{task.get_future()};
+        {
+            const std::lock_guard<std::mutex> lock(tasksMutex);
+            tasks.emplace_back([task = std::move(task)]() mutable
+                               { task(); });
+        }
+        tasksChanged.notify_all();
+        return result;
+    }
+
+    /**
+     * @brief Get the number of operations queued and running
+     *
+     * @return std::size_t
+     */
+    std::size_t getPendingCount();
+
+    /**
+     * @brief Waits until every operation submitted so far has run
+     *
+     */
+    void waitIdle();
+};
+
+#endif
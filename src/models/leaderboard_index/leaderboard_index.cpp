@@ -0,0 +1,92 @@
+#include "leaderboard_index.hpp"
+#include "score_journal.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+using namespace std;
+
+void LeaderboardIndex::ScoreCounts::add(int score)
+{
+    const size_t index{static_cast<size_t>(clamp(score, 0, MAX_SCORE)) + 1};
+
+    // Doubling the tree keeps every node, the new root counts everything and the nodes between count nothing yet
+    size_t size{tree.size() - 1};
+    while (index > size)
+    {
+        tree.resize(size * 2 + 1, 0);
+        tree[size * 2] = static_cast<uint32_t>(total);
+        size *= 2;
+    }
+
+    for (size_t node{index}; node <= size; node += node & (~node + 1))
+        ++tree[node];
+    ++total;
+}
+
+size_t LeaderboardIndex::ScoreCounts::countAbove(int score) const
+{
+    const size_t index{static_cast<size_t>(clamp(score, 0, MAX_SCORE)) + 1};
+    if (index >= tree.size())
+        return 0;
+
+    // Sum the scores up to the score, the rest are above it
+    size_t atOrBelow{0};
+    for (size_t node{index}; node > 0; node &= node - 1)
+        atOrBelow += tree[node];
+    return total - atOrBelow;
+}
+
+size_t LeaderboardIndex::load(const string &path)
+{
+    // Count into new trees so ranks are still answered while the file is read
+    map<LeaderboardConfiguration, ScoreCounts> loaded;
+    size_t scoreCount{0};
+    if (filesystem::exists(path))
+    {
+        // Scores of one configuration tend to be saved together, so the last one is checked before the map
+        LeaderboardConfiguration lastConfiguration;
+        ScoreCounts *lastCounts{nullptr};
+        ScoreJournal::read(path, [&](const ScoreRecord &record)
+                           {
+                               const LeaderboardConfiguration configuration{record.width, record.height, record.gameSpeed};
+                               if (!lastCounts || configuration != lastConfiguration)
+                               {
+                                   lastConfiguration = configuration;
+                                   lastCounts = &loaded[configuration];
+                               }
+                               lastCounts->add(record.score);
+                               ++scoreCount;
+                               return true; });
+    }
+
+    const lock_guard<mutex> lock(countsMutex);
+    counts = std::move(loaded);
+    isLoaded = true;
+    return scoreCount;
+}
+
+bool LeaderboardIndex::getIsLoaded() const
+{
+    const lock_guard<mutex> lock(countsMutex);
+    return isLoaded;
+}
+
+void LeaderboardIndex::add(const ScoreRecord &record)
+{
+    const lock_guard<mutex> lock(countsMutex);
+    if (isLoaded)
+        counts[LeaderboardConfiguration{record.width, record.height, record.gameSpeed}].add(record.score);
+}
+
+LeaderboardRank LeaderboardIndex::getRank(const LeaderboardConfiguration &configuration, int score) const
+{
+    const lock_guard<mutex> lock(countsMutex);
+    if (!isLoaded)
+        return LeaderboardRank{};
+    const auto found{counts.find(configuration)};
+    if (found == counts.end())
+        return LeaderboardRank{1, 0};
+    return LeaderboardRank{found->second.countAbove(score) + 1, found->second.getTotal()};
+}
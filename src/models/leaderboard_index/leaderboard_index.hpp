@@ -0,0 +1,128 @@
+#ifndef LEADERBOARD_INDEX_H
+#define LEADERBOARD_INDEX_H
+
+#include "score_record.hpp"
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The settings whose scores are ranked together
+ *
+ */
+struct LeaderboardConfiguration
+{
+    int width{0};
+    int height{0};
+    double gameSpeed{0};
+
+    auto operator<=>(const LeaderboardConfiguration &) const = default;
+};
+
+/**
+ * @brief Where a score places among the saved scores of its configuration
+ *
+ */
+struct LeaderboardRank
+{
+    /**
+     * @brief One more than the number of saved scores above the score, 0 if the leaderboard isn't loaded
+     *
+     */
+    std::size_t rank{0};
+
+    /**
+     * @brief The number of saved scores of the configuration
+     *
+     */
+    std::size_t scoreCount{0};
+};
+
+/**
+ * @brief The saved scores of every configuration, counted so the rank of any score is found in O(log n)
+ *
+ * @note Each configuration counts its scores in a Fenwick tree indexed by score, which doubles when a higher score
+ * is added. Scores are held in memory once loaded, adding a score and ranking one never reads the score file. Every
+ * method is thread safe, loading reads the file without holding the lock so ranks are answered meanwhile.
+ */
+class LeaderboardIndex
+{
+public:
+    /**
+     * @brief The highest score counted apart, higher scores count as this one
+     *
+     */
+    constexpr static int MAX_SCORE{(1 << 20) - 1};
+
+private:
+    /**
+     * @brief The number of scores of one configuration by score
+     *
+     */
+    class ScoreCounts
+    {
+    private:
+        /**
+         * @brief The Fenwick tree from index 1, a power of two long, index i counts the scores i - 1 and below down
+         * to the lowest set bit of i
+         *
+         */
+        std::vector<std::uint32_t> tree{0, 0};
+        std::size_t total{0};
+
+    public:
+        void add(int score);
+
+        /**
+         * @brief Get the number of scores higher than the score
+         *
+         */
+        std::size_t countAbove(int score) const;
+
+        std::size_t getTotal() const { return total; }
+    };
+
+    mutable std::mutex countsMutex;
+    std::map<LeaderboardConfiguration, ScoreCounts> counts;
+    bool isLoaded{false};
+
+public:
+    /**
+     * @brief Replaces the scores with the ones saved in a score file
+     *
+     * @note A missing file loads no scores
+     * @param path The score file
+     * @throws std::invalid_argument Thrown if the file exists but can't be read
+     * @return std::size_t The number of scores loaded
+     */
+    std::size_t load(const std::string &path);
+
+    /**
+     * @brief Returns whether the scores have been loaded
+     *
+     */
+    bool getIsLoaded() const;
+
+    /**
+     * @brief Counts a newly saved score
+     *
+     * @note Scores saved before the leaderboard is loaded are ignored, loading reads them from the file
+     * @param record The score
+     */
+    void add(const ScoreRecord &record);
+
+    /**
+     * @brief Get where a score places among the saved scores of its configuration
+     *
+     * @param configuration The configuration the score was made with
+     * @param score The score
+     * @return LeaderboardRank
+     */
+    LeaderboardRank getRank(const LeaderboardConfiguration &configuration, int score) const;
+};
+
+#endif
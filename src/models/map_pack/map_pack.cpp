@@ -0,0 +1,205 @@
+#include "map_pack.hpp"
+#include "binary_format.hpp"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief The first bytes of a map pack
+ *
+ */
+constexpr string_view MAGIC{"SNAKEMAP"};
+constexpr uint32_t VERSION{1};
+
+/**
+ * @brief The sizes of the header and of a map's entry
+ *
+ * @note Header: magic, uint32 version, uint32 map count, uint64 offset of the entries, 8 reserved bytes.
+ * Entry: uint64 cells offset, uint64 name offset, uint32 name length, int32 width, height, spawn x and spawn y,
+ * uint32 topology, uint32 CRC-32 of the cells, 4 reserved bytes.
+ */
+constexpr size_t HEADER_SIZE{32};
+constexpr size_t ENTRY_SIZE{48};
+
+/**
+ * @brief The largest board side a map pack holds
+ *
+ */
+constexpr int MAX_SIDE{4096};
+
+/**
+ * @brief Get the number of cells of a board, one more column and row than its width and height
+ *
+ */
+static size_t getCellCount(int width, int height)
+{
+    return static_cast<size_t>(width + 1) * static_cast<size_t>(height + 1);
+}
+
+MapPack::MapPack(const string &path) : file(path)
+{
+    const char *bytes{file.getData()};
+    if (file.getSize() < HEADER_SIZE || string_view{bytes, MAGIC.size()} != MAGIC)
+        throw invalid_argument(path + " is not a map pack");
+    if (readLittle<uint32_t>(bytes + 8) != VERSION)
+        throw invalid_argument(path + " has an unsupported map pack version");
+
+    // Only the table of entries is checked up front, maps are checked when they are used
+    mapCount = readLittle<uint32_t>(bytes + 12);
+    const uint64_t entriesOffset{readLittle<uint64_t>(bytes + 16)};
+    if (entriesOffset > file.getSize() || (file.getSize() - entriesOffset) / ENTRY_SIZE < mapCount)
+        throw invalid_argument(path + " is truncated");
+}
+
+const char *MapPack::getEntry(size_t index) const
+{
+    if (index >= mapCount)
+        throw out_of_range("there is no map " + to_string(index));
+    return file.getData() + readLittle<uint64_t>(file.getData() + 16) + index * ENTRY_SIZE;
+}
+
+MapInfo MapPack::getMapInfo(size_t index) const
+{
+    const char *entry{getEntry(index)};
+    const uint64_t nameOffset{readLittle<uint64_t>(entry + 8)};
+    const uint32_t nameLength{readLittle<uint32_t>(entry + 16)};
+    if (nameOffset > file.getSize() || file.getSize() - nameOffset < nameLength)
+        throw invalid_argument("the name of map " + to_string(index) + " is outside the pack");
+
+    const int width{readLittle<int32_t>(entry + 20)};
+    const int height{readLittle<int32_t>(entry + 24)};
+    if (width <= 0 || height <= 0 || width > MAX_SIDE || height > MAX_SIDE)
+        throw invalid_argument("map " + to_string(index) + " has an invalid size");
+    return MapInfo{string_view{file.getData() + nameOffset, nameLength}, width, height, readLittle<uint32_t>(entry + 36) == 1 ? BoardTopology::WRAPPED : BoardTopology::WALLED,
+                   Point{readLittle<int32_t>(entry + 28), readLittle<int32_t>(entry + 32)}};
+}
+
+unique_ptr<Board> MapPack::createBoard(size_t index) const
+{
+    const MapInfo info{getMapInfo(index)};
+    const char *entry{getEntry(index)};
+    const uint64_t cellsOffset{readLittle<uint64_t>(entry)};
+    const size_t cellCount{getCellCount(info.width, info.height)};
+    if (cellsOffset > file.getSize() || file.getSize() - cellsOffset < cellCount)
+        throw invalid_argument("the cells of map " + to_string(index) + " are outside the pack");
+
+    // The cells are the board's obstacles byte for byte
+    const string_view cells{file.getData() + cellsOffset, cellCount};
+    if (computeCrc32(cells) != readLittle<uint32_t>(entry + 40))
+        throw invalid_argument("the cells of map " + to_string(index) + " are corrupt");
+    return make_unique<Board>(info.width, info.height, info.topology, span{reinterpret_cast<const uint8_t *>(cells.data()), cells.size()});
+}
+
+unique_ptr<Snake> MapPack::createSnake(size_t index, int startingLength) const
+{
+    const MapInfo info{getMapInfo(index)};
+    const auto board{createBoard(index)};
+    if (startingLength <= 0)
+        throw invalid_argument("starting length must be positive");
+
+    // The snake lies to the right of the spawn on free cells
+    for (int offset{0}; offset < startingLength; ++offset)
+        if (!board->isInBoard(Point{info.spawn.x + offset, info.spawn.y}))
+            throw invalid_argument("a snake of length " + to_string(startingLength) + " doesn't fit at the spawn of map " + to_string(index));
+    return make_unique<Snake>(Point{info.spawn.x + startingLength, info.spawn.y}, startingLength);
+}
+
+MapDefinition MapPack::parseMap(string_view text, const string &name)
+{
+    MapDefinition map;
+    map.name = name;
+
+    // Split the rows, ignoring a trailing new line and carriage returns
+    vector<string_view> rows;
+    for (size_t start{0}; start < text.size();)
+    {
+        size_t end{min(text.find('\n', start), text.size())};
+        string_view row{text.substr(start, end - start)};
+        if (!row.empty() && row.back() == '\r')
+            row.remove_suffix(1);
+        rows.push_back(row);
+        start = end + 1;
+    }
+    if (!rows.empty() && (rows.front() == "wrapped" || rows.front() == "walled"))
+    {
+        map.topology = rows.front() == "wrapped" ? BoardTopology::WRAPPED : BoardTopology::WALLED;
+        rows.erase(rows.begin());
+    }
+    if (rows.empty() || rows.front().empty())
+        throw invalid_argument("map " + name + " has no rows");
+
+    // A board of width w has w + 1 columns
+    map.width = static_cast<int>(rows.front().size()) - 1;
+    map.height = static_cast<int>(rows.size()) - 1;
+    map.spawn = Point{0, map.height};
+    map.obstacles.reserve(getCellCount(map.width, map.height));
+    for (int y{0}; y <= map.height; ++y)
+    {
+        const string_view row{rows[y]};
+        if (static_cast<int>(row.size()) != map.width + 1)
+            throw invalid_argument("row " + to_string(y + 1) + " of map " + name + " isn't as long as the first row");
+        for (int x{0}; x <= map.width; ++x)
+        {
+            map.obstacles.push_back(row[x] == '#' ? 1 : 0);
+            if (row[x] == 'S')
+                map.spawn = Point{x, y};
+        }
+    }
+    return map;
+}
+
+void MapPack::write(const string &path, const vector<MapDefinition> &maps)
+{
+    // Lay out the header, the entries and then every map's cells and name
+    string header;
+    header.append(MAGIC);
+    appendLittle<uint32_t>(header, VERSION);
+    appendLittle<uint32_t>(header, static_cast<uint32_t>(maps.size()));
+    appendLittle<uint64_t>(header, HEADER_SIZE);
+    appendLittle<uint64_t>(header, 0);
+
+    string entries;
+    string data;
+    const uint64_t dataOffset{HEADER_SIZE + maps.size() * ENTRY_SIZE};
+    for (const auto &map : maps)
+    {
+        if (map.width <= 0 || map.height <= 0 || map.width > MAX_SIDE || map.height > MAX_SIDE)
+            throw invalid_argument("map " + map.name + " has an invalid size");
+
+        // Maps without obstacles store a cell of 0 for every cell
+        string cells(getCellCount(map.width, map.height), '\0');
+        if (!map.obstacles.empty())
+        {
+            if (map.obstacles.size() != cells.size())
+                throw invalid_argument("map " + map.name + " must have one obstacle byte per cell");
+            for (size_t cell{0}; cell < cells.size(); ++cell)
+                cells[cell] = map.obstacles[cell] != 0 ? 1 : 0;
+        }
+
+        appendLittle<uint64_t>(entries, dataOffset + data.size());
+        appendLittle<uint64_t>(entries, dataOffset + data.size() + cells.size());
+        appendLittle<uint32_t>(entries, static_cast<uint32_t>(map.name.size()));
+        appendLittle<int32_t>(entries, map.width);
+        appendLittle<int32_t>(entries, map.height);
+        appendLittle<int32_t>(entries, map.spawn.x);
+        appendLittle<int32_t>(entries, map.spawn.y);
+        appendLittle<uint32_t>(entries, map.topology == BoardTopology::WRAPPED ? 1 : 0);
+        appendLittle<uint32_t>(entries, computeCrc32(cells));
+        appendLittle<uint32_t>(entries, 0);
+        data += cells;
+        data += map.name;
+    }
+
+    ofstream stream(path, ios::binary | ios::trunc);
+    stream << header << entries << data;
+    if (!stream.flush())
+        throw invalid_argument("Failed to write map pack at: " + path);
+}
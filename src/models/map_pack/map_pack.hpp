@@ -0,0 +1,142 @@
+#ifndef MAP_PACK_H
+#define MAP_PACK_H
+
+#include "board.hpp"
+#include "mapped_file.hpp"
+#include "point.hpp"
+#include "snake.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief A map to put in a map pack
+ *
+ */
+struct MapDefinition
+{
+    std::string name;
+    int width{0};
+    int height{0};
+    BoardTopology topology{BoardTopology::WALLED};
+
+    /**
+     * @brief The tail end of the snake at the start, the snake lies to the right of it facing right
+     *
+     */
+    Point spawn;
+
+    /**
+     * @brief 1 for the cells blocked by an obstacle, one byte per cell row by row
+     *
+     */
+    std::vector<std::uint8_t> obstacles;
+};
+
+/**
+ * @brief The maps of a map pack file without their cells
+ *
+ */
+struct MapInfo
+{
+    std::string_view name;
+    int width;
+    int height;
+    BoardTopology topology;
+    Point spawn;
+};
+
+/**
+ * @brief Many maps in one file, mapped into memory and read without parsing
+ *
+ * @note The file is a fixed header, a fixed size entry per map and then the cells and names of the maps. Every
+ * number is little endian. Opening a pack only checks that the header and entries fit the file, a map's cells are
+ * copied straight into its board and checked against the entry's CRC-32 when the board is created. The file is
+ * created by MapPack::write, see parseMap for the text form of a map.
+ */
+class MapPack
+{
+private:
+    MappedFile file;
+    std::size_t mapCount{0};
+
+    /**
+     * @brief Get the bytes of the map's entry
+     *
+     * @throws std::out_of_range Thrown if there is no map at the index
+     */
+    const char *getEntry(std::size_t index) const;
+
+public:
+    /**
+     * @brief Maps the pack file into memory
+     *
+     * @param path The pack file
+     * @throws std::invalid_argument Thrown if the file can't be mapped or isn't a map pack
+     */
+    explicit MapPack(const std::string &path);
+
+    /**
+     * @brief Get the number of maps in the pack
+     *
+     * @return std::size_t
+     */
+    std::size_t getMapCount() const { return mapCount; }
+
+    /**
+     * @brief Get the name, size, topology and spawn of the map
+     *
+     * @param index The map, starting at 0
+     * @throws std::out_of_range Thrown if there is no map at the index
+     * @return MapInfo The name points into the mapped file and lives as long as the pack
+     */
+    MapInfo getMapInfo(std::size_t index) const;
+
+    /**
+     * @brief Creates the board of the map
+     *
+     * @param index The map, starting at 0
+     * @throws std::out_of_range Thrown if there is no map at the index
+     * @throws std::invalid_argument Thrown if the map's cells are corrupt
+     * @return std::unique_ptr<Board>
+     */
+    std::unique_ptr<Board> createBoard(std::size_t index) const;
+
+    /**
+     * @brief Creates a snake at the spawn of the map
+     *
+     * @param index The map, starting at 0
+     * @param startingLength The length of the snake
+     * @throws std::out_of_range Thrown if there is no map at the index
+     * @throws std::invalid_argument Thrown if the snake doesn't fit on free cells at the spawn
+     * @return std::unique_ptr<Snake>
+     */
+    std::unique_ptr<Snake> createSnake(std::size_t index, int startingLength) const;
+
+    /**
+     * @brief Parses a map from text
+     *
+     * @note Each line is a row of the board: '#' is an obstacle, 'S' the tail end of the snake at the start and
+     * any other character an empty cell. A first line of "wrapped" or "walled" sets the topology, boards are walled
+     * by default. Without an 'S' the snake starts in the bottom left corner like on an empty board.
+     * @param text The map
+     * @param name The name of the map
+     * @throws std::invalid_argument Thrown if the rows aren't the same length or there are no rows
+     * @return MapDefinition
+     */
+    static MapDefinition parseMap(std::string_view text, const std::string &name);
+
+    /**
+     * @brief Writes the maps to a pack file
+     *
+     * @param path The pack file, replaced if it exists
+     * @param maps The maps in the order they are indexed
+     * @throws std::invalid_argument Thrown if a map is invalid or the file can't be written
+     */
+    static void write(const std::string &path, const std::vector<MapDefinition> &maps);
+};
+
+#endif
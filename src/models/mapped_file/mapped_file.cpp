@@ -0,0 +1,108 @@
+#include "mapped_file.hpp"
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const string &path)
+{
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        fileHandle = nullptr;
+        throw invalid_argument("Failed to open file at: " + path);
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize))
+    {
+        release();
+        throw invalid_argument("Failed to read the size of file at: " + path);
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+    if (size == 0)
+        return;
+
+    // Map the whole file
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle)
+        bytes = static_cast<const char *>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!bytes)
+    {
+        release();
+        throw invalid_argument("Failed to map file at: " + path);
+    }
+}
+
+void MappedFile::release()
+{
+    if (bytes)
+        UnmapViewOfFile(bytes);
+    if (mappingHandle)
+        CloseHandle(mappingHandle);
+    if (fileHandle)
+        CloseHandle(fileHandle);
+    bytes = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile(const string &path)
+{
+    const int descriptor{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (descriptor < 0)
+        throw invalid_argument("Failed to open file at: " + path);
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0)
+    {
+        close(descriptor);
+        throw invalid_argument("Failed to read the size of file at: " + path);
+    }
+    size = static_cast<size_t>(status.st_size);
+    if (size == 0)
+    {
+        close(descriptor);
+        return;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void *mapping{mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0)};
+    close(descriptor);
+    if (mapping == MAP_FAILED)
+    {
+        size = 0;
+        throw invalid_argument("Failed to map file at: " + path);
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    bytes = static_cast<const char *>(mapping);
+}
+
+void MappedFile::release()
+{
+    if (bytes)
+        munmap(const_cast<char *>(bytes), size);
+    bytes = nullptr;
+    size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    release();
+}
@@ -0,0 +1,69 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief A whole file mapped read only into memory
+ *
+ */
+class MappedFile
+{
+private:
+    const char *bytes{nullptr};
+    std::size_t size{0};
+
+#if defined(_WIN32)
+    void *fileHandle{nullptr};
+    void *mappingHandle{nullptr};
+#endif
+
+    /**
+     * @brief Unmaps the file
+     *
+     */
+    void release();
+
+public:
+    /**
+     * @brief Maps the file
+     *
+     * @param path The file to map
+     * @throws std::invalid_argument Thrown if the file can't be opened or mapped
+     */
+    explicit MappedFile(const std::string &path);
+
+    /**
+     * @brief Unmaps the file
+     *
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @brief Get the bytes of the file
+     *
+     * @return const char* Null for an empty file
+     */
+    const char *getData() const { return bytes; }
+
+    /**
+     * @brief Get the Size object
+     *
+     * @return std::size_t
+     */
+    std::size_t getSize() const { return size; }
+
+    /**
+     * @brief Get the file contents as a string view
+     *
+     * @return std::string_view
+     */
+    std::string_view getView() const { return {bytes, size}; }
+};
+
+#endif
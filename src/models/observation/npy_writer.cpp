@@ -0,0 +1,71 @@
+#include "npy_writer.hpp"
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+NpyWriter::NpyWriter(const string &path, DataType dataType, vector<size_t> sampleShape)
+    : file(path, ofstream::binary | ofstream::trunc), dataType(dataType), sampleShape(std::move(sampleShape)), sampleSize(1)
+{
+    if (file.fail())
+        throw invalid_argument("Failed to create npy file at: " + path);
+    for (const auto dimension : this->sampleShape)
+        sampleSize *= dimension;
+    writeHeader();
+}
+
+NpyWriter::~NpyWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+        // Destructors must not throw
+    }
+}
+
+void NpyWriter::writeHeader()
+{
+    // Describe the array as a python dict
+    string header{"{'descr': '"};
+    header += dataType == DataType::UINT8 ? "|u1" : dataType == DataType::FLOAT32 ? "<f4" : "<u8";
+    header += "', 'fortran_order': False, 'shape': (" + to_string(sampleCount) + ',';
+    for (const auto dimension : sampleShape)
+        header += ' ' + to_string(dimension) + ',';
+    header += "), }";
+
+    // Magic, version 1.0 and the little endian header length, padded with spaces and ending in a newline
+    const size_t prefixSize{10};
+    if (header.size() + 1 > HEADER_SIZE - prefixSize)
+        throw invalid_argument("npy sample shape is too large");
+    header.append(HEADER_SIZE - prefixSize - header.size() - 1, ' ');
+    header += '\n';
+
+    const auto headerLength{static_cast<uint16_t>(header.size())};
+    file.seekp(0);
+    file.write("\x93NUMPY\x01\x00", 8);
+    const char length[2]{static_cast<char>(headerLength & 0xFF), static_cast<char>(headerLength >> 8)};
+    file.write(length, 2);
+    file.write(header.data(), static_cast<streamsize>(header.size()));
+    file.seekp(0, ios_base::end);
+}
+
+void NpyWriter::appendBytes(const void *sample, size_t elementSize, DataType expectedType)
+{
+    if (dataType != expectedType)
+        throw invalid_argument("sample type does not match the npy data type");
+    if (!file.is_open())
+        throw invalid_argument("npy writer is closed");
+    file.write(static_cast<const char *>(sample), static_cast<streamsize>(sampleSize * elementSize));
+    ++sampleCount;
+}
+
+void NpyWriter::close()
+{
+    if (!file.is_open())
+        return;
+    writeHeader();
+    file.close();
+}
@@ -0,0 +1,106 @@
+#ifndef NPY_WRITER_H
+#define NPY_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Streams fixed size samples into a NumPy .npy file
+ *
+ * @note The file holds an array of shape (samples, ...sampleShape). The sample count is written into the header
+ * when the writer is closed, so a file that was not closed reads as having zero samples.
+ */
+class NpyWriter
+{
+public:
+    /**
+     * @brief The element types that can be written
+     *
+     */
+    enum class DataType
+    {
+        UINT8,
+        FLOAT32,
+        UINT64
+    };
+
+private:
+    /**
+     * @brief The size reserved for the header so it can be rewritten in place
+     *
+     */
+    constexpr static std::size_t HEADER_SIZE{128};
+
+    std::ofstream file;
+    DataType dataType;
+    std::vector<std::size_t> sampleShape;
+    std::size_t sampleSize;
+    std::size_t sampleCount{0};
+
+    /**
+     * @brief Writes the header for the current sample count at the start of the file
+     *
+     */
+    void writeHeader();
+
+    /**
+     * @brief Appends raw sample bytes
+     *
+     */
+    void appendBytes(const void *sample, std::size_t elementSize, DataType expectedType);
+
+public:
+    /**
+     * @brief Construct a new Npy Writer object
+     *
+     * @param path The file to create
+     * @param dataType The element type
+     * @param sampleShape The shape of a single sample
+     * @throws std::invalid_argument Thrown if the file can't be created
+     */
+    NpyWriter(const std::string &path, DataType dataType, std::vector<std::size_t> sampleShape);
+
+    /**
+     * @brief Closes the writer if it is still open
+     *
+     */
+    ~NpyWriter();
+
+    NpyWriter(const NpyWriter &) = delete;
+    NpyWriter &operator=(const NpyWriter &) = delete;
+
+    /**
+     * @brief Appends a sample
+     *
+     * @param sample The sample values, the writer must have been created with the matching data type
+     */
+    void append(const std::uint8_t *sample) { appendBytes(sample, sizeof(std::uint8_t), DataType::UINT8); }
+
+    /**
+     * @copydoc append
+     */
+    void append(const float *sample) { appendBytes(sample, sizeof(float), DataType::FLOAT32); }
+
+    /**
+     * @copydoc append
+     */
+    void append(const std::uint64_t *sample) { appendBytes(sample, sizeof(std::uint64_t), DataType::UINT64); }
+
+    /**
+     * @brief Get the number of samples written
+     *
+     * @return std::size_t
+     */
+    std::size_t getSampleCount() const { return sampleCount; }
+
+    /**
+     * @brief Writes the final header and closes the file
+     *
+     */
+    void close();
+};
+
+#endif
@@ -0,0 +1,202 @@
+#include "observation.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * @brief The value of a set cell
+ *
+ */
+template <typename T>
+constexpr T SET_VALUE{1};
+
+/**
+ * @brief Converts an age between 0 and 1 to the buffer type
+ *
+ */
+template <typename T>
+static T toAgeValue(double age)
+{
+    if constexpr (is_floating_point_v<T>)
+        return static_cast<T>(age);
+    else
+        return static_cast<T>(age * 255.0 + 0.5);
+}
+
+template <typename T>
+void ObservationWriter::setCell(T *observation, ObservationPlane plane, const Point &point, T value) const
+{
+    // Crash points can be outside the board
+    if (point.x < 0 || point.x > width || point.y < 0 || point.y > height)
+        return;
+    observation[static_cast<size_t>(plane) * getPlaneSize() + static_cast<size_t>(point.y) * (width + 1) + point.x] = value;
+}
+
+void ObservationWriter::remember(const Game &game)
+{
+    hasWritten = true;
+    lastHead = game.getSnake().getHead();
+    lastTail = game.getSnake().getTail();
+    lastApple = game.getApple();
+    lastLength = game.getSnake().getBody().size();
+}
+
+template <typename T>
+void ObservationWriter::write(const Game &game, T *observation)
+{
+    if (game.getBoard().getWidth() != width || game.getBoard().getHeight() != height)
+        throw invalid_argument("game board does not match the observation size");
+
+    fill_n(observation, getObservationSize(), T{0});
+
+    // Body and age planes
+    const auto &body{game.getSnake().getBody()};
+    const double length{static_cast<double>(body.size())};
+    size_t index{0};
+    for (const auto &segment : body)
+    {
+        setCell(observation, ObservationPlane::BODY, segment, SET_VALUE<T>);
+        if (includeAge)
+            setCell(observation, ObservationPlane::AGE, segment, toAgeValue<T>((index + 1) / length));
+        ++index;
+    }
+
+    setCell(observation, ObservationPlane::HEAD, game.getSnake().getHead(), SET_VALUE<T>);
+    setCell(observation, ObservationPlane::TAIL, game.getSnake().getTail(), SET_VALUE<T>);
+    setCell(observation, ObservationPlane::APPLE, game.getApple(), SET_VALUE<T>);
+    remember(game);
+}
+
+template <typename T>
+void ObservationWriter::update(const Game &game, T *observation)
+{
+    // Incremental updates need the previous state to be exactly one step behind
+    const auto &body{game.getSnake().getBody()};
+    const bool isOneStep{hasWritten && body.size() >= 2 && (body.size() == lastLength || body.size() == lastLength + 1) && body[body.size() - 2] == lastHead};
+    if (includeAge || !isOneStep)
+    {
+        write(game, observation);
+        return;
+    }
+
+    const Point &head{game.getSnake().getHead()};
+    const Point &tail{game.getSnake().getTail()};
+
+    // The old tail left the body unless the snake grew or the head moved into it
+    if (tail != lastTail && lastTail != head)
+        setCell(observation, ObservationPlane::BODY, lastTail, T{0});
+    setCell(observation, ObservationPlane::BODY, head, SET_VALUE<T>);
+
+    setCell(observation, ObservationPlane::HEAD, lastHead, T{0});
+    setCell(observation, ObservationPlane::HEAD, head, SET_VALUE<T>);
+    setCell(observation, ObservationPlane::TAIL, lastTail, T{0});
+    setCell(observation, ObservationPlane::TAIL, tail, SET_VALUE<T>);
+    setCell(observation, ObservationPlane::APPLE, lastApple, T{0});
+    setCell(observation, ObservationPlane::APPLE, game.getApple(), SET_VALUE<T>);
+    remember(game);
+}
+
+template <typename T>
+void ObservationWriter::writeBatch(const Game *const *games, int count, T *observations)
+{
+    for (int index{0}; index < count; ++index)
+        write(*games[index], observations + static_cast<size_t>(index) * getObservationSize());
+
+    // The writer can only track one buffer so batches are never updated incrementally
+    hasWritten = false;
+}
+
+BatchObservationWriter::BatchObservationWriter(const BatchStepper &batch)
+    : layout(batch.getWidth(), batch.getHeight()), lastHeads(batch.getGameCount()), lastTails(batch.getGameCount()), lastApples(batch.getGameCount()), needsFullWrite(batch.getGameCount())
+{
+}
+
+/**
+ * @brief Writes the full observation of one game of a batch
+ *
+ */
+template <typename T>
+static void writeBatchGame(const BatchStepper &batch, int game, size_t planeSize, T *observation)
+{
+    fill_n(observation, planeSize * 4, T{0});
+    const int stride{batch.getWidth() + 1};
+    for (int index{0}; index < batch.getLength(game); ++index)
+        observation[static_cast<size_t>(ObservationPlane::BODY) * planeSize + batch.getBodyCell(game, index)] = SET_VALUE<T>;
+    observation[static_cast<size_t>(ObservationPlane::HEAD) * planeSize + batch.getHeadY(game) * stride + batch.getHeadX(game)] = SET_VALUE<T>;
+    observation[static_cast<size_t>(ObservationPlane::TAIL) * planeSize + batch.getTailCell(game)] = SET_VALUE<T>;
+    if (batch.getAppleX(game) >= 0)
+        observation[static_cast<size_t>(ObservationPlane::APPLE) * planeSize + batch.getAppleY(game) * stride + batch.getAppleX(game)] = SET_VALUE<T>;
+}
+
+template <typename T>
+void BatchObservationWriter::write(const BatchStepper &batch, T *observations)
+{
+    const int stride{batch.getWidth() + 1};
+    for (int game{0}; game < batch.getGameCount(); ++game)
+    {
+        writeBatchGame(batch, game, layout.getPlaneSize(), observations + game * layout.getObservationSize());
+        lastHeads[game] = batch.getHeadY(game) * stride + batch.getHeadX(game);
+        lastTails[game] = batch.getTailCell(game);
+        lastApples[game] = batch.getAppleX(game) >= 0 ? batch.getAppleY(game) * stride + batch.getAppleX(game) : -1;
+        needsFullWrite[game] = batch.isDone(game);
+    }
+    hasWritten = true;
+}
+
+template <typename T>
+void BatchObservationWriter::update(const BatchStepper &batch, T *observations)
+{
+    if (!hasWritten)
+    {
+        write(batch, observations);
+        return;
+    }
+
+    const int stride{batch.getWidth() + 1};
+    const size_t planeSize{layout.getPlaneSize()};
+    for (int game{0}; game < batch.getGameCount(); ++game)
+    {
+        T *observation{observations + game * layout.getObservationSize()};
+        const int head{batch.getHeadY(game) * stride + batch.getHeadX(game)};
+        const int tail{batch.getTailCell(game)};
+        const int apple{batch.getAppleX(game) >= 0 ? batch.getAppleY(game) * stride + batch.getAppleX(game) : -1};
+
+        // Games that crashed or cleared the board are reset on the following step
+        if (needsFullWrite[game])
+        {
+            writeBatchGame(batch, game, planeSize, observation);
+        }
+        else
+        {
+            if (tail != lastTails[game] && lastTails[game] != head)
+                observation[static_cast<size_t>(ObservationPlane::BODY) * planeSize + lastTails[game]] = T{0};
+            observation[static_cast<size_t>(ObservationPlane::BODY) * planeSize + head] = SET_VALUE<T>;
+            observation[static_cast<size_t>(ObservationPlane::HEAD) * planeSize + lastHeads[game]] = T{0};
+            observation[static_cast<size_t>(ObservationPlane::HEAD) * planeSize + head] = SET_VALUE<T>;
+            observation[static_cast<size_t>(ObservationPlane::TAIL) * planeSize + lastTails[game]] = T{0};
+            observation[static_cast<size_t>(ObservationPlane::TAIL) * planeSize + tail] = SET_VALUE<T>;
+            if (lastApples[game] >= 0)
+                observation[static_cast<size_t>(ObservationPlane::APPLE) * planeSize + lastApples[game]] = T{0};
+            if (apple >= 0)
+                observation[static_cast<size_t>(ObservationPlane::APPLE) * planeSize + apple] = SET_VALUE<T>;
+        }
+        lastHeads[game] = head;
+        lastTails[game] = tail;
+        lastApples[game] = apple;
+        needsFullWrite[game] = batch.isDone(game);
+    }
+}
+
+// The supported buffer types
+template void ObservationWriter::write<uint8_t>(const Game &, uint8_t *);
+template void ObservationWriter::write<float>(const Game &, float *);
+template void ObservationWriter::update<uint8_t>(const Game &, uint8_t *);
+template void ObservationWriter::update<float>(const Game &, float *);
+template void ObservationWriter::writeBatch<uint8_t>(const Game *const *, int, uint8_t *);
+template void ObservationWriter::writeBatch<float>(const Game *const *, int, float *);
+template void BatchObservationWriter::write<uint8_t>(const BatchStepper &, uint8_t *);
+template void BatchObservationWriter::write<float>(const BatchStepper &, float *);
+template void BatchObservationWriter::update<uint8_t>(const BatchStepper &, uint8_t *);
+template void BatchObservationWriter::update<float>(const BatchStepper &, float *);
@@ -0,0 +1,203 @@
+#ifndef OBSERVATION_H
+#define OBSERVATION_H
+
+#include "game.hpp"
+#include "batch_stepper.hpp"
+#include "point.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief The feature planes of an observation in channel order
+ *
+ */
+enum class ObservationPlane
+{
+    BODY,
+    HEAD,
+    TAIL,
+    APPLE,
+    AGE
+};
+
+/**
+ * @brief Writes games as feature planes into caller provided buffers
+ *
+ * @note Observations are channel major, plane by plane, each plane is (height + 1) rows of (width + 1) cells
+ * matching the cells of the board. Cells are 1 when set and 0 otherwise, the optional age plane holds the
+ * position of each segment counted from the tail divided by the snake length, scaled to 255 for uint8_t buffers.
+ * Only uint8_t and float buffers are supported.
+ */
+class ObservationWriter
+{
+private:
+    /**
+     * @brief The board dimensions
+     *
+     */
+    int width;
+    int height;
+
+    /**
+     * @brief Whether the age plane is written
+     *
+     */
+    bool includeAge;
+
+    /**
+     * @brief The state written to the buffer last, used for incremental updates
+     *
+     */
+    bool hasWritten{false};
+    Point lastHead;
+    Point lastTail;
+    Point lastApple;
+    std::size_t lastLength{0};
+
+    /**
+     * @brief Sets a cell of a plane if the point is in the board
+     *
+     */
+    template <typename T>
+    void setCell(T *observation, ObservationPlane plane, const Point &point, T value) const;
+
+    /**
+     * @brief Remembers the state written so the next update can be incremental
+     *
+     */
+    void remember(const Game &game);
+
+public:
+    /**
+     * @brief Construct a new Observation Writer object
+     *
+     * @param width The board width
+     * @param height The board height
+     * @param includeAge Whether to write the age plane
+     */
+    ObservationWriter(int width, int height, bool includeAge = false) : width(width), height(height), includeAge(includeAge) {}
+
+    /**
+     * @brief Get the number of planes written
+     *
+     * @return int
+     */
+    int getPlaneCount() const { return includeAge ? 5 : 4; }
+
+    /**
+     * @brief Get the number of cells in a plane
+     *
+     * @return std::size_t
+     */
+    std::size_t getPlaneSize() const { return static_cast<std::size_t>(width + 1) * (height + 1); }
+
+    /**
+     * @brief Get the number of values in an observation
+     *
+     * @return std::size_t
+     */
+    std::size_t getObservationSize() const { return getPlaneSize() * getPlaneCount(); }
+
+    /**
+     * @brief Writes the full observation of the game
+     *
+     * @param game The game, its board must match the writer
+     * @param observation The buffer of getObservationSize() values
+     */
+    template <typename T>
+    void write(const Game &game, T *observation);
+
+    /**
+     * @brief Updates the observation written last to the game's current state
+     *
+     * @note Only the head, tail and apple cells that changed are touched when the game moved a single step since
+     * the last write, otherwise the full observation is written. The age plane always requires a full write.
+     * @param game The game written last
+     * @param observation The buffer written last
+     */
+    template <typename T>
+    void update(const Game &game, T *observation);
+
+    /**
+     * @brief Writes the full observations of many games one after another
+     *
+     * @param games The games, their boards must match the writer
+     * @param count The number of games
+     * @param observations The buffer of count * getObservationSize() values
+     */
+    template <typename T>
+    void writeBatch(const Game *const *games, int count, T *observations);
+};
+
+/**
+ * @brief Writes the games of a batch stepper as feature planes
+ *
+ * @note Uses the same layout as ObservationWriter, one observation per game one after another
+ */
+class BatchObservationWriter
+{
+private:
+    /**
+     * @brief The layout of a single observation
+     *
+     */
+    ObservationWriter layout;
+
+    /**
+     * @brief The cells written to the buffer last for each game, used for incremental updates
+     *
+     */
+    std::vector<std::int32_t> lastHeads;
+    std::vector<std::int32_t> lastTails;
+    std::vector<std::int32_t> lastApples;
+
+    /**
+     * @brief Whether each game crashed when last written, it is reset by the following step
+     *
+     */
+    std::vector<std::uint8_t> needsFullWrite;
+
+    /**
+     * @brief Whether the buffer holds the full observations of the batch
+     *
+     */
+    bool hasWritten{false};
+
+public:
+    /**
+     * @brief Construct a new Batch Observation Writer object
+     *
+     * @param batch The batch to write observations for
+     */
+    explicit BatchObservationWriter(const BatchStepper &batch);
+
+    /**
+     * @brief Get the number of values in an observation
+     *
+     * @return std::size_t
+     */
+    std::size_t getObservationSize() const { return layout.getObservationSize(); }
+
+    /**
+     * @brief Writes the full observations of the batch
+     *
+     * @param batch The batch
+     * @param observations The buffer of getGameCount() * getObservationSize() values
+     */
+    template <typename T>
+    void write(const BatchStepper &batch, T *observations);
+
+    /**
+     * @brief Updates the observations written last after a single step of the batch
+     *
+     * @note Only the head, tail and apple cells are touched, games that were reset are fully rewritten.
+     * Must be called after every step.
+     * @param batch The batch written last
+     * @param observations The buffer written last
+     */
+    template <typename T>
+    void update(const BatchStepper &batch, T *observations);
+};
+
+#endif
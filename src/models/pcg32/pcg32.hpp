@@ -0,0 +1,147 @@
+#ifndef PCG32_H
+#define PCG32_H
+
+#include <cstdint>
+#include <limits>
+
+/**
+ * @brief A small, fast and seedable random number generator
+ *
+ * @note PCG32 (XSH RR) from O'Neill's PCG family: a 64 bit LCG whose output is permuted down to 32 bits. Each
+ * generator holds 16 bytes, so every game owns one instead of sharing a global engine. The same seed and stream
+ * always give the same sequence, and different streams of one seed are independent sequences, so parallel
+ * simulations can use their index as the stream. Satisfies UniformRandomBitGenerator. Not thread safe.
+ */
+class Pcg32
+{
+private:
+    static constexpr std::uint64_t MULTIPLIER{6364136223846793005ULL};
+    static constexpr std::uint64_t DEFAULT_STREAM{0xda3e39cb94b95bdbULL};
+
+    std::uint64_t state{0};
+
+    /**
+     * @brief The LCG increment, always odd, picks the stream
+     *
+     */
+    std::uint64_t increment{1};
+
+public:
+    using result_type = std::uint32_t;
+
+    /**
+     * @brief Construct a new Pcg32 object
+     *
+     * @param seed The starting point in the sequence
+     * @param stream The sequence to draw from, generators on different streams don't overlap
+     */
+    constexpr explicit Pcg32(std::uint64_t seed = 0, std::uint64_t stream = DEFAULT_STREAM) : increment((stream << 1) | 1)
+    {
+        (*this)();
+        state += seed;
+        (*this)();
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    /**
+     * @brief Get the next random number
+     *
+     * @return result_type A number between min() and max()
+     */
+    constexpr result_type operator()()
+    {
+        const std::uint64_t oldState{state};
+        state = oldState * MULTIPLIER + increment;
+        const auto shifted{static_cast<std::uint32_t>(((oldState >> 18) ^ oldState) >> 27)};
+        const auto rotation{static_cast<std::uint32_t>(oldState >> 59)};
+        return (shifted >> rotation) | (shifted << ((0u - rotation) & 31));
+    }
+
+    /**
+     * @brief Get a random number below the bound without bias
+     *
+     * @note Lemire's multiply and shift, a division is only needed for the rare draws that would be biased
+     * @param bound The number of possible results, must be positive
+     * @return std::uint32_t A number from 0 to bound - 1
+     */
+    constexpr std::uint32_t bounded(std::uint32_t bound)
+    {
+        std::uint64_t product{static_cast<std::uint64_t>((*this)()) * bound};
+        auto low{static_cast<std::uint32_t>(product)};
+        if (low < bound)
+        {
+            const std::uint32_t threshold{(0u - bound) % bound};
+            while (low < threshold)
+            {
+                product = static_cast<std::uint64_t>((*this)()) * bound;
+                low = static_cast<std::uint32_t>(product);
+            }
+        }
+        return static_cast<std::uint32_t>(product >> 32);
+    }
+
+    /**
+     * @brief Get a random number in the range without bias
+     *
+     * @param low The smallest possible result
+     * @param high The largest possible result, must be at least low
+     * @return int A number from low to high
+     */
+    constexpr int between(int low, int high)
+    {
+        return low + static_cast<int>(bounded(static_cast<std::uint32_t>(high - low) + 1));
+    }
+
+    /**
+     * @brief Skips ahead in the sequence as if the generator was called the given number of times
+     *
+     * @note Takes a step per bit of the distance, so jumping far ahead is as cheap as jumping one ahead
+     * @param distance The number of results to skip
+     */
+    constexpr void advance(std::uint64_t distance)
+    {
+        std::uint64_t accumulatedMultiplier{1};
+        std::uint64_t accumulatedIncrement{0};
+        std::uint64_t multiplier{MULTIPLIER};
+        std::uint64_t stepIncrement{increment};
+        for (; distance > 0; distance >>= 1)
+        {
+            if (distance & 1)
+            {
+                accumulatedMultiplier *= multiplier;
+                accumulatedIncrement = accumulatedIncrement * multiplier + stepIncrement;
+            }
+            stepIncrement = (multiplier + 1) * stepIncrement;
+            multiplier *= multiplier;
+        }
+        state = accumulatedMultiplier * state + accumulatedIncrement;
+    }
+
+    /**
+     * @brief Creates a generator on a new stream seeded from this one
+     *
+     * @note Splitting the same generator state always gives the same child, so trees of simulations stay
+     * reproducible
+     * @return Pcg32 The child generator
+     */
+    constexpr Pcg32 split()
+    {
+        // Draw one at a time, the order operands are evaluated in isn't fixed
+        std::uint64_t words[4];
+        for (auto &word : words)
+            word = (*this)();
+        return Pcg32((words[0] << 32) | words[1], (words[2] << 32) | words[3]);
+    }
+
+    /**
+     * @brief Get the position in the sequence, generators on one stream draw the same from the same state
+     *
+     */
+    constexpr std::uint64_t getState() const { return state; }
+
+    constexpr bool operator==(const Pcg32 &) const = default;
+};
+
+#endif
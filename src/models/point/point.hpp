@@ -29,13 +29,13 @@ struct Point
      * @param x The x dimension of the point
      * @param y The y dimension of the point
      */
-    Point(const int x, const int y) : x{x}, y{y} {}
+    constexpr Point(const int x, const int y) : x{x}, y{y} {}
 
     /**
      * @brief Construct a new Point object
      *
      */
-    Point() = default;
+    constexpr Point() = default;
 
     /**
      * @brief Get the Point in the direction specified
@@ -43,19 +43,10 @@ struct Point
      * @param direction The direction to get the point of
      * @return Point The point adjacent in the direction specified
      */
-    Point getAdjacentPoint(Directions::Direction direction) const
+    constexpr Point getAdjacentPoint(Directions::Direction direction) const
     {
-        switch (direction)
-        {
-        case Directions::Direction::UP:
-            return Point{x, y - 1};
-        case Directions::Direction::RIGHT:
-            return Point{x + 1, y};
-        case Directions::Direction::DOWN:
-            return Point{x, y + 1};
-        case Directions::Direction::LEFT:
-            return Point{x - 1, y};
-        }
+        const auto index{static_cast<int>(direction)};
+        return Point{x + Directions::DELTA_X[index], y + Directions::DELTA_Y[index]};
     }
 
     /**
@@ -64,6 +55,12 @@ struct Point
      */
     std::strong_ordering operator<=>(const Point &otherPoint) const = default;
 
+    /**
+     * @brief Copy a Point object, declared since the copy assignment operator is user provided
+     *
+     */
+    constexpr Point(const Point &otherPoint) = default;
+
     /**
      * @brief Overide the copy assignment operator to assign const members
      *
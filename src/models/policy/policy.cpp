@@ -0,0 +1,364 @@
+#include "policy.hpp"
+#include "mapped_file.hpp"
+#include "binary_format.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief The first bytes of a policy file
+ *
+ */
+constexpr string_view MAGIC{"SNAKENET"};
+constexpr uint32_t VERSION{1};
+
+/**
+ * @brief The sizes of the file header and of a layer's header
+ *
+ * @note Header: magic, uint32 version, uint32 layer count, int32 width, int32 height, uint32 plane count, 4
+ * reserved bytes. Layer: uint32 kind, precision, activation, input count and output count, 4 reserved bytes, then
+ * the float biases, the float scales of int8 layers and the weights, int8 weights padded to 4 bytes.
+ */
+constexpr size_t HEADER_SIZE{32};
+constexpr size_t LAYER_HEADER_SIZE{24};
+
+/**
+ * @brief The largest board side and layer width a policy file holds
+ *
+ */
+constexpr int MAX_SIDE{4096};
+constexpr int MAX_LAYER_SIZE{1 << 24};
+
+/**
+ * @brief The number of games whose observations are written and evaluated together
+ *
+ */
+constexpr int DECISION_CHUNK{32};
+
+/**
+ * @brief Reads count little endian floats
+ *
+ */
+static vector<float> readFloats(const char *bytes, size_t count)
+{
+    vector<float> values(count);
+    for (size_t index{0}; index < count; ++index)
+        values[index] = bit_cast<float>(readLittle<uint32_t>(bytes + index * 4));
+    return values;
+}
+
+/**
+ * @brief Rounds the count up to a multiple of the block
+ *
+ */
+static size_t roundUp(size_t count, size_t block)
+{
+    return (count + block - 1) / block * block;
+}
+
+/**
+ * @brief Copies the planes into the middle of planes one cell larger on every side, with a border of zeros
+ *
+ */
+static void padPlanes(const float *planes, int channels, int rows, int columns, float *padded)
+{
+    const int paddedColumns{columns + 2};
+    fill_n(padded, static_cast<size_t>(channels) * (rows + 2) * paddedColumns, 0.0F);
+    for (int channel{0}; channel < channels; ++channel)
+        for (int y{0}; y < rows; ++y)
+            copy_n(planes + (static_cast<size_t>(channel) * rows + y) * columns, columns, padded + (static_cast<size_t>(channel) * (rows + 2) + y + 1) * paddedColumns + 1);
+}
+
+Policy::Policy(const string &path, SimdLevel simdLevel) : observationWriter(0, 0), simdLevel(simdLevel)
+{
+    const MappedFile file(path);
+    const char *bytes{file.getData()};
+    const size_t size{file.getSize()};
+    if (size < HEADER_SIZE || string_view{bytes, MAGIC.size()} != MAGIC)
+        throw invalid_argument(path + " is not a policy");
+    if (readLittle<uint32_t>(bytes + 8) != VERSION)
+        throw invalid_argument(path + " has an unsupported policy version");
+
+    const uint32_t layerCount{readLittle<uint32_t>(bytes + 12)};
+    width = readLittle<int32_t>(bytes + 16);
+    height = readLittle<int32_t>(bytes + 20);
+    const uint32_t planeCount{readLittle<uint32_t>(bytes + 24)};
+    if (width <= 0 || height <= 0 || width > MAX_SIDE || height > MAX_SIDE)
+        throw invalid_argument(path + " has an invalid board size");
+    if (planeCount != 4 && planeCount != 5)
+        throw invalid_argument(path + " must read 4 or 5 observation planes");
+    observationWriter = ObservationWriter(width, height, planeCount == 5);
+
+    // Convolutions keep the planes, the first dense layer flattens them
+    const int planeSize{(width + 1) * (height + 1)};
+    int channels{static_cast<int>(planeCount)};
+    int currentSize{channels * planeSize};
+    bool isSpatial{true};
+    auto loaded{make_shared<vector<Layer>>()};
+    size_t offset{HEADER_SIZE};
+    for (uint32_t index{0}; index < layerCount; ++index)
+    {
+        const string layerName{"layer " + to_string(index) + " of " + path};
+        if (size - offset < LAYER_HEADER_SIZE)
+            throw invalid_argument(path + " is truncated");
+        const char *header{bytes + offset};
+        const uint32_t kind{readLittle<uint32_t>(header)};
+        const uint32_t precision{readLittle<uint32_t>(header + 4)};
+        const uint32_t activation{readLittle<uint32_t>(header + 8)};
+        if (kind > 1 || precision > 1 || activation > 1)
+            throw invalid_argument(layerName + " has an unknown kind, precision or activation");
+
+        Layer layer{};
+        layer.kind = static_cast<PolicyLayerKind>(kind);
+        layer.precision = static_cast<PolicyPrecision>(precision);
+        layer.activation = static_cast<PolicyActivation>(activation);
+        layer.inputs = readLittle<int32_t>(header + 12);
+        layer.outputs = readLittle<int32_t>(header + 16);
+        if (layer.inputs <= 0 || layer.outputs <= 0 || layer.inputs > MAX_LAYER_SIZE || layer.outputs > MAX_LAYER_SIZE)
+            throw invalid_argument(layerName + " has an invalid size");
+
+        // Check the layer reads what the previous one wrote
+        const bool isConvolution{layer.kind == PolicyLayerKind::CONV3X3};
+        if (isConvolution ? !isSpatial || layer.inputs != channels : layer.inputs != currentSize)
+            throw invalid_argument(layerName + " doesn't fit the layer before it");
+        layer.inputSize = isConvolution ? layer.inputs * planeSize : layer.inputs;
+        layer.outputSize = isConvolution ? layer.outputs * planeSize : layer.outputs;
+        if (static_cast<int64_t>(layer.outputSize) > MAX_LAYER_SIZE)
+            throw invalid_argument(layerName + " has an invalid size");
+        channels = layer.outputs;
+        currentSize = layer.outputSize;
+        isSpatial = isConvolution;
+
+        // Read the biases, scales and weights
+        const size_t weightCount{static_cast<size_t>(layer.outputs) * layer.inputs * (isConvolution ? 9 : 1)};
+        const bool isInt8{layer.precision == PolicyPrecision::INT8};
+        const size_t outputBytes{static_cast<size_t>(layer.outputs) * 4};
+        const size_t weightBytes{isInt8 ? outputBytes + roundUp(weightCount, 4) : weightCount * 4};
+        offset += LAYER_HEADER_SIZE;
+        if ((size - offset) / 2 < outputBytes || size - offset - outputBytes < weightBytes)
+            throw invalid_argument(path + " is truncated");
+        layer.biases = readFloats(bytes + offset, layer.outputs);
+        offset += outputBytes;
+
+        vector<float> weights;
+        if (isInt8)
+        {
+            layer.weightScales = readFloats(bytes + offset, layer.outputs);
+            const auto *quantizedWeights{reinterpret_cast<const int8_t *>(bytes + offset + outputBytes)};
+            weights.resize(weightCount);
+            const size_t rowSize{weightCount / layer.outputs};
+            for (size_t weight{0}; weight < weightCount; ++weight)
+                weights[weight] = quantizedWeights[weight] * layer.weightScales[weight / rowSize];
+
+            // Later dense layers multiply the int8 weights directly, their rows padded to whole registers
+            if (!isConvolution && index > 0)
+            {
+                layer.paddedInputSize = static_cast<int>(roundUp(layer.inputs, POLICY_INT8_BLOCK));
+                layer.quantizedWeights.assign(static_cast<size_t>(layer.outputs) * layer.paddedInputSize, 0);
+                for (int output{0}; output < layer.outputs; ++output)
+                    copy_n(quantizedWeights + static_cast<size_t>(output) * layer.inputs, layer.inputs, layer.quantizedWeights.begin() + static_cast<size_t>(output) * layer.paddedInputSize);
+                weights.clear();
+            }
+        }
+        else
+            weights = readFloats(bytes + offset, weightCount);
+        offset += weightBytes;
+
+        // A dense first layer reads the observation, which is added up by column
+        if (!isConvolution && index == 0)
+        {
+            layer.columns.resize(weightCount);
+            for (int output{0}; output < layer.outputs; ++output)
+                for (int input{0}; input < layer.inputs; ++input)
+                    layer.columns[static_cast<size_t>(input) * layer.outputs + output] = weights[static_cast<size_t>(output) * layer.inputs + input];
+        }
+        else
+            layer.weights = std::move(weights);
+        loaded->push_back(std::move(layer));
+    }
+    if (loaded->empty() || isSpatial || currentSize != MOVE_COUNT)
+        throw invalid_argument(path + " must end in a dense layer of " + to_string(MOVE_COUNT) + " scores");
+    layers = std::move(loaded);
+}
+
+void Policy::evaluateSparse(const Layer &layer, const float *inputs, int count, float *outputs)
+{
+    const PolicyKernels &kernels{getPolicyKernels(simdLevel)};
+    if (nonZeroIndices.size() < static_cast<size_t>(layer.inputSize))
+        nonZeroIndices.resize(layer.inputSize);
+    for (int game{0}; game < count; ++game)
+    {
+        const float *input{inputs + static_cast<size_t>(game) * layer.inputSize};
+        float *output{outputs + static_cast<size_t>(game) * layer.outputSize};
+        copy(layer.biases.begin(), layer.biases.end(), output);
+        const int found{kernels.findNonZero(input, layer.inputSize, nonZeroIndices.data())};
+        kernels.addColumns(layer.columns.data(), nonZeroIndices.data(), input, found, layer.outputSize, output);
+    }
+}
+
+void Policy::evaluate(const float *inputs, int count, float *scores)
+{
+    const PolicyKernels &kernels{getPolicyKernels(simdLevel)};
+
+    // Grow the scratch space for the batch
+    size_t largestSize{0};
+    for (const auto &layer : *layers)
+        largestSize = max(largestSize, static_cast<size_t>(layer.outputSize));
+    if (activations.size() < count * largestSize)
+    {
+        activations.resize(count * largestSize);
+        nextActivations.resize(count * largestSize);
+    }
+
+    // Every layer reads the output of the last one
+    const float *input{inputs};
+    for (size_t index{0}; index < layers->size(); ++index)
+    {
+        const Layer &layer{(*layers)[index]};
+        float *output{(index % 2 == 0 ? activations : nextActivations).data()};
+        if (layer.kind == PolicyLayerKind::CONV3X3)
+        {
+            const int rows{height + 1};
+            const int columns{width + 1};
+            const size_t paddedSize{static_cast<size_t>(layer.inputs) * (rows + 2) * (columns + 2)};
+            if (padded.size() < paddedSize)
+                padded.resize(paddedSize);
+            for (int game{0}; game < count; ++game)
+            {
+                padPlanes(input + static_cast<size_t>(game) * layer.inputSize, layer.inputs, rows, columns, padded.data());
+                kernels.conv3x3(padded.data(), layer.inputs, rows, columns, layer.weights.data(), layer.biases.data(), layer.outputs, output + static_cast<size_t>(game) * layer.outputSize);
+            }
+        }
+        else if (!layer.columns.empty())
+            evaluateSparse(layer, input, count, output);
+        else if (layer.precision == PolicyPrecision::INT8)
+        {
+            // Quantize the inputs of every game with its own scale
+            if (quantized.size() < static_cast<size_t>(count) * layer.paddedInputSize)
+                quantized.resize(static_cast<size_t>(count) * layer.paddedInputSize);
+            if (inputScales.size() < static_cast<size_t>(count))
+                inputScales.resize(count);
+            for (int game{0}; game < count; ++game)
+                inputScales[game] = kernels.quantize(input + static_cast<size_t>(game) * layer.inputSize, layer.inputSize, layer.paddedInputSize,
+                                                     quantized.data() + static_cast<size_t>(game) * layer.paddedInputSize);
+            kernels.denseInt8(quantized.data(), inputScales.data(), count, layer.paddedInputSize, layer.quantizedWeights.data(), layer.weightScales.data(),
+                              layer.biases.data(), layer.outputs, output);
+        }
+        else
+            kernels.dense(input, count, layer.inputSize, layer.weights.data(), layer.biases.data(), layer.outputs, output);
+
+        if (layer.activation == PolicyActivation::RELU)
+        {
+            const size_t valueCount{static_cast<size_t>(count) * layer.outputSize};
+            for (size_t value{0}; value < valueCount; ++value)
+                output[value] = max(output[value], 0.0F);
+        }
+        input = output;
+    }
+    copy_n(input, static_cast<size_t>(count) * MOVE_COUNT, scores);
+}
+
+void Policy::decideBatch(const float *inputs, int count, Directions::Direction *moves)
+{
+    if (logits.size() < static_cast<size_t>(count) * MOVE_COUNT)
+        logits.resize(static_cast<size_t>(count) * MOVE_COUNT);
+    evaluate(inputs, count, logits.data());
+
+    // Play the highest scoring direction
+    for (int game{0}; game < count; ++game)
+    {
+        const float *scores{logits.data() + static_cast<size_t>(game) * MOVE_COUNT};
+        moves[game] = static_cast<Directions::Direction>(max_element(scores, scores + MOVE_COUNT) - scores);
+    }
+}
+
+void Policy::decideBatch(const Game *const *games, int count, Directions::Direction *moves)
+{
+    // Decide a chunk at a time so the observations stay in the cache
+    const int chunkSize{min(count, DECISION_CHUNK)};
+    if (observations.size() < static_cast<size_t>(chunkSize) * getObservationSize())
+        observations.resize(static_cast<size_t>(chunkSize) * getObservationSize());
+    for (int first{0}; first < count; first += chunkSize)
+    {
+        const int chunkCount{min(chunkSize, count - first)};
+        observationWriter.writeBatch(games + first, chunkCount, observations.data());
+        decideBatch(observations.data(), chunkCount, moves + first);
+    }
+}
+
+Directions::Direction Policy::decide(const Game &game)
+{
+    const Game *games[]{&game};
+    Directions::Direction move;
+    decideBatch(games, 1, &move);
+    return move;
+}
+
+void Policy::write(const string &path, const PolicyDefinition &definition)
+{
+    if (definition.width <= 0 || definition.height <= 0 || definition.width > MAX_SIDE || definition.height > MAX_SIDE)
+        throw invalid_argument("policy has an invalid board size");
+
+    string bytes;
+    bytes.append(MAGIC);
+    appendLittle<uint32_t>(bytes, VERSION);
+    appendLittle<uint32_t>(bytes, static_cast<uint32_t>(definition.layers.size()));
+    appendLittle<int32_t>(bytes, definition.width);
+    appendLittle<int32_t>(bytes, definition.height);
+    appendLittle<uint32_t>(bytes, definition.includeAge ? 5 : 4);
+    appendLittle<uint32_t>(bytes, 0);
+
+    for (size_t index{0}; index < definition.layers.size(); ++index)
+    {
+        const auto &layer{definition.layers[index]};
+        const size_t rowSize{static_cast<size_t>(max(layer.inputs, 0)) * (layer.kind == PolicyLayerKind::CONV3X3 ? 9 : 1)};
+        if (layer.inputs <= 0 || layer.outputs <= 0 || layer.weights.size() != layer.outputs * rowSize || layer.biases.size() != static_cast<size_t>(layer.outputs))
+            throw invalid_argument("layer " + to_string(index) + " has the wrong number of weights or biases");
+
+        appendLittle<uint32_t>(bytes, static_cast<uint32_t>(layer.kind));
+        appendLittle<uint32_t>(bytes, static_cast<uint32_t>(layer.precision));
+        appendLittle<uint32_t>(bytes, static_cast<uint32_t>(layer.activation));
+        appendLittle<int32_t>(bytes, layer.inputs);
+        appendLittle<int32_t>(bytes, layer.outputs);
+        appendLittle<uint32_t>(bytes, 0);
+        for (const float bias : layer.biases)
+            appendLittle<uint32_t>(bytes, bit_cast<uint32_t>(bias));
+
+        if (layer.precision == PolicyPrecision::FLOAT32)
+        {
+            for (const float weight : layer.weights)
+                appendLittle<uint32_t>(bytes, bit_cast<uint32_t>(weight));
+            continue;
+        }
+
+        // Quantize every output's weights symmetrically with its own scale
+        string quantizedWeights;
+        for (int output{0}; output < layer.outputs; ++output)
+        {
+            const auto row{layer.weights.begin() + static_cast<ptrdiff_t>(output * rowSize)};
+            float largest{0};
+            for (auto weight{row}; weight != row + static_cast<ptrdiff_t>(rowSize); ++weight)
+                largest = max(largest, abs(*weight));
+            const float scale{largest > 0 ? largest / 127 : 1};
+            appendLittle<uint32_t>(bytes, bit_cast<uint32_t>(scale));
+            for (auto weight{row}; weight != row + static_cast<ptrdiff_t>(rowSize); ++weight)
+                quantizedWeights += static_cast<char>(clamp(lrintf(*weight / scale), -127L, 127L));
+        }
+        quantizedWeights.resize(roundUp(quantizedWeights.size(), 4), '\0');
+        bytes += quantizedWeights;
+    }
+
+    ofstream stream(path, ios::binary | ios::trunc);
+    stream << bytes;
+    if (!stream.flush())
+        throw invalid_argument("Failed to write policy at: " + path);
+}
@@ -0,0 +1,262 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "game.hpp"
+#include "direction.hpp"
+#include "observation.hpp"
+#include "policy_kernels.hpp"
+#include "simd.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The kinds of layers a policy is made of
+ *
+ */
+enum class PolicyLayerKind
+{
+    DENSE,
+    CONV3X3
+};
+
+/**
+ * @brief How a layer's weights are stored and multiplied
+ *
+ */
+enum class PolicyPrecision
+{
+    FLOAT32,
+    INT8
+};
+
+/**
+ * @brief The function applied to a layer's outputs
+ *
+ */
+enum class PolicyActivation
+{
+    NONE,
+    RELU
+};
+
+/**
+ * @brief A layer to write to a policy file
+ *
+ */
+struct PolicyLayerDefinition
+{
+    PolicyLayerKind kind{PolicyLayerKind::DENSE};
+    PolicyPrecision precision{PolicyPrecision::FLOAT32};
+    PolicyActivation activation{PolicyActivation::RELU};
+
+    /**
+     * @brief The number of input and output values of a dense layer, or channels of a convolution
+     *
+     */
+    int inputs{0};
+    int outputs{0};
+
+    /**
+     * @brief outputs rows of inputs values for a dense layer, outputs by inputs by 3 by 3 for a convolution
+     *
+     * @note Int8 layers are quantized when written
+     */
+    std::vector<float> weights;
+    std::vector<float> biases;
+};
+
+/**
+ * @brief A policy to write to a policy file
+ *
+ */
+struct PolicyDefinition
+{
+    /**
+     * @brief The board the policy plays on
+     *
+     */
+    int width{0};
+    int height{0};
+
+    /**
+     * @brief Whether the observations include the age plane
+     *
+     */
+    bool includeAge{false};
+
+    /**
+     * @brief The layers from the observation to the 4 scores of the moves
+     *
+     */
+    std::vector<PolicyLayerDefinition> layers;
+};
+
+/**
+ * @brief A small neural network trained offline that picks the moves of bot players
+ *
+ * @note The network reads the observation planes of ObservationWriter and ends in one score per direction, the
+ * highest scoring direction is played. Convolutions come first and keep the size of the planes, dense layers then
+ * read the planes flattened. Observations are mostly zeros, so a dense first layer adds up the weight columns of the
+ * cells that are set instead of multiplying every cell. Evaluating many games at once shares each weight load
+ * between games. Copies share the weights, so threads can evaluate at the same time with a copy each.
+ */
+class Policy
+{
+private:
+    /**
+     * @brief A layer as it is evaluated
+     *
+     */
+    struct Layer
+    {
+        PolicyLayerKind kind;
+        PolicyPrecision precision;
+        PolicyActivation activation;
+        int inputs;
+        int outputs;
+
+        /**
+         * @brief The number of values each game reads and writes
+         *
+         */
+        int inputSize;
+        int outputSize;
+
+        /**
+         * @brief The weights of float dense layers and of convolutions, int8 convolutions are widened on load
+         *
+         */
+        std::vector<float> weights;
+
+        /**
+         * @brief The rows of int8 dense layers padded to POLICY_INT8_BLOCK values, and the scale of each row
+         *
+         */
+        std::vector<std::int8_t> quantizedWeights;
+        std::vector<float> weightScales;
+        int paddedInputSize;
+
+        /**
+         * @brief The weights of a dense first layer by input, for adding the columns of the cells that are set
+         *
+         */
+        std::vector<float> columns;
+
+        std::vector<float> biases;
+    };
+
+    int width;
+    int height;
+    std::shared_ptr<const std::vector<Layer>> layers;
+    ObservationWriter observationWriter;
+    SimdLevel simdLevel;
+
+    /**
+     * @brief Scratch space, grown to the largest batch evaluated
+     *
+     */
+    std::vector<float> observations;
+    std::vector<float> activations;
+    std::vector<float> nextActivations;
+    std::vector<float> padded;
+    std::vector<std::int8_t> quantized;
+    std::vector<float> inputScales;
+    std::vector<std::int32_t> nonZeroIndices;
+    std::vector<float> logits;
+
+    /**
+     * @brief Evaluates a dense first layer from the cells that are set
+     *
+     */
+    void evaluateSparse(const Layer &layer, const float *inputs, int count, float *outputs);
+
+public:
+    /**
+     * @brief The number of scores the network ends in, one per direction
+     *
+     */
+    constexpr static int MOVE_COUNT{4};
+
+    /**
+     * @brief Loads a policy file
+     *
+     * @param path The policy file written by Policy::write
+     * @param simdLevel The instruction set to evaluate with
+     * @throws std::invalid_argument Thrown if the file can't be read or the layers don't fit together
+     */
+    explicit Policy(const std::string &path, SimdLevel simdLevel = detectSimdLevel());
+
+    /**
+     * @brief Get the board size the policy plays on
+     *
+     */
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    /**
+     * @brief Get the number of values of an observation the policy reads
+     *
+     * @return std::size_t
+     */
+    std::size_t getObservationSize() const { return observationWriter.getObservationSize(); }
+
+    /**
+     * @brief Sets the instruction set to evaluate with, mostly for benchmarks
+     *
+     */
+    void setSimdLevel(SimdLevel level) { simdLevel = level; }
+    SimdLevel getSimdLevel() const { return simdLevel; }
+
+    /**
+     * @brief Scores the moves of many games
+     *
+     * @param observations count observations of getObservationSize() float values one after another
+     * @param count The number of games
+     * @param scores count times MOVE_COUNT scores, by game and then direction
+     */
+    void evaluate(const float *observations, int count, float *scores);
+
+    /**
+     * @brief Picks the moves of many games from their observations
+     *
+     * @param observations count observations of getObservationSize() float values one after another
+     * @param count The number of games
+     * @param moves count moves
+     */
+    void decideBatch(const float *observations, int count, Directions::Direction *moves);
+
+    /**
+     * @brief Picks the moves of many games
+     *
+     * @param games The games, on boards the size of the policy's
+     * @param count The number of games
+     * @param moves count moves
+     * @throws std::invalid_argument Thrown if a board isn't the size of the policy's
+     */
+    void decideBatch(const Game *const *games, int count, Directions::Direction *moves);
+
+    /**
+     * @brief Picks the move of a game
+     *
+     * @param game The game, on a board the size of the policy's
+     * @throws std::invalid_argument Thrown if the board isn't the size of the policy's
+     * @return Directions::Direction
+     */
+    Directions::Direction decide(const Game &game);
+
+    /**
+     * @brief Writes a policy file
+     *
+     * @note The file is a fixed header and then every layer's fixed header, biases and weights, int8 layers
+     * storing a scale per output before their weights. Every number is little endian.
+     * @param path The policy file, replaced if it exists
+     * @param definition The policy
+     * @throws std::invalid_argument Thrown if a layer has the wrong number of weights or the file can't be written
+     */
+    static void write(const std::string &path, const PolicyDefinition &definition);
+};
+
+#endif
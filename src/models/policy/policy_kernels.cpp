@@ -0,0 +1,408 @@
+#include "policy_kernels.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#if SNAKE_HAS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/**
+ * @brief The number of dot products the AVX2 dense kernels compute at once
+ *
+ */
+constexpr int DOT_COUNT{4};
+
+static void denseScalar(const float *inputs, int count, int inputSize, const float *weights, const float *biases, int outputSize, float *outputs)
+{
+    for (int game{0}; game < count; ++game)
+    {
+        const float *input{inputs + static_cast<size_t>(game) * inputSize};
+        for (int output{0}; output < outputSize; ++output)
+        {
+            const float *row{weights + static_cast<size_t>(output) * inputSize};
+            float sum{0};
+            for (int index{0}; index < inputSize; ++index)
+                sum += row[index] * input[index];
+            outputs[static_cast<size_t>(game) * outputSize + output] = biases[output] + sum;
+        }
+    }
+}
+
+static void denseInt8Scalar(const int8_t *inputs, const float *inputScales, int count, int paddedSize, const int8_t *weights, const float *weightScales,
+                            const float *biases, int outputSize, float *outputs)
+{
+    for (int game{0}; game < count; ++game)
+    {
+        const int8_t *input{inputs + static_cast<size_t>(game) * paddedSize};
+        for (int output{0}; output < outputSize; ++output)
+        {
+            const int8_t *row{weights + static_cast<size_t>(output) * paddedSize};
+            int32_t sum{0};
+            for (int index{0}; index < paddedSize; ++index)
+                sum += static_cast<int32_t>(row[index]) * input[index];
+            outputs[static_cast<size_t>(game) * outputSize + output] = biases[output] + static_cast<float>(sum) * inputScales[game] * weightScales[output];
+        }
+    }
+}
+
+static float quantizeScalar(const float *values, int size, int paddedSize, int8_t *quantized)
+{
+    float largest{0};
+    for (int index{0}; index < size; ++index)
+        largest = max(largest, abs(values[index]));
+    const float scale{largest > 0 ? largest / 127 : 1};
+    const float inverse{1 / scale};
+    for (int index{0}; index < size; ++index)
+        quantized[index] = static_cast<int8_t>(clamp(lrintf(values[index] * inverse), -127L, 127L));
+    fill(quantized + size, quantized + paddedSize, 0);
+    return scale;
+}
+
+static void conv3x3Scalar(const float *padded, int inputChannels, int rows, int columns, const float *weights, const float *biases, int outputChannels, float *outputs)
+{
+    const int paddedColumns{columns + 2};
+    const size_t paddedPlane{static_cast<size_t>(rows + 2) * paddedColumns};
+    for (int output{0}; output < outputChannels; ++output)
+    {
+        float *plane{outputs + static_cast<size_t>(output) * rows * columns};
+        for (int y{0}; y < rows; ++y)
+        {
+            for (int x{0}; x < columns; ++x)
+            {
+                float sum{biases[output]};
+                for (int input{0}; input < inputChannels; ++input)
+                {
+                    const float *kernel{weights + (static_cast<size_t>(output) * inputChannels + input) * 9};
+                    const float *window{padded + input * paddedPlane + static_cast<size_t>(y) * paddedColumns + x};
+                    for (int kernelY{0}; kernelY < 3; ++kernelY)
+                        for (int kernelX{0}; kernelX < 3; ++kernelX)
+                            sum += kernel[kernelY * 3 + kernelX] * window[kernelY * paddedColumns + kernelX];
+                }
+                plane[y * columns + x] = sum;
+            }
+        }
+    }
+}
+
+static int findNonZeroScalar(const float *values, int size, int32_t *indices)
+{
+    int found{0};
+    for (int index{0}; index < size; ++index)
+        if (values[index] != 0)
+            indices[found++] = index;
+    return found;
+}
+
+static void addColumnsScalar(const float *columns, const int32_t *indices, const float *values, int count, int outputSize, float *outputs)
+{
+    for (int entry{0}; entry < count; ++entry)
+    {
+        const float value{values[indices[entry]]};
+        const float *column{columns + static_cast<size_t>(indices[entry]) * outputSize};
+        for (int output{0}; output < outputSize; ++output)
+            outputs[output] += value * column[output];
+    }
+}
+
+#if SNAKE_HAS_X86_KERNELS
+
+/**
+ * @brief Adds the lanes of the register
+ *
+ */
+SNAKE_TARGET_AVX2 static inline float horizontalSum(__m256 values)
+{
+    __m128 sum{_mm_add_ps(_mm256_castps256_ps128(values), _mm256_extractf128_ps(values, 1))};
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+/**
+ * @copydoc horizontalSum
+ */
+SNAKE_TARGET_AVX2 static inline int32_t horizontalSum(__m256i values)
+{
+    __m128i sum{_mm_add_epi32(_mm256_castsi256_si128(values), _mm256_extracti128_si256(values, 1))};
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+/**
+ * @brief Get a mask of the first count lanes for masked loads and stores
+ *
+ */
+SNAKE_TARGET_AVX2 static inline __m256i firstLanes(int count)
+{
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+/**
+ * @brief Computes DOT_COUNT dot products at once, the nth of inputs + n * inputStride and weights + n * weightStride
+ *
+ * @note A stride of 0 shares the inputs or the weights, so a game takes several rows or several games a row. The
+ * independent sums hide the latency of the additions.
+ */
+SNAKE_TARGET_AVX2 static void dotFourAvx2(const float *inputs, size_t inputStride, const float *weights, size_t weightStride, int size, float *sums)
+{
+    const int vectorSize{size & ~7};
+    __m256 first{_mm256_setzero_ps()};
+    __m256 second{_mm256_setzero_ps()};
+    __m256 third{_mm256_setzero_ps()};
+    __m256 fourth{_mm256_setzero_ps()};
+    for (int index{0}; index < vectorSize; index += 8)
+    {
+        first = _mm256_add_ps(first, _mm256_mul_ps(_mm256_loadu_ps(weights + index), _mm256_loadu_ps(inputs + index)));
+        second = _mm256_add_ps(second, _mm256_mul_ps(_mm256_loadu_ps(weights + weightStride + index), _mm256_loadu_ps(inputs + inputStride + index)));
+        third = _mm256_add_ps(third, _mm256_mul_ps(_mm256_loadu_ps(weights + 2 * weightStride + index), _mm256_loadu_ps(inputs + 2 * inputStride + index)));
+        fourth = _mm256_add_ps(fourth, _mm256_mul_ps(_mm256_loadu_ps(weights + 3 * weightStride + index), _mm256_loadu_ps(inputs + 3 * inputStride + index)));
+    }
+
+    // The values after the last full register are loaded masked
+    if (vectorSize < size)
+    {
+        const __m256i mask{firstLanes(size - vectorSize)};
+        first = _mm256_add_ps(first, _mm256_mul_ps(_mm256_maskload_ps(weights + vectorSize, mask), _mm256_maskload_ps(inputs + vectorSize, mask)));
+        second = _mm256_add_ps(second, _mm256_mul_ps(_mm256_maskload_ps(weights + weightStride + vectorSize, mask), _mm256_maskload_ps(inputs + inputStride + vectorSize, mask)));
+        third = _mm256_add_ps(third, _mm256_mul_ps(_mm256_maskload_ps(weights + 2 * weightStride + vectorSize, mask), _mm256_maskload_ps(inputs + 2 * inputStride + vectorSize, mask)));
+        fourth = _mm256_add_ps(fourth, _mm256_mul_ps(_mm256_maskload_ps(weights + 3 * weightStride + vectorSize, mask), _mm256_maskload_ps(inputs + 3 * inputStride + vectorSize, mask)));
+    }
+    sums[0] = horizontalSum(first);
+    sums[1] = horizontalSum(second);
+    sums[2] = horizontalSum(third);
+    sums[3] = horizontalSum(fourth);
+}
+
+SNAKE_TARGET_AVX2 static void denseAvx2(const float *inputs, int count, int inputSize, const float *weights, const float *biases, int outputSize, float *outputs)
+{
+    float sums[DOT_COUNT];
+
+    // Groups of games share each weight load
+    int game{0};
+    for (; game + DOT_COUNT <= count; game += DOT_COUNT)
+        for (int output{0}; output < outputSize; ++output)
+        {
+            dotFourAvx2(inputs + static_cast<size_t>(game) * inputSize, inputSize, weights + static_cast<size_t>(output) * inputSize, 0, inputSize, sums);
+            for (int dot{0}; dot < DOT_COUNT; ++dot)
+                outputs[static_cast<size_t>(game + dot) * outputSize + output] = biases[output] + sums[dot];
+        }
+
+    // The games left over take several rows at once
+    for (; game < count; ++game)
+    {
+        const float *input{inputs + static_cast<size_t>(game) * inputSize};
+        float *output{outputs + static_cast<size_t>(game) * outputSize};
+        for (int row{0}; row < outputSize;)
+        {
+            // Several rows while enough are left, then one at a time
+            const int rows{row + DOT_COUNT <= outputSize ? DOT_COUNT : 1};
+            dotFourAvx2(input, 0, weights + static_cast<size_t>(row) * inputSize, rows == DOT_COUNT ? inputSize : 0, inputSize, sums);
+            for (int dot{0}; dot < rows; ++dot)
+                output[row + dot] = biases[row + dot] + sums[dot];
+            row += rows;
+        }
+    }
+}
+
+/**
+ * @brief Adds the products of POLICY_INT8_BLOCK quantized inputs and weights to the 8 sums
+ *
+ * @note maddubs multiplies unsigned by signed bytes, so the inputs' signs are moved onto the weights. The pairs it
+ * adds are at most 2 * 127 * 127 and don't saturate.
+ */
+SNAKE_TARGET_AVX2 static inline __m256i multiplyAddInt8(__m256i sum, const int8_t *inputs, const int8_t *weights, __m256i ones)
+{
+    const __m256i values{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(inputs))};
+    const __m256i products{_mm256_maddubs_epi16(_mm256_abs_epi8(values), _mm256_sign_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights)), values))};
+    return _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+}
+
+/**
+ * @brief The dot products of dotFourAvx2 on quantized values
+ *
+ */
+SNAKE_TARGET_AVX2 static void dotFourInt8Avx2(const int8_t *inputs, size_t inputStride, const int8_t *weights, size_t weightStride, int paddedSize, int32_t *sums)
+{
+    const __m256i ones{_mm256_set1_epi16(1)};
+    __m256i first{_mm256_setzero_si256()};
+    __m256i second{_mm256_setzero_si256()};
+    __m256i third{_mm256_setzero_si256()};
+    __m256i fourth{_mm256_setzero_si256()};
+    for (int index{0}; index < paddedSize; index += POLICY_INT8_BLOCK)
+    {
+        first = multiplyAddInt8(first, inputs + index, weights + index, ones);
+        second = multiplyAddInt8(second, inputs + inputStride + index, weights + weightStride + index, ones);
+        third = multiplyAddInt8(third, inputs + 2 * inputStride + index, weights + 2 * weightStride + index, ones);
+        fourth = multiplyAddInt8(fourth, inputs + 3 * inputStride + index, weights + 3 * weightStride + index, ones);
+    }
+    sums[0] = horizontalSum(first);
+    sums[1] = horizontalSum(second);
+    sums[2] = horizontalSum(third);
+    sums[3] = horizontalSum(fourth);
+}
+
+SNAKE_TARGET_AVX2 static void denseInt8Avx2(const int8_t *inputs, const float *inputScales, int count, int paddedSize, const int8_t *weights, const float *weightScales,
+                                            const float *biases, int outputSize, float *outputs)
+{
+    int32_t sums[DOT_COUNT];
+
+    // Groups of games share each weight load
+    int game{0};
+    for (; game + DOT_COUNT <= count; game += DOT_COUNT)
+        for (int output{0}; output < outputSize; ++output)
+        {
+            dotFourInt8Avx2(inputs + static_cast<size_t>(game) * paddedSize, paddedSize, weights + static_cast<size_t>(output) * paddedSize, 0, paddedSize, sums);
+            for (int dot{0}; dot < DOT_COUNT; ++dot)
+                outputs[static_cast<size_t>(game + dot) * outputSize + output] = biases[output] + static_cast<float>(sums[dot]) * inputScales[game + dot] * weightScales[output];
+        }
+
+    // The games left over take several rows at once
+    for (; game < count; ++game)
+    {
+        const int8_t *input{inputs + static_cast<size_t>(game) * paddedSize};
+        float *output{outputs + static_cast<size_t>(game) * outputSize};
+        for (int row{0}; row < outputSize;)
+        {
+            // Several rows while enough are left, then one at a time
+            const int rows{row + DOT_COUNT <= outputSize ? DOT_COUNT : 1};
+            dotFourInt8Avx2(input, 0, weights + static_cast<size_t>(row) * paddedSize, rows == DOT_COUNT ? paddedSize : 0, paddedSize, sums);
+            for (int dot{0}; dot < rows; ++dot)
+                output[row + dot] = biases[row + dot] + static_cast<float>(sums[dot]) * inputScales[game] * weightScales[row + dot];
+            row += rows;
+        }
+    }
+}
+
+SNAKE_TARGET_AVX2 static float quantizeAvx2(const float *values, int size, int paddedSize, int8_t *quantized)
+{
+    const int vectorSize{size & ~(POLICY_INT8_BLOCK - 1)};
+
+    // Find the largest magnitude by clearing the sign bits
+    const __m256 signBits{_mm256_set1_ps(-0.0F)};
+    __m256 largestLanes{_mm256_setzero_ps()};
+    for (int index{0}; index < vectorSize; index += 8)
+        largestLanes = _mm256_max_ps(largestLanes, _mm256_andnot_ps(signBits, _mm256_loadu_ps(values + index)));
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, largestLanes);
+    float largest{*max_element(lanes, lanes + 8)};
+    for (int index{vectorSize}; index < size; ++index)
+        largest = max(largest, abs(values[index]));
+    const float scale{largest > 0 ? largest / 127 : 1};
+    const float inverse{1 / scale};
+
+    // Round 32 values at a time and pack them to bytes, the packs interleave the 128 bit lanes so they are permuted back
+    const __m256 inverses{_mm256_set1_ps(inverse)};
+    const __m256i order{_mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)};
+    for (int index{0}; index < vectorSize; index += POLICY_INT8_BLOCK)
+    {
+        const __m256i first{_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(values + index), inverses))};
+        const __m256i second{_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(values + index + 8), inverses))};
+        const __m256i third{_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(values + index + 16), inverses))};
+        const __m256i fourth{_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(values + index + 24), inverses))};
+        const __m256i packed{_mm256_packs_epi16(_mm256_packs_epi32(first, second), _mm256_packs_epi32(third, fourth))};
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(quantized + index), _mm256_permutevar8x32_epi32(packed, order));
+    }
+    for (int index{vectorSize}; index < size; ++index)
+        quantized[index] = static_cast<int8_t>(clamp(lrintf(values[index] * inverse), -127L, 127L));
+    fill(quantized + size, quantized + paddedSize, 0);
+    return scale;
+}
+
+SNAKE_TARGET_AVX2 static void conv3x3Avx2(const float *padded, int inputChannels, int rows, int columns, const float *weights, const float *biases, int outputChannels,
+                                          float *outputs)
+{
+    const int paddedColumns{columns + 2};
+    const size_t paddedPlane{static_cast<size_t>(rows + 2) * paddedColumns};
+    for (int output{0}; output < outputChannels; ++output)
+    {
+        float *plane{outputs + static_cast<size_t>(output) * rows * columns};
+        const float *outputWeights{weights + static_cast<size_t>(output) * inputChannels * 9};
+        for (int y{0}; y < rows; ++y)
+        {
+            // Keep 8 outputs of the row in a register through every input channel and tap
+            for (int x{0}; x < columns; x += 8)
+            {
+                const __m256i mask{firstLanes(columns - x)};
+                __m256 sum{_mm256_set1_ps(biases[output])};
+                for (int input{0}; input < inputChannels; ++input)
+                {
+                    const float *kernel{outputWeights + input * 9};
+                    const float *window{padded + input * paddedPlane + static_cast<size_t>(y) * paddedColumns + x};
+                    for (int kernelY{0}; kernelY < 3; ++kernelY)
+                        for (int kernelX{0}; kernelX < 3; ++kernelX)
+                            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_broadcast_ss(kernel + kernelY * 3 + kernelX),
+                                                                   _mm256_maskload_ps(window + kernelY * paddedColumns + kernelX, mask)));
+                }
+                _mm256_maskstore_ps(plane + y * columns + x, mask, sum);
+            }
+        }
+    }
+}
+
+SNAKE_TARGET_AVX2 static int findNonZeroAvx2(const float *values, int size, int32_t *indices)
+{
+    int found{0};
+    const int vectorSize{size & ~7};
+    const int blockSize{size & ~31};
+    const __m256 zero{_mm256_setzero_ps()};
+    for (int block{0}; block < vectorSize; block += 32)
+    {
+        // Skip 32 zeros at a time, any value that isn't zero leaves bits set in the combined lanes
+        if (block < blockSize)
+        {
+            const __m256 combined{_mm256_or_ps(_mm256_or_ps(_mm256_loadu_ps(values + block), _mm256_loadu_ps(values + block + 8)),
+                                               _mm256_or_ps(_mm256_loadu_ps(values + block + 16), _mm256_loadu_ps(values + block + 24)))};
+            if (_mm256_movemask_ps(_mm256_cmp_ps(combined, zero, _CMP_NEQ_UQ)) == 0)
+                continue;
+        }
+        for (int index{block}; index < min(block + 32, vectorSize); index += 8)
+        {
+            // Walk the bits of the lanes that aren't zero
+            unsigned bits{static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + index), zero, _CMP_NEQ_UQ)))};
+            while (bits != 0)
+            {
+                indices[found++] = index + countr_zero(bits);
+                bits &= bits - 1;
+            }
+        }
+    }
+    for (int index{vectorSize}; index < size; ++index)
+        if (values[index] != 0)
+            indices[found++] = index;
+    return found;
+}
+
+SNAKE_TARGET_AVX2 static void addColumnsAvx2(const float *columns, const int32_t *indices, const float *values, int count, int outputSize, float *outputs)
+{
+    const int vectorSize{outputSize & ~7};
+    for (int entry{0}; entry < count; ++entry)
+    {
+        const float value{values[indices[entry]]};
+        const __m256 values8{_mm256_set1_ps(value)};
+        const float *column{columns + static_cast<size_t>(indices[entry]) * outputSize};
+        for (int output{0}; output < vectorSize; output += 8)
+            _mm256_storeu_ps(outputs + output, _mm256_add_ps(_mm256_loadu_ps(outputs + output), _mm256_mul_ps(values8, _mm256_loadu_ps(column + output))));
+        for (int output{vectorSize}; output < outputSize; ++output)
+            outputs[output] += value * column[output];
+    }
+}
+
+#endif
+
+const PolicyKernels &getPolicyKernels(SimdLevel level)
+{
+    static const PolicyKernels scalar{denseScalar, denseInt8Scalar, quantizeScalar, conv3x3Scalar, findNonZeroScalar, addColumnsScalar};
+#if SNAKE_HAS_X86_KERNELS
+    static const PolicyKernels avx2{denseAvx2, denseInt8Avx2, quantizeAvx2, conv3x3Avx2, findNonZeroAvx2, addColumnsAvx2};
+    if (level == SimdLevel::AVX2)
+        return avx2;
+#endif
+    return scalar;
+}
@@ -0,0 +1,76 @@
+#ifndef POLICY_KERNELS_H
+#define POLICY_KERNELS_H
+
+#include "simd.hpp"
+#include <cstdint>
+
+/**
+ * @brief The number of values int8 rows are padded to, one AVX2 register of int8 values
+ *
+ */
+constexpr int POLICY_INT8_BLOCK{32};
+
+/**
+ * @brief The kernels a policy evaluates its layers with, selected for an instruction set
+ *
+ * @note Inputs and outputs are one row per game, rows of count games one after another
+ */
+struct PolicyKernels
+{
+    /**
+     * @brief outputs[game][output] = biases[output] + weights[output] . inputs[game]
+     *
+     * @note weights holds outputSize rows of inputSize values
+     */
+    void (*dense)(const float *inputs, int count, int inputSize, const float *weights, const float *biases, int outputSize, float *outputs);
+
+    /**
+     * @brief The dense kernel on quantized values, each product scaled by the input's and the output's scale
+     *
+     * @note inputs holds count rows and weights outputSize rows of paddedSize values, a multiple of
+     * POLICY_INT8_BLOCK, in [-127, 127]
+     */
+    void (*denseInt8)(const std::int8_t *inputs, const float *inputScales, int count, int paddedSize, const std::int8_t *weights, const float *weightScales,
+                      const float *biases, int outputSize, float *outputs);
+
+    /**
+     * @brief Quantizes the values to [-127, 127], padding with zeros to paddedSize
+     *
+     * @return float The scale of a quantized step
+     */
+    float (*quantize)(const float *values, int size, int paddedSize, std::int8_t *quantized);
+
+    /**
+     * @brief A 3x3 convolution keeping the plane size
+     *
+     * @note padded holds inputChannels planes of rows + 2 by columns + 2 values with a border of zeros, weights
+     * holds outputChannels by inputChannels by 3 by 3 values and outputs outputChannels planes of rows by columns
+     */
+    void (*conv3x3)(const float *padded, int inputChannels, int rows, int columns, const float *weights, const float *biases, int outputChannels, float *outputs);
+
+    /**
+     * @brief Finds the values that aren't zero
+     *
+     * @return int The number of indices written
+     */
+    int (*findNonZero)(const float *values, int size, std::int32_t *indices);
+
+    /**
+     * @brief outputs += values[index] * columns[index] for each of the count indices
+     *
+     * @note columns holds one column of outputSize values per value, adding only the columns of the values that
+     * aren't zero skips most of a sparse input
+     */
+    void (*addColumns)(const float *columns, const std::int32_t *indices, const float *values, int count, int outputSize, float *outputs);
+};
+
+/**
+ * @brief Get the kernels for the instruction set
+ *
+ * @note SSE2 uses the scalar kernels, which the compiler vectorizes for it
+ * @param level The instruction set
+ * @return const PolicyKernels&
+ */
+const PolicyKernels &getPolicyKernels(SimdLevel level);
+
+#endif
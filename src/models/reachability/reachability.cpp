@@ -0,0 +1,384 @@
+#include "reachability.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+using namespace std;
+
+Reachability::Reachability(const Board &board, const Snake &snake) : board(board), neighbours(board.getNeighbours())
+{
+    // Size everything for the board once, the wall cell is the last cell
+    const size_t cellCount{static_cast<size_t>(board.getCellCount())};
+    occupied.resize(cellCount + 1);
+    regions.resize(cellCount + 1);
+    regionSizes.resize(cellCount);
+    unusedRegions.reserve(cellCount);
+    searchOwners.resize(cellCount);
+    searchMarks.resize(cellCount);
+    for (auto &search : searches)
+        search.reserve(cellCount);
+    rebuild(snake);
+}
+
+bool Reachability::areNeighbours(int32_t cell, int32_t otherCell) const
+{
+    if (cell == board.getWallCell())
+        return false;
+    for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+        if (getNeighbour(cell, direction) == otherCell)
+            return true;
+    return false;
+}
+
+int32_t Reachability::createRegion(int32_t size)
+{
+    const int32_t region{unusedRegions.back()};
+    unusedRegions.pop_back();
+    regionSizes[region] = size;
+    return region;
+}
+
+int32_t Reachability::labelRegion(int32_t cell, int32_t from, int32_t to)
+{
+    // Breadth first from the cell through the cells still labelled from
+    auto &queue{searches[0]};
+    queue.clear();
+    queue.push_back(cell);
+    regions[cell] = to;
+    for (size_t next{0}; next < queue.size(); ++next)
+    {
+        for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+        {
+            const int32_t neighbour{getNeighbour(queue[next], direction)};
+            if (!occupied[neighbour] && regions[neighbour] == from)
+            {
+                regions[neighbour] = to;
+                queue.push_back(neighbour);
+            }
+        }
+    }
+    return static_cast<int32_t>(queue.size());
+}
+
+void Reachability::rebuild(const Snake &snake)
+{
+    const int32_t cellCount{board.getCellCount()};
+    const int columns{board.getWidth() + 1};
+
+    // Obstacles, the snake and the wall cell are occupied
+    for (int32_t cell{0}; cell < cellCount; ++cell)
+        occupied[cell] = board.isObstacle(Point{cell % columns, cell / columns}) ? 1 : 0;
+    occupied[cellCount] = 1;
+    for (const auto &point : snake.getBody())
+        if (board.isInBoard(point))
+            occupied[board.getCellIndex(point)] = 1;
+
+    // Label every region again
+    fill(regions.begin(), regions.end(), NO_REGION);
+    unusedRegions.clear();
+    for (int32_t region{cellCount - 1}; region >= 0; --region)
+        unusedRegions.push_back(region);
+    for (int32_t cell{0}; cell < cellCount; ++cell)
+    {
+        if (!occupied[cell] && regions[cell] == NO_REGION)
+        {
+            const int32_t region{createRegion(0)};
+            regionSizes[region] = labelRegion(cell, NO_REGION, region);
+        }
+    }
+
+    lastHead = board.isInBoard(snake.getHead()) ? board.getCellIndex(snake.getHead()) : board.getWallCell();
+    lastTail = board.isInBoard(snake.getTail()) ? board.getCellIndex(snake.getTail()) : board.getWallCell();
+    lastLength = snake.getBody().size();
+}
+
+bool Reachability::areNeighboursConnected(int32_t cell) const
+{
+    array<int32_t, Board::DIRECTION_COUNT> sides;
+    int freeSides{0};
+    for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+    {
+        sides[direction] = getNeighbour(cell, direction);
+        freeSides += occupied[sides[direction]] ? 0 : 1;
+    }
+    if (freeSides <= 1)
+        return true;
+
+    // Walk around the cell, two free sides next to each other are linked by a free corner between them
+    int links{0};
+    for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+    {
+        const int nextDirection{(direction + 1) % Board::DIRECTION_COUNT};
+        if (occupied[sides[direction]] || occupied[sides[nextDirection]])
+            continue;
+        const int32_t corner{getNeighbour(sides[direction], nextDirection)};
+        if (!occupied[corner] && corner == getNeighbour(sides[nextDirection], direction))
+            ++links;
+    }
+
+    // The sides form a ring, so they are all linked once there is one link fewer than free sides
+    return links >= freeSides - 1;
+}
+
+void Reachability::freeCell(int32_t cell)
+{
+    occupied[cell] = 0;
+
+    // Find the largest region around the cell
+    int32_t largest{NO_REGION};
+    for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+    {
+        const int32_t neighbour{getNeighbour(cell, direction)};
+        if (!occupied[neighbour] && (largest == NO_REGION || regionSizes[regions[neighbour]] > regionSizes[largest]))
+            largest = regions[neighbour];
+    }
+    if (largest == NO_REGION)
+    {
+        regions[cell] = createRegion(1);
+        return;
+    }
+
+    // Relabel the smaller regions into the largest one
+    for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+    {
+        const int32_t neighbour{getNeighbour(cell, direction)};
+        if (occupied[neighbour] || regions[neighbour] == largest)
+            continue;
+        const int32_t region{regions[neighbour]};
+        regionSizes[largest] += labelRegion(neighbour, region, largest);
+        regionSizes[region] = 0;
+        unusedRegions.push_back(region);
+    }
+    regions[cell] = largest;
+    ++regionSizes[largest];
+}
+
+void Reachability::occupyCell(int32_t cell)
+{
+    const int32_t region{regions[cell]};
+    occupied[cell] = 1;
+    regions[cell] = NO_REGION;
+    if (--regionSizes[region] == 0)
+    {
+        unusedRegions.push_back(region);
+        return;
+    }
+    if (areNeighboursConnected(cell))
+        return;
+
+    // Start a search from every free side
+    if (++searchMark == 0)
+    {
+        fill(searchMarks.begin(), searchMarks.end(), 0);
+        searchMark = 1;
+    }
+    array<size_t, Board::DIRECTION_COUNT> nextCells{};
+    array<int, Board::DIRECTION_COUNT> groups{};
+    int searchCount{0};
+    for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+    {
+        const int32_t neighbour{getNeighbour(cell, direction)};
+        if (occupied[neighbour] || searchMarks[neighbour] == searchMark)
+            continue;
+        searches[searchCount].clear();
+        searches[searchCount].push_back(neighbour);
+        searchMarks[neighbour] = searchMark;
+        searchOwners[neighbour] = static_cast<uint8_t>(searchCount);
+        groups[searchCount] = searchCount;
+        ++searchCount;
+    }
+    if (searchCount <= 1)
+        return;
+
+    // Searches that meet join a group, a group is a whole region once its searches run out of cells
+    const auto findGroup{[&](int search)
+                         {
+                             while (groups[search] != search)
+                                 search = groups[search];
+                             return search;
+                         }};
+    const auto countGrowingGroups{[&]
+                                  {
+                                      array<bool, Board::DIRECTION_COUNT> isGrowing{};
+                                      for (int search{0}; search < searchCount; ++search)
+                                          if (nextCells[search] < searches[search].size())
+                                              isGrowing[findGroup(search)] = true;
+                                      return count(isGrowing.begin(), isGrowing.end(), true);
+                                  }};
+
+    // Step the searches in lockstep so the work is bounded by the smaller pieces
+    while (countGrowingGroups() > 1)
+    {
+        for (int search{0}; search < searchCount; ++search)
+        {
+            if (nextCells[search] >= searches[search].size())
+                continue;
+            const int32_t current{searches[search][nextCells[search]++]};
+            for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+            {
+                const int32_t neighbour{getNeighbour(current, direction)};
+                if (occupied[neighbour])
+                    continue;
+                if (searchMarks[neighbour] != searchMark)
+                {
+                    searchMarks[neighbour] = searchMark;
+                    searchOwners[neighbour] = static_cast<uint8_t>(search);
+                    searches[search].push_back(neighbour);
+                }
+                else if (const int group{findGroup(searchOwners[neighbour])}; group != findGroup(search))
+                    groups[group] = findGroup(search);
+            }
+        }
+    }
+
+    // The group still growing keeps the region, or the largest if all of them finished
+    array<int32_t, Board::DIRECTION_COUNT> groupSizes{};
+    int keptGroup{-1};
+    for (int search{0}; search < searchCount; ++search)
+    {
+        const int group{findGroup(search)};
+        groupSizes[group] += static_cast<int32_t>(searches[search].size());
+        if (nextCells[search] < searches[search].size())
+            keptGroup = group;
+    }
+    if (keptGroup < 0)
+        keptGroup = static_cast<int>(max_element(groupSizes.begin(), groupSizes.end()) - groupSizes.begin());
+
+    // Every other group is a piece cut off from the region
+    for (int group{0}; group < searchCount; ++group)
+    {
+        if (group == keptGroup || findGroup(group) != group)
+            continue;
+        const int32_t newRegion{createRegion(groupSizes[group])};
+        regionSizes[region] -= groupSizes[group];
+        for (int search{0}; search < searchCount; ++search)
+            if (findGroup(search) == group)
+                for (const int32_t found : searches[search])
+                    regions[found] = newRegion;
+    }
+}
+
+void Reachability::update(const Snake &snake)
+{
+    if (snake.getIsCrashed())
+        return;
+    const auto &body{snake.getBody()};
+    const int32_t head{board.getCellIndex(body.back())};
+    const int32_t tail{board.getCellIndex(body.front())};
+    if (head == lastHead && tail == lastTail && body.size() == lastLength)
+        return;
+
+    // Anything but one move or growth onto a free cell since the last update is relabelled from scratch
+    const bool hasMoved{tail != lastTail};
+    const bool isOneStep{hasMoved ? areNeighbours(lastTail, tail) && body.size() == lastLength : body.size() == lastLength + 1};
+    if (!isOneStep || !areNeighbours(lastHead, head) || (occupied[head] && !(hasMoved && head == lastTail)))
+    {
+        rebuild(snake);
+        return;
+    }
+
+    // The tail leaves before the head arrives, so the head can take the old tail
+    if (hasMoved)
+        freeCell(lastTail);
+    occupyCell(head);
+    lastHead = head;
+    lastTail = tail;
+    lastLength = body.size();
+}
+
+int32_t Reachability::getDestination(const Snake &snake, Directions::Direction direction) const
+{
+    // Reversing keeps the snake going the way it faces
+    if (Directions::areOppositeDirections(snake.getDirection(), direction))
+        direction = snake.getDirection();
+    return getNeighbour(board.getCellIndex(snake.getHead()), static_cast<int>(direction));
+}
+
+int Reachability::getReachableCount(const Snake &snake, Directions::Direction direction) const
+{
+    if (snake.getIsCrashed())
+        return 0;
+    const int32_t destination{getDestination(snake, direction)};
+    if (!occupied[destination])
+        return regionSizes[regions[destination]];
+    if (destination != board.getCellIndex(snake.getTail()))
+        return 0;
+
+    // Moving onto the tail frees it first, joining the regions around it
+    array<int32_t, Board::DIRECTION_COUNT> joined;
+    int joinedCount{0};
+    int count{1};
+    for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+    {
+        const int32_t neighbour{getNeighbour(destination, direction)};
+        if (occupied[neighbour] || find(joined.begin(), joined.begin() + joinedCount, regions[neighbour]) != joined.begin() + joinedCount)
+            continue;
+        joined[joinedCount++] = regions[neighbour];
+        count += regionSizes[regions[neighbour]];
+    }
+    return count;
+}
+
+bool Reachability::canEscape(const Snake &snake, Directions::Direction direction) const
+{
+    if (snake.getIsCrashed())
+        return false;
+    const int32_t destination{getDestination(snake, direction)};
+    if (destination == board.getCellIndex(snake.getTail()))
+        return true;
+    if (occupied[destination])
+        return false;
+    const int32_t region{regions[destination]};
+    const auto &body{snake.getBody()};
+    if (static_cast<size_t>(regionSizes[region]) >= body.size())
+        return true;
+
+    // The segment at index i frees after i + 1 moves, the region lasts as many moves as it has cells
+    for (size_t index{0}; index < static_cast<size_t>(regionSizes[region]); ++index)
+    {
+        const int32_t segment{board.getCellIndex(body[index])};
+        for (int side{0}; side < Board::DIRECTION_COUNT; ++side)
+        {
+            const int32_t neighbour{getNeighbour(segment, side)};
+            if (!occupied[neighbour] && regions[neighbour] == region)
+                return true;
+        }
+    }
+    return false;
+}
+
+bool Reachability::isTrapped(const Snake &snake) const
+{
+    for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+        if (canEscape(snake, static_cast<Directions::Direction>(direction)))
+            return false;
+    return true;
+}
+
+optional<Directions::Direction> Reachability::pickMove(const Snake &snake, Pcg32 &random) const
+{
+    array<Directions::Direction, Board::DIRECTION_COUNT> escapes;
+    int escapeCount{0};
+    optional<Directions::Direction> roomiest;
+    int mostRoom{0};
+    for (int index{0}; index < Board::DIRECTION_COUNT; ++index)
+    {
+        // Reversing is the same move as going straight
+        const auto direction{static_cast<Directions::Direction>(index)};
+        if (Directions::areOppositeDirections(snake.getDirection(), direction))
+            continue;
+        if (canEscape(snake, direction))
+            escapes[escapeCount++] = direction;
+        else if (const int room{getReachableCount(snake, direction)}; room > mostRoom)
+        {
+            mostRoom = room;
+            roomiest = direction;
+        }
+    }
+    if (escapeCount > 0)
+        return escapes[random.bounded(static_cast<uint32_t>(escapeCount))];
+    return roomiest;
+}
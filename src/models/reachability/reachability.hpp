@@ -0,0 +1,209 @@
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include "board.hpp"
+#include "direction.hpp"
+#include "pcg32.hpp"
+#include "point.hpp"
+#include "snake.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief The free regions of a board, kept up to date as the snake moves
+ *
+ * @note Every free cell is labelled with its region and every region knows its size, so how much room a move leads
+ * into is a lookup. A freed tail joins the regions around it by relabelling the smaller ones. An occupied head only
+ * needs work when its free neighbours aren't connected through the cells around it, then a search runs from each
+ * neighbour in lockstep and the searches that finish first are the pieces cut off. The labels and searches are sized
+ * once for the board, so updates don't allocate.
+ */
+class Reachability
+{
+private:
+    /**
+     * @brief The label of occupied cells
+     *
+     */
+    constexpr static std::int32_t NO_REGION{-1};
+
+    const Board &board;
+
+    /**
+     * @brief The board's neighbour table, ending in the wall cell
+     *
+     */
+    const std::int32_t *neighbours;
+
+    /**
+     * @brief 1 for cells taken by the snake, an obstacle or the wall cell
+     *
+     */
+    std::vector<std::uint8_t> occupied;
+
+    /**
+     * @brief The region of every free cell
+     *
+     */
+    std::vector<std::int32_t> regions;
+
+    /**
+     * @brief The number of cells of every region
+     *
+     */
+    std::vector<std::int32_t> regionSizes;
+
+    /**
+     * @brief The labels not in use
+     *
+     */
+    std::vector<std::int32_t> unusedRegions;
+
+    /**
+     * @brief The cells found by each search, in the order they were found
+     *
+     */
+    std::array<std::vector<std::int32_t>, Board::DIRECTION_COUNT> searches;
+
+    /**
+     * @brief The search that found each cell, valid where searchMarks holds the current searchMark
+     *
+     */
+    std::vector<std::uint8_t> searchOwners;
+    std::vector<std::uint32_t> searchMarks;
+    std::uint32_t searchMark{0};
+
+    /**
+     * @brief The snake as of the last update
+     *
+     */
+    std::int32_t lastHead{0};
+    std::int32_t lastTail{0};
+    std::size_t lastLength{0};
+
+    /**
+     * @brief Get the cell the move from the cell leads to, the wall cell if it is blocked
+     *
+     */
+    std::int32_t getNeighbour(std::int32_t cell, int direction) const { return neighbours[static_cast<std::size_t>(cell) * Board::DIRECTION_COUNT + direction]; }
+
+    /**
+     * @brief Checks if a single move leads from one cell to the other
+     *
+     */
+    bool areNeighbours(std::int32_t cell, std::int32_t otherCell) const;
+
+    /**
+     * @brief Takes an unused label for a region of the size
+     *
+     */
+    std::int32_t createRegion(std::int32_t size);
+
+    /**
+     * @brief Labels the cells connected to the cell with the region
+     *
+     * @param cell A free cell
+     * @param from The region to relabel, NO_REGION to label unlabelled cells
+     * @param to The new region
+     * @return std::int32_t The number of cells labelled
+     */
+    std::int32_t labelRegion(std::int32_t cell, std::int32_t from, std::int32_t to);
+
+    /**
+     * @brief Checks if the free neighbours of the cell are connected through the eight cells around it
+     *
+     * @note Then taking the cell can't split its region
+     */
+    bool areNeighboursConnected(std::int32_t cell) const;
+
+    /**
+     * @brief Marks the cell free, merging the regions around it
+     *
+     */
+    void freeCell(std::int32_t cell);
+
+    /**
+     * @brief Marks the cell occupied, splitting its region if the cell was the only link between parts of it
+     *
+     */
+    void occupyCell(std::int32_t cell);
+
+    /**
+     * @brief Get the cell the snake's head would move to
+     *
+     */
+    std::int32_t getDestination(const Snake &snake, Directions::Direction direction) const;
+
+public:
+    /**
+     * @brief Labels the free regions of the board around the snake
+     *
+     * @param board The board, which must outlive the reachability
+     * @param snake The snake on the board
+     */
+    Reachability(const Board &board, const Snake &snake);
+
+    /**
+     * @brief Relabels every region from scratch
+     *
+     * @param snake The snake on the board
+     */
+    void rebuild(const Snake &snake);
+
+    /**
+     * @brief Catches up with the snake
+     *
+     * @note A single move or growth since the last update is applied incrementally, anything else rebuilds. A
+     * crashed snake is ignored.
+     * @param snake The snake on the board
+     */
+    void update(const Snake &snake);
+
+    /**
+     * @brief Get the number of free cells connected to the cell the move leads to, including it
+     *
+     * @note Moving onto the tail counts the regions the freed tail joins. Cells the tail frees later aren't counted.
+     * @param snake The snake, as of the last update
+     * @param direction The move
+     * @return int 0 if the move crashes
+     */
+    int getReachableCount(const Snake &snake, Directions::Direction direction) const;
+
+    /**
+     * @brief Checks if the move leads into room the snake can survive in
+     *
+     * @note True if the region the move leads to is at least as big as the snake, or if it touches a segment that
+     * frees before the region runs out. Following the tail always escapes.
+     * @param snake The snake, as of the last update
+     * @param direction The move
+     */
+    bool canEscape(const Snake &snake, Directions::Direction direction) const;
+
+    /**
+     * @brief Checks if every move crashes now or dead ends later, whichever apples are eaten
+     *
+     * @param snake The snake, as of the last update
+     */
+    bool isTrapped(const Snake &snake) const;
+
+    /**
+     * @brief Picks a random move that escapes, or the move with the most room if none does
+     *
+     * @param snake The snake, as of the last update
+     * @param random The generator to pick with
+     * @return std::optional<Directions::Direction> Empty if every move crashes
+     */
+    std::optional<Directions::Direction> pickMove(const Snake &snake, Pcg32 &random) const;
+
+    /**
+     * @brief Get the number of free regions
+     *
+     * @return std::size_t
+     */
+    std::size_t getRegionCount() const { return regionSizes.size() - unusedRegions.size(); }
+};
+
+#endif
@@ -0,0 +1,495 @@
+#include "replay_archive.hpp"
+#include "binary_format.hpp"
+#include "board.hpp"
+#include "game.hpp"
+#include "game_stepper.hpp"
+#include "point.hpp"
+#include "snake.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+constexpr string_view MAGIC{"SNKRPLY1"};
+constexpr string_view FOOTER_MAGIC{"SNKRIDX1"};
+
+/**
+ * @brief The replay count, footer offset, offsets CRC-32 and magic ending a footer
+ *
+ */
+constexpr size_t TRAILER_SIZE{8 + 8 + 4 + 8};
+
+/**
+ * @brief The largest board side a replay may have
+ *
+ */
+constexpr uint64_t MAX_SIDE{4096};
+
+/**
+ * @brief The moves room is made for at a time, long stretches without eating fit in half of it
+ *
+ */
+constexpr size_t MOVE_CHUNK{1 << 16};
+
+void Replay::reserveMoves()
+{
+    if (packedMoves.capacity() * 4 - moveCount >= MOVE_CHUNK / 2)
+        return;
+    packedMoves.reserve((moveCount + MOVE_CHUNK + 3) / 4);
+}
+
+void Replay::truncateMoves(size_t count)
+{
+    if (count >= moveCount)
+        return;
+    moveCount = count;
+    packedMoves.resize((count + 3) / 4);
+    if (count % 4 != 0)
+        packedMoves.back() &= static_cast<uint8_t>((1u << (count % 4 * 2)) - 1);
+}
+
+unique_ptr<Game> createReplayGame(const Replay &replay, const string &playerName)
+{
+    if (replay.width <= 0 || replay.height <= 0 || replay.snakeLength <= 0 || replay.snakeLength > replay.width)
+        throw invalid_argument("the replay's snake must fit in a board of positive size");
+    return make_unique<Game>(make_unique<Board>(replay.width, replay.height), make_unique<Snake>(Point(replay.snakeLength, replay.height), replay.snakeLength),
+                             replay.gameSpeed, playerName, replay.seed);
+}
+
+bool startReplay(const Game &game, Replay &replay)
+{
+    const Board &board{game.getBoard()};
+    const Snake &snake{game.getSnake()};
+    replay = Replay{};
+    replay.seed = game.getSeed();
+    replay.width = board.getWidth();
+    replay.height = board.getHeight();
+    replay.gameSpeed = game.getGameSpeed();
+    replay.snakeLength = static_cast<int>(snake.getBody().size());
+    if (board.getTopology() != BoardTopology::WALLED || game.getScore() != 0 || replay.snakeLength > replay.width)
+        return false;
+    for (int y{1}; y <= board.getHeight(); ++y)
+        for (int x{1}; x <= board.getWidth(); ++x)
+            if (board.isObstacle(Point{x, y}))
+                return false;
+
+    // Compare with the game the replay would start, built the same way
+    const auto start{createReplayGame(replay)};
+    return snake.getBody() == start->getSnake().getBody() && snake.getDirection() == start->getSnake().getDirection() &&
+           game.getApple() == start->getApple();
+}
+
+ReplayVerdict simulateReplay(const Replay &replay)
+{
+    // The game starts the way GameService starts it, without the sleeps between ticks
+    const auto replayGame{createReplayGame(replay)};
+    Game &game{*replayGame};
+    game.reserve();
+    const auto stepper{makeGameStepper(game)};
+    ReplayVerdict verdict;
+    for (size_t index{0}; index < replay.moveCount; ++index)
+    {
+        if (game.isGameOver())
+        {
+            verdict.hasMovesAfterCrash = true;
+            break;
+        }
+        stepper->step(replay.getMove(index));
+    }
+    verdict.score = game.getScore();
+    verdict.snakeLength = game.getSnake().getBody().size();
+    verdict.isGameOver = game.isGameOver();
+    return verdict;
+}
+
+/**
+ * @brief Appends the number as a little endian varint, 7 bits per byte
+ *
+ */
+static void appendVarint(string &bytes, uint64_t value)
+{
+    for (; value >= 0x80; value >>= 7)
+        bytes += static_cast<char>((value & 0x7F) | 0x80);
+    bytes += static_cast<char>(value);
+}
+
+/**
+ * @brief Reads a varint at the position, moving past it
+ *
+ * @return bool False if the bytes end inside it or it is too long
+ */
+static bool readVarint(string_view bytes, size_t &position, uint64_t &value)
+{
+    value = 0;
+    for (int shift{0}; shift < 64 && position < bytes.size(); shift += 7)
+    {
+        const auto byte{static_cast<uint8_t>(bytes[position++])};
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Appends the replay's frame
+ *
+ */
+static void appendFrame(string &bytes, const Replay &replay)
+{
+    string payload;
+    payload.reserve(32 + replay.packedMoves.size());
+    appendVarint(payload, replay.seed);
+    appendVarint(payload, static_cast<uint64_t>(replay.width));
+    appendVarint(payload, static_cast<uint64_t>(replay.height));
+    uint64_t speed;
+    memcpy(&speed, &replay.gameSpeed, sizeof(speed));
+    appendLittle<uint64_t>(payload, speed);
+    appendVarint(payload, static_cast<uint64_t>(replay.snakeLength));
+    appendVarint(payload, static_cast<uint64_t>(replay.score));
+    appendVarint(payload, replay.moveCount);
+    payload.append(reinterpret_cast<const char *>(replay.packedMoves.data()), (replay.moveCount + 3) / 4);
+
+    appendVarint(bytes, payload.size());
+    bytes += payload;
+    appendLittle<uint32_t>(bytes, computeCrc32(payload));
+}
+
+/**
+ * @brief Finds the payload of the frame at the offset and checks it
+ *
+ * @return bool False if the frame runs past the bytes or fails its checksum
+ */
+static bool readFrame(string_view bytes, uint64_t offset, string_view &payload, uint64_t &end)
+{
+    size_t position{static_cast<size_t>(offset)};
+    uint64_t size;
+    if (offset >= bytes.size() || !readVarint(bytes, position, size) || size > bytes.size() - position || bytes.size() - position - size < 4)
+        return false;
+    payload = bytes.substr(position, static_cast<size_t>(size));
+    end = position + size + 4;
+    return computeCrc32(payload) == readLittle<uint32_t>(bytes.data() + position + size);
+}
+
+/**
+ * @brief Decodes a checked payload
+ *
+ * @return bool False if the fields don't fit the payload or are out of range
+ */
+static bool decodePayload(string_view payload, Replay &replay)
+{
+    size_t position{0};
+    uint64_t seed, width, height, snakeLength, score, moveCount;
+    if (!readVarint(payload, position, seed) || !readVarint(payload, position, width) || !readVarint(payload, position, height) ||
+        payload.size() - position < sizeof(uint64_t))
+        return false;
+    const auto speed{readLittle<uint64_t>(payload.data() + position)};
+    position += sizeof(uint64_t);
+    if (!readVarint(payload, position, snakeLength) || !readVarint(payload, position, score) || !readVarint(payload, position, moveCount) ||
+        seed > UINT32_MAX || width > MAX_SIDE || height > MAX_SIDE || snakeLength > MAX_SIDE || score > INT32_MAX || moveCount / 4 > payload.size() || (moveCount + 3) / 4 != payload.size() - position)
+        return false;
+
+    replay.seed = static_cast<uint32_t>(seed);
+    replay.width = static_cast<int>(width);
+    replay.height = static_cast<int>(height);
+    memcpy(&replay.gameSpeed, &speed, sizeof(speed));
+    replay.snakeLength = static_cast<int>(snakeLength);
+    replay.score = static_cast<int>(score);
+    replay.moveCount = static_cast<size_t>(moveCount);
+    replay.packedMoves.assign(payload.begin() + static_cast<ptrdiff_t>(position), payload.end());
+    return true;
+}
+
+/**
+ * @brief Reads the index of the frames from the footer
+ *
+ * @param bytes The end of the file, holding at least the footer
+ * @param bytesOffset The offset of the bytes in the file
+ * @return bool False if there is no valid footer
+ */
+static bool readFooter(string_view bytes, uint64_t bytesOffset, vector<uint64_t> &offsets, uint64_t &footerOffset)
+{
+    if (bytes.size() < TRAILER_SIZE || bytes.substr(bytes.size() - FOOTER_MAGIC.size()) != FOOTER_MAGIC)
+        return false;
+    const char *const trailer{bytes.data() + bytes.size() - TRAILER_SIZE};
+    const auto count{readLittle<uint64_t>(trailer)};
+    footerOffset = readLittle<uint64_t>(trailer + 8);
+    const uint64_t trailerOffset{bytesOffset + bytes.size() - TRAILER_SIZE};
+    if (footerOffset < max<uint64_t>(bytesOffset, MAGIC.size()) || footerOffset > trailerOffset || count > trailerOffset - footerOffset)
+        return false;
+    const string_view index{bytes.substr(static_cast<size_t>(footerOffset - bytesOffset), static_cast<size_t>(trailerOffset - footerOffset))};
+    if (computeCrc32(index) != readLittle<uint32_t>(trailer + 16))
+        return false;
+
+    // Frames follow each other, so every offset is past the one before it and before the footer
+    offsets.clear();
+    offsets.reserve(static_cast<size_t>(count));
+    size_t position{0};
+    uint64_t offset{MAGIC.size()};
+    for (uint64_t replay{0}; replay < count; ++replay)
+    {
+        uint64_t difference;
+        if (!readVarint(index, position, difference) || difference > footerOffset - offset || (replay > 0 && difference == 0))
+            return false;
+        offset += difference;
+        offsets.push_back(offset);
+    }
+    return position == index.size() && (count == 0 || offset < footerOffset);
+}
+
+/**
+ * @brief Indexes the frames from the start, stopping at the first that is torn or corrupt
+ *
+ * @return uint64_t The offset after the last whole frame
+ */
+static uint64_t scanFrames(string_view bytes, vector<uint64_t> &offsets)
+{
+    offsets.clear();
+    uint64_t offset{MAGIC.size()};
+    string_view payload;
+    uint64_t end;
+    while (readFrame(bytes, offset, payload, end))
+    {
+        offsets.push_back(offset);
+        offset = end;
+    }
+    return offset;
+}
+
+/**
+ * @brief Appends the footer indexing the frames
+ *
+ */
+static void appendFooter(string &bytes, const vector<uint64_t> &offsets, uint64_t footerOffset)
+{
+    string index;
+    index.reserve(offsets.size() * 2);
+    uint64_t previous{MAGIC.size()};
+    for (const auto offset : offsets)
+    {
+        appendVarint(index, offset - previous);
+        previous = offset;
+    }
+    bytes += index;
+    appendLittle<uint64_t>(bytes, offsets.size());
+    appendLittle<uint64_t>(bytes, footerOffset);
+    appendLittle<uint32_t>(bytes, computeCrc32(index));
+    bytes += FOOTER_MAGIC;
+}
+
+ReplayArchive::ReplayArchive(const string &path) : file(make_unique<MappedFile>(path))
+{
+    const string_view bytes{file->getView()};
+    if (bytes.substr(0, MAGIC.size()) != MAGIC)
+        throw invalid_argument("not a replay archive: " + path);
+    uint64_t footerOffset;
+    hasFooter = readFooter(bytes, 0, offsets, footerOffset);
+    if (!hasFooter)
+        scanFrames(bytes, offsets);
+}
+
+void ReplayArchive::getReplay(size_t index, Replay &replay) const
+{
+    if (index >= offsets.size())
+        throw out_of_range("no replay " + to_string(index));
+    string_view payload;
+    uint64_t end;
+    if (!readFrame(file->getView(), offsets[index], payload, end) || !decodePayload(payload, replay))
+        throw runtime_error("replay " + to_string(index) + " is corrupt");
+}
+
+/**
+ * @brief Throws a runtime error describing the last failed system call
+ *
+ */
+[[noreturn]] static void throwSystemError(const string &action, const string &path)
+{
+    throw runtime_error("Failed to " + action + " replay archive at: " + path + " (" + strerror(errno) + ')');
+}
+
+#if defined(_WIN32)
+
+static int openFile(const string &path) { return _open(path.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE); }
+static void closeFile(int descriptor) { _close(descriptor); }
+static int64_t getFileSize(int descriptor) { return _filelengthi64(descriptor); }
+static bool truncateFile(int descriptor, int64_t size) { return _chsize_s(descriptor, size) == 0; }
+static bool syncFile(int descriptor) { return _commit(descriptor) == 0; }
+
+static bool setFileLock(int descriptor, bool isLocked)
+{
+    const auto handle{reinterpret_cast<HANDLE>(_get_osfhandle(descriptor))};
+    OVERLAPPED overlapped{};
+    return isLocked ? LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped) != 0
+                    : UnlockFileEx(handle, 0, MAXDWORD, MAXDWORD, &overlapped) != 0;
+}
+
+static bool readAt(int descriptor, char *buffer, size_t size, int64_t offset)
+{
+    // The file is locked so moving the shared position is safe
+    return _lseeki64(descriptor, offset, SEEK_SET) >= 0 && _read(descriptor, buffer, static_cast<unsigned>(size)) == static_cast<int>(size);
+}
+
+static bool writeAt(int descriptor, const char *bytes, size_t size, int64_t offset)
+{
+    return _lseeki64(descriptor, offset, SEEK_SET) >= 0 && _write(descriptor, bytes, static_cast<unsigned>(size)) == static_cast<int>(size);
+}
+
+#else
+
+static int openFile(const string &path) { return open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644); }
+static void closeFile(int descriptor) { close(descriptor); }
+static bool truncateFile(int descriptor, int64_t size) { return ftruncate(descriptor, size) == 0; }
+
+static int64_t getFileSize(int descriptor)
+{
+    struct stat status;
+    return fstat(descriptor, &status) == 0 ? static_cast<int64_t>(status.st_size) : -1;
+}
+
+static bool setFileLock(int descriptor, bool isLocked)
+{
+    int result;
+    do
+        result = flock(descriptor, isLocked ? LOCK_EX : LOCK_UN);
+    while (result != 0 && errno == EINTR);
+    return result == 0;
+}
+
+static bool readAt(int descriptor, char *buffer, size_t size, int64_t offset)
+{
+    while (size > 0)
+    {
+        const ssize_t count{pread(descriptor, buffer, size, offset)};
+        if (count <= 0 && !(count < 0 && errno == EINTR))
+            return false;
+        if (count > 0)
+        {
+            buffer += count;
+            size -= static_cast<size_t>(count);
+            offset += count;
+        }
+    }
+    return true;
+}
+
+static bool writeAt(int descriptor, const char *bytes, size_t size, int64_t offset)
+{
+    while (size > 0)
+    {
+        const ssize_t count{pwrite(descriptor, bytes, size, offset)};
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return false;
+        bytes += count;
+        size -= static_cast<size_t>(count);
+        offset += count;
+    }
+    return true;
+}
+
+static bool syncFile(int descriptor)
+{
+#if defined(__linux__)
+    return fdatasync(descriptor) == 0;
+#else
+    return fsync(descriptor) == 0;
+#endif
+}
+
+#endif
+
+uint64_t ReplayArchive::append(const string &path, const vector<Replay> &replays)
+{
+    const int descriptor{openFile(path)};
+    if (descriptor < 0)
+        throwSystemError("open", path);
+    if (!setFileLock(descriptor, true))
+    {
+        closeFile(descriptor);
+        throwSystemError("lock", path);
+    }
+
+    try
+    {
+        // Find where the frames end: at the footer if the last append finished, or after the last whole frame
+        const int64_t size{getFileSize(descriptor)};
+        if (size < 0)
+            throwSystemError("read", path);
+        vector<uint64_t> offsets;
+        uint64_t framesEnd{0};
+        if (size > 0)
+        {
+            string header(MAGIC.size(), '\0');
+            if (size < static_cast<int64_t>(MAGIC.size()) || !readAt(descriptor, header.data(), header.size(), 0) || header != MAGIC)
+                throw runtime_error("not a replay archive: " + path);
+
+            // Only the footer is read when there is one
+            bool hasFooter{false};
+            string trailer(TRAILER_SIZE, '\0');
+            if (size >= static_cast<int64_t>(MAGIC.size() + TRAILER_SIZE) && readAt(descriptor, trailer.data(), TRAILER_SIZE, size - static_cast<int64_t>(TRAILER_SIZE)))
+            {
+                const auto footerOffset{readLittle<uint64_t>(trailer.data() + 8)};
+                if (footerOffset >= MAGIC.size() && footerOffset <= static_cast<uint64_t>(size) - TRAILER_SIZE)
+                {
+                    string footer(static_cast<size_t>(static_cast<uint64_t>(size) - footerOffset), '\0');
+                    hasFooter = readAt(descriptor, footer.data(), footer.size(), static_cast<int64_t>(footerOffset)) && readFooter(footer, footerOffset, offsets, framesEnd);
+                }
+            }
+            if (!hasFooter)
+            {
+                string contents(static_cast<size_t>(size), '\0');
+                if (!readAt(descriptor, contents.data(), contents.size(), 0))
+                    throwSystemError("read", path);
+                framesEnd = scanFrames(contents, offsets);
+            }
+        }
+
+        // Write the new frames over the old footer, then the new footer, and drop anything left after it
+        const uint64_t firstIndex{offsets.size()};
+        string bytes{size == 0 ? string{MAGIC} : string{}};
+        for (const auto &replay : replays)
+        {
+            offsets.push_back(framesEnd + bytes.size());
+            appendFrame(bytes, replay);
+        }
+        appendFooter(bytes, offsets, framesEnd + bytes.size());
+        if (!writeAt(descriptor, bytes.data(), bytes.size(), static_cast<int64_t>(framesEnd)) || !truncateFile(descriptor, static_cast<int64_t>(framesEnd + bytes.size())) ||
+            !syncFile(descriptor))
+            throwSystemError("write", path);
+        setFileLock(descriptor, false);
+        closeFile(descriptor);
+        return firstIndex;
+    }
+    catch (...)
+    {
+        setFileLock(descriptor, false);
+        closeFile(descriptor);
+        throw;
+    }
+}
+
+uint64_t ReplayArchive::append(const string &path, const Replay &replay)
+{
+    return append(path, vector<Replay>{replay});
+}
@@ -0,0 +1,193 @@
+#ifndef REPLAY_ARCHIVE_H
+#define REPLAY_ARCHIVE_H
+
+#include "direction.hpp"
+#include "mapped_file.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Game;
+
+/**
+ * @brief Everything needed to play a game again: its settings, seed and the direction given on every tick
+ *
+ * @note Replays are of games on boards without obstacles with the snake starting the way GameService starts it, see
+ * createReplayGame. Moves are packed 4 to a byte, the first move in the lowest 2 bits.
+ */
+struct Replay
+{
+    std::uint32_t seed{0};
+    int width{0};
+    int height{0};
+    double gameSpeed{0};
+    int snakeLength{0};
+
+    /**
+     * @brief The score the game ended with, as recorded when it was saved
+     *
+     */
+    int score{0};
+
+    std::vector<std::uint8_t> packedMoves;
+    std::size_t moveCount{0};
+
+    /**
+     * @brief Adds the direction given on the next tick
+     *
+     */
+    void addMove(Directions::Direction direction)
+    {
+        if (moveCount % 4 == 0)
+            packedMoves.push_back(0);
+        packedMoves.back() |= static_cast<std::uint8_t>(static_cast<unsigned>(direction) << (moveCount % 4 * 2));
+        ++moveCount;
+    }
+
+    /**
+     * @brief Makes room for the moves of the next ticks, so recording them doesn't allocate
+     *
+     * @note Grows by a chunk once less than half of one is left, call it on ticks that already do more than move
+     */
+    void reserveMoves();
+
+    /**
+     * @brief Get the direction given on a tick
+     *
+     * @param index The tick, not validated
+     */
+    Directions::Direction getMove(std::size_t index) const { return static_cast<Directions::Direction>(packedMoves[index / 4] >> (index % 4 * 2) & 3); }
+
+    /**
+     * @brief Drops the moves of the last ticks, like the ticks taken back in practice mode
+     *
+     * @param count The moves to keep
+     */
+    void truncateMoves(std::size_t count);
+};
+
+/**
+ * @brief The result of playing a replay again
+ *
+ */
+struct ReplayVerdict
+{
+    int score{0};
+    std::size_t snakeLength{0};
+    bool isGameOver{false};
+
+    /**
+     * @brief Whether the replay has moves after the snake crashed
+     *
+     */
+    bool hasMovesAfterCrash{false};
+};
+
+/**
+ * @brief Creates the game a replay starts from, the one GameService starts on an empty board with its settings
+ *
+ * @param replay The replay, its moves aren't played
+ * @param playerName The player of the game
+ * @throws std::invalid_argument Thrown if the replay's settings can't make a game
+ * @return std::unique_ptr<Game>
+ */
+std::unique_ptr<Game> createReplayGame(const Replay &replay, const std::string &playerName = "Replay");
+
+/**
+ * @brief Starts recording a game that hasn't been stepped yet
+ *
+ * @param game The game
+ * @param replay Set to the game's settings and seed, without moves
+ * @return true if a replay starts the game again, its walled board has no obstacles and the snake starts where
+ * createReplayGame puts it
+ * @return false if the game can't be recorded
+ */
+bool startReplay(const Game &game, Replay &replay);
+
+/**
+ * @brief Plays a replay again with the game rules, as fast as they step
+ *
+ * @param replay The replay
+ * @throws std::invalid_argument Thrown if the replay's settings can't make a game
+ * @return ReplayVerdict
+ */
+ReplayVerdict simulateReplay(const Replay &replay);
+
+/**
+ * @brief An append only file of replays read by their index
+ *
+ * @note The file is the 8 byte magic "SNKRPLY1" and a frame per replay: the payload size as a varint, the payload
+ * and the CRC-32 of the payload as 4 little endian bytes. A payload holds the seed, width, height, starting length,
+ * score and move count as varints, with the speed as a little endian double after the height, followed by the
+ * packed moves. After the frames comes a footer indexing them: the offset of each frame as a varint difference
+ * from the one before it, then the replay count and footer offset as 64 bit integers, the CRC-32 of the offsets
+ * and the magic "SNKRIDX1". Appending writes new frames over the footer and writes a new one, holding an exclusive
+ * advisory lock on the file, so a file without a valid footer is one whose writer crashed and its frames are
+ * scanned instead, up to the first torn frame.
+ */
+class ReplayArchive
+{
+private:
+    std::unique_ptr<MappedFile> file;
+
+    /**
+     * @brief The offset of each replay's frame
+     *
+     */
+    std::vector<std::uint64_t> offsets;
+
+    bool hasFooter{false};
+
+public:
+    /**
+     * @brief Maps the archive and reads its index
+     *
+     * @param path The archive
+     * @throws std::invalid_argument Thrown if the file can't be mapped or isn't a replay archive
+     */
+    explicit ReplayArchive(const std::string &path);
+
+    /**
+     * @brief Get the number of replays
+     *
+     */
+    std::size_t getReplayCount() const { return offsets.size(); }
+
+    /**
+     * @brief Whether the index was read from the footer rather than by scanning the frames
+     *
+     */
+    bool isIndexed() const { return hasFooter; }
+
+    /**
+     * @brief Reads a replay
+     *
+     * @param index The replay's index, the id append returned
+     * @param replay Filled with the replay, reusing its storage
+     * @throws std::out_of_range Thrown if there is no such replay
+     * @throws std::runtime_error Thrown if the replay's frame is corrupt
+     */
+    void getReplay(std::size_t index, Replay &replay) const;
+
+    /**
+     * @brief Appends replays to an archive, creating it if needed
+     *
+     * @param path The archive
+     * @param replays The replays
+     * @throws std::runtime_error Thrown if the file can't be written or isn't a replay archive
+     * @return std::uint64_t The index of the first replay appended
+     */
+    static std::uint64_t append(const std::string &path, const std::vector<Replay> &replays);
+
+    /**
+     * @brief Appends a replay to an archive, creating it if needed
+     *
+     * @throws std::runtime_error Thrown if the file can't be written or isn't a replay archive
+     * @return std::uint64_t The index of the replay
+     */
+    static std::uint64_t append(const std::string &path, const Replay &replay);
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "rewind_buffer.hpp"
+#include "board.hpp"
+#include "snake.hpp"
+#include "point.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+RewindBuffer::RewindBuffer(Game &game, GameStepper &stepper, size_t historyLength) : game(game), stepper(stepper), historyLength(historyLength)
+{
+    if (historyLength == 0)
+        throw invalid_argument("history length must be positive");
+    ticks.resize(historyLength);
+
+    // Each cell can be eaten at most once, so the ring never fills and ticks don't allocate
+    randoms.resize(min(historyLength, static_cast<size_t>(game.getBoard().getCellCount())));
+}
+
+StepOutcome RewindBuffer::step(Directions::Direction direction)
+{
+    const Snake &snake{game.getSnake()};
+    const Directions::Direction previousDirection{snake.getDirection()};
+    const Point tail{snake.getTail()};
+    const Pcg32 random{game.getRandom()};
+    const StepOutcome outcome{stepper.step(direction)};
+
+    // Drop the oldest tick once the history is full
+    if (tickCount == historyLength)
+    {
+        if (static_cast<StepOutcome>(ticks[firstTick] & 3) == StepOutcome::ATE)
+        {
+            firstRandom = (firstRandom + 1) % randoms.size();
+            --randomCount;
+        }
+        firstTick = (firstTick + 1) % historyLength;
+        --tickCount;
+    }
+
+    // Body segments are neighbours, so the tail moved off is one direction away from the new tail
+    int tailDirection{0};
+    if (outcome == StepOutcome::ATE)
+        randoms[(firstRandom + randomCount++) % randoms.size()] = random;
+    else
+        while (tailDirection < Board::DIRECTION_COUNT - 1 && game.getBoard().getNeighbour(snake.getTail(), static_cast<Directions::Direction>(tailDirection)) != tail)
+            ++tailDirection;
+
+    ticks[(firstTick + tickCount) % historyLength] = static_cast<uint8_t>(static_cast<int>(outcome) | static_cast<int>(previousDirection) << 2 | tailDirection << 4);
+    ++tickCount;
+    return outcome;
+}
+
+bool RewindBuffer::undo()
+{
+    if (tickCount == 0)
+        return false;
+    --tickCount;
+    const uint8_t tick{ticks[(firstTick + tickCount) % historyLength]};
+    const auto outcome{static_cast<StepOutcome>(tick & 3)};
+    const auto previousDirection{static_cast<Directions::Direction>(tick >> 2 & 3)};
+
+    Point freedTail;
+    if (outcome == StepOutcome::ATE)
+    {
+        --randomCount;
+        game.getRandom() = randoms[(firstRandom + randomCount) % randoms.size()];
+    }
+    else
+    {
+        freedTail = game.getBoard().getNeighbour(game.getSnake().getTail(), static_cast<Directions::Direction>(tick >> 4 & 3));
+    }
+    stepper.undo(outcome, previousDirection, freedTail);
+    return true;
+}
+
+size_t RewindBuffer::rewind(size_t tickCount)
+{
+    size_t undone{0};
+    while (undone < tickCount && undo())
+        ++undone;
+    return undone;
+}
+
+void RewindBuffer::clear()
+{
+    firstTick = 0;
+    tickCount = 0;
+    firstRandom = 0;
+    randomCount = 0;
+}
@@ -0,0 +1,102 @@
+#ifndef REWIND_BUFFER_H
+#define REWIND_BUFFER_H
+
+#include "game.hpp"
+#include "game_stepper.hpp"
+#include "direction.hpp"
+#include "pcg32.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Steps a game while keeping the last ticks so they can be taken back
+ *
+ * @note Each tick is one byte, its outcome, the direction the snake faced before it and the direction from the new
+ * tail to the tail it moved off. The rest of the tick follows from the game after it: the head pushed is the current
+ * head, the apple eaten was where the head is and the score changed by GameStepper::APPLE_SCORE. The random generator
+ * before each apple is kept on the side since placing an apple draws a varying number of times. Undoing a tick is
+ * constant time however long the snake is, and the memory is bounded by the history length however large the board
+ * is. The oldest ticks are dropped once the history is full. Not thread safe.
+ */
+class RewindBuffer
+{
+private:
+    Game &game;
+    GameStepper &stepper;
+    const std::size_t historyLength;
+
+    /**
+     * @brief The ticks as a ring, from the oldest at firstTick
+     *
+     */
+    std::vector<std::uint8_t> ticks;
+    std::size_t firstTick{0};
+    std::size_t tickCount{0};
+
+    /**
+     * @brief The random generator before each apple eaten in the history as a ring, from the oldest at firstRandom
+     *
+     * @note Sized for the most apples the history can hold, the history length or the board's cells if fewer
+     */
+    std::vector<Pcg32> randoms;
+    std::size_t firstRandom{0};
+    std::size_t randomCount{0};
+
+public:
+    /**
+     * @brief Construct a new Rewind Buffer object
+     *
+     * @param game The game to step, must outlive the buffer
+     * @param stepper The stepper of the game, must outlive the buffer
+     * @param historyLength The most ticks kept
+     * @throws std::invalid_argument Thrown if the history length is 0
+     */
+    RewindBuffer(Game &game, GameStepper &stepper, std::size_t historyLength);
+
+    /**
+     * @brief Steps the game and keeps the tick
+     *
+     * @param direction The direction to move
+     * @return StepOutcome What happened during the step
+     */
+    StepOutcome step(Directions::Direction direction);
+
+    /**
+     * @brief Takes back the last tick kept
+     *
+     * @return true if a tick was taken back
+     * @return false if no tick is kept
+     */
+    bool undo();
+
+    /**
+     * @brief Takes back the last ticks kept, stopping early if the history runs out
+     *
+     * @param tickCount The ticks to take back
+     * @return std::size_t The ticks taken back
+     */
+    std::size_t rewind(std::size_t tickCount);
+
+    /**
+     * @brief Forgets every tick kept, for when the game is changed without the buffer
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Get the number of ticks that can be taken back
+     *
+     */
+    std::size_t getTickCount() const { return tickCount; }
+
+    std::size_t getHistoryLength() const { return historyLength; }
+
+    /**
+     * @brief Get the bytes used by the history
+     *
+     */
+    std::size_t getMemoryUsage() const { return ticks.capacity() + randoms.capacity() * sizeof(Pcg32); }
+};
+
+#endif
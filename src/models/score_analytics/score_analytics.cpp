@@ -0,0 +1,430 @@
+#include "score_analytics.hpp"
+#include "score_record.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+using namespace std;
+
+/**
+ * @brief Scores below this are counted in a dense array, others in an ordered map
+ *
+ */
+constexpr int DENSE_SCORE_LIMIT{1 << 20};
+
+/**
+ * @brief Hashes the fields of a bucket
+ *
+ */
+struct ScoreBucketHash
+{
+    size_t operator()(const ScoreBucket &bucket) const
+    {
+        size_t value{std::hash<double>{}(bucket.gameSpeed)};
+        for (const int field : {bucket.width, bucket.height, bucket.snakeLength})
+            value = value * 0x9E3779B97F4A7C15ull + static_cast<size_t>(field);
+        return value;
+    }
+};
+
+/**
+ * @brief A score that points into the mapped file
+ *
+ */
+struct ScoreEntryView
+{
+    string_view playerName;
+    bool isNameEscaped{false};
+    int score{0};
+    int64_t timestamp{0};
+    ScoreBucket bucket;
+};
+
+/**
+ * @brief Orders the settings of buckets
+ *
+ */
+static bool isBucketBefore(const ScoreBucket &first, const ScoreBucket &second)
+{
+    return tie(first.width, first.height, first.gameSpeed, first.snakeLength) < tie(second.width, second.height, second.gameSpeed, second.snakeLength);
+}
+
+/**
+ * @brief Orders scores best first, earlier scores win ties
+ *
+ * @note Remaining ties are ordered by name and settings, so the report doesn't depend on how the file was split
+ */
+static bool isBetter(const ScoreEntryView &first, const ScoreEntryView &second)
+{
+    if (first.score != second.score)
+        return first.score > second.score;
+    if (first.timestamp != second.timestamp)
+        return first.timestamp < second.timestamp;
+    if (first.playerName != second.playerName)
+        return first.playerName < second.playerName;
+    return isBucketBefore(first.bucket, second.bucket);
+}
+
+/**
+ * @brief The scores of one bucket aggregated by one thread
+ *
+ */
+struct BucketPartial
+{
+    uint64_t count{0};
+    int64_t scoreSum{0};
+    vector<uint64_t> denseCounts;
+    map<int, uint64_t> sparseCounts;
+
+    /**
+     * @brief The best scores as a heap with the worst kept score at the front
+     *
+     */
+    vector<ScoreEntryView> topScores;
+
+    void add(const ScoreEntryView &entry, size_t topCount)
+    {
+        ++count;
+        scoreSum += entry.score;
+        if (entry.score >= 0 && entry.score < DENSE_SCORE_LIMIT)
+        {
+            if (static_cast<size_t>(entry.score) >= denseCounts.size())
+                denseCounts.resize(max<size_t>(entry.score + 1, denseCounts.size() * 2));
+            ++denseCounts[entry.score];
+        }
+        else
+        {
+            ++sparseCounts[entry.score];
+        }
+        addTopScore(entry, topCount);
+    }
+
+    void addTopScore(const ScoreEntryView &entry, size_t topCount)
+    {
+        if (topScores.size() < topCount)
+        {
+            topScores.push_back(entry);
+            push_heap(topScores.begin(), topScores.end(), isBetter);
+        }
+        else if (topCount > 0 && isBetter(entry, topScores.front()))
+        {
+            pop_heap(topScores.begin(), topScores.end(), isBetter);
+            topScores.back() = entry;
+            push_heap(topScores.begin(), topScores.end(), isBetter);
+        }
+    }
+
+    void merge(BucketPartial &other, size_t topCount)
+    {
+        count += other.count;
+        scoreSum += other.scoreSum;
+        if (other.denseCounts.size() > denseCounts.size())
+            denseCounts.resize(other.denseCounts.size());
+        for (size_t score{0}; score < other.denseCounts.size(); ++score)
+            denseCounts[score] += other.denseCounts[score];
+        for (const auto &[score, scoreCount] : other.sparseCounts)
+            sparseCounts[score] += scoreCount;
+        for (const auto &entry : other.topScores)
+            addTopScore(entry, topCount);
+    }
+
+    /**
+     * @brief Get the score at the percentile by nearest rank
+     *
+     */
+    int getPercentile(double percentile) const
+    {
+        const uint64_t rank{max<uint64_t>(1, static_cast<uint64_t>(ceil(percentile / 100.0 * static_cast<double>(count))))};
+        uint64_t seen{0};
+        auto sparse{sparseCounts.begin()};
+        for (; sparse != sparseCounts.end() && sparse->first < 0; ++sparse)
+            if ((seen += sparse->second) >= rank)
+                return sparse->first;
+        for (size_t score{0}; score < denseCounts.size(); ++score)
+            if ((seen += denseCounts[score]) >= rank)
+                return static_cast<int>(score);
+        for (; sparse != sparseCounts.end(); ++sparse)
+            if ((seen += sparse->second) >= rank)
+                return sparse->first;
+        return sparseCounts.empty() ? static_cast<int>(denseCounts.size()) - 1 : sparseCounts.rbegin()->first;
+    }
+};
+
+/**
+ * @brief The best score of each player in an open addressing table
+ *
+ * @note With many players every row misses the cache, so each slot keeps the name hash, short names and the best
+ * score inline and most rows touch a single slot
+ */
+class PlayerBestTable
+{
+private:
+    /**
+     * @brief Names up to this length are compared in the slot
+     *
+     */
+    constexpr static size_t INLINE_NAME_SIZE{15};
+
+    struct Slot
+    {
+        uint64_t hash{0};
+        uint32_t entry{0};
+        int32_t bestScore{0};
+        uint8_t nameSize{0};
+        char name[INLINE_NAME_SIZE]{};
+    };
+
+    vector<Slot> slots{vector<Slot>(1024)};
+    vector<ScoreEntryView> entries;
+
+    static bool isUsed(const Slot &slot) { return slot.hash != 0; }
+
+    bool isSamePlayer(const Slot &slot, uint64_t hash, string_view name) const
+    {
+        if (slot.hash != hash)
+            return false;
+        if (name.size() <= INLINE_NAME_SIZE)
+            return slot.nameSize == name.size() && memcmp(slot.name, name.data(), name.size()) == 0;
+        return entries[slot.entry].playerName == name;
+    }
+
+    void grow()
+    {
+        vector<Slot> oldSlots(slots.size() * 2);
+        oldSlots.swap(slots);
+        const size_t mask{slots.size() - 1};
+        for (const auto &slot : oldSlots)
+        {
+            if (!isUsed(slot))
+                continue;
+            size_t index{slot.hash & mask};
+            while (isUsed(slots[index]))
+                index = (index + 1) & mask;
+            slots[index] = slot;
+        }
+    }
+
+public:
+    void add(const ScoreEntryView &entry)
+    {
+        // Zero marks an empty slot
+        const uint64_t hash{std::hash<string_view>{}(entry.playerName) | 1};
+        const size_t mask{slots.size() - 1};
+        size_t index{hash & mask};
+        while (isUsed(slots[index]))
+        {
+            Slot &slot{slots[index]};
+            if (isSamePlayer(slot, hash, entry.playerName))
+            {
+                // Only scores that can win touch the entry
+                if (entry.score >= slot.bestScore && isBetter(entry, entries[slot.entry]))
+                {
+                    entries[slot.entry] = entry;
+                    slot.bestScore = entry.score;
+                }
+                return;
+            }
+            index = (index + 1) & mask;
+        }
+
+        // Keep the table at most half full
+        Slot &slot{slots[index]};
+        slot.hash = hash;
+        slot.entry = static_cast<uint32_t>(entries.size());
+        slot.bestScore = entry.score;
+        slot.nameSize = static_cast<uint8_t>(min<size_t>(entry.playerName.size(), 255));
+        memcpy(slot.name, entry.playerName.data(), min(entry.playerName.size(), INLINE_NAME_SIZE));
+        entries.push_back(entry);
+        if (entries.size() * 2 > slots.size())
+            grow();
+    }
+
+    const vector<ScoreEntryView> &getEntries() const { return entries; }
+};
+
+/**
+ * @brief Everything one thread aggregated from its chunk
+ *
+ */
+struct ScorePartial
+{
+    ScoreFileCounts lines;
+    PlayerBestTable playerBests;
+    unordered_map<ScoreBucket, BucketPartial, ScoreBucketHash> buckets;
+    unordered_map<int64_t, TimeBin> timeBins;
+};
+
+/**
+ * @brief Parses and aggregates the complete lines of a chunk
+ *
+ */
+static void aggregateChunk(string_view chunk, const ScoreQuery &query, ScorePartial &partial)
+{
+    const size_t topCount{static_cast<size_t>(query.topCount)};
+    ScoreRecordView record;
+    ScoreBucket lastKey;
+    BucketPartial *lastBucket{nullptr};
+
+    while (!chunk.empty())
+    {
+        // Split off the next line
+        const auto *newline{static_cast<const char *>(memchr(chunk.data(), '\n', chunk.size()))};
+        const size_t lineLength{newline ? static_cast<size_t>(newline - chunk.data()) : chunk.size()};
+        string_view line{chunk.substr(0, lineLength)};
+        chunk.remove_prefix(newline ? lineLength + 1 : lineLength);
+        if (!line.empty() && line.back() == '\r' && line.front() != '#')
+            line.remove_suffix(1);
+
+        switch (parseScoreLine(line, record, query.verifyChecksums))
+        {
+        case ScoreLineStatus::FRAMED:
+            ++partial.lines.framed;
+            break;
+        case ScoreLineStatus::LEGACY:
+            ++partial.lines.legacy;
+            break;
+        case ScoreLineStatus::MALFORMED:
+            ++partial.lines.malformed;
+            continue;
+        }
+
+        const ScoreEntryView entry{record.playerName, record.isNameEscaped, record.score, record.timestamp,
+                                   ScoreBucket{record.width, record.height, record.gameSpeed, record.snakeLength}};
+
+        // Consecutive scores usually share a bucket
+        if (!lastBucket || !(lastKey == entry.bucket))
+        {
+            lastKey = entry.bucket;
+            lastBucket = &partial.buckets[entry.bucket];
+        }
+        lastBucket->add(entry, topCount);
+
+        partial.playerBests.add(entry);
+
+        if (entry.timestamp > 0)
+        {
+            const int64_t binStart{entry.timestamp - entry.timestamp % query.binSeconds};
+            TimeBin &bin{partial.timeBins[binStart]};
+            bin.bestScore = bin.count == 0 ? entry.score : max(bin.bestScore, entry.score);
+            bin.start = binStart;
+            ++bin.count;
+        }
+    }
+}
+
+/**
+ * @brief Merges the second partial into the first
+ *
+ */
+static void mergePartial(ScorePartial &target, ScorePartial &source, size_t topCount)
+{
+    target.lines.framed += source.lines.framed;
+    target.lines.legacy += source.lines.legacy;
+    target.lines.malformed += source.lines.malformed;
+    for (auto &[key, bucket] : source.buckets)
+        target.buckets[key].merge(bucket, topCount);
+    for (const auto &entry : source.playerBests.getEntries())
+        target.playerBests.add(entry);
+    for (const auto &[start, bin] : source.timeBins)
+    {
+        const auto [targetBin, isNew]{target.timeBins.try_emplace(start, bin)};
+        if (!isNew)
+        {
+            targetBin->second.bestScore = max(targetBin->second.bestScore, bin.bestScore);
+            targetBin->second.count += bin.count;
+        }
+    }
+}
+
+/**
+ * @brief Copies a score out of the mapped file
+ *
+ */
+static ScoreEntry toScoreEntry(const ScoreEntryView &view)
+{
+    return ScoreEntry{getPlayerName(ScoreRecordView{view.playerName, view.isNameEscaped}), view.score, view.timestamp, view.bucket};
+}
+
+ScoreReport ScoreAnalytics::analyze(const string &path, const ScoreQuery &query)
+{
+    const MappedFile file(path);
+    return analyze(file.getView(), query);
+}
+
+ScoreReport ScoreAnalytics::analyze(string_view contents, const ScoreQuery &query)
+{
+    if (query.topCount < 0 || query.binSeconds <= 0)
+        throw invalid_argument("score query is invalid");
+    for (const double percentile : query.percentiles)
+        if (percentile < 0 || percentile > 100)
+            throw invalid_argument("percentiles must be between 0 and 100");
+
+    // Split the contents into newline aligned chunks, one per thread
+    const size_t threadCount{max<size_t>(1, query.threadCount > 0 ? static_cast<size_t>(query.threadCount) : thread::hardware_concurrency())};
+    vector<string_view> chunks;
+    size_t chunkStart{0};
+    for (size_t chunk{1}; chunk <= threadCount && chunkStart < contents.size(); ++chunk)
+    {
+        size_t chunkEnd{chunk == threadCount ? contents.size() : contents.size() / threadCount * chunk};
+        if (chunkEnd < chunkStart)
+            chunkEnd = chunkStart;
+        const size_t newline{contents.find('\n', chunkEnd == 0 ? 0 : chunkEnd - 1)};
+        chunkEnd = newline == string_view::npos ? contents.size() : newline + 1;
+        chunks.push_back(contents.substr(chunkStart, chunkEnd - chunkStart));
+        chunkStart = chunkEnd;
+    }
+
+    // Aggregate every chunk on its own thread
+    vector<ScorePartial> partials(max<size_t>(1, chunks.size()));
+    vector<thread> threads;
+    for (size_t chunk{1}; chunk < chunks.size(); ++chunk)
+        threads.emplace_back(aggregateChunk, chunks[chunk], cref(query), ref(partials[chunk]));
+    if (!chunks.empty())
+        aggregateChunk(chunks.front(), query, partials.front());
+    for (auto &thread : threads)
+        thread.join();
+
+    const size_t topCount{static_cast<size_t>(query.topCount)};
+    for (size_t partial{1}; partial < partials.size(); ++partial)
+        mergePartial(partials.front(), partials[partial], topCount);
+    ScorePartial &merged{partials.front()};
+
+    // Copy the answers out of the contents
+    ScoreReport report;
+    report.lines = merged.lines;
+
+    vector<ScoreEntryView> bests{merged.playerBests.getEntries()};
+    sort(bests.begin(), bests.end(), isBetter);
+    report.playerBests.reserve(bests.size());
+    for (const auto &entry : bests)
+        report.playerBests.push_back(toScoreEntry(entry));
+
+    for (auto &[key, bucket] : merged.buckets)
+    {
+        BucketSummary summary;
+        summary.bucket = key;
+        summary.count = bucket.count;
+        summary.meanScore = static_cast<double>(bucket.scoreSum) / static_cast<double>(bucket.count);
+        for (const double percentile : query.percentiles)
+            summary.percentiles.push_back(bucket.getPercentile(percentile));
+        sort(bucket.topScores.begin(), bucket.topScores.end(), isBetter);
+        for (const auto &entry : bucket.topScores)
+            summary.topScores.push_back(toScoreEntry(entry));
+        report.buckets.push_back(std::move(summary));
+    }
+    sort(report.buckets.begin(), report.buckets.end(), [](const BucketSummary &first, const BucketSummary &second)
+         { return first.count != second.count ? first.count > second.count : isBucketBefore(first.bucket, second.bucket); });
+
+    for (const auto &[start, bin] : merged.timeBins)
+        report.timeBins.push_back(bin);
+    sort(report.timeBins.begin(), report.timeBins.end(), [](const TimeBin &first, const TimeBin &second)
+         { return first.start < second.start; });
+    return report;
+}
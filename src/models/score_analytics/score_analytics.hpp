@@ -0,0 +1,170 @@
+#ifndef SCORE_ANALYTICS_H
+#define SCORE_ANALYTICS_H
+
+#include "score_record.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief The game settings scores are compared within
+ *
+ */
+struct ScoreBucket
+{
+    int width{0};
+    int height{0};
+    double gameSpeed{0};
+    int snakeLength{0};
+
+    bool operator==(const ScoreBucket &) const = default;
+};
+
+/**
+ * @brief A score of a player
+ *
+ */
+struct ScoreEntry
+{
+    std::string playerName;
+    int score{0};
+    std::int64_t timestamp{0};
+    ScoreBucket bucket;
+};
+
+/**
+ * @brief The scores of one bucket
+ *
+ */
+struct BucketSummary
+{
+    ScoreBucket bucket;
+    std::uint64_t count{0};
+    double meanScore{0};
+
+    /**
+     * @brief The score at each requested percentile, in the order requested
+     *
+     */
+    std::vector<int> percentiles;
+
+    /**
+     * @brief The best scores, best first
+     *
+     */
+    std::vector<ScoreEntry> topScores;
+};
+
+/**
+ * @brief The scores saved during one interval of time
+ *
+ */
+struct TimeBin
+{
+    /**
+     * @brief The seconds since the unix epoch when the interval starts
+     *
+     */
+    std::int64_t start{0};
+    std::uint64_t count{0};
+    int bestScore{0};
+};
+
+/**
+ * @brief The questions asked of a score file
+ *
+ */
+struct ScoreQuery
+{
+    /**
+     * @brief The number of best scores kept per bucket
+     *
+     */
+    int topCount{10};
+
+    /**
+     * @brief The percentiles computed per bucket, between 0 and 100
+     *
+     */
+    std::vector<double> percentiles{50, 90, 99};
+
+    /**
+     * @brief The seconds covered by each time bin, legacy records without a timestamp are not binned
+     *
+     */
+    std::int64_t binSeconds{24 * 60 * 60};
+
+    /**
+     * @brief The number of threads parsing the file, 0 for one per core
+     *
+     */
+    int threadCount{0};
+
+    /**
+     * @brief Whether the checksum of every framed line is checked
+     *
+     */
+    bool verifyChecksums{true};
+};
+
+/**
+ * @brief The answers for a score file
+ *
+ */
+struct ScoreReport
+{
+    ScoreFileCounts lines;
+
+    /**
+     * @brief The best score of every player, best first
+     *
+     */
+    std::vector<ScoreEntry> playerBests;
+
+    /**
+     * @brief Every bucket, most played first
+     *
+     */
+    std::vector<BucketSummary> buckets;
+
+    /**
+     * @brief The time bins that have scores, oldest first
+     *
+     */
+    std::vector<TimeBin> timeBins;
+};
+
+/**
+ * @brief Answers leaderboard queries over whole score files
+ *
+ * @note The file is memory mapped and split into newline aligned chunks that are parsed in place on every core.
+ * Each thread aggregates its chunk separately and the partial results are merged at the end, so no locks are
+ * taken while parsing. Percentiles are exact.
+ */
+class ScoreAnalytics
+{
+public:
+    /**
+     * @brief Analyzes a score file
+     *
+     * @param path The score file
+     * @param query The questions to answer
+     * @throws std::invalid_argument Thrown if the file can't be mapped or the query is invalid
+     * @return ScoreReport
+     */
+    static ScoreReport analyze(const std::string &path, const ScoreQuery &query = {});
+
+    /**
+     * @brief Analyzes the contents of a score file
+     *
+     * @param contents The lines of the score file
+     * @param query The questions to answer
+     * @throws std::invalid_argument Thrown if the query is invalid
+     * @return ScoreReport
+     */
+    static ScoreReport analyze(std::string_view contents, const ScoreQuery &query = {});
+};
+
+#endif
@@ -0,0 +1,342 @@
+#include "score_journal.hpp"
+#include "score_record.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/**
+ * @brief Throws a runtime error describing the last failed system call
+ *
+ */
+[[noreturn]] static void throwSystemError(const string &action, const string &path)
+{
+    throw runtime_error("Failed to " + action + " score journal at: " + path + " (" + strerror(errno) + ')');
+}
+
+#if defined(_WIN32)
+
+static int openFile(const string &path) { return _open(path.c_str(), _O_RDWR | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE); }
+static void closeFile(int descriptor) { _close(descriptor); }
+static int64_t getFileSize(int descriptor) { return _filelengthi64(descriptor); }
+static bool truncateFile(int descriptor, int64_t size) { return _chsize_s(descriptor, size) == 0; }
+static bool syncFile(int descriptor) { return _commit(descriptor) == 0; }
+
+static bool setFileLock(int descriptor, bool isLocked)
+{
+    const auto handle{reinterpret_cast<HANDLE>(_get_osfhandle(descriptor))};
+    OVERLAPPED overlapped{};
+    return isLocked ? LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped) != 0
+                    : UnlockFileEx(handle, 0, MAXDWORD, MAXDWORD, &overlapped) != 0;
+}
+
+static int64_t readAt(int descriptor, char *buffer, size_t size, int64_t offset)
+{
+    // The file is locked so moving the shared position is safe, appends always go to the end
+    if (_lseeki64(descriptor, offset, SEEK_SET) < 0)
+        return -1;
+    return _read(descriptor, buffer, static_cast<unsigned>(size));
+}
+
+static int64_t writeSome(int descriptor, const char *bytes, size_t size) { return _write(descriptor, bytes, static_cast<unsigned>(size)); }
+
+#else
+
+static int openFile(const string &path) { return open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644); }
+static void closeFile(int descriptor) { close(descriptor); }
+static bool truncateFile(int descriptor, int64_t size) { return ftruncate(descriptor, size) == 0; }
+static int64_t readAt(int descriptor, char *buffer, size_t size, int64_t offset) { return pread(descriptor, buffer, size, offset); }
+static int64_t writeSome(int descriptor, const char *bytes, size_t size) { return write(descriptor, bytes, size); }
+
+static int64_t getFileSize(int descriptor)
+{
+    struct stat status;
+    return fstat(descriptor, &status) == 0 ? static_cast<int64_t>(status.st_size) : -1;
+}
+
+static bool setFileLock(int descriptor, bool isLocked)
+{
+    int result;
+    do
+        result = flock(descriptor, isLocked ? LOCK_EX : LOCK_UN);
+    while (result != 0 && errno == EINTR);
+    return result == 0;
+}
+
+static bool syncFile(int descriptor)
+{
+#if defined(__linux__)
+    return fdatasync(descriptor) == 0;
+#else
+    return fsync(descriptor) == 0;
+#endif
+}
+
+#endif
+
+/**
+ * @brief Finds the last newline before the offset
+ *
+ * @return int64_t The offset of the newline, -1 if there is none
+ */
+static int64_t findLastNewline(int descriptor, int64_t end)
+{
+    char buffer[4096];
+    while (end > 0)
+    {
+        const int64_t start{end > static_cast<int64_t>(sizeof(buffer)) ? end - static_cast<int64_t>(sizeof(buffer)) : 0};
+        const int64_t count{readAt(descriptor, buffer, static_cast<size_t>(end - start), start)};
+        if (count <= 0)
+            return -1;
+        for (int64_t index{count - 1}; index >= 0; --index)
+            if (buffer[index] == '\n')
+                return start + index;
+        end = start;
+    }
+    return -1;
+}
+
+ScoreJournal::ScoreJournal(const string &path, Options options)
+    : path(path), options(options), descriptor(openFile(path)), lastSync(chrono::steady_clock::now())
+{
+    if (descriptor < 0)
+        throwSystemError("open", path);
+
+    // Recover from a writer that crashed in the middle of a record
+    if (!setFileLock(descriptor, true))
+    {
+        closeFile(descriptor);
+        throwSystemError("lock", path);
+    }
+    try
+    {
+        truncatedBytes = truncateTornTail(true);
+    }
+    catch (...)
+    {
+        setFileLock(descriptor, false);
+        closeFile(descriptor);
+        throw;
+    }
+    setFileLock(descriptor, false);
+}
+
+ScoreJournal::ScoreJournal(const string &path) : ScoreJournal(path, Options{})
+{
+}
+
+ScoreJournal::~ScoreJournal()
+{
+    if (options.syncPolicy != SyncPolicy::NEVER)
+        syncFile(descriptor);
+    closeFile(descriptor);
+}
+
+void ScoreJournal::lockFile()
+{
+    if (!setFileLock(descriptor, true))
+        throwSystemError("lock", path);
+}
+
+void ScoreJournal::unlockFile()
+{
+    setFileLock(descriptor, false);
+}
+
+size_t ScoreJournal::truncateTornTail(bool checkLastRecord)
+{
+    const int64_t size{getFileSize(descriptor)};
+    if (size < 0)
+        throwSystemError("read", path);
+    if (size == 0)
+        return 0;
+
+    // A complete file ends with a newline
+    char lastByte;
+    if (readAt(descriptor, &lastByte, 1, size - 1) != 1)
+        throwSystemError("read", path);
+    const int64_t lastNewline{lastByte == '\n' ? size - 1 : findLastNewline(descriptor, size - 1)};
+    int64_t keep{lastNewline + 1};
+
+    // Legacy files may end their last score without a newline, a line that parses is kept and terminated
+    if (keep < size)
+    {
+        string line(static_cast<size_t>(size - keep), '\0');
+        if (readAt(descriptor, line.data(), line.size(), keep) != static_cast<int64_t>(line.size()))
+            throwSystemError("read", path);
+        if (line.back() == '\r' && line.front() != '#')
+            line.pop_back();
+        ScoreRecord record;
+        if (parseScoreLine(line, record) != ScoreLineStatus::MALFORMED)
+        {
+            int64_t count;
+            do
+                count = writeSome(descriptor, "\n", 1);
+            while (count < 0 && errno == EINTR);
+            if (count != 1)
+                throwSystemError("write", path);
+            return 0;
+        }
+    }
+
+    // A framed record that fails its checksum at the end of the file was torn before its newline was flushed
+    if (checkLastRecord && lastNewline >= 0)
+    {
+        const int64_t lineStart{findLastNewline(descriptor, lastNewline) + 1};
+        string line(static_cast<size_t>(lastNewline - lineStart), '\0');
+        if (!line.empty() && readAt(descriptor, line.data(), line.size(), lineStart) != static_cast<int64_t>(line.size()))
+            throwSystemError("read", path);
+        ScoreRecord record;
+        if (!line.empty() && line.front() == '#' && parseScoreLine(line, record) == ScoreLineStatus::MALFORMED)
+            keep = lineStart;
+    }
+
+    if (keep == size)
+        return 0;
+    if (!truncateFile(descriptor, keep))
+        throwSystemError("truncate", path);
+    return static_cast<size_t>(size - keep);
+}
+
+void ScoreJournal::commit(const string &lines)
+{
+    lockFile();
+    try
+    {
+        // Another process may have crashed while holding the lock
+        truncateTornTail(false);
+
+        // The file is locked so a partial write is continued without interleaving
+        size_t written{0};
+        while (written < lines.size())
+        {
+            const int64_t count{writeSome(descriptor, lines.data() + written, lines.size() - written)};
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count <= 0)
+                throwSystemError("write", path);
+            written += static_cast<size_t>(count);
+        }
+
+        // Flush according to the policy
+        const auto now{chrono::steady_clock::now()};
+        if (options.syncPolicy == SyncPolicy::EVERY_COMMIT || (options.syncPolicy == SyncPolicy::INTERVAL && now - lastSync >= options.syncInterval))
+        {
+            if (!syncFile(descriptor))
+                throwSystemError("sync", path);
+            lastSync = now;
+        }
+    }
+    catch (...)
+    {
+        unlockFile();
+        throw;
+    }
+    unlockFile();
+}
+
+void ScoreJournal::append(const ScoreRecord &record)
+{
+    // Encode outside the lock
+    const string line{encodeScoreLine(record)};
+    Waiter waiter;
+
+    unique_lock<std::mutex> lock(mutex);
+    pendingLines += line;
+    pendingWaiters.push_back(&waiter);
+    while (!waiter.isDone)
+    {
+        // Wait for the commit in progress, it may not hold this record
+        if (isCommitting)
+        {
+            committed.wait(lock);
+            continue;
+        }
+
+        // Commit every pending record for the threads waiting
+        isCommitting = true;
+        string lines;
+        lines.swap(pendingLines);
+        vector<Waiter *> waiters;
+        waiters.swap(pendingWaiters);
+        lock.unlock();
+
+        exception_ptr error;
+        try
+        {
+            commit(lines);
+        }
+        catch (...)
+        {
+            error = current_exception();
+        }
+
+        lock.lock();
+        for (auto *committedWaiter : waiters)
+        {
+            committedWaiter->isDone = true;
+            committedWaiter->error = error;
+        }
+        isCommitting = false;
+        committed.notify_all();
+    }
+
+    if (waiter.error)
+        rethrow_exception(waiter.error);
+}
+
+void ScoreJournal::sync()
+{
+    if (!syncFile(descriptor))
+        throwSystemError("sync", path);
+}
+
+ScoreFileCounts ScoreJournal::read(const string &path, const function<bool(const ScoreRecord &)> &onRecord)
+{
+    ifstream file(path, ifstream::binary);
+    if (file.fail())
+        throw invalid_argument("Failed to open save file at: " + path);
+
+    ScoreFileCounts counts;
+    ScoreRecord record;
+    string line;
+    while (getline(file, line))
+    {
+        // Legacy files may have been written with windows line endings
+        if (!line.empty() && line.back() == '\r' && line.front() != '#')
+            line.pop_back();
+
+        switch (parseScoreLine(line, record))
+        {
+        case ScoreLineStatus::FRAMED:
+            ++counts.framed;
+            break;
+        case ScoreLineStatus::LEGACY:
+            ++counts.legacy;
+            break;
+        case ScoreLineStatus::MALFORMED:
+            ++counts.malformed;
+            continue;
+        }
+        if (!onRecord(record))
+            break;
+    }
+    return counts;
+}
@@ -0,0 +1,162 @@
+#ifndef SCORE_JOURNAL_H
+#define SCORE_JOURNAL_H
+
+#include "score_record.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief An append only score file shared by many threads and processes
+ *
+ * @note Every record is one framed line (see encodeScoreLine). Appends from all threads of a process are group
+ * committed: the first waiting thread writes every pending record in a single append while holding an exclusive
+ * advisory lock on the file, so records from different processes never interleave. Opening the journal truncates
+ * a torn record left at the end of the file by a crashed writer.
+ */
+class ScoreJournal
+{
+public:
+    /**
+     * @brief When committed records are flushed to the disk
+     *
+     */
+    enum class SyncPolicy
+    {
+        NEVER,
+        EVERY_COMMIT,
+        INTERVAL
+    };
+
+    /**
+     * @brief The journal settings
+     *
+     */
+    struct Options
+    {
+        SyncPolicy syncPolicy{SyncPolicy::EVERY_COMMIT};
+
+        /**
+         * @brief The least time between flushes for the INTERVAL policy
+         *
+         */
+        std::chrono::milliseconds syncInterval{100};
+    };
+
+private:
+    /**
+     * @brief A thread waiting for its records to be committed
+     *
+     */
+    struct Waiter
+    {
+        bool isDone{false};
+        std::exception_ptr error;
+    };
+
+    std::string path;
+    Options options;
+    int descriptor{-1};
+
+    /**
+     * @brief The records waiting for the next commit and the threads that appended them
+     *
+     */
+    std::mutex mutex;
+    std::condition_variable committed;
+    std::string pendingLines;
+    std::vector<Waiter *> pendingWaiters;
+    bool isCommitting{false};
+
+    std::chrono::steady_clock::time_point lastSync;
+    std::size_t truncatedBytes{0};
+
+    /**
+     * @brief Takes or releases the advisory lock on the whole file
+     *
+     */
+    void lockFile();
+    void unlockFile();
+
+    /**
+     * @brief Removes a record without its newline from the end of the file, the file must be locked
+     *
+     * @note A last line that parses, framed with a valid checksum or legacy, was written without a newline rather than
+     * torn, it is kept and the newline is appended
+     * @param checkLastRecord Whether the last complete record is also checked and removed if it is corrupt
+     * @return std::size_t The number of bytes removed
+     */
+    std::size_t truncateTornTail(bool checkLastRecord);
+
+    /**
+     * @brief Writes the lines to the end of the file and flushes them according to the policy
+     *
+     */
+    void commit(const std::string &lines);
+
+public:
+    /**
+     * @brief Opens or creates the journal and recovers it
+     *
+     * @param path The score file
+     * @param options The journal settings
+     * @throws std::runtime_error Thrown if the file can't be opened or locked
+     */
+    ScoreJournal(const std::string &path, Options options);
+
+    /**
+     * @brief Opens or creates the journal with the default settings
+     *
+     * @param path The score file
+     * @throws std::runtime_error Thrown if the file can't be opened or locked
+     */
+    explicit ScoreJournal(const std::string &path);
+
+    /**
+     * @brief Flushes the journal if the policy syncs and closes it
+     *
+     */
+    ~ScoreJournal();
+
+    ScoreJournal(const ScoreJournal &) = delete;
+    ScoreJournal &operator=(const ScoreJournal &) = delete;
+
+    /**
+     * @brief Appends the record and waits until it is written
+     *
+     * @param record The record to append
+     * @throws std::runtime_error Thrown if the commit holding the record failed
+     */
+    void append(const ScoreRecord &record);
+
+    /**
+     * @brief Flushes every committed record to the disk
+     *
+     */
+    void sync();
+
+    /**
+     * @brief Get the number of bytes removed from the end of the file when it was opened
+     *
+     * @return std::size_t
+     */
+    std::size_t getTruncatedBytes() const { return truncatedBytes; }
+
+    /**
+     * @brief Reads every record of a score file in order, malformed lines are counted and skipped
+     *
+     * @param path The score file
+     * @param onRecord Called with each record, return false to stop reading
+     * @throws std::invalid_argument Thrown if the file can't be opened
+     * @return ScoreFileCounts
+     */
+    static ScoreFileCounts read(const std::string &path, const std::function<bool(const ScoreRecord &)> &onRecord);
+};
+
+#endif
@@ -0,0 +1,459 @@
+#include "score_merge.hpp"
+#include "score_record.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+
+using namespace std;
+
+/**
+ * @brief The first bytes of a binary score file
+ *
+ */
+constexpr char BINARY_MAGIC[8]{'S', 'N', 'K', 'S', 'C', 'O', 'R', '2'};
+
+/**
+ * @brief The first bytes of a binary score file written before records held the replay id
+ *
+ */
+constexpr char BINARY_MAGIC_V1[8]{'S', 'N', 'K', 'S', 'C', 'O', 'R', '1'};
+
+/**
+ * @brief Orders records best score first, then oldest, then by name, settings and replay
+ *
+ */
+static bool isOrderedBefore(const ScoreRecord &first, const ScoreRecord &second)
+{
+    return tie(second.score, first.timestamp, first.playerName, first.width, first.height, first.gameSpeed, first.snakeLength, first.replayId) <
+           tie(first.score, second.timestamp, second.playerName, second.width, second.height, second.gameSpeed, second.snakeLength, second.replayId);
+}
+
+static bool isSameRecord(const ScoreRecord &first, const ScoreRecord &second)
+{
+    return first.score == second.score && first.timestamp == second.timestamp && first.playerName == second.playerName && first.width == second.width &&
+           first.height == second.height && first.gameSpeed == second.gameSpeed && first.snakeLength == second.snakeLength && first.replayId == second.replayId;
+}
+
+/**
+ * @brief Appends the integer in little endian byte order
+ *
+ */
+template <typename T>
+static void putInteger(string &bytes, T value)
+{
+    for (size_t byte{0}; byte < sizeof(T); ++byte)
+        bytes += static_cast<char>(static_cast<uint64_t>(value) >> (8 * byte) & 0xFF);
+}
+
+/**
+ * @brief Reads a little endian integer
+ *
+ */
+template <typename T>
+static bool getInteger(istream &stream, T &value)
+{
+    unsigned char bytes[sizeof(T)];
+    if (!stream.read(reinterpret_cast<char *>(bytes), sizeof(T)))
+        return false;
+    uint64_t result{0};
+    for (size_t byte{0}; byte < sizeof(T); ++byte)
+        result |= static_cast<uint64_t>(bytes[byte]) << (8 * byte);
+    value = static_cast<T>(result);
+    return true;
+}
+
+static void putBinaryRecord(string &bytes, const ScoreRecord &record)
+{
+    const size_t nameSize{min<size_t>(record.playerName.size(), 0xFFFF)};
+    putInteger<uint16_t>(bytes, static_cast<uint16_t>(nameSize));
+    bytes.append(record.playerName, 0, nameSize);
+    putInteger<int32_t>(bytes, record.width);
+    putInteger<int32_t>(bytes, record.height);
+    uint64_t speed;
+    memcpy(&speed, &record.gameSpeed, sizeof(speed));
+    putInteger<uint64_t>(bytes, speed);
+    putInteger<int32_t>(bytes, record.snakeLength);
+    putInteger<int32_t>(bytes, record.score);
+    putInteger<int64_t>(bytes, record.timestamp);
+    putInteger<int64_t>(bytes, record.replayId);
+}
+
+/**
+ * @brief Reads the next binary record
+ *
+ * @param hasReplayId Whether the record ends with the replay id, records of SNKSCOR1 files have none
+ * @return bool False at the end of the stream
+ * @throws std::runtime_error Thrown if the stream ends inside a record
+ */
+static bool getBinaryRecord(istream &stream, ScoreRecord &record, bool hasReplayId = true)
+{
+    uint16_t nameSize;
+    if (!getInteger(stream, nameSize))
+        return false;
+    record.playerName.resize(nameSize);
+    uint64_t speed;
+    if (!stream.read(record.playerName.data(), nameSize) || !getInteger(stream, record.width) || !getInteger(stream, record.height) ||
+        !getInteger(stream, speed) || !getInteger(stream, record.snakeLength) || !getInteger(stream, record.score) || !getInteger(stream, record.timestamp))
+        throw runtime_error("binary score record is truncated");
+    record.replayId = -1;
+    if (hasReplayId && !getInteger(stream, record.replayId))
+        throw runtime_error("binary score record is truncated");
+    memcpy(&record.gameSpeed, &speed, sizeof(speed));
+    return true;
+}
+
+/**
+ * @brief Writes records in the output format
+ *
+ */
+class ScoreWriter
+{
+private:
+    ofstream file;
+    ScoreFormat format;
+    string buffer;
+
+    void flushIfFull()
+    {
+        if (buffer.size() >= 1 << 16)
+        {
+            file.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+            buffer.clear();
+        }
+    }
+
+public:
+    ScoreWriter(const string &path, ScoreFormat format) : file(path, ofstream::binary | ofstream::trunc), format(format)
+    {
+        if (file.fail())
+            throw invalid_argument("Failed to create score file at: " + path);
+        if (format == ScoreFormat::BINARY)
+            buffer.append(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+        else if (format == ScoreFormat::CSV)
+            buffer += "player,width,height,speed,length,score,timestamp,replay\n";
+    }
+
+    void write(const ScoreRecord &record)
+    {
+        switch (format)
+        {
+        case ScoreFormat::TEXT:
+            buffer += encodeScoreLine(record);
+            break;
+        case ScoreFormat::BINARY:
+            putBinaryRecord(buffer, record);
+            break;
+        case ScoreFormat::CSV:
+            // Quote the name and double its quotes
+            buffer += '"';
+            for (const char character : record.playerName)
+            {
+                if (character == '"')
+                    buffer += '"';
+                buffer += character;
+            }
+            buffer += "\"," + to_string(record.width) + ',' + to_string(record.height) + ',';
+            char speed[32];
+            snprintf(speed, sizeof(speed), "%.17g", record.gameSpeed);
+            buffer += speed;
+            buffer += ',' + to_string(record.snakeLength) + ',' + to_string(record.score) + ',' + to_string(record.timestamp) + ',' + to_string(record.replayId) + '\n';
+            break;
+        }
+        flushIfFull();
+    }
+
+    void close()
+    {
+        file.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+        buffer.clear();
+        file.close();
+        if (file.fail())
+            throw runtime_error("Failed to write score file");
+    }
+};
+
+/**
+ * @brief A sorted run of records spilled to disk, deleted when destroyed
+ *
+ */
+class SpillRun
+{
+private:
+    filesystem::path path;
+    ifstream file;
+    ScoreRecord current;
+    bool hasCurrent{false};
+
+public:
+    explicit SpillRun(filesystem::path path) : path(std::move(path)) {}
+    ~SpillRun()
+    {
+        file.close();
+        error_code error;
+        filesystem::remove(path, error);
+    }
+
+    SpillRun(const SpillRun &) = delete;
+    SpillRun &operator=(const SpillRun &) = delete;
+
+    const filesystem::path &getPath() const { return path; }
+
+    void open()
+    {
+        file.open(path, ifstream::binary);
+        if (file.fail())
+            throw runtime_error("Failed to read spill file at: " + path.string());
+        advance();
+    }
+
+    bool hasRecord() const { return hasCurrent; }
+    const ScoreRecord &getRecord() const { return current; }
+    void advance() { hasCurrent = getBinaryRecord(file, current); }
+};
+
+/**
+ * @brief Collects records, spilling sorted runs when the memory limit is reached
+ *
+ */
+class RunBuilder
+{
+private:
+    const ScoreMergeOptions &options;
+    filesystem::path spillDirectory;
+    string spillPrefix;
+    vector<ScoreRecord> records;
+    size_t bufferedBytes{0};
+    ScoreMergeStats &stats;
+
+public:
+    vector<unique_ptr<SpillRun>> runs;
+
+    RunBuilder(const ScoreMergeOptions &options, ScoreMergeStats &stats) : options(options), stats(stats)
+    {
+        spillDirectory = options.spillDirectory.empty() ? filesystem::temp_directory_path() : filesystem::path(options.spillDirectory);
+        spillPrefix = "snake_merge_" + to_string(random_device{}()) + '_';
+    }
+
+    /**
+     * @brief Creates the file for the next run
+     *
+     */
+    unique_ptr<SpillRun> createRun()
+    {
+        return make_unique<SpillRun>(spillDirectory / (spillPrefix + to_string(stats.spillRuns++) + ".run"));
+    }
+
+    /**
+     * @brief Sorts the buffered records and removes duplicates
+     *
+     */
+    void sortRecords()
+    {
+        sort(records.begin(), records.end(), isOrderedBefore);
+        if (options.removeDuplicates)
+        {
+            const auto end{unique(records.begin(), records.end(), isSameRecord)};
+            stats.duplicates += static_cast<uint64_t>(records.end() - end);
+            records.erase(end, records.end());
+        }
+    }
+
+    void add(ScoreRecord &&record)
+    {
+        bufferedBytes += sizeof(ScoreRecord) + record.playerName.capacity();
+        records.push_back(std::move(record));
+        if (bufferedBytes >= options.memoryLimit)
+            spill();
+    }
+
+    void spill()
+    {
+        sortRecords();
+        auto run{createRun()};
+        ofstream file(run->getPath(), ofstream::binary | ofstream::trunc);
+        if (file.fail())
+            throw runtime_error("Failed to create spill file at: " + run->getPath().string());
+        string buffer;
+        for (const auto &record : records)
+        {
+            putBinaryRecord(buffer, record);
+            if (buffer.size() >= 1 << 16)
+            {
+                file.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        }
+        file.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+        file.close();
+        if (file.fail())
+            throw runtime_error("Failed to write spill file at: " + run->getPath().string());
+
+        runs.push_back(std::move(run));
+        records.clear();
+        records.shrink_to_fit();
+        bufferedBytes = 0;
+    }
+
+    vector<ScoreRecord> &getRecords() { return records; }
+};
+
+/**
+ * @brief Merges sorted runs, dropping duplicates that span runs
+ *
+ */
+static void mergeRuns(vector<unique_ptr<SpillRun>> &runs, const function<void(const ScoreRecord &)> &write, const ScoreMergeOptions &options, ScoreMergeStats &stats)
+{
+    for (auto &run : runs)
+        run->open();
+    const auto isAfter = [&runs](size_t first, size_t second)
+    { return isOrderedBefore(runs[second]->getRecord(), runs[first]->getRecord()); };
+    priority_queue<size_t, vector<size_t>, decltype(isAfter)> heap(isAfter);
+    for (size_t run{0}; run < runs.size(); ++run)
+        if (runs[run]->hasRecord())
+            heap.push(run);
+
+    ScoreRecord last;
+    bool hasLast{false};
+    while (!heap.empty())
+    {
+        const size_t run{heap.top()};
+        heap.pop();
+        const ScoreRecord &record{runs[run]->getRecord()};
+        if (options.removeDuplicates && hasLast && isSameRecord(record, last))
+        {
+            ++stats.duplicates;
+        }
+        else
+        {
+            write(record);
+            last = record;
+            hasLast = true;
+        }
+        runs[run]->advance();
+        if (runs[run]->hasRecord())
+            heap.push(run);
+    }
+}
+
+/**
+ * @brief Reads every record of an input into the builder
+ *
+ */
+static void readInput(const string &path, RunBuilder &builder, ScoreInputStats &stats)
+{
+    ifstream file(path, ifstream::binary);
+    if (file.fail())
+        throw invalid_argument("Failed to open score file at: " + path);
+
+    // Binary files start with the magic
+    char magic[sizeof(BINARY_MAGIC)]{};
+    file.read(magic, sizeof(magic));
+    const bool isBinary{file.gcount() == sizeof(magic) && memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0};
+    if (isBinary || (file.gcount() == sizeof(magic) && memcmp(magic, BINARY_MAGIC_V1, sizeof(magic)) == 0))
+    {
+        ScoreRecord record;
+        while (getBinaryRecord(file, record, isBinary))
+        {
+            ++stats.binaryRecords;
+            builder.add(std::move(record));
+        }
+        return;
+    }
+    file.clear();
+    file.seekg(0);
+
+    string line;
+    ScoreRecord record;
+    while (getline(file, line))
+    {
+        if (!line.empty() && line.back() == '\r' && line.front() != '#')
+            line.pop_back();
+        switch (parseScoreLine(line, record))
+        {
+        case ScoreLineStatus::FRAMED:
+            ++stats.lines.framed;
+            break;
+        case ScoreLineStatus::LEGACY:
+            ++stats.lines.legacy;
+            break;
+        case ScoreLineStatus::MALFORMED:
+            ++stats.lines.malformed;
+            continue;
+        }
+        builder.add(std::move(record));
+    }
+}
+
+ScoreMergeStats ScoreMerger::merge(const vector<string> &inputs, const string &output, const ScoreMergeOptions &options)
+{
+    if (options.maxOpenRuns < 2)
+        throw invalid_argument("a merge needs at least two open runs");
+
+    ScoreMergeStats stats;
+    RunBuilder builder(options, stats);
+    for (const auto &input : inputs)
+    {
+        stats.inputs.emplace_back().path = input;
+        readInput(input, builder, stats.inputs.back());
+    }
+
+    // Everything fit in memory
+    ScoreWriter writer(output, options.format);
+    const auto write = [&writer, &stats](const ScoreRecord &record)
+    {
+        writer.write(record);
+        ++stats.written;
+    };
+    if (builder.runs.empty())
+    {
+        builder.sortRecords();
+        for (const auto &record : builder.getRecords())
+            write(record);
+        writer.close();
+        return stats;
+    }
+
+    // Merge in passes until few enough runs are left to open at once
+    if (!builder.getRecords().empty())
+        builder.spill();
+    auto &runs{builder.runs};
+    while (runs.size() > options.maxOpenRuns)
+    {
+        vector<unique_ptr<SpillRun>> group;
+        for (size_t run{0}; run < options.maxOpenRuns; ++run)
+            group.push_back(std::move(runs[run]));
+        runs.erase(runs.begin(), runs.begin() + static_cast<ptrdiff_t>(options.maxOpenRuns));
+
+        auto merged{builder.createRun()};
+        ofstream file(merged->getPath(), ofstream::binary | ofstream::trunc);
+        if (file.fail())
+            throw runtime_error("Failed to create spill file at: " + merged->getPath().string());
+        string buffer;
+        mergeRuns(group, [&file, &buffer](const ScoreRecord &record)
+                  {
+                      putBinaryRecord(buffer, record);
+                      if (buffer.size() >= 1 << 16)
+                      {
+                          file.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+                          buffer.clear();
+                      } },
+                  options, stats);
+        file.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+        file.close();
+        if (file.fail())
+            throw runtime_error("Failed to write spill file at: " + merged->getPath().string());
+        runs.push_back(std::move(merged));
+    }
+
+    mergeRuns(runs, write, options, stats);
+    writer.close();
+    return stats;
+}
@@ -0,0 +1,111 @@
+#ifndef SCORE_MERGE_H
+#define SCORE_MERGE_H
+
+#include "score_record.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The file formats scores can be written in
+ *
+ * @note TEXT is the framed score file format, so its output can be used as a scores.dat. CSV has a header row and
+ * quotes names. BINARY starts with the 8 byte magic "SNKSCOR2" followed by little endian records: a 16 bit name
+ * size, the name, 32 bit width and height, a 64 bit float speed, 32 bit starting length and score, a 64 bit
+ * timestamp and a 64 bit replay id, -1 without a replay. "SNKSCOR1" files, whose records end at the timestamp, are
+ * still read.
+ */
+enum class ScoreFormat
+{
+    TEXT,
+    CSV,
+    BINARY
+};
+
+/**
+ * @brief The settings of a merge
+ *
+ */
+struct ScoreMergeOptions
+{
+    ScoreFormat format{ScoreFormat::TEXT};
+
+    /**
+     * @brief The most memory used to hold records before they are sorted and spilled to disk
+     *
+     */
+    std::size_t memoryLimit{64 * 1024 * 1024};
+
+    /**
+     * @brief The most spill files merged at once, more runs are merged in several passes
+     *
+     */
+    std::size_t maxOpenRuns{64};
+
+    /**
+     * @brief The folder spill files are written to, the system temporary folder if empty
+     *
+     */
+    std::string spillDirectory;
+
+    /**
+     * @brief Whether records equal in every field are written once
+     *
+     */
+    bool removeDuplicates{true};
+};
+
+/**
+ * @brief The lines read from one input
+ *
+ */
+struct ScoreInputStats
+{
+    std::string path;
+    ScoreFileCounts lines;
+
+    /**
+     * @brief The records read from a binary input
+     *
+     */
+    std::size_t binaryRecords{0};
+};
+
+/**
+ * @brief What a merge did
+ *
+ */
+struct ScoreMergeStats
+{
+    std::vector<ScoreInputStats> inputs;
+    std::uint64_t duplicates{0};
+    std::uint64_t written{0};
+    std::size_t spillRuns{0};
+};
+
+/**
+ * @brief Merges score files into one sorted, deduplicated file
+ *
+ * @note Inputs may be score files in the text format, framed or legacy, or binary files written by the merger.
+ * Records are ordered best score first, then oldest first, then by name, game settings and replay id. Memory stays within
+ * the limit regardless of the input size: full buffers are sorted and spilled to disk, then the spilled runs are
+ * merged.
+ */
+class ScoreMerger
+{
+public:
+    /**
+     * @brief Merges the inputs into the output
+     *
+     * @param inputs The files to read
+     * @param output The file to write
+     * @param options The merge settings
+     * @throws std::invalid_argument Thrown if a file can't be opened
+     * @throws std::runtime_error Thrown if a spill file can't be written or read back
+     * @return ScoreMergeStats
+     */
+    static ScoreMergeStats merge(const std::vector<std::string> &inputs, const std::string &output, const ScoreMergeOptions &options = {});
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "score_page_cache.hpp"
+#include "score_journal.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+using namespace std;
+
+ScorePageCache::ScorePageCache(const string &path, size_t capacity) : path(path), capacity(max<size_t>(capacity, 1))
+{
+}
+
+void ScorePageCache::validate()
+{
+    // A file that can't be read gets a size no file has, so it never matches the pages
+    error_code error;
+    uintmax_t size{filesystem::file_size(path, error)};
+    filesystem::file_time_type time{};
+    if (!error)
+        time = filesystem::last_write_time(path, error);
+    if (error)
+        size = numeric_limits<uintmax_t>::max();
+
+    if (size == fileSize && time == fileTime)
+        return;
+    fileSize = size;
+    fileTime = time;
+    entries.clear();
+    entryByKey.clear();
+}
+
+shared_ptr<const ScorePage> ScorePageCache::parsePage(int page, int pageSize) const
+{
+    // Keep the records of the page, or of the last page if the file ends first
+    auto parsed{make_shared<ScorePage>()};
+    size_t index{0};
+    const auto counts{ScoreJournal::read(path, [&](const ScoreRecord &record)
+                                         {
+                                             const int recordPage{static_cast<int>(index++ / pageSize)};
+                                             if (recordPage > page)
+                                                 return false;
+                                             if (recordPage != parsed->page)
+                                             {
+                                                 parsed->records.clear();
+                                                 parsed->page = recordPage;
+                                             }
+                                             parsed->records.push_back(record);
+                                             return true; })};
+    parsed->malformed = counts.malformed;
+    return parsed;
+}
+
+shared_ptr<const ScorePage> ScorePageCache::getPage(int page, int pageSize)
+{
+    if (page < 0 || pageSize <= 0)
+        throw invalid_argument("invalid score page " + to_string(page) + " of " + to_string(pageSize) + " scores");
+
+    // Use the cached page if the file hasn't changed
+    uintmax_t parsedSize;
+    filesystem::file_time_type parsedTime;
+    {
+        const lock_guard<mutex> lock(pagesMutex);
+        validate();
+        if (const auto entry{entryByKey.find(getKey(page, pageSize))}; entry != entryByKey.end())
+        {
+            ++hitCount;
+            entries.splice(entries.begin(), entries, entry->second);
+            return entry->second->page;
+        }
+        ++missCount;
+        parsedSize = fileSize;
+        parsedTime = fileTime;
+    }
+
+    const auto parsed{parsePage(page, pageSize)};
+
+    // Keep the page unless the file changed while it was parsed or another thread parsed it first
+    const lock_guard<mutex> lock(pagesMutex);
+    validate();
+    if (fileSize != parsedSize || fileTime != parsedTime || entryByKey.contains(getKey(page, pageSize)))
+        return parsed;
+    entries.push_front(Entry{getKey(page, pageSize), parsed});
+    entryByKey.emplace(entries.front().key, entries.begin());
+    if (entries.size() > capacity)
+    {
+        entryByKey.erase(entries.back().key);
+        entries.pop_back();
+    }
+    return parsed;
+}
+
+shared_ptr<const ScorePage> ScorePageCache::findPage(int page, int pageSize)
+{
+    const lock_guard<mutex> lock(pagesMutex);
+    validate();
+    const auto entry{entryByKey.find(getKey(page, pageSize))};
+    if (entry == entryByKey.end())
+        return nullptr;
+    entries.splice(entries.begin(), entries, entry->second);
+    return entry->second->page;
+}
+
+void ScorePageCache::clear()
+{
+    const lock_guard<mutex> lock(pagesMutex);
+    entries.clear();
+    entryByKey.clear();
+}
+
+size_t ScorePageCache::getHitCount() const
+{
+    const lock_guard<mutex> lock(pagesMutex);
+    return hitCount;
+}
+
+size_t ScorePageCache::getMissCount() const
+{
+    const lock_guard<mutex> lock(pagesMutex);
+    return missCount;
+}
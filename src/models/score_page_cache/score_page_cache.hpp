@@ -0,0 +1,139 @@
+#ifndef SCORE_PAGE_CACHE_H
+#define SCORE_PAGE_CACHE_H
+
+#include "score_record.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief A page of scores parsed from a score file
+ *
+ */
+struct ScorePage
+{
+    /**
+     * @brief The page the records are from, the last page if the file ends before the page asked for
+     *
+     */
+    int page{0};
+
+    std::vector<ScoreRecord> records;
+
+    /**
+     * @brief The malformed lines skipped before the end of the page
+     *
+     */
+    std::size_t malformed{0};
+};
+
+/**
+ * @brief The most recently used pages of a score file, parsed once
+ *
+ * @note Pages are kept until the file's size or modification time changes, which clears every page. Pages are
+ * shared and never modified, so they stay valid for holders after being evicted. Every method is thread safe, a page
+ * missing from the cache is parsed without holding the lock so hits aren't held up by a parse.
+ */
+class ScorePageCache
+{
+private:
+    /**
+     * @brief A cached page and what it was parsed with
+     *
+     */
+    struct Entry
+    {
+        std::uint64_t key;
+        std::shared_ptr<const ScorePage> page;
+    };
+
+    const std::string path;
+    const std::size_t capacity;
+
+    mutable std::mutex pagesMutex;
+
+    /**
+     * @brief The pages from the most to the least recently used, and where each key is in the list
+     *
+     */
+    std::list<Entry> entries;
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> entryByKey;
+
+    /**
+     * @brief The size and modification time of the file the pages were parsed from
+     *
+     */
+    std::uintmax_t fileSize{0};
+    std::filesystem::file_time_type fileTime{};
+
+    std::size_t hitCount{0};
+    std::size_t missCount{0};
+
+    /**
+     * @brief Get the key of a page of the size
+     *
+     */
+    static std::uint64_t getKey(int page, int pageSize) { return static_cast<std::uint64_t>(static_cast<std::uint32_t>(pageSize)) << 32 | static_cast<std::uint32_t>(page); }
+
+    /**
+     * @brief Clears the pages if the file changed since they were parsed
+     *
+     * @note Called with the lock held
+     */
+    void validate();
+
+    /**
+     * @brief Reads a page from the file
+     *
+     */
+    std::shared_ptr<const ScorePage> parsePage(int page, int pageSize) const;
+
+public:
+    /**
+     * @brief Creates an empty cache of a score file
+     *
+     * @param path The score file
+     * @param capacity The number of pages kept
+     */
+    explicit ScorePageCache(const std::string &path, std::size_t capacity = 16);
+
+    /**
+     * @brief Get a page, parsing it if it isn't cached
+     *
+     * @param page The page, starting at 0
+     * @param pageSize The number of scores per page
+     * @throws std::invalid_argument Thrown if the file can't be opened
+     * @return std::shared_ptr<const ScorePage>
+     */
+    std::shared_ptr<const ScorePage> getPage(int page, int pageSize);
+
+    /**
+     * @brief Get a page if it is cached
+     *
+     * @param page The page, starting at 0
+     * @param pageSize The number of scores per page
+     * @return std::shared_ptr<const ScorePage> Null if the page isn't cached
+     */
+    std::shared_ptr<const ScorePage> findPage(int page, int pageSize);
+
+    /**
+     * @brief Removes every page
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Get the number of pages found and parsed
+     *
+     */
+    std::size_t getHitCount() const;
+    std::size_t getMissCount() const;
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "score_record.hpp"
+#include "binary_format.hpp"
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <system_error>
+
+using namespace std;
+
+/**
+ * @brief Parses the whole field as a number
+ *
+ */
+template <typename T>
+static bool parseNumber(string_view field, T &value)
+{
+    const auto result{from_chars(field.data(), field.data() + field.size(), value)};
+    return result.ec == errc() && result.ptr == field.data() + field.size();
+}
+
+/**
+ * @brief Splits the next field off the front of the text
+ *
+ */
+static string_view takeField(string_view &text, char separator)
+{
+    const size_t end{text.find(separator)};
+    const string_view field{text.substr(0, end)};
+    text = end == string_view::npos ? string_view{} : text.substr(end + 1);
+    return field;
+}
+
+string encodeScoreLine(const ScoreRecord &record)
+{
+    // Escape the characters that would break the framing
+    string payload;
+    payload.reserve(record.playerName.size() + 48);
+    for (const char character : record.playerName)
+    {
+        if (character == '\t')
+            payload += "\\t";
+        else if (character == '\n')
+            payload += "\\n";
+        else if (character == '\\')
+            payload += "\\\\";
+        else
+            payload += character;
+    }
+
+    char numbers[128];
+    const int length{snprintf(numbers, sizeof(numbers), "\t%d\t%d\t%.17g\t%d\t%d\t%lld", record.width, record.height, record.gameSpeed,
+                              record.snakeLength, record.score, static_cast<long long>(record.timestamp))};
+    payload.append(numbers, static_cast<size_t>(length));
+    if (record.replayId >= 0)
+        payload += '\t' + to_string(record.replayId);
+
+    char header[32];
+    const int headerLength{snprintf(header, sizeof(header), "#%zu:%08x:", payload.size(), computeCrc32(payload))};
+    string line;
+    line.reserve(static_cast<size_t>(headerLength) + payload.size() + 1);
+    line.append(header, static_cast<size_t>(headerLength));
+    line += payload;
+    line += '\n';
+    return line;
+}
+
+/**
+ * @brief Parses the tab separated payload of a framed line
+ *
+ */
+static bool parsePayload(string_view payload, ScoreRecordView &record)
+{
+    // An escape must be followed by the escaped character
+    record.playerName = takeField(payload, '\t');
+    record.isNameEscaped = true;
+    for (size_t index{record.playerName.find('\\')}; index != string_view::npos; index = record.playerName.find('\\', index + 2))
+        if (index + 1 == record.playerName.size())
+            return false;
+
+    // Records without a replay end at the timestamp
+    long long timestamp{0};
+    long long replayId{-1};
+    const bool isValid{parseNumber(takeField(payload, '\t'), record.width) && parseNumber(takeField(payload, '\t'), record.height) &&
+                       parseNumber(takeField(payload, '\t'), record.gameSpeed) && parseNumber(takeField(payload, '\t'), record.snakeLength) &&
+                       parseNumber(takeField(payload, '\t'), record.score) && parseNumber(takeField(payload, '\t'), timestamp) &&
+                       (payload.empty() || (parseNumber(takeField(payload, '\t'), replayId) && replayId >= 0 && payload.empty()))};
+    record.timestamp = timestamp;
+    record.replayId = replayId;
+    return isValid;
+}
+
+/**
+ * @brief Parses a legacy dash separated line, the numbers are taken from the right
+ *
+ */
+static bool parseLegacyLine(string_view line, ScoreRecordView &record)
+{
+    string_view fields[5];
+    for (int field{4}; field >= 0; --field)
+    {
+        const size_t separator{line.rfind('-')};
+        if (separator == string_view::npos)
+            return false;
+        fields[field] = line.substr(separator + 1);
+        line = line.substr(0, separator);
+    }
+
+    // Legacy speeds were written as doubles but read back as integers
+    int gameSpeed{0};
+    if (!parseNumber(fields[0], record.width) || !parseNumber(fields[1], record.height) || !parseNumber(fields[3], record.snakeLength) ||
+        !parseNumber(fields[4], record.score))
+        return false;
+    if (!parseNumber(fields[2], record.gameSpeed))
+    {
+        if (!parseNumber(fields[2].substr(0, fields[2].find('.')), gameSpeed))
+            return false;
+        record.gameSpeed = gameSpeed;
+    }
+    record.playerName = line;
+    record.isNameEscaped = false;
+    record.timestamp = 0;
+    record.replayId = -1;
+    return true;
+}
+
+ScoreLineStatus parseScoreLine(string_view line, ScoreRecordView &record, bool verifyChecksum)
+{
+    if (line.empty())
+        return ScoreLineStatus::MALFORMED;
+    if (line.front() != '#')
+        return parseLegacyLine(line, record) ? ScoreLineStatus::LEGACY : ScoreLineStatus::MALFORMED;
+
+    // Check the frame before trusting the payload
+    line.remove_prefix(1);
+    size_t length;
+    uint32_t crc;
+    const string_view lengthField{takeField(line, ':')};
+    const string_view crcField{takeField(line, ':')};
+    if (!parseNumber(lengthField, length) || crcField.size() != 8 || from_chars(crcField.data(), crcField.data() + 8, crc, 16).ptr != crcField.data() + 8)
+        return ScoreLineStatus::MALFORMED;
+    if (line.size() != length || (verifyChecksum && computeCrc32(line) != crc))
+        return ScoreLineStatus::MALFORMED;
+    return parsePayload(line, record) ? ScoreLineStatus::FRAMED : ScoreLineStatus::MALFORMED;
+}
+
+string getPlayerName(const ScoreRecordView &record)
+{
+    if (!record.isNameEscaped || record.playerName.find('\\') == string_view::npos)
+        return string(record.playerName);
+
+    string name;
+    name.reserve(record.playerName.size());
+    for (size_t index{0}; index < record.playerName.size(); ++index)
+    {
+        char character{record.playerName[index]};
+        if (character == '\\' && index + 1 < record.playerName.size())
+        {
+            character = record.playerName[++index];
+            character = character == 't' ? '\t' : character == 'n' ? '\n'
+                                                                   : character;
+        }
+        name += character;
+    }
+    return name;
+}
+
+ScoreLineStatus parseScoreLine(string_view line, ScoreRecord &record)
+{
+    ScoreRecordView view;
+    const ScoreLineStatus status{parseScoreLine(line, view)};
+    if (status == ScoreLineStatus::MALFORMED)
+        return status;
+
+    record.playerName = getPlayerName(view);
+    record.width = view.width;
+    record.height = view.height;
+    record.gameSpeed = view.gameSpeed;
+    record.snakeLength = view.snakeLength;
+    record.score = view.score;
+    record.timestamp = view.timestamp;
+    record.replayId = view.replayId;
+    return status;
+}
@@ -0,0 +1,115 @@
+#ifndef SCORE_RECORD_H
+#define SCORE_RECORD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief A saved game score
+ *
+ */
+struct ScoreRecord
+{
+    std::string playerName;
+    int width{0};
+    int height{0};
+    double gameSpeed{0};
+    int snakeLength{0};
+    int score{0};
+
+    /**
+     * @brief The seconds since the unix epoch when the score was saved, 0 for legacy records
+     *
+     */
+    std::int64_t timestamp{0};
+
+    /**
+     * @brief The index of the game's replay in the replay archive, -1 if it has none
+     *
+     */
+    std::int64_t replayId{-1};
+};
+
+/**
+ * @brief A saved game score read in place from a line of the score file
+ *
+ * @note The player name points into the line, framed lines store it escaped, see getPlayerName
+ */
+struct ScoreRecordView
+{
+    std::string_view playerName;
+    bool isNameEscaped{false};
+    int width{0};
+    int height{0};
+    double gameSpeed{0};
+    int snakeLength{0};
+    int score{0};
+    std::int64_t timestamp{0};
+    std::int64_t replayId{-1};
+};
+
+/**
+ * @brief How a line of the score file was read
+ *
+ */
+enum class ScoreLineStatus
+{
+    FRAMED,
+    LEGACY,
+    MALFORMED
+};
+
+/**
+ * @brief The number of lines of each kind read from a score file
+ *
+ */
+struct ScoreFileCounts
+{
+    std::size_t framed{0};
+    std::size_t legacy{0};
+    std::size_t malformed{0};
+};
+
+/**
+ * @brief Encodes the record as one framed line of the score file
+ *
+ * @note Framed lines are "#<payload length>:<crc32 as 8 hex digits>:<payload>\n", the payload holds the fields
+ * separated by tabs with tabs, newlines and backslashes in the player name escaped. The replay id is only written
+ * for records that have one, so older readers still parse the other lines.
+ * @param record The record to encode
+ * @return std::string The line including the newline
+ */
+std::string encodeScoreLine(const ScoreRecord &record);
+
+/**
+ * @brief Parses one line of the score file without its newline
+ *
+ * @note Legacy lines are "name-width-height-speed-length-score", the numbers are read from the right so names may
+ * contain dashes
+ * @param line The line
+ * @param record The record to fill, left unspecified if the line is malformed
+ * @return ScoreLineStatus
+ */
+ScoreLineStatus parseScoreLine(std::string_view line, ScoreRecord &record);
+
+/**
+ * @brief Parses one line of the score file without its newline or copying the player name
+ *
+ * @param line The line, it must outlive the record
+ * @param record The record to fill, left unspecified if the line is malformed
+ * @param verifyChecksum Whether the checksum of framed lines is checked
+ * @return ScoreLineStatus
+ */
+ScoreLineStatus parseScoreLine(std::string_view line, ScoreRecordView &record, bool verifyChecksum = true);
+
+/**
+ * @brief Get the player name of a record read in place
+ *
+ * @param record The record
+ * @return std::string The unescaped name
+ */
+std::string getPlayerName(const ScoreRecordView &record);
+
+#endif
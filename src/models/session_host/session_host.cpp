@@ -0,0 +1,782 @@
+#include "session_host.hpp"
+#include "game_session.hpp"
+#include "game.hpp"
+#include "timer_wheel.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#endif
+
+using namespace std;
+using Clock = GameSession::Clock;
+
+/**
+ * @brief The resolution and size of the timer wheel, a turn covers the slowest timers of a session
+ *
+ */
+constexpr chrono::milliseconds TIMER_RESOLUTION{1};
+constexpr size_t TIMER_SLOTS{4096};
+
+/**
+ * @brief The width of a jitter histogram bucket
+ *
+ */
+constexpr int64_t JITTER_BUCKET_NANOSECONDS{100'000};
+
+/**
+ * @brief The most typed bytes kept waiting for a session, more are dropped
+ *
+ */
+constexpr size_t MAX_PENDING_INPUT{4096};
+
+/**
+ * @brief The most events the reactor takes from epoll at once
+ *
+ */
+constexpr int MAX_EVENTS{256};
+
+/**
+ * @brief The epoll ids of the descriptors that aren't sessions, session ids start at 1
+ *
+ */
+constexpr uint64_t WAKE_EVENT_ID{0};
+constexpr uint64_t LISTENER_EVENT_ID{UINT64_MAX};
+constexpr uint64_t TIMER_EVENT_ID{UINT64_MAX - 1};
+
+/**
+ * @brief Clears the terminal and moves the cursor to the top left before a whole frame
+ *
+ */
+constexpr string_view CLEAR_SCREEN{"\x1b[H\x1b[2J"};
+
+/**
+ * @brief Appends the escape codes that turn the last frame sent into the new frame
+ *
+ * @note Only the changed part of each changed line is sent, a step usually changes a few characters of a frame
+ * of thousands. Frames with a different number of lines are sent whole. Lines end in \r\n for terminals in raw
+ * mode.
+ * @param output The bytes to send
+ * @param frame The new frame
+ * @param lastFrame The frame the player sees, empty if nothing was sent yet
+ */
+static void appendFrame(string &output, string_view frame, string_view lastFrame)
+{
+    if (count(frame.begin(), frame.end(), '\n') != count(lastFrame.begin(), lastFrame.end(), '\n') || lastFrame.empty())
+    {
+        output += CLEAR_SCREEN;
+        for (size_t start{0}; start < frame.size();)
+        {
+            const size_t end{min(frame.find('\n', start), frame.size())};
+            output.append(frame, start, end - start);
+            output += "\r\n";
+            start = end + 1;
+        }
+        return;
+    }
+
+    size_t start{0};
+    size_t lastStart{0};
+    for (int row{1}; start <= frame.size(); ++row)
+    {
+        const size_t end{min(frame.find('\n', start), frame.size())};
+        const size_t lastEnd{min(lastFrame.find('\n', lastStart), lastFrame.size())};
+        const string_view line{frame.substr(start, end - start)};
+        const string_view lastLine{lastFrame.substr(lastStart, lastEnd - lastStart)};
+        if (line != lastLine)
+        {
+            // Rewrite from the first to the last changed column, clearing what is left of a shorter line
+            const size_t first{static_cast<size_t>(mismatch(line.begin(), line.end(), lastLine.begin(), lastLine.end()).first - line.begin())};
+            size_t last{line.size()};
+            if (line.size() == lastLine.size())
+                while (last > first && line[last - 1] == lastLine[last - 1])
+                    --last;
+            output += "\x1b[";
+            output += to_string(row);
+            output += ';';
+            output += to_string(first + 1);
+            output += 'H';
+            output.append(line, first, last - first);
+            if (line.size() < lastLine.size())
+                output += "\x1b[K";
+        }
+        start = end + 1;
+        lastStart = lastEnd + 1;
+    }
+
+    // Leave the cursor below the frame
+    output += "\x1b[";
+    output += to_string(count(frame.begin(), frame.end(), '\n') + 2);
+    output += ";1H";
+}
+
+/**
+ * @brief A player's connection and game session
+ *
+ */
+struct SessionHost::Session
+{
+    const uint64_t id;
+    const int descriptor;
+
+    /**
+     * @brief The session itself, only used by the worker running it
+     *
+     */
+    GameSession game;
+    string typed;
+    string lastFrame;
+    Clock::time_point scheduledDeadline{Clock::time_point::max()};
+
+    /**
+     * @brief The bytes passed between the reactor and the workers
+     *
+     */
+    std::mutex mutex;
+    string input;
+    string output;
+    size_t outputOffset{0};
+    bool isInputClosed{false};
+
+    /**
+     * @brief Whether the session is queued or running, and whether it has work it hasn't run yet
+     *
+     */
+    atomic<bool> isQueued{false};
+    atomic<bool> hasWork{false};
+
+    /**
+     * @brief Whether output is waiting to be written and whether the session is over
+     *
+     */
+    atomic<bool> hasOutput{false};
+    atomic<bool> isClosed{false};
+
+    /**
+     * @brief Whether the poller reports when the socket takes more output, only used by the reactor
+     *
+     */
+    bool isWatchingOutput{false};
+
+    Session(uint64_t id, int descriptor, SessionScores &scores, uint32_t seed) : id(id), descriptor(descriptor), game(scores, seed) {}
+};
+
+TickJitter SessionHost::getTickJitter() const
+{
+    TickJitter jitter;
+    for (const auto &bucket : jitterHistogram)
+        jitter.ticks += bucket.load(memory_order_relaxed);
+    jitter.maxMilliseconds = static_cast<double>(maxJitterNanoseconds.load(memory_order_relaxed)) / 1e6;
+    if (jitter.ticks == 0)
+        return jitter;
+
+    // Report the upper edge of the bucket each percentile falls in
+    const auto percentile = [this, &jitter](double fraction)
+    {
+        const auto rank{static_cast<uint64_t>(fraction * static_cast<double>(jitter.ticks - 1))};
+        uint64_t seen{0};
+        for (size_t index{0}; index < jitterHistogram.size(); ++index)
+        {
+            seen += jitterHistogram[index].load(memory_order_relaxed);
+            if (seen > rank)
+                return min(static_cast<double>((index + 1) * JITTER_BUCKET_NANOSECONDS) / 1e6, jitter.maxMilliseconds);
+        }
+        return jitter.maxMilliseconds;
+    };
+    jitter.p50Milliseconds = percentile(0.50);
+    jitter.p99Milliseconds = percentile(0.99);
+    return jitter;
+}
+
+#if defined(_WIN32)
+
+SessionHost::SessionHost(SessionHostOptions options, SessionScores &scores) : options(std::move(options)), scores(scores), timers(TIMER_RESOLUTION, TIMER_SLOTS)
+{
+    throw runtime_error("hosting sessions needs unix sockets");
+}
+
+SessionHost::~SessionHost() = default;
+void SessionHost::run() {}
+void SessionHost::requestStop() noexcept {}
+void SessionHost::wakeReactor() {}
+void SessionHost::post(const shared_ptr<Session> &) {}
+void SessionHost::runWorker() {}
+void SessionHost::runSession(Session &) {}
+void SessionHost::acceptConnections() {}
+bool SessionHost::readInput(Session &) { return false; }
+bool SessionHost::writeOutput(Session &) { return false; }
+void SessionHost::watchOutput(Session &) {}
+void SessionHost::closeSession(uint64_t) {}
+
+#else
+
+/**
+ * @brief Makes the descriptor non blocking and closed on exec
+ *
+ */
+static void makeNonBlocking(int descriptor)
+{
+    fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL) | O_NONBLOCK);
+    fcntl(descriptor, F_SETFD, fcntl(descriptor, F_GETFD) | FD_CLOEXEC);
+}
+
+SessionHost::SessionHost(SessionHostOptions options, SessionScores &scores) : options(std::move(options)), scores(scores), timers(TIMER_RESOLUTION, TIMER_SLOTS)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (this->options.socketPath.empty() || this->options.socketPath.size() >= sizeof(address.sun_path))
+        throw runtime_error("invalid socket path " + this->options.socketPath);
+    memcpy(address.sun_path, this->options.socketPath.c_str(), this->options.socketPath.size() + 1);
+
+    // Replace a socket left behind by a host that didn't shut down, but never another kind of file
+    struct stat status;
+    if (stat(this->options.socketPath.c_str(), &status) == 0)
+    {
+        if (!S_ISSOCK(status.st_mode))
+            throw runtime_error(this->options.socketPath + " exists and is not a socket");
+        unlink(this->options.socketPath.c_str());
+    }
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+        throw runtime_error("unable to create socket: " + string(strerror(errno)));
+    if (bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0)
+    {
+        const string error{strerror(errno)};
+        close(listener);
+        throw runtime_error("unable to listen on " + this->options.socketPath + ": " + error);
+    }
+    makeNonBlocking(listener);
+
+    int descriptors[2];
+    if (pipe(descriptors) != 0)
+    {
+        close(listener);
+        unlink(this->options.socketPath.c_str());
+        throw runtime_error("unable to create pipe: " + string(strerror(errno)));
+    }
+    wakeReader = descriptors[0];
+    wakeWriter = descriptors[1];
+    makeNonBlocking(wakeReader);
+    makeNonBlocking(wakeWriter);
+
+#if defined(__linux__)
+    // Watch the wake pipe, the listener and the timer once, sessions are added as they connect
+    poller = epoll_create1(EPOLL_CLOEXEC);
+    timerDescriptor = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    const auto watch = [this](int descriptor, uint64_t id)
+    {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = id;
+        return epoll_ctl(poller, EPOLL_CTL_ADD, descriptor, &event) == 0;
+    };
+    if (poller < 0 || timerDescriptor < 0 || !watch(wakeReader, WAKE_EVENT_ID) || !watch(listener, LISTENER_EVENT_ID) || !watch(timerDescriptor, TIMER_EVENT_ID))
+    {
+        const string error{strerror(errno)};
+        for (const int descriptor : {poller, timerDescriptor, listener, wakeReader, wakeWriter})
+            if (descriptor >= 0)
+                close(descriptor);
+        unlink(this->options.socketPath.c_str());
+        throw runtime_error("unable to create poller: " + error);
+    }
+#endif
+}
+
+SessionHost::~SessionHost()
+{
+    for (const auto &[id, session] : sessions)
+        close(session->descriptor);
+    close(listener);
+    close(wakeReader);
+    close(wakeWriter);
+    if (poller >= 0)
+        close(poller);
+    if (timerDescriptor >= 0)
+        close(timerDescriptor);
+    unlink(options.socketPath.c_str());
+}
+
+void SessionHost::requestStop() noexcept
+{
+    isStopRequested.store(true);
+    const char byte{0};
+    [[maybe_unused]] const auto written{write(wakeWriter, &byte, 1)};
+}
+
+void SessionHost::wakeReactor()
+{
+    // One byte in the pipe is enough no matter how many workers want the reactor
+    if (isWakePending.exchange(true))
+        return;
+    const char byte{0};
+    [[maybe_unused]] const auto written{write(wakeWriter, &byte, 1)};
+}
+
+void SessionHost::post(const shared_ptr<Session> &session)
+{
+    // A running session picks up the new work when it finishes
+    session->hasWork.store(true);
+    if (session->isQueued.exchange(true))
+        return;
+    {
+        const lock_guard<std::mutex> lock(queueMutex);
+        runQueue.push_back(session);
+    }
+    queueChanged.notify_one();
+}
+
+void SessionHost::runWorker()
+{
+    while (true)
+    {
+        shared_ptr<Session> session;
+        {
+            unique_lock<std::mutex> lock(queueMutex);
+            queueChanged.wait(lock, [this]
+                              { return isStopping || !runQueue.empty(); });
+            if (isStopping)
+                return;
+            session = std::move(runQueue.front());
+            runQueue.pop_front();
+        }
+
+        session->hasWork.store(false);
+        runSession(*session);
+
+        // Run the session again if work arrived while it was running
+        session->isQueued.store(false);
+        if (session->hasWork.load() && !session->isQueued.exchange(true))
+        {
+            const lock_guard<std::mutex> lock(queueMutex);
+            runQueue.push_back(std::move(session));
+        }
+    }
+}
+
+void SessionHost::runSession(Session &session)
+{
+    if (session.isClosed.load())
+        return;
+
+    // Take the typed bytes, leaving the emptied buffer for the reactor to fill
+    bool isInputClosed;
+    {
+        const lock_guard<std::mutex> lock(session.mutex);
+        swap(session.input, session.typed);
+        isInputClosed = session.isInputClosed;
+    }
+
+    const Clock::time_point now{Clock::now()};
+    try
+    {
+        if (!session.typed.empty())
+            session.game.onInput(session.typed, now);
+        session.typed.clear();
+
+        // Record how late the timer runs
+        const Clock::time_point deadline{session.game.getDeadline()};
+        if (now >= deadline)
+        {
+            const int64_t lateness{chrono::duration_cast<chrono::nanoseconds>(now - deadline).count()};
+            jitterHistogram[min<size_t>(static_cast<size_t>(lateness / JITTER_BUCKET_NANOSECONDS), jitterHistogram.size() - 1)].fetch_add(1, memory_order_relaxed);
+            int64_t maxLateness{maxJitterNanoseconds.load(memory_order_relaxed)};
+            while (lateness > maxLateness && !maxJitterNanoseconds.compare_exchange_weak(maxLateness, lateness, memory_order_relaxed))
+                ;
+            session.game.onTimer(now);
+        }
+    }
+    catch (const exception &)
+    {
+        isInputClosed = true;
+    }
+
+    // Hand the session back to the reactor to close once the player quits or disconnects
+    if (isInputClosed || session.game.isClosed())
+    {
+        session.isClosed.store(true);
+        {
+            const lock_guard<std::mutex> lock(notifyMutex);
+            notifiedSessions.push_back(session.id);
+        }
+        wakeReactor();
+        return;
+    }
+
+    // Queue the frame unless the player is too slow to keep up, the next frame is then compared to the last one sent
+    if (const string *frame{session.game.takeFrame()})
+    {
+        {
+            const lock_guard<std::mutex> lock(session.mutex);
+            if (session.output.size() - session.outputOffset <= options.maxPendingOutput)
+            {
+                appendFrame(session.output, *frame, session.lastFrame);
+                session.lastFrame.assign(*frame);
+            }
+        }
+        session.hasOutput.store(true);
+        {
+            const lock_guard<std::mutex> lock(notifyMutex);
+            notifiedSessions.push_back(session.id);
+        }
+        wakeReactor();
+    }
+
+    // Schedule the next timer, waking the reactor if it would sleep past it
+    const Clock::time_point next{session.game.getDeadline()};
+    if (next != Clock::time_point::max() && next != session.scheduledDeadline)
+    {
+        {
+            const lock_guard<std::mutex> lock(timerMutex);
+            timers.schedule(next, session.id);
+        }
+        session.scheduledDeadline = next;
+        if (next.time_since_epoch().count() < reactorWakeTime.load())
+            wakeReactor();
+    }
+}
+
+void SessionHost::acceptConnections()
+{
+    while (true)
+    {
+        const int descriptor{accept(listener, nullptr, nullptr)};
+        if (descriptor < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            return;
+        }
+        if (sessions.size() >= options.maxSessions)
+        {
+            close(descriptor);
+            continue;
+        }
+        makeNonBlocking(descriptor);
+#if defined(SO_NOSIGPIPE)
+        const int enabled{1};
+        setsockopt(descriptor, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+
+        // Run the session right away to draw its first frame and schedule its timers
+        const uint64_t id{nextSessionId++};
+#if defined(__linux__)
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = id;
+        if (epoll_ctl(poller, EPOLL_CTL_ADD, descriptor, &event) != 0)
+        {
+            close(descriptor);
+            continue;
+        }
+#endif
+        auto session{make_shared<Session>(id, descriptor, scores, Game::createSeed())};
+        sessions.emplace(id, session);
+        sessionCount.store(sessions.size(), memory_order_relaxed);
+        post(session);
+    }
+}
+
+bool SessionHost::readInput(Session &session)
+{
+    char buffer[1024];
+    while (true)
+    {
+        const auto count{read(session.descriptor, buffer, sizeof(buffer))};
+        if (count > 0)
+        {
+            const lock_guard<std::mutex> lock(session.mutex);
+            session.input.append(buffer, min(static_cast<size_t>(count), MAX_PENDING_INPUT - min(session.input.size(), MAX_PENDING_INPUT)));
+            continue;
+        }
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return true;
+
+        // The player disconnected
+        const lock_guard<std::mutex> lock(session.mutex);
+        session.isInputClosed = true;
+        return false;
+    }
+}
+
+bool SessionHost::writeOutput(Session &session)
+{
+    const lock_guard<std::mutex> lock(session.mutex);
+    while (session.outputOffset < session.output.size())
+    {
+#if defined(MSG_NOSIGNAL)
+        const auto count{send(session.descriptor, session.output.data() + session.outputOffset, session.output.size() - session.outputOffset, MSG_NOSIGNAL)};
+#else
+        const auto count{send(session.descriptor, session.output.data() + session.outputOffset, session.output.size() - session.outputOffset, 0)};
+#endif
+        if (count > 0)
+        {
+            session.outputOffset += static_cast<size_t>(count);
+            continue;
+        }
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            // Drop the written bytes once they are most of the buffer
+            if (session.outputOffset > session.output.size() / 2)
+            {
+                session.output.erase(0, session.outputOffset);
+                session.outputOffset = 0;
+            }
+            return true;
+        }
+
+        // The player disconnected, nothing more can be sent
+        session.output.clear();
+        session.outputOffset = 0;
+        session.hasOutput.store(false);
+        session.isInputClosed = true;
+        return false;
+    }
+    session.output.clear();
+    session.outputOffset = 0;
+    session.hasOutput.store(false);
+    return true;
+}
+
+void SessionHost::watchOutput(Session &session)
+{
+    const bool isStuck{session.hasOutput.load()};
+    if (session.isWatchingOutput == isStuck)
+        return;
+    session.isWatchingOutput = isStuck;
+#if defined(__linux__)
+    epoll_event event{};
+    event.events = isStuck ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    event.data.u64 = session.id;
+    epoll_ctl(poller, EPOLL_CTL_MOD, session.descriptor, &event);
+#endif
+}
+
+void SessionHost::closeSession(uint64_t id)
+{
+    const auto found{sessions.find(id)};
+    if (found == sessions.end())
+        return;
+    close(found->second->descriptor);
+    sessions.erase(found);
+    sessionCount.store(sessions.size(), memory_order_relaxed);
+}
+
+void SessionHost::run()
+{
+    // Start the workers
+    const int workerCount{options.workerCount > 0 ? options.workerCount : max(1, static_cast<int>(thread::hardware_concurrency()))};
+    isStopping = false;
+    for (int index{0}; index < workerCount; ++index)
+        workers.emplace_back(&SessionHost::runWorker, this);
+
+    vector<pair<shared_ptr<Session>, short>> ready;
+    vector<uint64_t> expired;
+    vector<uint64_t> notified;
+#if defined(__linux__)
+    array<epoll_event, MAX_EVENTS> events;
+    optional<Clock::time_point> armedDeadline;
+#else
+    vector<pollfd> descriptors;
+    vector<shared_ptr<Session>> polled;
+#endif
+    while (!isStopRequested.load())
+    {
+        // Sleep until the next timer at most
+        optional<Clock::time_point> nextDeadline;
+        {
+            const lock_guard<std::mutex> lock(timerMutex);
+            nextDeadline = timers.getNextDeadline();
+        }
+        reactorWakeTime.store(nextDeadline ? nextDeadline->time_since_epoch().count() : Clock::time_point::max().time_since_epoch().count());
+
+        bool isWoken{false};
+        bool hasConnections{false};
+        ready.clear();
+#if defined(__linux__)
+        // Arm the timer descriptor for the next deadline, steady_clock is CLOCK_MONOTONIC
+        if (nextDeadline != armedDeadline)
+        {
+            itimerspec timer{};
+            if (nextDeadline)
+            {
+                const auto nanoseconds{max<int64_t>(chrono::duration_cast<chrono::nanoseconds>(nextDeadline->time_since_epoch()).count(), 1)};
+                timer.it_value.tv_sec = static_cast<time_t>(nanoseconds / 1'000'000'000);
+                timer.it_value.tv_nsec = static_cast<long>(nanoseconds % 1'000'000'000);
+            }
+            timerfd_settime(timerDescriptor, TFD_TIMER_ABSTIME, &timer, nullptr);
+            armedDeadline = nextDeadline;
+        }
+
+        // Only the descriptors with events are returned, no matter how many sessions are connected
+        const int count{epoll_wait(poller, events.data(), MAX_EVENTS, -1)};
+        if (count < 0 && errno != EINTR)
+            break;
+        for (int index{0}; index < count; ++index)
+        {
+            const uint64_t id{events[index].data.u64};
+            if (id == WAKE_EVENT_ID)
+                isWoken = true;
+            else if (id == LISTENER_EVENT_ID)
+                hasConnections = true;
+            else if (id == TIMER_EVENT_ID)
+            {
+                uint64_t expirations;
+                [[maybe_unused]] const auto timerRead{read(timerDescriptor, &expirations, sizeof(expirations))};
+                armedDeadline.reset();
+            }
+            else if (const auto found{sessions.find(id)}; found != sessions.end())
+            {
+                const uint32_t flags{events[index].events};
+                short sessionEvents{0};
+                if (flags & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                    sessionEvents |= POLLIN;
+                if (flags & EPOLLOUT)
+                    sessionEvents |= POLLOUT;
+                ready.emplace_back(found->second, sessionEvents);
+            }
+        }
+#else
+        // Watch the wake pipe, the listener and every session, asking to write only when output is stuck
+        descriptors.clear();
+        polled.clear();
+        descriptors.push_back(pollfd{wakeReader, POLLIN, 0});
+        descriptors.push_back(pollfd{listener, POLLIN, 0});
+        for (const auto &[id, session] : sessions)
+        {
+            descriptors.push_back(pollfd{session->descriptor, static_cast<short>(session->isWatchingOutput ? POLLIN | POLLOUT : POLLIN), 0});
+            polled.push_back(session);
+        }
+
+        int timeout{-1};
+        if (nextDeadline)
+            timeout = static_cast<int>(chrono::ceil<chrono::milliseconds>(max(Clock::duration::zero(), *nextDeadline - Clock::now())).count());
+        const int count{poll(descriptors.data(), static_cast<nfds_t>(descriptors.size()), timeout)};
+        if (count < 0 && errno != EINTR)
+            break;
+        isWoken = descriptors[0].revents != 0;
+        hasConnections = descriptors[1].revents != 0;
+        for (size_t index{0}; index < polled.size(); ++index)
+        {
+            const short revents{descriptors[index + 2].revents};
+            short sessionEvents{0};
+            if (revents & (POLLIN | POLLHUP | POLLERR))
+                sessionEvents |= POLLIN;
+            if (revents & POLLOUT)
+                sessionEvents |= POLLOUT;
+            if (sessionEvents != 0)
+                ready.emplace_back(polled[index], sessionEvents);
+        }
+#endif
+
+        // Empty the wake pipe, later wakes write to it again
+        if (isWoken)
+        {
+            isWakePending.store(false);
+            char buffer[256];
+            while (read(wakeReader, buffer, sizeof(buffer)) > 0)
+                ;
+        }
+        if (hasConnections)
+            acceptConnections();
+
+        // Read input and write stuck output
+        for (const auto &[session, sessionEvents] : ready)
+        {
+            if (sessionEvents & POLLIN)
+            {
+                readInput(*session);
+                post(session);
+            }
+            if (sessionEvents & POLLOUT)
+            {
+                const bool isOpen{writeOutput(*session)};
+                if (session->isClosed.load() && (!isOpen || !session->hasOutput.load()))
+                {
+                    closeSession(session->id);
+                    continue;
+                }
+                if (!isOpen)
+                    post(session);
+                watchOutput(*session);
+            }
+        }
+        ready.clear();
+
+        // Write new frames right away and close the sessions that ended
+        {
+            const lock_guard<std::mutex> lock(notifyMutex);
+            notified.swap(notifiedSessions);
+        }
+        for (const uint64_t id : notified)
+        {
+            const auto found{sessions.find(id)};
+            if (found == sessions.end())
+                continue;
+            auto &session{found->second};
+            const bool isOpen{writeOutput(*session)};
+            if (session->isClosed.load() && (!isOpen || !session->hasOutput.load()))
+                closeSession(id);
+            else
+                watchOutput(*session);
+        }
+        notified.clear();
+
+        // Run the sessions whose timers are due
+        {
+            const lock_guard<std::mutex> lock(timerMutex);
+            timers.advance(Clock::now(), expired);
+        }
+        for (const uint64_t id : expired)
+        {
+            const auto found{sessions.find(id)};
+            if (found != sessions.end())
+                post(found->second);
+        }
+        expired.clear();
+    }
+
+    // Stop the workers
+    {
+        const lock_guard<std::mutex> lock(queueMutex);
+        isStopping = true;
+        runQueue.clear();
+    }
+    queueChanged.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+    workers.clear();
+    isStopRequested.store(false);
+}
+
+#endif
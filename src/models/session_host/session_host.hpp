@@ -0,0 +1,246 @@
+#ifndef SESSION_HOST_H
+#define SESSION_HOST_H
+
+#include "game_session.hpp"
+#include "timer_wheel.hpp"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief The settings of a session host
+ *
+ */
+struct SessionHostOptions
+{
+    /**
+     * @brief The path of the unix socket players connect to
+     *
+     */
+    std::string socketPath;
+
+    /**
+     * @brief The number of threads running sessions, 0 for one per core
+     *
+     */
+    int workerCount{0};
+
+    /**
+     * @brief The most bytes waiting to be sent to a player, frames are dropped while a slow player is over it
+     *
+     */
+    std::size_t maxPendingOutput{64 * 1024};
+
+    /**
+     * @brief The most players connected at once, later connections are closed
+     *
+     */
+    std::size_t maxSessions{4096};
+};
+
+/**
+ * @brief How late session timers ran, from their deadline until a worker ran them
+ *
+ */
+struct TickJitter
+{
+    std::uint64_t ticks{0};
+    double p50Milliseconds{0};
+    double p99Milliseconds{0};
+    double maxMilliseconds{0};
+};
+
+/**
+ * @brief Hosts many players' game sessions in one process
+ *
+ * @note One reactor thread accepts connections, reads and writes every socket and expires a shared timer wheel.
+ * Sessions that have input or a due timer are queued for a fixed pool of workers, and each session runs on at
+ * most one worker at a time, so sessions need no locks of their own. No thread is dedicated to a session. Only
+ * available on POSIX systems.
+ */
+class SessionHost
+{
+private:
+    struct Session;
+
+    SessionHostOptions options;
+    SessionScores &scores;
+
+    int listener{-1};
+
+    /**
+     * @brief The pipe written to wake the reactor
+     *
+     */
+    int wakeReader{-1};
+    int wakeWriter{-1};
+    std::atomic<bool> isWakePending{false};
+
+    std::atomic<bool> isStopRequested{false};
+
+    /**
+     * @brief The epoll instance watching every descriptor and the timer descriptor waking it at the next deadline,
+     * only used on Linux where other systems poll
+     *
+     */
+    int poller{-1};
+    int timerDescriptor{-1};
+
+    /**
+     * @brief The sessions by id, only used by the reactor
+     *
+     */
+    std::unordered_map<std::uint64_t, std::shared_ptr<Session>> sessions;
+    std::uint64_t nextSessionId{1};
+    std::atomic<std::size_t> sessionCount{0};
+
+    /**
+     * @brief The sessions with new output or that ended, for the reactor to handle
+     *
+     */
+    std::mutex notifyMutex;
+    std::vector<std::uint64_t> notifiedSessions;
+
+    /**
+     * @brief The timers of every session
+     *
+     */
+    std::mutex timerMutex;
+    TimerWheel timers;
+
+    /**
+     * @brief The time the reactor wakes up by itself next
+     *
+     */
+    std::atomic<std::int64_t> reactorWakeTime{0};
+
+    /**
+     * @brief The sessions waiting for a worker
+     *
+     */
+    std::mutex queueMutex;
+    std::condition_variable queueChanged;
+    std::deque<std::shared_ptr<Session>> runQueue;
+    bool isStopping{false};
+    std::vector<std::thread> workers;
+
+    /**
+     * @brief The number of timers run late by each tenth of a millisecond, the last bucket is everything later
+     *
+     */
+    std::array<std::atomic<std::uint64_t>, 1001> jitterHistogram{};
+    std::atomic<std::int64_t> maxJitterNanoseconds{0};
+
+    /**
+     * @brief Wakes the reactor from poll
+     *
+     */
+    void wakeReactor();
+
+    /**
+     * @brief Queues the session for a worker unless it is already queued or running
+     *
+     */
+    void post(const std::shared_ptr<Session> &session);
+
+    /**
+     * @brief Takes sessions off the queue and runs them until the host stops
+     *
+     */
+    void runWorker();
+
+    /**
+     * @brief Runs the session's input and due timers and queues its frame
+     *
+     */
+    void runSession(Session &session);
+
+    /**
+     * @brief Accepts waiting connections
+     *
+     */
+    void acceptConnections();
+
+    /**
+     * @brief Reads the input waiting on the session's socket
+     *
+     * @return true if the socket is still open
+     */
+    bool readInput(Session &session);
+
+    /**
+     * @brief Writes as much pending output as the session's socket takes
+     *
+     * @return true if the socket is still open
+     */
+    bool writeOutput(Session &session);
+
+    /**
+     * @brief Asks the poller to report when the session's socket takes more output, only while output is stuck
+     *
+     */
+    void watchOutput(Session &session);
+
+    /**
+     * @brief Closes the session's socket and forgets it
+     *
+     */
+    void closeSession(std::uint64_t id);
+
+public:
+    /**
+     * @brief Construct a new Session Host object listening on the socket
+     *
+     * @param options The host settings
+     * @param scores Where sessions save and read scores, must outlive the host
+     * @throws std::runtime_error Thrown if the socket can't be created or sessions can't be hosted on this system
+     */
+    SessionHost(SessionHostOptions options, SessionScores &scores);
+
+    /**
+     * @brief Destroy the Session Host object, closing every session
+     *
+     */
+    ~SessionHost();
+
+    SessionHost(const SessionHost &) = delete;
+    SessionHost &operator=(const SessionHost &) = delete;
+
+    /**
+     * @brief Runs the host on the calling thread until stop is requested
+     *
+     */
+    void run();
+
+    /**
+     * @brief Makes run return
+     *
+     * @note Safe to call from any thread and from signal handlers
+     */
+    void requestStop() noexcept;
+
+    /**
+     * @brief Get the number of connected players
+     *
+     * @return std::size_t
+     */
+    std::size_t getSessionCount() const { return sessionCount.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get how late session timers ran since the host started
+     *
+     * @return TickJitter
+     */
+    TickJitter getTickJitter() const;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include "simd.hpp"
+
+#if defined(_MSC_VER) && SNAKE_HAS_X86_KERNELS
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+SimdLevel detectSimdLevel()
+{
+#if !SNAKE_HAS_X86_KERNELS
+    return SimdLevel::SCALAR;
+#elif defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+    return SimdLevel::SSE2;
+#else
+    // Leaf 7 EBX bit 5 is AVX2, the OS must also save the YMM registers
+    int registers[4];
+    __cpuid(registers, 1);
+    const bool hasOsxsave{(registers[2] & (1 << 27)) != 0};
+    __cpuidex(registers, 7, 0);
+    const bool hasAvx2{(registers[1] & (1 << 5)) != 0};
+    if (hasOsxsave && hasAvx2 && (_xgetbv(0) & 0x6) == 0x6)
+        return SimdLevel::AVX2;
+    return SimdLevel::SSE2;
+#endif
+}
+
+const char *getSimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX2:
+        return "avx2";
+    case SimdLevel::SSE2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+/**
+ * @brief The instruction sets kernels can be selected for at runtime
+ *
+ */
+enum class SimdLevel
+{
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+/**
+ * @brief The target attribute for functions using AVX2 intrinsics
+ *
+ * @note MSVC allows intrinsics without a target so the attribute is only needed for GCC and Clang
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define SNAKE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SNAKE_TARGET_AVX2
+#endif
+
+/**
+ * @brief Whether the SSE2 and AVX2 kernels are compiled for this architecture
+ *
+ */
+#if defined(__x86_64__) || defined(_M_X64)
+#define SNAKE_HAS_X86_KERNELS 1
+#else
+#define SNAKE_HAS_X86_KERNELS 0
+#endif
+
+/**
+ * @brief Detects the best instruction set supported by the CPU and OS
+ *
+ * @return SimdLevel
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * @brief Get the name of the simd level for reports
+ *
+ * @param level The simd level
+ * @return const char*
+ */
+const char *getSimdLevelName(SimdLevel level);
+
+#endif
@@ -0,0 +1,576 @@
+#include "small_board_solver.hpp"
+#include "board.hpp"
+#include "snake.hpp"
+#include "point.hpp"
+#include "game_stepper.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+/**
+ * @brief The most moves of the sequences handed to the threads
+ *
+ */
+constexpr int MAX_SPLIT_DEPTH{8};
+
+/**
+ * @brief The sequences handed out per thread, enough that threads finishing early find more
+ *
+ */
+constexpr size_t TASKS_PER_THREAD{16};
+
+/**
+ * @brief The nodes a thread searches between adding to the shared statistics and checking for a stop
+ *
+ */
+constexpr uint64_t FLUSH_INTERVAL{1 << 12};
+
+/**
+ * @brief Get the direction from a cell to the next one
+ *
+ */
+static Directions::Direction findDirection(const int32_t *neighbours, int cell, int next)
+{
+    for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+        if (neighbours[cell * Board::DIRECTION_COUNT + direction] == next)
+            return static_cast<Directions::Direction>(direction);
+    throw invalid_argument("the cells aren't neighbours");
+}
+
+ZobristKeys::ZobristKeys(int cellCount, uint64_t seed) : keys(static_cast<size_t>(cellCount) * KEYS_PER_CELL)
+{
+    Pcg32 random(seed);
+    const auto draw = [&random]
+    {
+        const uint64_t high{random()};
+        return high << 32 | random();
+    };
+    for (auto &key : keys)
+        key = draw();
+    for (auto &key : directionKeys)
+        key = draw();
+}
+
+uint64_t ZobristKeys::getRandom(const Pcg32 &random)
+{
+    // The states of one stream are a counter times an odd constant, mix them so their bits spread over the key
+    uint64_t key{random.getState()};
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    return key ^ (key >> 31);
+}
+
+uint64_t ZobristKeys::hash(const Game &game) const
+{
+    const Board &board{game.getBoard()};
+    const int32_t *neighbours{board.getNeighbours()};
+    const Snake &snake{game.getSnake()};
+    const auto &body{snake.getBody()};
+
+    uint64_t hash{0};
+    for (size_t index{0}; index + 1 < body.size(); ++index)
+    {
+        const int cell{board.getCellIndex(body[index])};
+        hash ^= getSegment(cell, findDirection(neighbours, cell, board.getCellIndex(body[index + 1])));
+    }
+    return hash ^ getHead(board.getCellIndex(snake.getHead())) ^ getApple(board.getCellIndex(game.getApple())) ^
+           getDirection(snake.getDirection()) ^ getRandom(game.getRandom());
+}
+
+SolverStatistics &SolverStatistics::operator+=(const SolverStatistics &other)
+{
+    nodes += other.nodes;
+    tableProbes += other.tableProbes;
+    tableHits += other.tableHits;
+    tableCutoffs += other.tableCutoffs;
+    tableStores += other.tableStores;
+    tableReplacements += other.tableReplacements;
+    tableRejections += other.tableRejections;
+    return *this;
+}
+
+void SmallBoardSolver::SharedStatistics::add(const SolverStatistics &statistics)
+{
+    nodes.fetch_add(statistics.nodes, memory_order_relaxed);
+    tableProbes.fetch_add(statistics.tableProbes, memory_order_relaxed);
+    tableHits.fetch_add(statistics.tableHits, memory_order_relaxed);
+    tableCutoffs.fetch_add(statistics.tableCutoffs, memory_order_relaxed);
+    tableStores.fetch_add(statistics.tableStores, memory_order_relaxed);
+    tableReplacements.fetch_add(statistics.tableReplacements, memory_order_relaxed);
+    tableRejections.fetch_add(statistics.tableRejections, memory_order_relaxed);
+}
+
+SolverStatistics SmallBoardSolver::SharedStatistics::load() const
+{
+    return SolverStatistics{nodes.load(memory_order_relaxed), tableProbes.load(memory_order_relaxed), tableHits.load(memory_order_relaxed),
+                            tableCutoffs.load(memory_order_relaxed), tableStores.load(memory_order_relaxed),
+                            tableReplacements.load(memory_order_relaxed), tableRejections.load(memory_order_relaxed)};
+}
+
+/**
+ * @brief Starts a game with the replay's settings and plays its moves
+ *
+ * @throws std::invalid_argument Thrown if the settings can't make a game or the snake crashes before the last move
+ */
+static unique_ptr<Game> createGame(const Replay &replay)
+{
+    if (static_cast<int64_t>(replay.width + 1) * (replay.height + 1) > SmallBoardSolver::MAX_CELL_COUNT)
+        throw invalid_argument("the board is too large to solve");
+
+    // The game starts the way GameService starts it
+    auto game{createReplayGame(replay, "Solver")};
+    game->reserve();
+    const auto stepper{makeGameStepper(*game)};
+    for (size_t index{0}; index < replay.moveCount; ++index)
+    {
+        if (game->isGameOver())
+            throw invalid_argument("the snake crashes before the replay's last move");
+        stepper->step(replay.getMove(index));
+    }
+    return game;
+}
+
+/**
+ * @brief What playing a move did
+ *
+ */
+enum class SolverMove
+{
+    CRASHED,
+    MOVED,
+    ATE,
+
+    /**
+     * @brief The move eats the apple on the last vacant apple cell, which ends the game
+     *
+     */
+    CLEARED
+};
+
+/**
+ * @brief A sequence of moves from the root, searched further by whichever thread takes it
+ *
+ */
+struct SolverTask
+{
+    array<Directions::Direction, MAX_SPLIT_DEPTH> moves{};
+    int moveCount{0};
+
+    /**
+     * @brief The apples the moves eat
+     *
+     */
+    int apples{0};
+};
+
+/**
+ * @brief One thread's game at the root, searched by stepping and taking moves back
+ *
+ */
+class SolverWorker
+{
+private:
+    /**
+     * @brief What taking a move back needs
+     *
+     */
+    struct Undo
+    {
+        StepOutcome outcome{StepOutcome::MOVED};
+        Directions::Direction previousDirection{Directions::Direction::RIGHT};
+        Point tail;
+        Pcg32 random;
+        uint64_t hash{0};
+    };
+
+    SmallBoardSolver &solver;
+    const unique_ptr<Game> game;
+    const unique_ptr<GameStepper> stepper;
+    const Board &board;
+    const int32_t *neighbours;
+    const atomic<bool> &stopping;
+
+    uint64_t hash{0};
+
+    /**
+     * @brief The statistics not yet added to the solver's
+     *
+     */
+    SolverStatistics statistics;
+
+    /**
+     * @brief Get the most apples the snake could eat in the moves, if every apple were placed next to its head
+     *
+     */
+    int getUpperBound(int depth) const
+    {
+        const Point &head{game->getSnake().getHead()};
+        const Point &apple{game->getApple()};
+        const int distance{abs(head.x - apple.x) + abs(head.y - apple.y)};
+        return distance > depth ? 0 : min(depth - distance + 1, stepper->getVacantAppleCells());
+    }
+
+    /**
+     * @brief Counts a node, flushing the statistics and checking for a stop now and then
+     *
+     * @throws SearchStopped Thrown if the solve is stopping
+     */
+    void countNode()
+    {
+        if (++statistics.nodes % FLUSH_INTERVAL == 0)
+        {
+            flush();
+            if (stopping.load(memory_order_relaxed))
+                throw SearchStopped{};
+        }
+    }
+
+public:
+    /**
+     * @brief Thrown out of a search when the solve stops, the game is left mid search
+     *
+     */
+    struct SearchStopped
+    {
+    };
+
+    SolverWorker(SmallBoardSolver &solver, const atomic<bool> &stopping) : solver(solver), game(createGame(solver.root)), stepper(makeGameStepper(*game)), board(game->getBoard()), neighbours(board.getNeighbours()), stopping(stopping)
+    {
+        if (game->isGameOver())
+            return;
+        hash = solver.keys.hash(*game);
+    }
+
+    ~SolverWorker() { flush(); }
+
+    const Game &getGame() const { return *game; }
+
+    /**
+     * @brief Get the moves that don't reverse into the snake
+     *
+     */
+    array<Directions::Direction, 3> getMoves() const
+    {
+        array<Directions::Direction, 3> moves{};
+        int count{0};
+        for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+            if (!Directions::areOppositeDirections(game->getSnake().getDirection(), static_cast<Directions::Direction>(direction)))
+                moves[count++] = static_cast<Directions::Direction>(direction);
+        return moves;
+    }
+
+    /**
+     * @brief Plays a move, keeping the hash up to date
+     *
+     * @param direction The move, not reversing into the snake
+     * @param undo Filled with what taking the move back needs
+     * @return SolverMove
+     */
+    SolverMove play(Directions::Direction direction, Undo &undo)
+    {
+        const Snake &snake{game->getSnake()};
+        const auto &body{snake.getBody()};
+        const int head{board.getCellIndex(snake.getHead())};
+        const int destination{neighbours[head * Board::DIRECTION_COUNT + static_cast<int>(direction)]};
+        const int apple{board.getCellIndex(game->getApple())};
+        undo.previousDirection = snake.getDirection();
+        undo.tail = snake.getTail();
+        undo.random = game->getRandom();
+        undo.hash = hash;
+        const int tail{board.getCellIndex(undo.tail)};
+        const Directions::Direction towardHead{body.size() > 1 ? findDirection(neighbours, tail, board.getCellIndex(body[1])) : direction};
+
+        undo.outcome = stepper->step(direction);
+        switch (undo.outcome)
+        {
+        case StepOutcome::MOVED:
+            hash = solver.keys.popTail(solver.keys.pushHead(hash, head, destination, undo.previousDirection, direction), tail, towardHead);
+            return SolverMove::MOVED;
+        case StepOutcome::ATE:
+            // A cleared board ends the search, so its position is never hashed
+            if (game->getIsCleared())
+                return SolverMove::CLEARED;
+            hash = solver.keys.pushHead(hash, head, destination, undo.previousDirection, direction);
+            hash = solver.keys.moveApple(hash, apple, board.getCellIndex(game->getApple()), undo.random, game->getRandom());
+            return SolverMove::ATE;
+        default:
+            return SolverMove::CRASHED;
+        }
+    }
+
+    /**
+     * @brief Takes back the move played last
+     *
+     */
+    void takeBack(const Undo &undo)
+    {
+        stepper->undo(undo.outcome, undo.previousDirection, undo.tail);
+        if (undo.outcome == StepOutcome::ATE)
+            game->getRandom() = undo.random;
+        hash = undo.hash;
+    }
+
+    /**
+     * @brief Finds the most apples the snake can eat in the moves
+     *
+     * @param depth The moves left
+     * @param alpha The apples already reached elsewhere, only more matter
+     * @return int The apples if more than alpha, otherwise at least as many as the apples
+     */
+    int search(int depth, int alpha)
+    {
+        countNode();
+        if (depth == 0)
+            return 0;
+        const int bound{getUpperBound(depth)};
+        if (bound <= alpha)
+            return bound;
+
+        // Deeper searches bound shallower ones, the apples only grow with the moves
+        TableEntry entry;
+        uint8_t tableMove{TableEntry::NO_MOVE};
+        ++statistics.tableProbes;
+        if (solver.table.probe(hash, static_cast<uint16_t>(depth), entry))
+        {
+            ++statistics.tableHits;
+            tableMove = entry.move;
+            const bool isExact{entry.bound == TableBound::EXACT};
+            if ((entry.depth == depth && isExact) || (entry.depth >= depth && entry.value <= alpha))
+            {
+                ++statistics.tableCutoffs;
+                return entry.value;
+            }
+            if (entry.depth <= depth && isExact && entry.value >= bound)
+            {
+                ++statistics.tableCutoffs;
+                return bound;
+            }
+        }
+
+        // Try the table's move first, then the moves closest to the apple
+        array<Directions::Direction, 3> moves{getMoves()};
+        const Point &head{game->getSnake().getHead()};
+        const Point &apple{game->getApple()};
+        const auto rankMove = [&](Directions::Direction direction)
+        {
+            if (static_cast<uint8_t>(direction) == tableMove)
+                return -1;
+            const int index{static_cast<int>(direction)};
+            return abs(head.x + Directions::DELTA_X[index] - apple.x) + abs(head.y + Directions::DELTA_Y[index] - apple.y);
+        };
+        ranges::sort(moves, {}, rankMove);
+
+        int best{0};
+        uint8_t bestMove{TableEntry::NO_MOVE};
+        for (const auto direction : moves)
+        {
+            Undo undo;
+            const SolverMove move{play(direction, undo)};
+            int apples{0};
+            if (move == SolverMove::CLEARED)
+                apples = 1;
+            else if (move == SolverMove::MOVED)
+                apples = search(depth - 1, max(alpha, best));
+            else if (move == SolverMove::ATE)
+                apples = 1 + search(depth - 1, max(alpha, best) - 1);
+            takeBack(undo);
+
+            if (apples > best || (bestMove == TableEntry::NO_MOVE && move != SolverMove::CRASHED))
+            {
+                best = apples;
+                bestMove = static_cast<uint8_t>(direction);
+            }
+            if (best >= bound)
+                break;
+        }
+
+        // Every move failing to beat alpha leaves none better than the others to try first next time
+        const bool isExact{best > alpha};
+        ++statistics.tableStores;
+        const TableStore store{solver.table.store(TableEntry{hash, static_cast<int16_t>(best), static_cast<uint16_t>(depth),
+                                                             isExact ? TableBound::EXACT : TableBound::UPPER, isExact ? bestMove : TableEntry::NO_MOVE})};
+        statistics.tableReplacements += store == TableStore::REPLACED;
+        statistics.tableRejections += store == TableStore::REJECTED;
+        return best;
+    }
+
+    /**
+     * @brief Collects the move sequences from the root to hand to the threads
+     *
+     * @param depth The moves left to search
+     * @param splitDepth The moves of each sequence
+     * @param task The sequence so far
+     * @param tasks Filled with the sequences
+     * @param moveApples The apples of each first move, raised for sequences that end the game early
+     */
+    void split(int depth, int splitDepth, SolverTask &task, vector<SolverTask> &tasks, array<atomic<int>, 4> &moveApples)
+    {
+        for (const auto direction : getMoves())
+        {
+            task.moves[task.moveCount] = direction;
+            atomic<int> &firstApples{moveApples[static_cast<int>(task.moves[0])]};
+            Undo undo;
+            const SolverMove move{play(direction, undo)};
+            if (move == SolverMove::CRASHED || move == SolverMove::CLEARED)
+                firstApples = max(firstApples.load(), task.apples + (move == SolverMove::CLEARED));
+            else
+            {
+                ++task.moveCount;
+                task.apples += move == SolverMove::ATE;
+                if (task.moveCount == splitDepth || task.moveCount == depth)
+                    tasks.push_back(task);
+                else
+                    split(depth, splitDepth, task, tasks, moveApples);
+                task.apples -= move == SolverMove::ATE;
+                --task.moveCount;
+            }
+            takeBack(undo);
+        }
+    }
+
+    /**
+     * @brief Searches after a sequence of moves from the root
+     *
+     * @param depth The moves to search from the root
+     * @param task The sequence
+     * @param moveApples The apples of each first move, raised if the sequence beats them
+     */
+    void searchTask(int depth, const SolverTask &task, array<atomic<int>, 4> &moveApples)
+    {
+        array<Undo, MAX_SPLIT_DEPTH> undos;
+        for (int index{0}; index < task.moveCount; ++index)
+            play(task.moves[index], undos[index]);
+
+        // Sequences starting with the same move only matter if they beat each other
+        atomic<int> &firstApples{moveApples[static_cast<int>(task.moves[0])]};
+        const int apples{task.apples + search(depth - task.moveCount, firstApples.load(memory_order_relaxed) - task.apples)};
+        for (int known{firstApples.load(memory_order_relaxed)}; apples > known && !firstApples.compare_exchange_weak(known, apples, memory_order_relaxed);)
+            ;
+
+        for (int index{task.moveCount - 1}; index >= 0; --index)
+            takeBack(undos[index]);
+    }
+
+    /**
+     * @brief Adds the statistics to the solver's
+     *
+     */
+    void flush()
+    {
+        solver.statistics.add(statistics);
+        statistics = SolverStatistics{};
+    }
+};
+
+// Starting the game checks the root now rather than on every thread
+SmallBoardSolver::SmallBoardSolver(const Replay &root, size_t tableBytes, ReplacementPolicy policy) : root(root), keys(createGame(root)->getBoard().getCellCount()), table(tableBytes, policy)
+{
+}
+
+SolverResult SmallBoardSolver::solve(int depth, unsigned threadCount, const function<bool(const SolverProgress &)> &onProgress, chrono::milliseconds progressInterval)
+{
+    if (depth < 1 || depth > MAX_DEPTH)
+        throw invalid_argument("the depth must be between 1 and " + to_string(MAX_DEPTH));
+    if (threadCount == 0)
+        threadCount = max(thread::hardware_concurrency(), 1u);
+
+    statistics.nodes = statistics.tableProbes = statistics.tableHits = statistics.tableCutoffs = 0;
+    statistics.tableStores = statistics.tableReplacements = statistics.tableRejections = 0;
+    const auto start{chrono::steady_clock::now()};
+    const auto getSeconds = [&start]
+    { return chrono::duration<double>(chrono::steady_clock::now() - start).count(); };
+
+    SolverResult result;
+    atomic<bool> stopping{false};
+    SolverWorker rootWorker(*this, stopping);
+    if (rootWorker.getGame().isGameOver())
+    {
+        result.depth = depth;
+        return result;
+    }
+
+    // Enough sequences per thread to even out how long each takes
+    int splitDepth{1};
+    for (size_t sequenceCount{3}; sequenceCount < TASKS_PER_THREAD * threadCount && splitDepth < MAX_SPLIT_DEPTH; sequenceCount *= 3)
+        ++splitDepth;
+
+    for (int currentDepth{1}; currentDepth <= depth && !stopping; ++currentDepth)
+    {
+        array<atomic<int>, 4> moveApples;
+        for (auto &apples : moveApples)
+            apples = -1;
+        for (const auto direction : rootWorker.getMoves())
+            moveApples[static_cast<int>(direction)] = 0;
+        vector<SolverTask> tasks;
+        SolverTask task;
+        rootWorker.split(currentDepth, splitDepth, task, tasks, moveApples);
+
+        // Each sequence is searched by whichever thread takes it next
+        atomic<size_t> nextTask{0};
+        atomic<size_t> finishedTasks{0};
+        mutex doneMutex;
+        condition_variable doneCondition;
+        unsigned runningThreads{threadCount};
+        {
+            vector<jthread> threads;
+            for (unsigned index{0}; index < threadCount; ++index)
+                threads.emplace_back([&]
+                                     {
+                                         try
+                                         {
+                                             SolverWorker worker(*this, stopping);
+                                             for (size_t next{nextTask.fetch_add(1)}; next < tasks.size(); next = nextTask.fetch_add(1))
+                                             {
+                                                 worker.searchTask(currentDepth, tasks[next], moveApples);
+                                                 finishedTasks.fetch_add(1, memory_order_relaxed);
+                                             }
+                                         }
+                                         catch (const SolverWorker::SearchStopped &)
+                                         {
+                                         }
+                                         const lock_guard<mutex> lock(doneMutex);
+                                         --runningThreads;
+                                         doneCondition.notify_one(); });
+
+            unique_lock<mutex> lock(doneMutex);
+            while (!doneCondition.wait_for(lock, progressInterval, [&runningThreads]
+                                           { return runningThreads == 0; }))
+            {
+                lock.unlock();
+                if (onProgress && !onProgress(SolverProgress{currentDepth, finishedTasks.load(), tasks.size(), false, result.apples, result.bestMove,
+                                                             statistics.load(), getSeconds(), table.getFill()}))
+                    stopping = true;
+                lock.lock();
+            }
+        }
+        if (stopping)
+            break;
+
+        // The first move eating the most apples is the best, the earliest in the enum among equals
+        result.depth = currentDepth;
+        result.apples = 0;
+        result.bestMove.reset();
+        for (int direction{0}; direction < Board::DIRECTION_COUNT; ++direction)
+        {
+            result.moveApples[direction] = moveApples[direction];
+            if (moveApples[direction] >= 0 && (!result.bestMove || moveApples[direction] > result.apples))
+            {
+                result.apples = moveApples[direction];
+                result.bestMove = static_cast<Directions::Direction>(direction);
+            }
+        }
+        if (onProgress && !onProgress(SolverProgress{currentDepth, tasks.size(), tasks.size(), true, result.apples, result.bestMove,
+                                                     statistics.load(), getSeconds(), table.getFill()}))
+            break;
+    }
+
+    result.statistics = statistics.load();
+    result.seconds = getSeconds();
+    return result;
+}
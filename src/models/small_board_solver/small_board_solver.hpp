@@ -0,0 +1,294 @@
+#ifndef SMALL_BOARD_SOLVER_H
+#define SMALL_BOARD_SOLVER_H
+
+#include "game.hpp"
+#include "direction.hpp"
+#include "pcg32.hpp"
+#include "replay_archive.hpp"
+#include "transposition_table.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Random keys whose xor hashes a game position, updated in a few xors as the snake moves
+ *
+ * @note A position is its snake, apple, direction and random generator. Each segment but the head is keyed by its
+ * cell and the direction to the segment after it, which tells the body apart from another over the same cells.
+ * Placing an apple draws from the game's generator a varying number of times, so the generator's state is hashed
+ * with the apple: games in the same cells but with different generators get different apples later on.
+ */
+class ZobristKeys
+{
+private:
+    /**
+     * @brief The keys of each cell: a segment leading each way, the head and the apple
+     *
+     */
+    constexpr static int KEYS_PER_CELL{6};
+
+    std::vector<std::uint64_t> keys;
+
+    std::array<std::uint64_t, 4> directionKeys{};
+
+public:
+    /**
+     * @brief Construct a new Zobrist Keys object
+     *
+     * @param cellCount The board's cells, see Board::getCellCount
+     * @param seed The seed of the keys
+     */
+    explicit ZobristKeys(int cellCount, std::uint64_t seed = 0x5a0b815cULL);
+
+    std::uint64_t getSegment(int cell, Directions::Direction towardHead) const { return keys[cell * KEYS_PER_CELL + static_cast<int>(towardHead)]; }
+    std::uint64_t getHead(int cell) const { return keys[cell * KEYS_PER_CELL + 4]; }
+    std::uint64_t getApple(int cell) const { return keys[cell * KEYS_PER_CELL + 5]; }
+    std::uint64_t getDirection(Directions::Direction direction) const { return directionKeys[static_cast<int>(direction)]; }
+
+    /**
+     * @brief Get the key of a random generator's state
+     *
+     */
+    static std::uint64_t getRandom(const Pcg32 &random);
+
+    /**
+     * @brief Hashes a position from scratch
+     *
+     * @param game The game, its snake must not have crashed
+     * @return std::uint64_t
+     */
+    std::uint64_t hash(const Game &game) const;
+
+    /**
+     * @brief Updates a hash for the head moving to a new cell, the old head becoming a segment
+     *
+     * @param hash The hash before the move
+     * @param head The old head's cell
+     * @param destination The new head's cell
+     * @param previousDirection The direction the snake faced before the move
+     * @param direction The direction moved
+     * @return std::uint64_t
+     */
+    std::uint64_t pushHead(std::uint64_t hash, int head, int destination, Directions::Direction previousDirection, Directions::Direction direction) const
+    {
+        return hash ^ getHead(head) ^ getSegment(head, direction) ^ getHead(destination) ^ getDirection(previousDirection) ^ getDirection(direction);
+    }
+
+    /**
+     * @brief Updates a hash for the tail leaving its cell
+     *
+     * @param hash The hash before the tail moved
+     * @param tail The tail's cell
+     * @param towardHead The direction from the tail to the segment after it
+     * @return std::uint64_t
+     */
+    std::uint64_t popTail(std::uint64_t hash, int tail, Directions::Direction towardHead) const { return hash ^ getSegment(tail, towardHead); }
+
+    /**
+     * @brief Updates a hash for an apple eaten and the next one placed
+     *
+     * @param hash The hash before the apple moved
+     * @param apple The eaten apple's cell
+     * @param newApple The new apple's cell
+     * @param random The game's random generator before placing the new apple
+     * @param newRandom The game's random generator after placing it
+     * @return std::uint64_t
+     */
+    std::uint64_t moveApple(std::uint64_t hash, int apple, int newApple, const Pcg32 &random, const Pcg32 &newRandom) const
+    {
+        return hash ^ getApple(apple) ^ getApple(newApple) ^ getRandom(random) ^ getRandom(newRandom);
+    }
+};
+
+/**
+ * @brief Counts of the work a solve did
+ *
+ */
+struct SolverStatistics
+{
+    std::uint64_t nodes{0};
+    std::uint64_t tableProbes{0};
+
+    /**
+     * @brief The probes that found their position
+     *
+     */
+    std::uint64_t tableHits{0};
+
+    /**
+     * @brief The hits whose entry answered the position without searching it
+     *
+     */
+    std::uint64_t tableCutoffs{0};
+
+    std::uint64_t tableStores{0};
+
+    /**
+     * @brief The stores that evicted another position
+     *
+     */
+    std::uint64_t tableReplacements{0};
+
+    /**
+     * @brief The stores the replacement policy refused
+     *
+     */
+    std::uint64_t tableRejections{0};
+
+    double getHitRate() const { return tableProbes > 0 ? static_cast<double>(tableHits) / static_cast<double>(tableProbes) : 0.0; }
+    double getCutoffRate() const { return tableProbes > 0 ? static_cast<double>(tableCutoffs) / static_cast<double>(tableProbes) : 0.0; }
+
+    SolverStatistics &operator+=(const SolverStatistics &other);
+};
+
+/**
+ * @brief How far a solve is, reported while it runs
+ *
+ */
+struct SolverProgress
+{
+    /**
+     * @brief The depth being searched
+     *
+     */
+    int depth{0};
+
+    std::size_t finishedTasks{0};
+    std::size_t taskCount{0};
+
+    /**
+     * @brief Whether the depth has been searched, the apples and best move are only known then
+     *
+     */
+    bool isDepthComplete{false};
+
+    int apples{0};
+    std::optional<Directions::Direction> bestMove;
+    SolverStatistics statistics;
+    double seconds{0};
+    double tableFill{0};
+};
+
+/**
+ * @brief The optimal play found by a solve
+ *
+ */
+struct SolverResult
+{
+    /**
+     * @brief The deepest depth searched completely, 0 if the solve stopped before any
+     *
+     */
+    int depth{0};
+
+    /**
+     * @brief The most apples the snake can eat in that many moves
+     *
+     */
+    int apples{0};
+
+    /**
+     * @brief A move eating them, none if the game is over
+     *
+     */
+    std::optional<Directions::Direction> bestMove;
+
+    /**
+     * @brief The most apples eaten after each move, -1 for the move reversing into the snake
+     *
+     */
+    std::array<int, 4> moveApples{-1, -1, -1, -1};
+
+    SolverStatistics statistics;
+    double seconds{0};
+};
+
+/**
+ * @brief Finds the most apples a snake can eat within a number of moves, exactly, by searching every move
+ *
+ * @note Apples are placed by the game's seeded random generator, so each game is deterministic and the solver plays
+ * the real game rules on Game objects, stepping and taking moves back. The search is a depth first branch and bound
+ * with iterative deepening: a position whose apples can't beat the best line found, going by its distance to the
+ * apple, isn't searched, and results are kept in a transposition table keyed by Zobrist hashes. Threads share the
+ * table and take the move sequences a few moves deep from a queue. Clearing the board ends the game, apples can't be
+ * placed once the snake covers every cell they go to. Meant for small boards, the work grows exponentially with
+ * the depth.
+ */
+class SmallBoardSolver
+{
+public:
+    /**
+     * @brief The largest board solved, in cells
+     *
+     */
+    constexpr static int MAX_CELL_COUNT{4096};
+
+    constexpr static int MAX_DEPTH{1000};
+
+private:
+    /**
+     * @brief The statistics of every thread, added to in batches
+     *
+     */
+    struct SharedStatistics
+    {
+        std::atomic<std::uint64_t> nodes{0};
+        std::atomic<std::uint64_t> tableProbes{0};
+        std::atomic<std::uint64_t> tableHits{0};
+        std::atomic<std::uint64_t> tableCutoffs{0};
+        std::atomic<std::uint64_t> tableStores{0};
+        std::atomic<std::uint64_t> tableReplacements{0};
+        std::atomic<std::uint64_t> tableRejections{0};
+
+        void add(const SolverStatistics &statistics);
+        SolverStatistics load() const;
+    };
+
+    /**
+     * @brief The position solved, the replay's settings and the moves played so far
+     *
+     */
+    const Replay root;
+
+    const ZobristKeys keys;
+    TranspositionTable table;
+    SharedStatistics statistics;
+
+    friend class SolverWorker;
+
+public:
+    /**
+     * @brief Construct a new Small Board Solver object
+     *
+     * @param root The position to solve, a game started with the replay's settings after its moves
+     * @param tableBytes The memory of the transposition table
+     * @param policy How the transposition table replaces entries
+     * @throws std::invalid_argument Thrown if the replay's settings can't make a game, the board is too large or the
+     * snake crashes before the replay's last move
+     */
+    SmallBoardSolver(const Replay &root, std::size_t tableBytes, ReplacementPolicy policy);
+
+    /**
+     * @brief Searches deeper and deeper up to a depth
+     *
+     * @note The table is kept between solves, so solving again deeper reuses what was found
+     * @param depth The moves to search ahead
+     * @param threadCount The threads searching, 0 for one per core
+     * @param onProgress Called on the calling thread every progress interval and after each depth, the solve stops
+     * after the deepest depth completed when it returns false
+     * @param progressInterval How often progress is reported
+     * @throws std::invalid_argument Thrown if the depth isn't between 1 and MAX_DEPTH
+     * @return SolverResult
+     */
+    SolverResult solve(int depth, unsigned threadCount = 0, const std::function<bool(const SolverProgress &)> &onProgress = nullptr,
+                       std::chrono::milliseconds progressInterval = std::chrono::seconds(1));
+
+    const TranspositionTable &getTable() const { return table; }
+};
+
+#endif
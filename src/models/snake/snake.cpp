@@ -1,11 +1,49 @@
 #include "snake.hpp"
 #include "direction.hpp"
 #include <stdexcept>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <vector>
 
 using namespace std;
 
-Snake::Snake(const Point &head, const int startingSize)
+/**
+ * @brief The bytes reserved for deque blocks and maps beyond the segments themselves
+ *
+ */
+constexpr size_t STORAGE_OVERHEAD{4 * 1024};
+
+/**
+ * @brief The fewest slots segmentSlots has
+ *
+ */
+constexpr size_t MIN_SEGMENT_SLOTS{16};
+
+/**
+ * @brief Spreads the point over the bits of a slot index
+ *
+ */
+static size_t hashSegment(const Point &point)
+{
+    const uint64_t key{static_cast<uint64_t>(static_cast<uint32_t>(point.x)) << 32 | static_cast<uint32_t>(point.y)};
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+Snake::Storage::Storage(size_t capacity)
+    : capacity(capacity),
+      arena(capacity * sizeof(Point) + STORAGE_OVERHEAD),
+      pool(pmr::pool_options{0, STORAGE_OVERHEAD}, &arena),
+      body(&pool)
+{
+}
+
+Snake::Snake(const Point &head, const int startingSize) : storage(make_unique<Storage>(static_cast<size_t>(max(startingSize, 0))))
 {
+    resizeSegmentSlots(bit_ceil(max(2 * storage->capacity, MIN_SEGMENT_SLOTS)));
     for (int index{startingSize}; index > 0; --index)
     {
         Point point(head.x - index, head.y);
@@ -13,53 +51,154 @@ Snake::Snake(const Point &head, const int startingSize)
     }
 }
 
+void Snake::reserve(size_t capacity)
+{
+    // Keep the current storage if it is already big enough
+    if (capacity <= storage->capacity)
+        return;
+
+    // Copy the body into the new storage
+    auto newStorage{make_unique<Storage>(capacity)};
+    newStorage->body.assign(storage->body.begin(), storage->body.end());
+    storage = std::move(newStorage);
+
+    // Keep the table at most half full at the capacity
+    if (2 * capacity > segmentSlots.size())
+        resizeSegmentSlots(bit_ceil(2 * capacity));
+}
+
+size_t Snake::findSlot(const Point &point) const
+{
+    const size_t mask{segmentSlots.size() - 1};
+    size_t slot{hashSegment(point) & mask};
+    while (segmentSlots[slot] != point && segmentSlots[slot] != EMPTY_SLOT)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+void Snake::resizeSegmentSlots(size_t slotCount)
+{
+    vector<Point> oldSlots(slotCount, EMPTY_SLOT);
+    segmentSlots.swap(oldSlots);
+    for (const auto &point : oldSlots)
+        if (point != EMPTY_SLOT)
+            segmentSlots[findSlot(point)] = point;
+}
+
+void Snake::insertSegment(const Point &point)
+{
+    // Grow once the table would be more than half full
+    if (2 * (segmentCount + 1) > segmentSlots.size())
+        resizeSegmentSlots(2 * segmentSlots.size());
+
+    const size_t slot{findSlot(point)};
+    if (segmentSlots[slot] == EMPTY_SLOT)
+    {
+        segmentSlots[slot] = point;
+        ++segmentCount;
+    }
+}
+
+void Snake::eraseSegment(const Point &point)
+{
+    size_t hole{findSlot(point)};
+    if (segmentSlots[hole] == EMPTY_SLOT)
+        return;
+
+    // Shift the points after the hole back so every point stays reachable from its home slot
+    const size_t mask{segmentSlots.size() - 1};
+    for (size_t slot{(hole + 1) & mask}; segmentSlots[slot] != EMPTY_SLOT; slot = (slot + 1) & mask)
+    {
+        const size_t home{hashSegment(segmentSlots[slot]) & mask};
+        if (((slot - home) & mask) >= ((slot - hole) & mask))
+        {
+            segmentSlots[hole] = segmentSlots[slot];
+            hole = slot;
+        }
+    }
+    segmentSlots[hole] = EMPTY_SLOT;
+    --segmentCount;
+}
+
 void Snake::push(const Point &point, bool isGrowing)
 {
     if (isInSnake(point))
         throw invalid_argument("point already exists");
 
-    body.push_back(point);
-    bodySegmentsSet.insert(point);
+    storage->body.push_back(point);
+    insertSegment(point);
 }
 
 void Snake::pop()
 {
-    bodySegmentsSet.erase(body.front());
-    body.pop_front();
+    eraseSegment(storage->body.front());
+    storage->body.pop_front();
 }
 
 void Snake::move(Directions::Direction direction)
+{
+    move(direction, getHead().getAdjacentPoint(direction));
+}
+
+void Snake::move(Directions::Direction direction, const Point &destination)
 {
     if (!Directions::areOppositeDirections(this->direction, direction) && !isCrashed)
     {
         pop();
-        push(getHead().getAdjacentPoint(direction));
+        push(destination);
         this->direction = direction;
     }
 }
 
 void Snake::grow(Directions::Direction direction)
+{
+    grow(direction, getHead().getAdjacentPoint(direction));
+}
+
+void Snake::grow(Directions::Direction direction, const Point &destination)
 {
     if (!Directions::areOppositeDirections(this->direction, direction) && !isCrashed)
     {
-        push(getHead().getAdjacentPoint(direction), true);
+        push(destination, true);
         this->direction = direction;
     }
 }
 
 void Snake::crash(Directions::Direction direction)
+{
+    crash(direction, getHead().getAdjacentPoint(direction));
+}
+
+void Snake::crash(Directions::Direction direction, const Point &destination)
 {
     if (!Directions::areOppositeDirections(this->direction, direction) && !isCrashed)
     {
         pop();
-        body.push_back(getHead().getAdjacentPoint(direction));
+        storage->body.push_back(destination);
         isCrashed = true;
     }
 }
 
+void Snake::undo(Directions::Direction previousDirection, const optional<Point> &freedTail)
+{
+    // The crash point was never added to segmentSlots
+    if (isCrashed)
+        isCrashed = false;
+    else
+        eraseSegment(storage->body.back());
+    storage->body.pop_back();
+
+    if (freedTail)
+    {
+        storage->body.push_front(*freedTail);
+        insertSegment(*freedTail);
+    }
+    direction = previousDirection;
+}
+
 bool Snake::isInSnake(const Point &pointToCheck) const
 {
-    return bodySegmentsSet.find(pointToCheck) != bodySegmentsSet.end();
+    return segmentSlots[findSlot(pointToCheck)] != EMPTY_SLOT;
 }
 
 const char Snake::getDirectionAsChar() const
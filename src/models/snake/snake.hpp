@@ -3,8 +3,13 @@
 
 #include "point.hpp"
 #include "direction.hpp"
+#include <climits>
+#include <cstddef>
 #include <deque>
-#include <unordered_set>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <vector>
 #include <stdexcept>
 
 /**
@@ -15,16 +20,99 @@ class Snake
 {
 private:
     /**
-     * @brief The body represented as a queue
+     * @brief The memory the body is kept in
      *
+     * @note Deque blocks freed by the tail go back to the pool and are reused by the head, so once the storage is
+     * reserved for the whole board a moving snake doesn't allocate
      */
-    std::deque<Point> body{};
+    struct Storage
+    {
+        /**
+         * @brief The number of segments the storage is sized for
+         *
+         */
+        std::size_t capacity;
+
+        /**
+         * @brief The memory allocated up front for the pool
+         *
+         */
+        std::pmr::monotonic_buffer_resource arena;
+
+        /**
+         * @brief Recycles the blocks freed by the body
+         *
+         */
+        std::pmr::unsynchronized_pool_resource pool;
+
+        /**
+         * @brief The body represented as a queue
+         *
+         */
+        std::pmr::deque<Point> body;
+
+        /**
+         * @brief Construct a new Storage object
+         *
+         * @param capacity The number of segments to size the storage for
+         */
+        explicit Storage(std::size_t capacity);
+    };
+
+    /**
+     * @brief The storage of the body
+     *
+     */
+    std::unique_ptr<Storage> storage;
+
+    /**
+     * @brief The body points as an open addressing hash table for quick lookup
+     *
+     * @note Holds EMPTY_SLOT where there is no point and is kept at most half full, so lookups and updates don't
+     * allocate
+     */
+    std::vector<Point> segmentSlots;
+
+    /**
+     * @brief The number of points in segmentSlots
+     *
+     */
+    std::size_t segmentCount{0};
+
+    /**
+     * @brief The marker of an unused slot, never a point of the body
+     *
+     */
+    constexpr static Point EMPTY_SLOT{INT_MIN, INT_MIN};
 
     /**
-     * @brief The body points as a hash set for quick lookup
+     * @brief Get the slot the point is in, or the empty slot it would be put in
      *
+     * @param point
+     * @return std::size_t
      */
-    std::unordered_set<Point, Point::hasher> bodySegmentsSet{};
+    std::size_t findSlot(const Point &point) const;
+
+    /**
+     * @brief Resizes segmentSlots and puts the points back in
+     *
+     * @param slotCount The new number of slots, a power of two
+     */
+    void resizeSegmentSlots(std::size_t slotCount);
+
+    /**
+     * @brief Adds the point to segmentSlots
+     *
+     * @param point
+     */
+    void insertSegment(const Point &point);
+
+    /**
+     * @brief Removes the point from segmentSlots
+     *
+     * @param point
+     */
+    void eraseSegment(const Point &point);
 
     /**
      * @brief The character representing the direction the snake is facing
@@ -61,9 +149,9 @@ public:
      */
     const Point &getHead() const
     {
-        if (body.size() == 0)
+        if (storage->body.size() == 0)
             throw std::invalid_argument("body is empty");
-        return body.back();
+        return storage->body.back();
     }
 
     /**
@@ -73,17 +161,17 @@ public:
      */
     const Point &getTail() const
     {
-        if (body.size() == 0)
+        if (storage->body.size() == 0)
             throw std::invalid_argument("body is empty");
-        return body.front();
+        return storage->body.front();
     }
 
     /**
      * @brief Get the body of the snake
      *
-     * @return const std::queue<Point>&
+     * @return const std::pmr::deque<Point>&
      */
-    const std::deque<Point> &getBody() const { return body; }
+    const std::pmr::deque<Point> &getBody() const { return storage->body; }
 
     /**
      * @brief Get the Direction object
@@ -108,6 +196,14 @@ public:
      */
     Snake(const Point &head, const int startingSize);
 
+    /**
+     * @brief Sizes the storage of the body for the given number of segments
+     *
+     * @note The snake doesn't allocate while it is no longer than the capacity
+     * @param capacity The longest the snake is expected to grow
+     */
+    void reserve(std::size_t capacity);
+
     /**
      * @brief Moves the snake head to the new target, moving the tail in the process
      *
@@ -115,6 +211,16 @@ public:
      */
     void move(Directions::Direction direction);
 
+    /**
+     * @brief Moves the snake head to the destination, moving the tail in the process
+     *
+     * @note The destination is trusted to be the cell reached by moving in the direction, for boards whose
+     * neighbours aren't the adjacent points
+     * @param direction The direction to move to
+     * @param destination The cell the head moves to
+     */
+    void move(Directions::Direction direction, const Point &destination);
+
     /**
      * @brief Grows the snake by stretching the head to the new target, leaving the tail in the same place
      *
@@ -122,6 +228,14 @@ public:
      */
     void grow(Directions::Direction direction);
 
+    /**
+     * @brief Grows the snake by stretching the head to the destination, leaving the tail in the same place
+     *
+     * @param direction The direction to move to
+     * @param destination The cell the head moves to
+     */
+    void grow(Directions::Direction direction, const Point &destination);
+
     /**
      * @brief Moves the snake toward the crash point and crashes it.
      *
@@ -130,6 +244,23 @@ public:
      */
     void crash(Directions::Direction direction);
 
+    /**
+     * @brief Moves the snake to the crash point and crashes it
+     *
+     * @param direction The direction to crash
+     * @param destination The wall, obstacle or segment the head crashes into
+     */
+    void crash(Directions::Direction direction, const Point &destination);
+
+    /**
+     * @brief Takes back the last move, growth or crash
+     *
+     * @note Constant time, the body isn't copied
+     * @param previousDirection The direction the snake faced before the step
+     * @param freedTail The tail the step moved off, empty if the snake grew
+     */
+    void undo(Directions::Direction previousDirection, const std::optional<Point> &freedTail);
+
     /**
      * @brief Checks if the point is in the snake body
      *
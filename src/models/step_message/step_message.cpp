@@ -0,0 +1,39 @@
+#include "step_message.hpp"
+
+using namespace std;
+
+/**
+ * @brief The steps the YUM message stays up after an apple
+ *
+ */
+constexpr short YUM_STEPS{3};
+
+void showStepMessage(Game &game, StepOutcome outcome, const Reachability &reachability, short &lastAte)
+{
+    switch (outcome)
+    {
+    case StepOutcome::ATE:
+        if (game.getIsCleared())
+        {
+            game.setMessage("YOU WIN!\n\nThe board is full");
+            break;
+        }
+        game.setMessage("YUM!!!");
+        lastAte = YUM_STEPS;
+        break;
+    case StepOutcome::HIT_SELF:
+        game.setMessage("GAMEOVER!\n\nYou ate your tail!");
+        break;
+    case StepOutcome::HIT_WALL:
+        game.setMessage("GAMEOVER!\n\nYou hit the wall!");
+        break;
+    case StepOutcome::MOVED:
+        if (reachability.isTrapped(game.getSnake()))
+            game.setMessage("TRAPPED!\n\nThere's no way out");
+        else if (lastAte > 0)
+            --lastAte;
+        else
+            game.setMessage("");
+        break;
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef STEP_MESSAGE_H
+#define STEP_MESSAGE_H
+
+#include "game.hpp"
+#include "game_stepper.hpp"
+#include "reachability.hpp"
+
+/**
+ * @brief Shows the message for the outcome of a step of the game
+ *
+ * @note An apple shows YUM for a few steps, a crash or a cleared board shows how the game ended and a move into a
+ * region the snake can't get out of warns the player. The other moves clear the message.
+ * @param game The game stepped
+ * @param outcome The outcome of the step
+ * @param reachability The free regions of the game, updated for the step
+ * @param lastAte The steps left before the YUM message is cleared, set by an apple and counted down by moves
+ */
+void showStepMessage(Game &game, StepOutcome outcome, const Reachability &reachability, short &lastAte);
+
+#endif
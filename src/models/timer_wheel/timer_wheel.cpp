@@ -0,0 +1,83 @@
+#include "timer_wheel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+TimerWheel::TimerWheel(Clock::duration slotDuration, size_t slotCount, Clock::time_point start) : slotDuration(slotDuration), currentSlotStart(start)
+{
+    if (slotDuration <= Clock::duration::zero() || slotCount == 0)
+        throw invalid_argument("timer wheel needs a positive slot duration and count");
+    slots.resize(slotCount);
+}
+
+void TimerWheel::schedule(Clock::time_point deadline, uint64_t id)
+{
+    // Past deadlines go in the current slot so the next advance expires them
+    const auto slotsAhead{deadline > currentSlotStart ? static_cast<size_t>((deadline - currentSlotStart) / slotDuration) : 0};
+    slots[(currentSlot + slotsAhead) % slots.size()].push_back(Entry{deadline, id});
+    ++size;
+}
+
+void TimerWheel::expireSlot(vector<Entry> &slot, Clock::time_point now, vector<uint64_t> &expired)
+{
+    // Keep the timers of later turns, swapping the due ones out
+    for (size_t index{0}; index < slot.size();)
+    {
+        if (slot[index].deadline > now)
+        {
+            ++index;
+            continue;
+        }
+        expired.push_back(slot[index].id);
+        slot[index] = slot.back();
+        slot.pop_back();
+        --size;
+    }
+}
+
+void TimerWheel::advance(Clock::time_point now, vector<uint64_t> &expired)
+{
+    // Expire every slot passed since the last advance, visiting each slot at most once
+    if (now >= currentSlotStart + slotDuration)
+    {
+        const auto passedSlots{static_cast<size_t>((now - currentSlotStart) / slotDuration)};
+        for (size_t step{0}; step < min(passedSlots, slots.size()); ++step)
+            expireSlot(slots[(currentSlot + step) % slots.size()], now, expired);
+        currentSlot = (currentSlot + passedSlots) % slots.size();
+        currentSlotStart += passedSlots * slotDuration;
+    }
+
+    // Expire the due timers of the current slot as well
+    expireSlot(slots[currentSlot], now, expired);
+}
+
+optional<TimerWheel::Clock::time_point> TimerWheel::getNextDeadline() const
+{
+    if (size == 0)
+        return nullopt;
+
+    // The first slot with a timer of this turn has the next deadline
+    for (size_t step{0}; step < slots.size(); ++step)
+    {
+        const Clock::time_point slotEnd{currentSlotStart + (step + 1) * slotDuration};
+        optional<Clock::time_point> next;
+        for (const auto &entry : slots[(currentSlot + step) % slots.size()])
+            if (entry.deadline < slotEnd && (!next || entry.deadline < *next))
+                next = entry.deadline;
+        if (next)
+            return next;
+    }
+
+    // Every timer is at least a turn away
+    optional<Clock::time_point> next;
+    for (const auto &slot : slots)
+        for (const auto &entry : slot)
+            if (!next || entry.deadline < *next)
+                next = entry.deadline;
+    return next;
+}
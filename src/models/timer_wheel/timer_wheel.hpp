@@ -0,0 +1,94 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Schedules many timers at a fixed resolution
+ *
+ * @note Timers are hashed into a ring of slots by their deadline, so scheduling and expiring cost the same no
+ * matter how many timers are pending. Timers further away than one turn of the ring wait in their slot for later
+ * turns. A timer expires on the first advance at or after its deadline. Not thread safe.
+ */
+class TimerWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    /**
+     * @brief A pending timer
+     *
+     */
+    struct Entry
+    {
+        Clock::time_point deadline;
+        std::uint64_t id;
+    };
+
+    Clock::duration slotDuration;
+    std::vector<std::vector<Entry>> slots;
+
+    /**
+     * @brief The slot the current time falls in and the time it starts at
+     *
+     */
+    std::size_t currentSlot{0};
+    Clock::time_point currentSlotStart;
+
+    std::size_t size{0};
+
+    /**
+     * @brief Moves the ids of the slot's timers that are due at the time to expired
+     *
+     */
+    void expireSlot(std::vector<Entry> &slot, Clock::time_point now, std::vector<std::uint64_t> &expired);
+
+public:
+    /**
+     * @brief Construct a new Timer Wheel object
+     *
+     * @param slotDuration The resolution of the timers
+     * @param slotCount The number of slots in the ring
+     * @param start The time the wheel starts at
+     * @throws std::invalid_argument Thrown if the duration or count is not positive
+     */
+    TimerWheel(Clock::duration slotDuration, std::size_t slotCount, Clock::time_point start = Clock::now());
+
+    /**
+     * @brief Schedules a timer
+     *
+     * @note Deadlines in the past expire on the next advance
+     * @param deadline When the timer expires
+     * @param id The id reported when the timer expires
+     */
+    void schedule(Clock::time_point deadline, std::uint64_t id);
+
+    /**
+     * @brief Expires every timer due at the time
+     *
+     * @param now The current time
+     * @param expired The ids of the expired timers are appended to it
+     */
+    void advance(Clock::time_point now, std::vector<std::uint64_t> &expired);
+
+    /**
+     * @brief Get the time the next timer expires
+     *
+     * @return std::optional<Clock::time_point> Empty if no timers are pending
+     */
+    std::optional<Clock::time_point> getNextDeadline() const;
+
+    /**
+     * @brief Get the number of pending timers
+     *
+     * @return std::size_t
+     */
+    std::size_t getSize() const { return size; }
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "transposition_table.hpp"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * @brief The bit set in every packed entry
+ *
+ */
+constexpr static uint64_t VALID_BIT{1ULL << 63};
+
+uint64_t TranspositionTable::pack(const TableEntry &entry)
+{
+    return static_cast<uint64_t>(static_cast<uint16_t>(entry.value)) | static_cast<uint64_t>(entry.depth) << 16 |
+           static_cast<uint64_t>(entry.bound) << 32 | static_cast<uint64_t>(entry.move & 7) << 34 | VALID_BIT;
+}
+
+TableEntry TranspositionTable::unpack(uint64_t key, uint64_t data)
+{
+    TableEntry entry;
+    entry.key = key;
+    entry.value = static_cast<int16_t>(static_cast<uint16_t>(data));
+    entry.depth = static_cast<uint16_t>(data >> 16);
+    entry.bound = static_cast<TableBound>(data >> 32 & 3);
+    entry.move = static_cast<uint8_t>(data >> 34 & 7);
+    return entry;
+}
+
+void TranspositionTable::write(Slot &slot, uint64_t key, uint64_t data)
+{
+    slot.data.store(data, memory_order_relaxed);
+    slot.check.store(key ^ data, memory_order_relaxed);
+}
+
+TranspositionTable::TranspositionTable(size_t bytes, ReplacementPolicy policy) : policy(policy)
+{
+    const size_t bucketCount{bit_floor(bytes / (sizeof(Slot) * SLOTS_PER_BUCKET))};
+    if (bucketCount == 0)
+        throw invalid_argument("the table must have room for a bucket");
+    slots = make_unique<Slot[]>(bucketCount * SLOTS_PER_BUCKET);
+    bucketMask = bucketCount - 1;
+}
+
+bool TranspositionTable::probe(uint64_t key, uint16_t depth, TableEntry &entry) const
+{
+    const Slot *bucket{getBucket(key)};
+    bool isFound{false};
+    for (size_t index{0}; index < SLOTS_PER_BUCKET; ++index)
+    {
+        const uint64_t data{bucket[index].data.load(memory_order_relaxed)};
+        if (data == 0 || (bucket[index].check.load(memory_order_relaxed) ^ data) != key)
+            continue;
+
+        // A deeper entry than needed only bounds the value, the closer one is more precise
+        const TableEntry found{unpack(key, data)};
+        const bool isCloser{found.depth >= depth ? entry.depth < depth || found.depth < entry.depth : entry.depth < depth && found.depth > entry.depth};
+        if (!isFound || isCloser)
+            entry = found;
+        isFound = true;
+    }
+    return isFound;
+}
+
+TableStore TranspositionTable::store(const TableEntry &entry)
+{
+    Slot *bucket{getBucket(entry.key)};
+    const uint64_t data{pack(entry)};
+
+    // Compares the entry with what a slot holds, a torn slot counts as another position
+    const auto inspect = [&entry](const Slot &slot, TableEntry &stored)
+    {
+        const uint64_t storedData{slot.data.load(memory_order_relaxed)};
+        if (storedData == 0)
+            return TableStore::ADDED;
+        const uint64_t storedKey{slot.check.load(memory_order_relaxed) ^ storedData};
+        stored = unpack(storedKey, storedData);
+        return storedKey == entry.key ? TableStore::UPDATED : TableStore::REPLACED;
+    };
+
+    TableEntry stored;
+    if (policy != ReplacementPolicy::TWO_TIER)
+    {
+        // The key's top bit picks the position's slot, it isn't used for the bucket
+        Slot &slot{bucket[entry.key >> 63]};
+        const TableStore outcome{inspect(slot, stored)};
+        if (policy == ReplacementPolicy::DEPTH_PREFERRED && outcome != TableStore::ADDED && entry.depth < stored.depth)
+            return TableStore::REJECTED;
+        write(slot, entry.key, data);
+        return outcome;
+    }
+
+    // A search at least as deep as the first slot's takes it, moving what it held to the second slot
+    Slot &deep{bucket[0]};
+    Slot &recent{bucket[1]};
+    const TableStore deepOutcome{inspect(deep, stored)};
+    if (deepOutcome == TableStore::ADDED || entry.depth >= stored.depth)
+    {
+        if (deepOutcome == TableStore::REPLACED)
+            write(recent, stored.key, pack(stored));
+        write(deep, entry.key, data);
+        return deepOutcome;
+    }
+    const TableStore recentOutcome{inspect(recent, stored)};
+    write(recent, entry.key, data);
+    return recentOutcome;
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t index{0}; index < getSlotCount(); ++index)
+        write(slots[index], 0, 0);
+}
+
+double TranspositionTable::getFill(size_t bucketCount) const
+{
+    const size_t slotCount{min(bucketCount * SLOTS_PER_BUCKET, getSlotCount())};
+    size_t used{0};
+    for (size_t index{0}; index < slotCount; ++index)
+        used += slots[index].data.load(memory_order_relaxed) != 0;
+    return slotCount > 0 ? static_cast<double>(used) / static_cast<double>(slotCount) : 0.0;
+}
@@ -0,0 +1,186 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief How the value stored for a position relates to its true value
+ *
+ */
+enum class TableBound : std::uint8_t
+{
+    EXACT,
+    UPPER
+};
+
+/**
+ * @brief Which entry a store evicts when the position's bucket is full
+ *
+ */
+enum class ReplacementPolicy
+{
+    /**
+     * @brief Each position has one slot of its bucket and the newest store always takes it
+     *
+     */
+    ALWAYS,
+
+    /**
+     * @brief Each position has one slot of its bucket and a store only takes it from a shallower search
+     *
+     */
+    DEPTH_PREFERRED,
+
+    /**
+     * @brief The first slot keeps the deepest search and the second slot takes every other store
+     *
+     */
+    TWO_TIER
+};
+
+/**
+ * @brief What a search found for a position
+ *
+ */
+struct TableEntry
+{
+    std::uint64_t key{0};
+    std::int16_t value{0};
+
+    /**
+     * @brief The moves searched ahead of the position
+     *
+     */
+    std::uint16_t depth{0};
+
+    TableBound bound{TableBound::EXACT};
+
+    /**
+     * @brief The best move found, NO_MOVE if none was
+     *
+     */
+    std::uint8_t move{NO_MOVE};
+
+    constexpr static std::uint8_t NO_MOVE{4};
+};
+
+/**
+ * @brief What storing an entry did
+ *
+ */
+enum class TableStore
+{
+    /**
+     * @brief The entry took an empty slot
+     *
+     */
+    ADDED,
+
+    /**
+     * @brief The entry replaced one of the same position
+     *
+     */
+    UPDATED,
+
+    /**
+     * @brief The entry evicted another position
+     *
+     */
+    REPLACED,
+
+    /**
+     * @brief The replacement policy kept what was stored
+     *
+     */
+    REJECTED
+};
+
+/**
+ * @brief A fixed size hash table of search results shared by every search thread without locks
+ *
+ * @note Buckets are two slots of two 64 bit words, the packed entry and the key xored with it, so two buckets share
+ * a cache line. Words are read and written with relaxed atomics: a slot torn by threads writing it at once no longer
+ * xors back to its key and reads as a miss, so entries are never mixed up without taking a lock (Hyatt and Mann's
+ * lockless hashing). A store racing another may be lost, which only costs the search repeating work.
+ */
+class TranspositionTable
+{
+private:
+    struct Slot
+    {
+        std::atomic<std::uint64_t> check{0};
+        std::atomic<std::uint64_t> data{0};
+    };
+
+    constexpr static std::size_t SLOTS_PER_BUCKET{2};
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t bucketMask{0};
+    const ReplacementPolicy policy;
+
+    /**
+     * @brief Packs the entry without its key, never 0 so empty slots stand out
+     *
+     */
+    static std::uint64_t pack(const TableEntry &entry);
+
+    static TableEntry unpack(std::uint64_t key, std::uint64_t data);
+
+    Slot *getBucket(std::uint64_t key) const { return &slots[(key & bucketMask) * SLOTS_PER_BUCKET]; }
+
+    static void write(Slot &slot, std::uint64_t key, std::uint64_t data);
+
+public:
+    /**
+     * @brief Construct a new Transposition Table object
+     *
+     * @param bytes The most memory the table may use, rounded down to a power of two buckets
+     * @param policy How full buckets are replaced
+     * @throws std::invalid_argument Thrown if the memory doesn't fit one bucket
+     */
+    TranspositionTable(std::size_t bytes, ReplacementPolicy policy);
+
+    /**
+     * @brief Looks up a position
+     *
+     * @note A position may be stored twice with different depths, the entry searched closest to the depth without
+     * falling short of it is picked, and the deepest one if both fall short
+     * @param key The position's hash
+     * @param depth The depth being searched
+     * @param entry Filled with what was stored for the position
+     * @return true if the position was found
+     */
+    bool probe(std::uint64_t key, std::uint16_t depth, TableEntry &entry) const;
+
+    /**
+     * @brief Stores a search result, following the replacement policy if the position's bucket is full
+     *
+     * @param entry The result, its value must fit 16 bits
+     * @return TableStore What the store did
+     */
+    TableStore store(const TableEntry &entry);
+
+    /**
+     * @brief Empties the table, not while it is searched
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Get the share of slots in use, counted over the first buckets
+     *
+     * @param bucketCount The buckets counted, at most all of them
+     */
+    double getFill(std::size_t bucketCount = 4096) const;
+
+    std::size_t getSlotCount() const { return (bucketMask + 1) * SLOTS_PER_BUCKET; }
+
+    std::size_t getMemoryUsage() const { return getSlotCount() * sizeof(Slot); }
+
+    ReplacementPolicy getPolicy() const { return policy; }
+};
+
+#endif
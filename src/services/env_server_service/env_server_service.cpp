@@ -0,0 +1,40 @@
+#include "env_server_service.hpp"
+#include "env_server.hpp"
+#include "plog/Log.h"
+#include <atomic>
+#include <csignal>
+
+using namespace std;
+
+/**
+ * @brief The server stopped by the interrupt and terminate signals
+ *
+ */
+static atomic<EnvServer *> runningServer{nullptr};
+
+/**
+ * @brief Stops the running server
+ *
+ */
+static void onStopSignal(int)
+{
+    if (EnvServer *server{runningServer.load()})
+        server->requestStop();
+}
+
+void EnvServerService::run(const EnvServerOptions &options)
+{
+    EnvServer server(options);
+    PLOGI << "Serving environments on " << options.socketPath;
+
+    // Stop on ctrl+c or when the process is terminated
+    runningServer.store(&server);
+    const auto previousInterrupt{signal(SIGINT, onStopSignal)};
+    const auto previousTerminate{signal(SIGTERM, onStopSignal)};
+    server.run();
+    signal(SIGINT, previousInterrupt);
+    signal(SIGTERM, previousTerminate);
+    runningServer.store(nullptr);
+
+    PLOGI << "Stopped serving environments after " << server.getStepCount() << " batched steps, " << server.getRejectedCount() << " clients rejected";
+}
@@ -0,0 +1,22 @@
+#ifndef ENV_SERVER_SERVICE_H
+#define ENV_SERVER_SERVICE_H
+
+#include "env_server.hpp"
+
+/**
+ * @brief Serves batches of games to trainers in other processes through shared memory
+ *
+ * @note Trainers connect with an EnvClient or by following the protocol of EnvServer and EnvRegionHeader
+ */
+class EnvServerService
+{
+public:
+    /**
+     * @brief Serves clients until the process is interrupted or terminated
+     *
+     * @param options The server settings
+     */
+    void run(const EnvServerOptions &options);
+};
+
+#endif
@@ -4,6 +4,11 @@
 #include "board.hpp"
 #include "snake.hpp"
 #include "config.hpp"
+#include "score_journal.hpp"
+#include "score_record.hpp"
+#include "score_page_cache.hpp"
+#include "leaderboard_index.hpp"
+#include "io_worker.hpp"
 #include "plog/Log.h"
 #include <string>
 #include <memory>
@@ -11,61 +16,179 @@
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include <chrono>
+#include <future>
 
 using namespace std;
 
-void FileService::saveSettings(const Game &game)
+/**
+ * @brief Get the score journal, it is opened on the first save or file thread operation
+ *
+ */
+static ScoreJournal &getScoreJournal()
+{
+    SnakeConfig::ensureGameDirectories();
+    static ScoreJournal journal(SnakeConfig::getGameDirectory() + "scores.dat");
+    return journal;
+}
+
+/**
+ * @brief Get the parsed pages of the score file
+ *
+ */
+static ScorePageCache &getScorePageCache()
+{
+    static ScorePageCache cache(SnakeConfig::getGameDirectory() + "scores.dat");
+    return cache;
+}
+
+/**
+ * @brief Get the ranks of the saved scores, empty until loaded
+ *
+ */
+static LeaderboardIndex &getLeaderboard()
+{
+    static LeaderboardIndex leaderboard;
+    return leaderboard;
+}
+
+/**
+ * @brief Get the thread file operations are queued on
+ *
+ * @note The score journal, pages and leaderboard are created first, so they are destroyed after the worker runs what
+ * is queued
+ */
+static IoWorker &getIoWorker()
+{
+    try
+    {
+        getScoreJournal();
+    }
+    catch (const exception &exception)
+    {
+        PLOGW << "Unable to open the score journal " << exception.what();
+    }
+    getScorePageCache();
+    getLeaderboard();
+    static IoWorker worker;
+    return worker;
+}
+
+/**
+ * @brief Writes the settings file
+ *
+ */
+static void writeSettings(int width, int height, double gameSpeed, size_t snakeLength)
 {
     // Open the file and check for fail
     PLOGI << "Saving settings";
-    ofstream file(GAME_DIRECTORY + "settings.dat", ofstream::trunc);
+    SnakeConfig::ensureGameDirectories();
+    ofstream file(SnakeConfig::getGameDirectory() + "settings.dat", ofstream::trunc);
     if (file.fail())
-        throw invalid_argument("Failed to create save file at: " + GAME_DIRECTORY + "settings.dat");
+        throw invalid_argument("Failed to create save file at: " + SnakeConfig::getGameDirectory() + "settings.dat");
 
     // Save the settings
-    PLOGD << "Width: " << game.getBoard().getWidth() << endl
-          << "Height: " << game.getBoard().getHeight() << endl
-          << "Speed: " << game.getGameSpeed() << endl
-          << "Snake Length: " << game.getSnake().getBody().size() << endl;
-    file << game.getBoard().getWidth() << endl
-         << game.getBoard().getHeight() << endl
-         << game.getGameSpeed() << endl
-         << game.getSnake().getBody().size() << endl;
+    PLOGD << "Width: " << width << endl
+          << "Height: " << height << endl
+          << "Speed: " << gameSpeed << endl
+          << "Snake Length: " << snakeLength << endl;
+    file << width << endl
+         << height << endl
+         << gameSpeed << endl
+         << snakeLength << endl;
 
     // Close the file
     file.close();
 }
 
-void FileService::saveScore(const Game &game)
+void FileService::saveSettings(const Game &game)
 {
-    // Open the file and check for fail
-    PLOGI << "Saving score";
-    ofstream file(GAME_DIRECTORY + "scores.dat", ofstream::app);
-    if (file.fail())
-        throw invalid_argument("Failed to create save file at: " + GAME_DIRECTORY + "scores.dat");
+    writeSettings(game.getBoard().getWidth(), game.getBoard().getHeight(), game.getGameSpeed(), game.getSnake().getBody().size());
+}
+
+future<void> FileService::saveSettingsTask(const Game &game)
+{
+    // Copy the settings now, the game may change before the worker runs
+    return getIoWorker().submit([width = game.getBoard().getWidth(), height = game.getBoard().getHeight(), gameSpeed = game.getGameSpeed(), snakeLength = game.getSnake().getBody().size()]
+                                { writeSettings(width, height, gameSpeed, snakeLength); });
+}
 
-    // Save the score
+/**
+ * @brief Creates the record of the game's score
+ *
+ */
+static ScoreRecord createScoreRecord(const Game &game, int64_t replayId)
+{
+    PLOGI << "Saving score";
     PLOGD << "Player: " << game.getPlayerName() << endl
           << "Width: " << game.getBoard().getWidth() << endl
           << "Height: " << game.getBoard().getHeight() << endl
           << "Game Speed: " << game.getGameSpeed() << endl
           << "Snake Length: " << game.getSnake().getBody().size() << endl
           << "Score: " << game.getScore() << endl;
-    file << game.getPlayerName() << '-'
-         << game.getBoard().getWidth() << '-'
-         << game.getBoard().getHeight() << '-'
-         << game.getGameSpeed() << '-'
-         << game.getSnake().getBody().size() << '-'
-         << game.getScore() << endl;
 
-    // Close the file
-    file.close();
+    ScoreRecord record;
+    record.playerName = game.getPlayerName();
+    record.width = game.getBoard().getWidth();
+    record.height = game.getBoard().getHeight();
+    record.gameSpeed = game.getGameSpeed();
+    record.snakeLength = static_cast<int>(game.getSnake().getBody().size());
+    record.score = game.getScore();
+    record.timestamp = chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+    record.replayId = replayId;
+    return record;
+}
+
+future<void> FileService::saveScoreTask(const Game &game, int64_t replayId)
+{
+    // Append the score to the journal and rank the following games against it
+    return getIoWorker().submit([record = createScoreRecord(game, replayId)]
+                                {
+                                    getScoreJournal().append(record);
+                                    getLeaderboard().add(record); });
+}
+
+/**
+ * @brief Reads the saved scores into the leaderboard unless it is loaded, only called on the file thread
+ *
+ */
+static void loadLeaderboard()
+{
+    if (getLeaderboard().getIsLoaded())
+        return;
+    PLOGI << "Loading the leaderboard";
+    try
+    {
+        const size_t scoreCount{getLeaderboard().load(SnakeConfig::getGameDirectory() + "scores.dat")};
+        PLOGI << "Ranked " << scoreCount << " saved scores";
+    }
+    catch (const exception &exception)
+    {
+        PLOGW << "Unable to load the leaderboard " << exception.what();
+    }
+}
+
+future<void> FileService::loadLeaderboardTask()
+{
+    return getIoWorker().submit(loadLeaderboard);
+}
+
+LeaderboardRank FileService::getRank(const Game &game)
+{
+    return getLeaderboard().getRank(LeaderboardConfiguration{game.getBoard().getWidth(), game.getBoard().getHeight(), game.getGameSpeed()}, game.getScore());
+}
+
+int64_t FileService::saveReplay(const Replay &replay)
+{
+    PLOGI << "Saving replay of " << replay.moveCount << " moves";
+    SnakeConfig::ensureGameDirectories();
+    return static_cast<int64_t>(ReplayArchive::append(SnakeConfig::getGameDirectory() + "replays.dat", replay));
 }
 
 bool FileService::hasSettingsFile()
 {
     PLOGI << "Checking for settings file";
-    ifstream file(GAME_DIRECTORY + "settings.dat");
+    ifstream file(SnakeConfig::getGameDirectory() + "settings.dat");
     bool toReturn = file.good();
     file.close();
     return toReturn;
@@ -75,9 +198,9 @@ unique_ptr<Game> FileService::loadSettings()
 {
     // Open the settings file
     PLOGI << "Loading settings";
-    ifstream file(GAME_DIRECTORY + "settings.dat");
+    ifstream file(SnakeConfig::getGameDirectory() + "settings.dat");
     if (file.fail())
-        throw invalid_argument("Failed to open save file at: " + GAME_DIRECTORY + "settings.dat");
+        throw invalid_argument("Failed to open save file at: " + SnakeConfig::getGameDirectory() + "settings.dat");
 
     // Declare ptr to return
     PLOGD << "Parsing settings file";
@@ -100,9 +223,9 @@ unique_ptr<Game> FileService::loadSettings()
     }
     catch (const invalid_argument &exception)
     {
-        PLOGE << "An error occurred while parsing file " << GAME_DIRECTORY << "settings.dat" << exception.what();
+        PLOGE << "An error occurred while parsing file " << SnakeConfig::getGameDirectory() << "settings.dat" << exception.what();
         file.close();
-        throw invalid_argument("Failed to open save file at: " + GAME_DIRECTORY + "settings.dat");
+        throw invalid_argument("Failed to open save file at: " + SnakeConfig::getGameDirectory() + "settings.dat");
     }
 
     // Close the file
@@ -113,71 +236,50 @@ unique_ptr<Game> FileService::loadSettings()
     return game;
 }
 
+future<unique_ptr<Game>> FileService::loadSettingsTask()
+{
+    return getIoWorker().submit(&FileService::loadSettings);
+}
+
 void FileService::loadScores(vector<Game> &scores, int page, const int numPerPage)
 {
     // Clear vector for set of scores
     scores.clear();
 
-    // Initialize current page
-    auto currentPage{0};
-
-    // Open the scores file
-    ifstream file(GAME_DIRECTORY + "scores.dat");
-    if (file.fail())
-        throw invalid_argument("Failed to open save file at: " + GAME_DIRECTORY + "scores.dat");
-
-    // Read scores from the file
-    string line;
-    bool readNewLine{getline(file, line)};
-    while (readNewLine)
+    // Create a game for each score of the page, parsed once and kept until the score file changes
+    const auto scorePage{getScorePageCache().getPage(page, numPerPage)};
+    scores.reserve(scorePage->records.size());
+    for (const auto &record : scorePage->records)
     {
-        try
-        {
-            // Parse game
-            size_t leftIndex{};
-            size_t rightIndex{line.find('-')};
-            string playerName = line.substr(leftIndex, rightIndex);
-            updateSeparatorIndices(line, leftIndex, rightIndex);
-            int boardWidth = stoi(line.substr(leftIndex, rightIndex - leftIndex));
-            updateSeparatorIndices(line, leftIndex, rightIndex);
-            int boardHeight = stoi(line.substr(leftIndex, rightIndex - leftIndex));
-            updateSeparatorIndices(line, leftIndex, rightIndex);
-            double gameSpeed = stoi(line.substr(leftIndex, rightIndex - leftIndex));
-            updateSeparatorIndices(line, leftIndex, rightIndex);
-            int snakeLength = stoi(line.substr(leftIndex, rightIndex - leftIndex));
-            updateSeparatorIndices(line, leftIndex, rightIndex);
-            int score = stoi(line.substr(leftIndex, rightIndex - leftIndex));
-
-            // Create game and add it to the vector
-            scores.push_back(Game(make_unique<Board>(boardWidth, boardHeight), make_unique<Snake>(Point(), snakeLength), gameSpeed, playerName));
-
-            // Read next line
-            readNewLine = static_cast<bool>(getline(file, line));
-
-            // If there is another line to parse and the page
-            if (scores.size() == numPerPage && readNewLine)
-            {
-                // If the page of games we've loaded belong to the requested page, break
-                if (currentPage == page)
-                    break;
-
-                // Otherwise, increment current page number and clear data from the vector to return
-                scores.clear();
-                ++currentPage;
-            }
-
-            if (!readNewLine && currentPage != page)
-            {
-                throw out_of_range("Last page is " + to_string(currentPage));
-            }
-        }
-        catch (const invalid_argument &exception)
-        {
-            PLOGE << "An error occurred while parsing one game score: " << exception.what();
-            continue;
-        }
+        scores.push_back(Game(make_unique<Board>(record.width, record.height), make_unique<Snake>(Point(), record.snakeLength), record.gameSpeed, record.playerName));
+        scores.back().setScore(record.score);
     }
 
-    // Close the file
-    file.close();
+    if (scorePage->malformed > 0)
+        PLOGE << "Skipped " << scorePage->malformed << " malformed game scores";
+    if (scorePage->page != page)
+        throw out_of_range("Last page is " + to_string(scorePage->page));
+}
+
+future<vector<Game>> FileService::loadScoresTask(int page, int numPerPage)
+{
+    return getIoWorker().submit([page, numPerPage]
+                                {
+                                    vector<Game> scores;
+                                    loadScores(scores, page, numPerPage);
+                                    return scores; });
+}
+
+future<void> FileService::prefetchScoresTask(int page, int numPerPage)
+{
+    return getIoWorker().submit([page, numPerPage]
+                                {
+                                    // A missing score file is reported when the page is shown
+                                    try
+                                    {
+                                        getScorePageCache().getPage(page, numPerPage);
+                                    }
+                                    catch (const invalid_argument &)
+                                    {
+                                    } });
 }
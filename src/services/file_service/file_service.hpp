@@ -2,18 +2,22 @@
 #define FILE_SERVICE_H
 
 #include "game.hpp"
+#include "leaderboard_index.hpp"
+#include "replay_archive.hpp"
+#include <cstdint>
+#include <future>
 #include <vector>
 #include <memory>
 
+/**
+ * @brief Reads and writes the settings and score files
+ *
+ * @note The Task functions queue the operation on a file thread shared by the whole program and return its future,
+ * operations run one at a time in the order they were queued. Score pages are parsed once and kept until the score
+ * file changes, so showing a page that was shown or prefetched doesn't read the file.
+ */
 class FileService
 {
-private:
-    static inline void updateSeparatorIndices(const std::string &line, size_t &left, size_t &right)
-    {
-        left = right + 1;
-        right = line.find('-', left);
-    }
-
 public:
     /**
      * @brief Save the settings of the last game
@@ -24,12 +28,50 @@ public:
     static void saveSettings(const Game &game);
 
     /**
-     * @brief Saves the game score
+     * @brief Saves the settings of the last game on the file thread
      *
-     * @param game The game to save
-     * @throws std::invalid_argument
+     * @param game The game to save the settings of, read before returning
+     * @return std::future<void> Throws std::invalid_argument if the file can't be written
+     */
+    static std::future<void> saveSettingsTask(const Game &game);
+
+    /**
+     * @brief Saves the game score on the file thread
+     *
+     * @note Scores are appended to the score journal, so any number of games and processes can save at once, and
+     * counted in the leaderboard if it is loaded
+     * @param game The game to save, read before returning
+     * @param replayId The index of the game's replay in the replay archive, -1 if it has none
+     * @return std::future<void> Throws std::runtime_error if the score journal can't be written
+     */
+    static std::future<void> saveScoreTask(const Game &game, std::int64_t replayId = -1);
+
+    /**
+     * @brief Reads the saved scores into the leaderboard once on the file thread, so games can be ranked without
+     * reading the file
+     *
+     * @note Logs a warning and leaves games unranked if the score file can't be read. Scores saved through the file
+     * thread before or after are ranked too.
+     * @return std::future<void> Ready once the leaderboard is loaded
+     */
+    static std::future<void> loadLeaderboardTask();
+
+    /**
+     * @brief Get where the game's score places among the saved scores of the same board and speed
+     *
+     * @param game The game
+     * @return LeaderboardRank A rank of 0 if the leaderboard isn't loaded
+     */
+    static LeaderboardRank getRank(const Game &game);
+
+    /**
+     * @brief Appends a game's replay to the replay archive
+     *
+     * @param replay The replay to save
+     * @throws std::runtime_error Thrown if the replay archive can't be written
+     * @return std::int64_t The replay's index, to link its score to
      */
-    static void saveScore(const Game &game);
+    static std::int64_t saveReplay(const Replay &replay);
 
     /**
      * @brief Check if settings file exists
@@ -44,6 +86,13 @@ public:
      */
     static std::unique_ptr<Game> loadSettings();
 
+    /**
+     * @brief Loads the last settings used on the file thread
+     *
+     * @return std::future<std::unique_ptr<Game>> Throws std::invalid_argument if the file can't be read
+     */
+    static std::future<std::unique_ptr<Game>> loadSettingsTask();
+
     /**
      * @brief Load the saved scores by page
      *
@@ -52,6 +101,20 @@ public:
      * @return std::vector<Game> The saved game scores
      */
     static void loadScores(std::vector<Game> &scores, const int page = 0, const int numPerPage = 5);
+
+    /**
+     * @brief Loads the saved scores by page on the file thread
+     *
+     * @return std::future<std::vector<Game>> Throws like loadScores, without the last existing page
+     */
+    static std::future<std::vector<Game>> loadScoresTask(int page = 0, int numPerPage = 5);
+
+    /**
+     * @brief Parses a page of saved scores on the file thread so showing it doesn't read the file
+     *
+     * @return std::future<void> Ready once the page is cached, errors are ignored
+     */
+    static std::future<void> prefetchScoresTask(int page, int numPerPage = 5);
 };
 
 #endif
\ No newline at end of file
@@ -2,37 +2,36 @@
 #include "direction.hpp"
 #include "utility.hpp"
 #include "file_service.hpp"
+#include "latency_service.hpp"
+#include "game_stepper.hpp"
+#include "step_message.hpp"
+#include "config.hpp"
+#include "startup_timer.hpp"
 #include "SFML/Window.hpp"
+#include "plog/Log.h"
 #include <stdexcept>
 #include <memory>
+#include <chrono>
+#include <string>
 
 constexpr auto &KEYP = sf::Keyboard::isKeyPressed;
 using enum sf::Keyboard::Key;
 using namespace std;
 
-void GameService::updateAppleLocation()
-{
-    // Null check
-    if (!game)
-        throw invalid_argument("game is null");
-
-    // Set the apple to a new location
-    game->setApple(game->getRandomVacantPoint());
-}
-
 void GameService::render()
 {
     // Null check
     if (!game)
         throw invalid_argument("game is null");
 
-    // Render the board
-    string string;
+    // Render the board, copying it into the frame kept between renders
     {
         const lock_guard<mutex> lock(updateMutex);
-        string = game->toString();
+        frame.assign(game->toString());
+        latencyService.onFrameBuilt();
     }
-    Utility::printSafe(string, true);
+    Utility::printSafe(frame, true);
+    latencyService.onFrameWritten();
 }
 
 void GameService::processLogic()
@@ -44,38 +43,63 @@ void GameService::processLogic()
     // Ensure thread safe updates
     const lock_guard<mutex> lock(updateMutex);
 
-    // Get the destination point
-    const Point destination{game->getSnake().getHead().getAdjacentPoint(inputDirection)};
-
     static short lastAte{0};
 
-    // Handle snake movement
-    if (destination == game->getApple())
+    // Take back the ticks asked for in practice mode instead of stepping
+    if (const int requests{rewindRequests.exchange(0)}; requests > 0 && rewindBuffer)
     {
-        updateAppleLocation();
-        game->getSnake().grow(inputDirection);
-        game->setScore(game->getScore() + 10);
-        game->setMessage("YUM!!!");
-        lastAte = 3;
-    }
-    else if (game->getSnake().isInSnake(destination) && game->getSnake().getTail() != destination)
-    {
-        game->getSnake().crash(inputDirection);
-        game->setMessage("GAMEOVER!\n\nYou ate your tail!");
+        if (const size_t rewound{rewindBuffer->rewind(static_cast<size_t>(requests) * PRACTICE_REWIND_TICKS)}; rewound > 0)
+        {
+            if (isRecordingReplay)
+                replay.truncateMoves(replay.moveCount - rewound);
+            reachability->rebuild(game->getSnake());
+            updateRank();
+            game->setMessage("REWOUND!");
+            lastAte = 3;
+
+            // The turns queued were for the snake before the rewind and are dropped, the next ones are validated
+            // against the restored snake
+            rewoundDirection = game->getSnake().getDirection();
+            ++rewindGeneration;
+            return;
+        }
     }
-    else if (!game->getBoard().isInBoard(destination))
+
+    // Consume at most one queued direction change per tick, skipping the ones queued before the last rewind, the
+    // bot's move replaces it
+    Directions::Direction inputDirection{game->getSnake().getDirection()};
+    DirectionInput input;
+    bool hasInput{false};
+    while (!hasInput && inputQueue.pop(input))
+        hasInput = input.rewindGeneration == rewindGeneration.load(memory_order_relaxed);
+    if (hasInput && !botIsPlaying)
     {
-        game->getSnake().crash(inputDirection);
-        game->setMessage("GAMEOVER!\n\nYou hit the wall!");
+        inputDirection = input.direction;
+        latencyService.onApplied(LatencyService::Clock::time_point(LatencyService::Clock::duration(input.timestamp)));
     }
-    else
+    if (botIsPlaying)
+        inputDirection = botPolicy->decide(*game);
+
+    // Apply the game rules and update the message
+    const StepOutcome outcome{rewindBuffer ? rewindBuffer->step(inputDirection) : stepper->step(inputDirection)};
+    reachability->update(game->getSnake());
+    if (isRecordingReplay)
+        replay.addMove(inputDirection);
+    showStepMessage(*game, outcome, *reachability, lastAte);
+
+    // Rank the new score and make room for the moves until the next apple now, so the ticks moving toward it don't
+    // allocate
+    if (outcome == StepOutcome::ATE)
     {
-        if (lastAte > 0)
-            --lastAte;
-        else
-            game->setMessage("");
-        game->getSnake().move(inputDirection);
+        updateRank();
+        if (isRecordingReplay)
+            replay.reserveMoves();
     }
+
+    StartupTimer::mark(StartupTimer::Milestone::FIRST_STEP);
+
+    // Record the tick for offline datasets
+    dumpObservation();
 }
 
 void GameService::processInput()
@@ -105,15 +129,46 @@ void GameService::processInput()
         justChanged = false;
     }
 
-    // Update direction moving
-    if (KEYP(W) && game->getSnake().getDirection() != Directions::Direction::DOWN)
-        inputDirection = Directions::Direction::UP;
-    if (KEYP(D) && game->getSnake().getDirection() != Directions::Direction::LEFT)
-        inputDirection = Directions::Direction::RIGHT;
-    if (KEYP(S) && game->getSnake().getDirection() != Directions::Direction::UP)
-        inputDirection = Directions::Direction::DOWN;
-    if (KEYP(A) && game->getSnake().getDirection() != Directions::Direction::RIGHT)
-        inputDirection = Directions::Direction::LEFT;
+    // Queue a direction change on each key press
+    const auto queueKey = [this](bool isPressed, bool &wasPressed, Directions::Direction direction)
+    {
+        if (isPressed && !wasPressed)
+            queueDirection(direction);
+        wasPressed = isPressed;
+    };
+    queueKey(KEYP(W), directionKeysPressed[0], Directions::Direction::UP);
+    queueKey(KEYP(D), directionKeysPressed[1], Directions::Direction::RIGHT);
+    queueKey(KEYP(S), directionKeysPressed[2], Directions::Direction::DOWN);
+    queueKey(KEYP(A), directionKeysPressed[3], Directions::Direction::LEFT);
+
+    // Ask the logic thread to rewind on each press in practice mode
+    const bool isRewindPressed{KEYP(R)};
+    if (isRewindPressed && !rewindKeyPressed)
+        requestRewind();
+    rewindKeyPressed = isRewindPressed;
+}
+
+bool GameService::queueDirection(Directions::Direction direction)
+{
+    // Validate against the last queued direction, the snake turns after the directions queued before. After a
+    // rewind it turns from the restored direction, stored before the generation was bumped.
+    if (const unsigned generation{rewindGeneration.load()}; generation != seenRewindGeneration)
+    {
+        lastQueuedDirection = rewoundDirection.load();
+        seenRewindGeneration = generation;
+    }
+    if (direction == lastQueuedDirection || Directions::areOppositeDirections(lastQueuedDirection, direction))
+        return false;
+    if (!inputQueue.push(DirectionInput{direction, LatencyService::now().time_since_epoch().count(), seenRewindGeneration}))
+        return false;
+    lastQueuedDirection = direction;
+    return true;
+}
+
+void GameService::requestRewind()
+{
+    if (practiceHistoryLength > 0)
+        ++rewindRequests;
 }
 
 void GameService::createProcessInputTask()
@@ -157,28 +212,113 @@ void GameService::createRenderTask()
 
 void GameService::saveScore(const string &playerName)
 {
+    if (!canSaveScore())
+        throw runtime_error("practice and bot games can't be saved");
+
     auto fileService{make_unique<FileService>()};
     game->setPlayerName(playerName);
-    fileService->saveScore(*game);
+
+    // Link the score to the game's replay, the score is saved without one if the replay can't be
+    int64_t replayId{-1};
+    if (isRecordingReplay)
+    {
+        replay.score = game->getScore();
+        try
+        {
+            replayId = fileService->saveReplay(replay);
+        }
+        catch (const exception &exception)
+        {
+            PLOGW << "Unable to save the replay " << exception.what();
+        }
+    }
+
+    // Append on the file thread, after a leaderboard load still reading the file, so the score is ranked
+    FileService::saveScoreTask(*game, replayId).get();
+}
+
+void GameService::updateRank()
+{
+    const LeaderboardRank rank{FileService::getRank(*game)};
+    game->setRank(rank.rank, rank.scoreCount + 1);
 }
 
 void GameService::saveSettings()
 {
-    auto fileService{make_unique<FileService>()};
-    fileService->saveSettings(*game);
+    // Written on the file thread, settings loaded later are read after it
+    FileService::saveSettingsTask(*game);
 }
 
 void GameService::startNewGame(int boardWidth, int boardHeight, int snakeLength, double gameSpeed)
+{
+    setUpGame(boardWidth, boardHeight, snakeLength, gameSpeed);
+    playGame();
+}
+
+void GameService::setUpGame(int boardWidth, int boardHeight, int snakeLength, double gameSpeed)
 {
     // Check if game is still running
     if (game && !game->isGameOver())
         throw runtime_error("game is still in progress");
 
-    // Create the game and start it
-    startNewGame(make_unique<Game>(make_unique<Board>(boardWidth, boardHeight), make_unique<Snake>(Point(snakeLength, boardHeight), snakeLength), gameSpeed));
+    // A bot plays on the board it was trained on
+    if (botPolicy && !mapPack)
+    {
+        boardWidth = botPolicy->getWidth();
+        boardHeight = botPolicy->getHeight();
+    }
+
+    // Create the game on the map if one is set, otherwise on an empty board laid out again only when its size changes
+    if (mapPack)
+        setUpGame(make_unique<Game>(make_unique<Board>(*newGameBoard), mapPack->createSnake(mapIndex, snakeLength), gameSpeed));
+    else
+    {
+        if (!newGameBoard || newGameBoard->getWidth() != boardWidth || newGameBoard->getHeight() != boardHeight)
+            newGameBoard = make_unique<Board>(boardWidth, boardHeight);
+        setUpGame(make_unique<Game>(make_unique<Board>(*newGameBoard), make_unique<Snake>(Point(snakeLength, boardHeight), snakeLength), gameSpeed));
+    }
+}
+
+void GameService::setMap(const string &path, size_t index)
+{
+    try
+    {
+        // Load the map once up front so a bad map is reported before playing, its games copy the board
+        auto pack{make_unique<MapPack>(path)};
+        const MapInfo info{pack->getMapInfo(index)};
+        auto board{pack->createBoard(index)};
+        PLOGI << "Playing map " << info.name << " (" << info.width << 'x' << info.height << ") from " << path;
+        mapPack = std::move(pack);
+        mapIndex = index;
+        newGameBoard = std::move(board);
+    }
+    catch (const exception &exception)
+    {
+        PLOGW << "Unable to load map " << index << " from " << path << " " << exception.what();
+    }
+}
+
+void GameService::setBotPolicy(const string &path)
+{
+    try
+    {
+        auto policy{make_unique<Policy>(path)};
+        PLOGI << "Playing with the policy " << path << " (" << policy->getWidth() << 'x' << policy->getHeight() << ") using " << getSimdLevelName(policy->getSimdLevel());
+        botPolicy = std::move(policy);
+    }
+    catch (const exception &exception)
+    {
+        PLOGW << "Unable to load policy " << path << " " << exception.what();
+    }
 }
 
 void GameService::startNewGame(unique_ptr<Game> game)
+{
+    setUpGame(std::move(game));
+    playGame();
+}
+
+void GameService::setUpGame(unique_ptr<Game> game)
 {
     // Check if game is still running
     if (this->game && !this->game->isGameOver())
@@ -187,6 +327,49 @@ void GameService::startNewGame(unique_ptr<Game> game)
     // Start the passed game
     this->game = std::move(game);
 
+    // Size the game's storage so ticks don't allocate
+    this->game->reserve();
+    frame.reserve(this->game->toString().capacity());
+
+    // Rank the game among the saved scores, unranked until the file thread has loaded them
+    updateRank();
+
+    // Create the stepper specialized for the board size and label the free regions
+    stepper = makeGameStepper(*this->game);
+    reachability = make_unique<Reachability>(this->game->getBoard(), this->game->getSnake());
+
+    // Keep the last ticks for rewinding in practice mode
+    rewindBuffer.reset();
+    if (practiceHistoryLength > 0)
+        rewindBuffer = make_unique<RewindBuffer>(*this->game, *stepper, practiceHistoryLength);
+
+    // Record the moves if the game can be started again from its settings and seed
+    isRecordingReplay = startReplay(*this->game, replay);
+    if (isRecordingReplay)
+        replay.reserveMoves();
+
+    // Let the bot play if the board is the one it was trained on
+    botIsPlaying = botPolicy && botPolicy->getWidth() == this->game->getBoard().getWidth() && botPolicy->getHeight() == this->game->getBoard().getHeight();
+    if (botPolicy && !botIsPlaying)
+        PLOGW << "The policy plays on " << botPolicy->getWidth() << 'x' << botPolicy->getHeight() << " boards, playing with the keyboard instead";
+
+    // Start dumping observations if requested
+    startObservationDump();
+
+    // Reset the input and latency state of the previous game
+    latencyService = LatencyService{};
+    inputQueue.clear();
+    lastQueuedDirection = this->game->getSnake().getDirection();
+    directionKeysPressed.fill(false);
+    rewindRequests = 0;
+    rewoundDirection = lastQueuedDirection;
+    rewindGeneration = 0;
+    seenRewindGeneration = 0;
+    rewindKeyPressed = false;
+}
+
+void GameService::playGame()
+{
     // Set the start message
     this->game->setMessage("Welcome to\nSnake!\n\nMove the snake around the board, and eat as many apples as you can\n\nAvoid the walls and yourself\n\nWhen you crash, it's gameover!");
 
@@ -210,4 +393,69 @@ void GameService::startNewGame(unique_ptr<Game> game)
     processInputTask.wait();
     processLogicTask.wait();
     renderTask.wait();
+
+    // Export the input latency measured during the game
+    exportLatency();
+
+    // Finish the observation dump
+    if (observationDump)
+    {
+        PLOGI << "Dumped " << observationDump->getSampleCount() << " observations";
+        observationDump->close();
+        observationDump.reset();
+    }
+}
+
+void GameService::startObservationDump()
+{
+    observationDump.reset();
+    if (observationDumpDirectory.empty())
+        return;
+
+    const int width{game->getBoard().getWidth()};
+    const int height{game->getBoard().getHeight()};
+    observationWriter = make_unique<ObservationWriter>(width, height);
+    observation.resize(observationWriter->getObservationSize());
+
+    // One file per game named by its start time
+    const auto startTime{chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count()};
+    const auto path{observationDumpDirectory + "/observations_" + to_string(startTime) + ".npy"};
+    try
+    {
+        observationDump = make_unique<NpyWriter>(path, NpyWriter::DataType::UINT8, vector<size_t>{static_cast<size_t>(observationWriter->getPlaneCount()), static_cast<size_t>(height + 1), static_cast<size_t>(width + 1)});
+        PLOGI << "Dumping observations to " << path;
+    }
+    catch (const invalid_argument &exception)
+    {
+        PLOGW << "Unable to dump observations " << exception.what();
+        return;
+    }
+
+    // The first observation is the starting position
+    observationWriter->write(*game, observation.data());
+    observationDump->append(observation.data());
+}
+
+void GameService::dumpObservation()
+{
+    if (!observationDump)
+        return;
+    observationWriter->update(*game, observation.data());
+    observationDump->append(observation.data());
+}
+
+void GameService::exportLatency()
+{
+    PLOGI << "Input to logic latency: " << latencyService.getSummary(LatencyService::Stage::INPUT_TO_LOGIC);
+    PLOGI << "Logic to display latency: " << latencyService.getSummary(LatencyService::Stage::LOGIC_TO_DISPLAY);
+    PLOGI << "Input to display latency: " << latencyService.getSummary(LatencyService::Stage::INPUT_TO_DISPLAY);
+    try
+    {
+        SnakeConfig::ensureGameDirectories();
+        latencyService.exportDistribution(SnakeConfig::getGameDirectory() + "logs/latency.csv");
+    }
+    catch (const invalid_argument &exception)
+    {
+        PLOGW << "Unable to export input latency " << exception.what();
+    }
 }
@@ -3,20 +3,86 @@
 
 #include "file_service.hpp"
 #include "game.hpp"
+#include "game_stepper.hpp"
+#include "reachability.hpp"
+#include "latency_service.hpp"
+#include "observation.hpp"
+#include "npy_writer.hpp"
+#include "map_pack.hpp"
+#include "policy.hpp"
+#include "replay_archive.hpp"
+#include "rewind_buffer.hpp"
+#include "spsc_queue.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
 #include <future>
 #include <stdexcept>
 #include <memory>
 
 constexpr int TIME_BETWEEN_RENDER_MILLISECONDS = 1.0 / 20.0 * 1000.0;
 
+/**
+ * @brief The ticks taken back by each press of the rewind key in practice mode
+ *
+ */
+constexpr int PRACTICE_REWIND_TICKS = 10;
+
+/**
+ * @brief A direction change read from the keyboard
+ *
+ */
+struct DirectionInput
+{
+    /**
+     * @brief The direction to turn to
+     *
+     */
+    Directions::Direction direction{Directions::Direction::RIGHT};
+
+    /**
+     * @brief The time the key press was read
+     *
+     */
+    LatencyService::Clock::rep timestamp{0};
+
+    /**
+     * @brief The rewinds taken when the key was pressed, the input is dropped if the snake was rewound since
+     *
+     */
+    unsigned rewindGeneration{0};
+};
+
 class GameService
 {
 private:
     /**
-     * @brief The direction the snake will move/grow next
+     * @brief The direction changes waiting for a logic tick, one is consumed per tick
+     *
+     */
+    SpscQueue<DirectionInput, 4> inputQueue;
+
+    /**
+     * @brief The last direction queued, used to validate the next key press
      *
+     * @note Only used by the input thread
      */
-    std::atomic<Directions::Direction> inputDirection{Directions::Direction::RIGHT};
+    Directions::Direction lastQueuedDirection{Directions::Direction::RIGHT};
+
+    /**
+     * @brief Whether each direction key (W, D, S, A) was held during the last input poll
+     *
+     * @note Only used by the input thread
+     */
+    std::array<bool, 4> directionKeysPressed{};
+
+    /**
+     * @brief Measures the input to display latency of the game
+     *
+     */
+    LatencyService latencyService;
 
     /**
      * @brief Whether or not the game is paused
@@ -54,6 +120,119 @@ private:
      */
     std::unique_ptr<Game> game;
 
+    /**
+     * @brief The last frame rendered, reused so rendering doesn't allocate
+     *
+     */
+    std::string frame;
+
+    /**
+     * @brief Applies the game rules, specialized for the board size when the game starts
+     *
+     */
+    std::unique_ptr<GameStepper> stepper;
+
+    /**
+     * @brief The free regions around the snake, for telling the player they are trapped
+     *
+     */
+    std::unique_ptr<Reachability> reachability;
+
+    /**
+     * @brief The folder observations are dumped to, empty when not dumping
+     *
+     */
+    std::string observationDumpDirectory;
+
+    /**
+     * @brief Writes the observation of each tick and the file it is dumped to
+     *
+     */
+    std::unique_ptr<ObservationWriter> observationWriter;
+    std::unique_ptr<NpyWriter> observationDump;
+    std::vector<std::uint8_t> observation;
+
+    /**
+     * @brief The map pack new games are played on and the map picked from it, null for empty boards
+     *
+     */
+    std::unique_ptr<MapPack> mapPack;
+    std::size_t mapIndex{0};
+
+    /**
+     * @brief The board new games are copies of, so they share its neighbour table and string, null before the first
+     *
+     * @note The map's board once a map is set, otherwise the empty board of the last game's size
+     */
+    std::unique_ptr<Board> newGameBoard;
+
+    /**
+     * @brief The policy steering the snake instead of the keyboard, null for human players
+     *
+     */
+    std::unique_ptr<Policy> botPolicy;
+
+    /**
+     * @brief Whether the policy plays the current game, false if its board isn't the policy's size
+     *
+     */
+    bool botIsPlaying{false};
+
+    /**
+     * @brief The ticks kept for rewinding in practice mode, 0 when not practicing
+     *
+     */
+    std::size_t practiceHistoryLength{0};
+
+    /**
+     * @brief Steps the game and keeps its last ticks in practice mode, null when not practicing
+     *
+     */
+    std::unique_ptr<RewindBuffer> rewindBuffer;
+
+    /**
+     * @brief The rewind key presses waiting for a logic tick
+     *
+     */
+    std::atomic<int> rewindRequests{0};
+
+    /**
+     * @brief The direction of the snake restored by the last rewind
+     *
+     * @note Set by the logic thread before it bumps rewindGeneration, the input thread validates the following key
+     * presses against it
+     */
+    std::atomic<Directions::Direction> rewoundDirection{Directions::Direction::RIGHT};
+
+    /**
+     * @brief The rewinds taken in the current game, queued inputs tagged with an older count are dropped
+     *
+     * @note Only bumped by the logic thread
+     */
+    std::atomic<unsigned> rewindGeneration{0};
+
+    /**
+     * @brief The rewinds the input thread last validated key presses after
+     *
+     * @note Only used by the input thread
+     */
+    unsigned seenRewindGeneration{0};
+
+    /**
+     * @brief Whether the rewind key (R) was held during the last input poll
+     *
+     * @note Only used by the input thread
+     */
+    bool rewindKeyPressed{false};
+
+    /**
+     * @brief The moves of the current game, saved with its score
+     *
+     * @note Only games on empty walled boards are recorded, the ones a replay can start again
+     */
+    Replay replay;
+    bool isRecordingReplay{false};
+
 public:
     /**
      * @brief Get the Game object
@@ -71,14 +250,104 @@ public:
      * @brief Saves the score with the provided player name
      *
      * @param playerName The player name to associate with the saved score
+     * @throws std::runtime_error If the game was played in practice mode or by the bot
      */
     void saveScore(const std::string &playerName);
 
     /**
-     * @brief Saves the settings of the game
+     * @brief Returns whether the score of the current game can be saved, false for practice and bot games
+     *
+     * @note Rewinds and the bot's moves would put scores on the leaderboard that weren't played
+     */
+    bool canSaveScore() const { return !rewindBuffer && !botIsPlaying; }
+
+    /**
+     * @brief Saves the settings of the game on the file thread, without waiting for them to be written
      */
     void saveSettings();
 
+    /**
+     * @brief Dumps the observation of every tick of the following games to a .npy file per game
+     *
+     * @param directory The folder to create the files in, empty to stop dumping
+     */
+    void setObservationDumpDirectory(const std::string &directory) { observationDumpDirectory = directory; }
+
+    /**
+     * @brief Plays the following new games on a map of a map pack instead of an empty board
+     *
+     * @note Logs a warning and keeps empty boards if the map can't be loaded
+     * @param path The map pack file
+     * @param index The map, starting at 0
+     */
+    void setMap(const std::string &path, std::size_t index);
+
+    /**
+     * @brief Returns whether new games are played on a map, whose size is then fixed
+     *
+     */
+    bool hasMap() const { return mapPack != nullptr; }
+
+    /**
+     * @brief Lets a policy play the following new games instead of the keyboard
+     *
+     * @note Logs a warning and keeps the keyboard if the policy can't be loaded. New games on empty boards are the
+     * size of the policy's board.
+     * @param path The policy file
+     */
+    void setBotPolicy(const std::string &path);
+
+    /**
+     * @brief Returns whether a policy plays new games, whose size is then fixed
+     *
+     */
+    bool hasBotPolicy() const { return botPolicy != nullptr; }
+
+    /**
+     * @brief Plays the following new games in practice mode, where R takes back the last PRACTICE_REWIND_TICKS ticks
+     *
+     * @param historyLength The most ticks kept for rewinding, 0 to stop practicing
+     */
+    void setPracticeHistoryLength(std::size_t historyLength) { practiceHistoryLength = historyLength; }
+
+    /**
+     * @brief Sets up a new game without playing it, for driving it tick by tick with queueDirection and processLogic
+     *
+     * @param game The game, which must not have been stepped
+     */
+    void setUpGame(std::unique_ptr<Game> game);
+
+    /**
+     * @brief Creates a new game the way startNewGameTask does and sets it up without playing it
+     *
+     * @param boardWidth
+     * @param boardHeight
+     * @param snakeLength
+     * @param gameSpeed
+     */
+    void setUpGame(int boardWidth, int boardHeight, int snakeLength, double gameSpeed);
+
+    /**
+     * @brief Queues a direction change for the following logic ticks, from the input thread
+     *
+     * @param direction The direction to turn to
+     * @return true if it was queued
+     * @return false if it is the last direction queued or its opposite, or the queue is full
+     */
+    bool queueDirection(Directions::Direction direction);
+
+    /**
+     * @brief Asks the next logic tick to take back PRACTICE_REWIND_TICKS ticks, ignored when not practicing
+     *
+     */
+    void requestRewind();
+
+    /**
+     * @brief Processes all the logic of the game for a given tick
+     *
+     */
+    void processLogic();
+
     /**
      * @brief Creates and starts a new game using previous settings and returns a task
      *
@@ -87,8 +356,7 @@ public:
      */
     std::future<void> startNewGameTask()
     {
-        auto fileService{std::make_unique<FileService>()};
-        auto settings = fileService->loadSettings();
+        auto settings = FileService::loadSettingsTask().get();
         return std::async(static_cast<void (GameService::*)(std::unique_ptr<Game>)>(&GameService::startNewGame), this, std::move(settings));
     }
 
@@ -126,16 +394,17 @@ private:
     void startNewGame(const int boardWidth, const int boardHeight, const int snakeLength, const double gameSpeed);
 
     /**
-     * @brief Updates the location of the apple
+     * @brief Plays the game set up, waiting for a key press to start it
      *
+     * @note This function blocks while the game is running and exits when the game ends
      */
-    void updateAppleLocation();
+    void playGame();
 
     /**
-     * @brief Processes all the logic of the game for a given tick
+     * @brief Shows the rank of the game's score among the saved scores of the same board and speed
      *
      */
-    void processLogic();
+    void updateRank();
 
     /**
      * @brief Renders the game board
@@ -149,6 +418,24 @@ private:
      */
     void processInput();
 
+    /**
+     * @brief Logs the measured input latency and exports its distribution to the logs folder
+     *
+     */
+    void exportLatency();
+
+    /**
+     * @brief Creates the observation dump for the game if dumping is enabled
+     *
+     */
+    void startObservationDump();
+
+    /**
+     * @brief Appends the observation of the current tick to the dump
+     *
+     */
+    void dumpObservation();
+
     /**
      * @brief Create a Process Input Task object
      *
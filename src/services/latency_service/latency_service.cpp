@@ -0,0 +1,123 @@
+#include "latency_service.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+constexpr double BUCKET_GROWTH{1.05};
+
+int LatencyService::getBucket(int64_t microseconds)
+{
+    if (microseconds <= 1)
+        return 0;
+    const int bucket{static_cast<int>(ceil(log(static_cast<double>(microseconds)) / log(BUCKET_GROWTH)))};
+    return min(bucket, BUCKET_COUNT - 1);
+}
+
+int64_t LatencyService::getBucketUpperBound(int bucket)
+{
+    return static_cast<int64_t>(ceil(pow(BUCKET_GROWTH, bucket)));
+}
+
+void LatencyService::addSample(Stage stage, Clock::duration duration)
+{
+    const auto microseconds{chrono::duration_cast<chrono::microseconds>(duration).count()};
+    const auto index{static_cast<int>(stage)};
+    ++histograms[index][getBucket(microseconds)];
+    maxMicroseconds[index] = max(maxMicroseconds[index], microseconds);
+}
+
+void LatencyService::onApplied(Clock::time_point inputTime)
+{
+    const auto appliedTime{now()};
+    addSample(Stage::INPUT_TO_LOGIC, appliedTime - inputTime);
+
+    // Wait for the frame that reflects the input
+    if (appliedCount < MAX_PENDING)
+        applied[appliedCount++] = AppliedInput{inputTime, appliedTime};
+}
+
+void LatencyService::onFrameBuilt()
+{
+    // Inputs still in a frame that was never written are carried over
+    for (int index{0}; index < appliedCount && inFrameCount < MAX_PENDING; ++index)
+        inFrame[inFrameCount++] = applied[index];
+    appliedCount = 0;
+}
+
+void LatencyService::onFrameWritten()
+{
+    const auto writtenTime{now()};
+    for (int index{0}; index < inFrameCount; ++index)
+    {
+        addSample(Stage::LOGIC_TO_DISPLAY, writtenTime - inFrame[index].appliedTime);
+        addSample(Stage::INPUT_TO_DISPLAY, writtenTime - inFrame[index].inputTime);
+    }
+    inFrameCount = 0;
+}
+
+uint64_t LatencyService::getSampleCount(Stage stage) const
+{
+    const auto &histogram{histograms[static_cast<int>(stage)]};
+    uint64_t count{0};
+    for (const auto bucketCount : histogram)
+        count += bucketCount;
+    return count;
+}
+
+int64_t LatencyService::getPercentile(Stage stage, double percentile) const
+{
+    const auto count{getSampleCount(stage)};
+    if (count == 0)
+        return 0;
+
+    // Walk the buckets until the requested rank is covered
+    const auto &histogram{histograms[static_cast<int>(stage)]};
+    const auto rank{static_cast<uint64_t>(ceil(percentile / 100.0 * count))};
+    uint64_t seen{0};
+    for (int bucket{0}; bucket < BUCKET_COUNT; ++bucket)
+    {
+        seen += histogram[bucket];
+        if (seen >= max<uint64_t>(rank, 1))
+            return min(getBucketUpperBound(bucket), maxMicroseconds[static_cast<int>(stage)]);
+    }
+    return maxMicroseconds[static_cast<int>(stage)];
+}
+
+string LatencyService::getSummary(Stage stage) const
+{
+    stringstream summary;
+    summary << "samples=" << getSampleCount(stage)
+            << " p50=" << getPercentile(stage, 50) << "us"
+            << " p90=" << getPercentile(stage, 90) << "us"
+            << " p99=" << getPercentile(stage, 99) << "us"
+            << " max=" << maxMicroseconds[static_cast<int>(stage)] << "us";
+    return summary.str();
+}
+
+void LatencyService::exportDistribution(const string &path) const
+{
+    // Open the file and check for fail
+    ofstream file(path, ofstream::trunc);
+    if (file.fail())
+        throw invalid_argument("Failed to create latency file at: " + path);
+
+    // Write the non empty buckets
+    file << "bucket_upper_us,input_to_logic,logic_to_display,input_to_display\n";
+    for (int bucket{0}; bucket < BUCKET_COUNT; ++bucket)
+    {
+        if (histograms[0][bucket] == 0 && histograms[1][bucket] == 0 && histograms[2][bucket] == 0)
+            continue;
+        file << getBucketUpperBound(bucket) << ','
+             << histograms[0][bucket] << ','
+             << histograms[1][bucket] << ','
+             << histograms[2][bucket] << '\n';
+    }
+
+    // Close the file
+    file.close();
+}
@@ -0,0 +1,168 @@
+#ifndef LATENCY_SERVICE_H
+#define LATENCY_SERVICE_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Tracks how long a key press takes to travel through the game loop
+ *
+ * @note A key event is timestamped by the input thread, marked as applied by the logic thread and marked as
+ * displayed by the render thread once the frame that first reflects it has been written. onApplied and
+ * onFrameBuilt must be called while holding the game update mutex, onFrameWritten only from the render thread.
+ */
+class LatencyService
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief The stages a latency sample is measured between
+     *
+     */
+    enum class Stage
+    {
+        INPUT_TO_LOGIC,
+        LOGIC_TO_DISPLAY,
+        INPUT_TO_DISPLAY
+    };
+
+    /**
+     * @brief The number of logarithmic histogram buckets
+     *
+     * @note Buckets grow by 5% per step starting at 1 microsecond, covering roughly 10 seconds
+     */
+    constexpr static int BUCKET_COUNT{340};
+
+private:
+    /**
+     * @brief An input event that has been applied by the logic thread but not yet displayed
+     *
+     */
+    struct AppliedInput
+    {
+        Clock::time_point inputTime;
+        Clock::time_point appliedTime;
+    };
+
+    /**
+     * @brief The max number of applied inputs that can wait for a frame
+     *
+     * @note Inputs applied beyond this between two frames are dropped from the measurement
+     */
+    constexpr static int MAX_PENDING{16};
+
+    /**
+     * @brief Inputs applied since the last frame was built
+     *
+     */
+    std::array<AppliedInput, MAX_PENDING> applied{};
+    int appliedCount{0};
+
+    /**
+     * @brief Inputs contained in the frame currently being written
+     *
+     */
+    std::array<AppliedInput, MAX_PENDING> inFrame{};
+    int inFrameCount{0};
+
+    /**
+     * @brief The histograms for each stage
+     *
+     */
+    std::array<std::array<std::uint64_t, BUCKET_COUNT>, 3> histograms{};
+
+    /**
+     * @brief The max latency seen for each stage in microseconds
+     *
+     */
+    std::array<std::int64_t, 3> maxMicroseconds{};
+
+    /**
+     * @brief Adds a sample to the histogram of the stage
+     *
+     * @param stage The stage measured
+     * @param duration The measured latency
+     */
+    void addSample(Stage stage, Clock::duration duration);
+
+public:
+    /**
+     * @brief Gets the current time for timestamping a key event
+     *
+     * @return Clock::time_point
+     */
+    static Clock::time_point now() { return Clock::now(); }
+
+    /**
+     * @brief Gets the bucket a latency belongs to
+     *
+     * @param microseconds The latency in microseconds
+     * @return int The bucket index
+     */
+    static int getBucket(std::int64_t microseconds);
+
+    /**
+     * @brief Gets the upper bound of a bucket in microseconds
+     *
+     * @param bucket The bucket index
+     * @return std::int64_t
+     */
+    static std::int64_t getBucketUpperBound(int bucket);
+
+    /**
+     * @brief Records that the logic thread applied a key event
+     *
+     * @param inputTime The time the key event was read
+     */
+    void onApplied(Clock::time_point inputTime);
+
+    /**
+     * @brief Records that a frame was built, it contains every input applied so far
+     *
+     */
+    void onFrameBuilt();
+
+    /**
+     * @brief Records that the frame built last was written to the display
+     *
+     */
+    void onFrameWritten();
+
+    /**
+     * @brief Gets the number of samples recorded for a stage
+     *
+     * @param stage The stage
+     * @return std::uint64_t
+     */
+    std::uint64_t getSampleCount(Stage stage) const;
+
+    /**
+     * @brief Gets the latency percentile for a stage
+     *
+     * @param stage The stage
+     * @param percentile The percentile between 0 and 100
+     * @return std::int64_t The upper bound of the bucket containing the percentile in microseconds
+     */
+    std::int64_t getPercentile(Stage stage, double percentile) const;
+
+    /**
+     * @brief Get a one line summary of the distribution of a stage
+     *
+     * @param stage The stage
+     * @return std::string
+     */
+    std::string getSummary(Stage stage) const;
+
+    /**
+     * @brief Writes the latency distribution as csv
+     *
+     * @param path The file to write
+     * @throws std::invalid_argument Thrown if the file can't be created
+     */
+    void exportDistribution(const std::string &path) const;
+};
+
+#endif
@@ -138,20 +138,8 @@ int MenuService::getInitialSnakeLength()
     }
 }
 
-bool MenuService::animationHasSafeMove() const
-{
-    Point head = menuGame->getSnake().getHead();
-    Point up = head.getAdjacentPoint(Directions::Direction::UP);
-    Point right = head.getAdjacentPoint(Directions::Direction::RIGHT);
-    Point down = head.getAdjacentPoint(Directions::Direction::DOWN);
-    Point left = head.getAdjacentPoint(Directions::Direction::LEFT);
-    return !menuGame->getSnake().isInSnake(up) && menuGame->getBoard().isInBoard(up) || !menuGame->getSnake().isInSnake(right) && menuGame->getBoard().isInBoard(right) || !menuGame->getSnake().isInSnake(down) && menuGame->getBoard().isInBoard(down) || !menuGame->getSnake().isInSnake(left) && menuGame->getBoard().isInBoard(left);
-}
-
 void MenuService::showScoresMenu()
 {
-    // Initialize file service
-    auto fileService{make_unique<FileService>()};
     auto scores{make_unique<vector<Game>>()};
     auto pageShowing{0};
 
@@ -163,20 +151,26 @@ void MenuService::showScoresMenu()
     // Run menu until break
     while (true)
     {
-        // Get scores by current page being viewed
+        // Get scores by current page being viewed, read on the file thread after the pages prefetched
         try
         {
             PLOGI << "Loading score page " + to_string(pageShowing);
-            fileService->loadScores(*scores, pageShowing);
+            *scores = FileService::loadScoresTask(pageShowing).get();
         }
         catch (out_of_range &exception)
         {
             PLOGW << "Score page " + to_string(pageShowing) + " does not exist. Showing page " + to_string(pageShowing - 1);
-            --pageShowing;
+            scores->clear();
+            if (pageShowing > 0)
+            {
+                --pageShowing;
+                continue;
+            }
         }
         catch (invalid_argument &exception)
         {
             PLOGW << "No saved scores file";
+            scores->clear();
             pageShowing = 0;
         }
 
@@ -198,6 +192,11 @@ void MenuService::showScoresMenu()
         // Display the scores
         menuGame->setMessage(stream.str());
 
+        // Parse the neighbouring pages while this one is shown so flipping to them doesn't read the file
+        if (pageShowing > 0)
+            FileService::prefetchScoresTask(pageShowing - 1);
+        FileService::prefetchScoresTask(pageShowing + 1);
+
         // Wait for user input
         while (!((userClosed = KEYP(Escape)) || (rightPressed = KEYP(Right)) || (leftPressed = KEYP(Left))))
             ;
@@ -220,40 +219,41 @@ void MenuService::showScoresMenu()
 void MenuService::playBoardAnimation()
 {
     isAnimationPlaying = true;
+
+    // The menu game may have been replaced while the animation was stopped
+    menuReachability.reset();
     while (isAnimationPlaying)
     {
         // Create a new game if last one was over
         if (!menuGame || menuGame->isGameOver())
+        {
+            menuReachability.reset();
             menuGame = make_unique<Game>(make_unique<Board>(50, 30), make_unique<Snake>(Point(5, 20), 5));
+        }
+        if (!menuReachability)
+            menuReachability = make_unique<Reachability>(menuGame->getBoard(), menuGame->getSnake());
 
-        // Declare vars
-        uniform_int_distribution next{0, 3};
-        bool hasSafeMove{animationHasSafeMove()};
-        Directions::Direction nextDirection;
-        Point destination;
-
-        // Find the next move
-        do
-        {
-            nextDirection = static_cast<Directions::Direction>(next(Utility::getRandom()));
-            destination = menuGame->getSnake().getHead().getAdjacentPoint(nextDirection);
-        } while (hasSafeMove && (menuGame->getSnake().isInSnake(destination) || !menuGame->getBoard().isInBoard(destination)));
+        // Find a random move that doesn't lead into a dead end, crashing if every move does
+        const auto move{menuReachability->pickMove(menuGame->getSnake(), menuGame->getRandom())};
+        const Directions::Direction nextDirection{move.value_or(static_cast<Directions::Direction>(menuGame->getRandom().bounded(4)))};
+        const Point destination{menuGame->getBoard().getNeighbour(menuGame->getSnake().getHead(), nextDirection)};
 
         // Make next move
-        if (!hasSafeMove)
+        if (!move)
         {
-            menuGame->getSnake().crash(nextDirection);
+            menuGame->getSnake().crash(nextDirection, destination);
         }
         else if (destination == menuGame->getApple())
         {
             menuGame->setApple(menuGame->getRandomVacantPoint());
-            menuGame->getSnake().grow(nextDirection);
+            menuGame->getSnake().grow(nextDirection, destination);
             menuGame->setScore(menuGame->getScore() + 10);
         }
         else
         {
-            menuGame->getSnake().move(nextDirection);
+            menuGame->getSnake().move(nextDirection, destination);
         }
+        menuReachability->update(menuGame->getSnake());
 
         // Render the resulting board
         Utility::printSafe(menuGame->toString(), true);
@@ -265,9 +265,9 @@ void MenuService::playBoardAnimation()
 
 void MenuService::showMainMenu()
 {
-    // Null check
+    // Create the menu game on first use
     if (!menuGame)
-        throw invalid_argument("game is null");
+        menuGame = make_unique<Game>(make_unique<Board>(30, 20), make_unique<Snake>(Point(5, 20), 5));
 
     // Declare vars
     bool userQuit{false};
@@ -324,8 +324,10 @@ void MenuService::showMainMenu()
         else
         {
             // Prompt user for settings
-            boardWidth = getBoardWidth();
-            boardHeight = getBoardHeight();
+            // The map or the bot sets the board size if one is played
+            const bool isSizeFixed{gameService->hasMap() || gameService->hasBotPolicy()};
+            boardWidth = isSizeFixed ? 0 : getBoardWidth();
+            boardHeight = isSizeFixed ? 0 : getBoardHeight();
             snakeLength = getInitialSnakeLength();
             gameSpeed = getGameSpeed();
 
@@ -345,8 +347,10 @@ void MenuService::showMainMenu()
         // Restart animation task
         playBoardAnimationTask();
 
-        // Prompt to save the game
-        if (promptForBoolean("Would you like to save your score?\n'Y' for yes\n'N' for no"))
+        // Prompt to save the game, practice and bot games stay off the leaderboard
+        if (!gameService->canSaveScore())
+            menuGame->setMessage("GAME OVER\n\nPractice and bot games aren't saved");
+        else if (promptForBoolean("Would you like to save your score?\n'Y' for yes\n'N' for no"))
         {
             try
             {
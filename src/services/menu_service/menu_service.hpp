@@ -4,6 +4,7 @@
 #include "point.hpp"
 #include "game.hpp"
 #include "game_service.hpp"
+#include "reachability.hpp"
 #include "SFML/Window.hpp"
 #include <string_view>
 #include <future>
@@ -15,8 +16,16 @@ private:
     /**
      * @brief A game object for displaying as a menu with prompts
      *
+     * @note Created when the main menu is first shown
      */
-    std::unique_ptr<Game> menuGame{std::make_unique<Game>(std::make_unique<Board>(30, 20), std::make_unique<Snake>(Point(5, 20), 5))};
+    std::unique_ptr<Game> menuGame;
+
+    /**
+     * @brief The free regions of the menu game's board, for steering the animation away from dead ends
+     *
+     * @note Created for each game the animation plays
+     */
+    std::unique_ptr<Reachability> menuReachability;
 
     /**
      * @brief The game service instance
@@ -45,6 +54,35 @@ public:
      */
     void setMenuShowing(bool setter);
 
+    /**
+     * @brief Dumps the observations of every game played to .npy files in the folder
+     *
+     * @param directory The folder to create the files in
+     */
+    void setObservationDumpDirectory(const std::string &directory) { gameService->setObservationDumpDirectory(directory); }
+
+    /**
+     * @brief Plays games on a map of a map pack, the board size isn't asked for
+     *
+     * @param path The map pack file
+     * @param index The map, starting at 0
+     */
+    void setMap(const std::string &path, std::size_t index) { gameService->setMap(path, index); }
+
+    /**
+     * @brief Lets a policy play new games instead of the keyboard
+     *
+     * @param path The policy file
+     */
+    void setBotPolicy(const std::string &path) { gameService->setBotPolicy(path); }
+
+    /**
+     * @brief Plays new games in practice mode, where the last ticks can be taken back
+     *
+     * @param historyLength The most ticks kept for rewinding
+     */
+    void setPracticeHistoryLength(std::size_t historyLength) { gameService->setPracticeHistoryLength(historyLength); }
+
     /**
      * @brief Shows the welcome menu.
      *
@@ -95,7 +133,7 @@ private:
     /**
      * @brief Plays the animation
      *
-     * @note The animation is random steps of the snake
+     * @note The animation is random steps of the snake that avoid dead ends while it can
      */
     void playBoardAnimation();
 
@@ -139,14 +177,6 @@ private:
      */
     void showMainMenu();
 
-    /**
-     * @brief Returns true if the snake has a move that will not result in a crash.
-     *
-     * @return true if there is a move that will not crash the snake
-     * @return false if there is not a move that will not crash the snake
-     */
-    bool animationHasSafeMove() const;
-
     /**
      * @brief Shows the scores menu
      */
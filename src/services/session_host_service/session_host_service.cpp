@@ -0,0 +1,83 @@
+#include "session_host_service.hpp"
+#include "file_service.hpp"
+#include "session_host.hpp"
+#include "game.hpp"
+#include "plog/Log.h"
+#include <atomic>
+#include <csignal>
+#include <future>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief The host stopped by the interrupt and terminate signals
+ *
+ */
+static atomic<SessionHost *> runningHost{nullptr};
+
+/**
+ * @brief Stops the running host
+ *
+ */
+static void onStopSignal(int)
+{
+    if (SessionHost *host{runningHost.load()})
+        host->requestStop();
+}
+
+future<void> SessionHostService::saveScore(Game &game)
+{
+    return FileService::saveScoreTask(game);
+}
+
+string SessionHostService::getScorePage(int page)
+{
+    // Collect score strings
+    vector<Game> scores;
+    try
+    {
+        FileService::loadScores(scores, page);
+    }
+    catch (const invalid_argument &)
+    {
+        PLOGW << "No saved scores file";
+    }
+
+    stringstream stream{};
+    stream << Game::getScoreHeader() << '\n';
+    for (auto &score : scores)
+        stream << score.getScoreString() << '\n';
+
+    // Print message if no scores found
+    if (scores.empty())
+        stream << "No saved scores";
+
+    // Remove the last \n char
+    string message{stream.str()};
+    if (message.back() == '\n')
+        message.pop_back();
+    return message;
+}
+
+void SessionHostService::run(const SessionHostOptions &options)
+{
+    SessionHost host(options, *this);
+    PLOGI << "Hosting sessions on " << options.socketPath;
+
+    // Stop on ctrl+c or when the process is terminated
+    runningHost.store(&host);
+    const auto previousInterrupt{signal(SIGINT, onStopSignal)};
+    const auto previousTerminate{signal(SIGTERM, onStopSignal)};
+    host.run();
+    signal(SIGINT, previousInterrupt);
+    signal(SIGTERM, previousTerminate);
+    runningHost.store(nullptr);
+
+    const TickJitter jitter{host.getTickJitter()};
+    PLOGI << "Stopped hosting sessions, " << jitter.ticks << " timers ran late by p50 " << jitter.p50Milliseconds << "ms, p99 "
+          << jitter.p99Milliseconds << "ms, max " << jitter.maxMilliseconds << "ms";
+}
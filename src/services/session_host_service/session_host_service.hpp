@@ -0,0 +1,43 @@
+#ifndef SESSION_HOST_SERVICE_H
+#define SESSION_HOST_SERVICE_H
+
+#include "game.hpp"
+#include "game_session.hpp"
+#include "session_host.hpp"
+#include <future>
+#include <string>
+
+/**
+ * @brief Hosts game sessions for players connecting to a unix socket, saving scores to the game folder
+ *
+ * @note Players connect with a terminal in raw mode, for example socat -,raw,echo=0 UNIX-CONNECT:<socket path>
+ */
+class SessionHostService : public SessionScores
+{
+public:
+    /**
+     * @brief Saves the score to the scores file on the file thread
+     *
+     * @param game The finished game
+     * @return std::future<void> Throws std::runtime_error if the scores file can't be written
+     */
+    std::future<void> saveScore(Game &game) override;
+
+    /**
+     * @brief Get a page of the scores file as the scores menu message
+     *
+     * @param page The page, starting at 0
+     * @throws std::out_of_range Thrown if the page is past the last page
+     * @return std::string
+     */
+    std::string getScorePage(int page) override;
+
+    /**
+     * @brief Hosts sessions until the process is interrupted or terminated
+     *
+     * @param options The host settings
+     */
+    void run(const SessionHostOptions &options);
+};
+
+#endif
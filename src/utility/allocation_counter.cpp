@@ -0,0 +1,106 @@
+#include "allocation_counter.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+/**
+ * @brief The allocations made by the current thread
+ *
+ */
+static thread_local uint64_t threadAllocations{0};
+
+/**
+ * @brief The allocations made by every thread
+ *
+ */
+static atomic<uint64_t> totalAllocations{0};
+
+uint64_t AllocationCounter::getThreadCount() { return threadAllocations; }
+
+uint64_t AllocationCounter::getTotalCount() { return totalAllocations.load(memory_order_relaxed); }
+
+void AllocationCounter::onAllocation()
+{
+    ++threadAllocations;
+    totalAllocations.fetch_add(1, memory_order_relaxed);
+}
+
+/**
+ * @brief Allocates the bytes and counts the allocation
+ *
+ * @return void* The memory, or nullptr if it couldn't be allocated
+ */
+static void *countedAllocate(size_t size, size_t alignment = 0) noexcept
+{
+    AllocationCounter::onAllocation();
+
+    // Zero byte allocations still need unique addresses
+    if (size == 0)
+        size = 1;
+    if (alignment <= alignof(max_align_t))
+        return malloc(size);
+#if defined(_WIN32)
+    return _aligned_malloc(size, alignment);
+#else
+    // Aligned allocations need a size that is a multiple of the alignment
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+/**
+ * @brief Frees memory allocated by countedAllocate
+ *
+ */
+static void countedFree(void *pointer, size_t alignment = 0) noexcept
+{
+#if defined(_WIN32)
+    if (alignment > alignof(max_align_t))
+    {
+        _aligned_free(pointer);
+        return;
+    }
+#endif
+    free(pointer);
+}
+
+/**
+ * @brief Allocates the bytes, calling the new handler until it succeeds or throwing std::bad_alloc
+ *
+ */
+static void *countedNew(size_t size, size_t alignment = 0)
+{
+    while (true)
+    {
+        if (void *pointer{countedAllocate(size, alignment)})
+            return pointer;
+        const new_handler handler{get_new_handler()};
+        if (!handler)
+            throw bad_alloc();
+        handler();
+    }
+}
+
+void *operator new(size_t size) { return countedNew(size); }
+void *operator new[](size_t size) { return countedNew(size); }
+void *operator new(size_t size, align_val_t alignment) { return countedNew(size, static_cast<size_t>(alignment)); }
+void *operator new[](size_t size, align_val_t alignment) { return countedNew(size, static_cast<size_t>(alignment)); }
+void *operator new(size_t size, const nothrow_t &) noexcept { return countedAllocate(size); }
+void *operator new[](size_t size, const nothrow_t &) noexcept { return countedAllocate(size); }
+void *operator new(size_t size, align_val_t alignment, const nothrow_t &) noexcept { return countedAllocate(size, static_cast<size_t>(alignment)); }
+void *operator new[](size_t size, align_val_t alignment, const nothrow_t &) noexcept { return countedAllocate(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void *pointer) noexcept { countedFree(pointer); }
+void operator delete[](void *pointer) noexcept { countedFree(pointer); }
+void operator delete(void *pointer, size_t) noexcept { countedFree(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { countedFree(pointer); }
+void operator delete(void *pointer, align_val_t alignment) noexcept { countedFree(pointer, static_cast<size_t>(alignment)); }
+void operator delete[](void *pointer, align_val_t alignment) noexcept { countedFree(pointer, static_cast<size_t>(alignment)); }
+void operator delete(void *pointer, size_t, align_val_t alignment) noexcept { countedFree(pointer, static_cast<size_t>(alignment)); }
+void operator delete[](void *pointer, size_t, align_val_t alignment) noexcept { countedFree(pointer, static_cast<size_t>(alignment)); }
+void operator delete(void *pointer, const nothrow_t &) noexcept { countedFree(pointer); }
+void operator delete[](void *pointer, const nothrow_t &) noexcept { countedFree(pointer); }
+void operator delete(void *pointer, align_val_t alignment, const nothrow_t &) noexcept { countedFree(pointer, static_cast<size_t>(alignment)); }
+void operator delete[](void *pointer, align_val_t alignment, const nothrow_t &) noexcept { countedFree(pointer, static_cast<size_t>(alignment)); }
@@ -0,0 +1,36 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+/**
+ * @brief Counts the heap allocations made through operator new
+ *
+ * @note Linking allocation_counter.cpp into an executable replaces the global operator new and delete of the whole
+ * executable, so it is only linked into the benchmarks and the allocation test
+ */
+class AllocationCounter
+{
+public:
+    /**
+     * @brief Get the number of allocations made by the calling thread
+     *
+     * @return std::uint64_t
+     */
+    static std::uint64_t getThreadCount();
+
+    /**
+     * @brief Get the number of allocations made by every thread
+     *
+     * @return std::uint64_t
+     */
+    static std::uint64_t getTotalCount();
+
+    /**
+     * @brief Records an allocation
+     *
+     */
+    static void onAllocation();
+};
+
+#endif
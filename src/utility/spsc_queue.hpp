@@ -0,0 +1,90 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief A bounded lock free queue for one producer thread and one consumer thread
+ *
+ * @tparam T The type of the queued items
+ * @tparam Capacity The max number of queued items, must be a power of two
+ */
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    /**
+     * @brief The queued items
+     *
+     */
+    std::array<T, Capacity> items{};
+
+    /**
+     * @brief The index of the next item to pop, only written by the consumer
+     *
+     */
+    alignas(64) std::atomic<std::size_t> head{0};
+
+    /**
+     * @brief The index of the next item to push, only written by the producer
+     *
+     */
+    alignas(64) std::atomic<std::size_t> tail{0};
+
+public:
+    /**
+     * @brief Pushes an item onto the queue
+     *
+     * @note Must only be called from the producer thread
+     * @param item The item to push
+     * @return true if the item was queued
+     * @return false if the queue is full
+     */
+    bool push(const T &item)
+    {
+        const auto currentTail{tail.load(std::memory_order_relaxed)};
+        if (currentTail - head.load(std::memory_order_acquire) == Capacity)
+            return false;
+        items[currentTail & (Capacity - 1)] = item;
+        tail.store(currentTail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pops the oldest item off the queue
+     *
+     * @note Must only be called from the consumer thread
+     * @param item Set to the popped item
+     * @return true if an item was popped
+     * @return false if the queue is empty
+     */
+    bool pop(T &item)
+    {
+        const auto currentHead{head.load(std::memory_order_relaxed)};
+        if (currentHead == tail.load(std::memory_order_acquire))
+            return false;
+        item = items[currentHead & (Capacity - 1)];
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Checks if the queue is empty
+     *
+     * @return true if there is nothing to pop
+     */
+    bool isEmpty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Removes all queued items
+     *
+     * @note Not thread safe, only call while neither thread is using the queue
+     */
+    void clear() { head.store(tail.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef STARTUP_TIMER_H
+#define STARTUP_TIMER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Records how long after startup the first frame and the first game step happen
+ *
+ * @note The start time is taken when the program's static objects are initialized, each milestone is recorded
+ * once by the first thread to reach it
+ */
+class StartupTimer
+{
+public:
+    /**
+     * @brief The milestones that are timed
+     *
+     */
+    enum class Milestone
+    {
+        FIRST_FRAME,
+        FIRST_STEP
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief The time the program started
+     *
+     */
+    inline static const Clock::time_point startTime{Clock::now()};
+
+    /**
+     * @brief The nanoseconds from startup to each milestone, 0 if it has not happened
+     *
+     */
+    inline static std::atomic<std::int64_t> milestoneTimes[2]{};
+
+public:
+    /**
+     * @brief Records the milestone if it has not been recorded yet
+     *
+     * @param milestone The milestone reached
+     */
+    static void mark(Milestone milestone)
+    {
+        auto &time{milestoneTimes[static_cast<int>(milestone)]};
+        if (time.load(std::memory_order_relaxed) != 0)
+            return;
+        std::int64_t expected{0};
+        const std::int64_t elapsed{std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime).count()};
+        time.compare_exchange_strong(expected, elapsed == 0 ? 1 : elapsed, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the milliseconds from startup to the milestone
+     *
+     * @param milestone The milestone
+     * @return double The milliseconds, or a negative number if the milestone has not happened
+     */
+    static double getMilliseconds(Milestone milestone)
+    {
+        const std::int64_t time{milestoneTimes[static_cast<int>(milestone)].load(std::memory_order_relaxed)};
+        return time == 0 ? -1.0 : static_cast<double>(time) / 1'000'000.0;
+    }
+
+    /**
+     * @brief Get a summary of the milestones reached
+     *
+     * @return std::string
+     */
+    static std::string getSummary()
+    {
+        const auto format = [](double milliseconds)
+        { return milliseconds < 0 ? std::string("not reached") : std::to_string(milliseconds) + "ms"; };
+        return "Startup to first frame " + format(getMilliseconds(Milestone::FIRST_FRAME)) +
+               ", to first step " + format(getMilliseconds(Milestone::FIRST_STEP));
+    }
+};
+
+#endif
@@ -1,12 +1,10 @@
 #include "utility.hpp"
-#include <random>
 #include <mutex>
 
 using namespace std;
 using enum sf::Keyboard::Key;
 
 mutex Utility::ioMutex{};
-mt19937 Utility::random(static_cast<unsigned int>(chrono::steady_clock::now().time_since_epoch().count()));
 
 char Utility::sfKeyToChar(sf::Keyboard::Key key)
 {
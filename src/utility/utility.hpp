@@ -2,22 +2,16 @@
 #define UTILITY_H
 
 #include "SFML/Window.hpp"
+#include "startup_timer.hpp"
 #include <thread>
 #include <chrono>
 #include <string_view>
 #include <iostream>
-#include <random>
 #include <mutex>
 
 class Utility
 {
 private:
-    /**
-     * @brief The snake random number generator
-     *
-     */
-    static std::mt19937 random;
-
     /**
      * @brief The snake io mutex for synchronizing io operations
      *
@@ -39,13 +33,6 @@ public:
      */
     static std::mutex &getIoMutex() { return Utility::ioMutex; }
 
-    /**
-     * @brief Get the Random object
-     *
-     * @return std::mt19937&
-     */
-    static std::mt19937 &getRandom() { return Utility::random; }
-
     /**
      * @brief Pauses the current thread for the given number of milliseconds
      *
@@ -67,18 +54,21 @@ public:
         // Get lock for printing
         const std::lock_guard<std::mutex> lock(Utility::getIoMutex());
 
-        // Clear screen using system commands
+        // Clear screen, terminals on linux and mac are cleared with escape codes so no process is started
         if (clearScreen)
         {
 #if defined(_WIN32)
             system("cls");
 #elif defined(__linux__) || defined(__APPLE__)
-            system("clear");
+            std::cout.write("\x1b[H\x1b[2J\x1b[3J", 11);
 #endif
         }
 
         // Print the passed string
-        std::cout << string << std::endl;
+        std::cout.write(string.data(), static_cast<std::streamsize>(string.size()));
+        std::cout.put('\n');
+        std::cout.flush();
+        StartupTimer::mark(StartupTimer::Milestone::FIRST_FRAME);
     }
 };
 
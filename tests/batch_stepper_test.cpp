@@ -0,0 +1,147 @@
+#include "batch_stepper.hpp"
+#include "direction.hpp"
+#include "simd.hpp"
+#include "test_check.hpp"
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Picks the move toward the game's apple, moving along the row first
+ *
+ */
+static Directions::Direction getMoveToApple(const BatchStepper &batch, int game)
+{
+    if (batch.getAppleX(game) > batch.getHeadX(game))
+        return Directions::Direction::RIGHT;
+    if (batch.getAppleX(game) < batch.getHeadX(game))
+        return Directions::Direction::LEFT;
+    return batch.getAppleY(game) > batch.getHeadY(game) ? Directions::Direction::DOWN : Directions::Direction::UP;
+}
+
+/**
+ * @brief A snake filling the only row apples go in clears the board and restarts instead of looking for a cell
+ *
+ */
+static void testClearedRow()
+{
+    // Walking right covers both cells of the row, eating the apple wherever it is
+    BatchStepper batch(1, 2, 1, 1, 3);
+    const Directions::Direction right{Directions::Direction::RIGHT};
+    batch.step(&right);
+    CHECK(!batch.isDone(0));
+    batch.step(&right);
+    CHECK(batch.didEat(0) && batch.didClear(0) && batch.isDone(0));
+    CHECK(batch.getScore(0) >= BatchStepper::APPLE_SCORE);
+    CHECK(batch.getAppleX(0) == -1 && batch.getAppleY(0) == -1);
+
+    // The next step starts the game over
+    batch.step(&right);
+    CHECK(!batch.isDone(0));
+    CHECK(batch.getLength(0) <= 2 && batch.getHeadX(0) == 1);
+}
+
+/**
+ * @brief Games chasing apples on tiny boards keep their apples on vacant cells and end once they run out of them
+ *
+ */
+static void testTinyBoards()
+{
+    constexpr int GAMES{16};
+    for (int width{1}; width <= 4; ++width)
+        for (int height{1}; height <= 3; ++height)
+        {
+            BatchStepper batch(GAMES, width, height, 1, static_cast<uint32_t>(width * 10 + height));
+            vector<Directions::Direction> moves(GAMES);
+            int clears{0};
+            for (int step{0}; step < 500; ++step)
+            {
+                for (int game{0}; game < GAMES; ++game)
+                    moves[game] = getMoveToApple(batch, game);
+                batch.step(moves.data());
+                for (int game{0}; game < GAMES; ++game)
+                {
+                    clears += batch.didClear(game);
+                    CHECK(!batch.didClear(game) || batch.didEat(game));
+                    if (batch.didClear(game))
+                        continue;
+                    const int appleX{batch.getAppleX(game)};
+                    const int appleY{batch.getAppleY(game)};
+                    CHECK(appleX >= 1 && appleX <= width && appleY >= 1 && appleY <= height);
+                    CHECK(!batch.isOccupied(game, appleY * (width + 1) + appleX));
+                }
+            }
+
+            // A single row or column is filled by walking along it
+            CHECK((width > 1 && height > 1) || clears > 0);
+        }
+}
+
+/**
+ * @brief Steps the same moves through the move kernel of every instruction set the CPU supports and checks every game
+ * ends up the same as with the scalar kernel
+ *
+ * @note Most moves chase the apple so games eat and grow, the rest are random so they also turn back and crash
+ */
+static void testSimdLevels()
+{
+    vector<SimdLevel> levels{SimdLevel::SCALAR};
+#if SNAKE_HAS_X86_KERNELS
+    levels.push_back(SimdLevel::SSE2);
+    if (detectSimdLevel() == SimdLevel::AVX2)
+        levels.push_back(SimdLevel::AVX2);
+#endif
+
+    // Game counts that aren't a multiple of the vector width leave a tail for the kernels
+    constexpr int GAMES{37};
+    const int sizes[][2]{{3, 3}, {10, 10}, {30, 20}, {7, 33}};
+    for (const auto &size : sizes)
+    {
+        vector<unique_ptr<BatchStepper>> batches;
+        for (const SimdLevel level : levels)
+        {
+            batches.push_back(make_unique<BatchStepper>(GAMES, size[0], size[1], 3, static_cast<uint32_t>(size[0] * 100 + size[1])));
+            batches.back()->setSimdLevel(level);
+        }
+
+        mt19937 random(static_cast<uint32_t>(size[0] + size[1]));
+        vector<Directions::Direction> moves(GAMES);
+        vector<int> mismatches(levels.size(), 0);
+        for (int step{0}; step < 2000; ++step)
+        {
+            const BatchStepper &scalar{*batches.front()};
+            for (int game{0}; game < GAMES; ++game)
+                moves[game] = random() % 4 == 0 ? static_cast<Directions::Direction>(random() % 4) : getMoveToApple(scalar, game);
+            for (const auto &batch : batches)
+                batch->step(moves.data());
+
+            for (size_t level{1}; level < levels.size(); ++level)
+            {
+                const BatchStepper &batch{*batches[level]};
+                for (int game{0}; game < GAMES; ++game)
+                    mismatches[level] += batch.getHeadX(game) != scalar.getHeadX(game) || batch.getHeadY(game) != scalar.getHeadY(game) ||
+                                         batch.getAppleX(game) != scalar.getAppleX(game) || batch.getAppleY(game) != scalar.getAppleY(game) ||
+                                         batch.getScore(game) != scalar.getScore(game) || batch.getLength(game) != scalar.getLength(game) ||
+                                         batch.didCrash(game) != scalar.didCrash(game) || batch.didEat(game) != scalar.didEat(game) ||
+                                         batch.didClear(game) != scalar.didClear(game);
+            }
+        }
+        for (size_t level{1}; level < levels.size(); ++level)
+        {
+            if (mismatches[level] > 0)
+                cerr << getSimdLevelName(levels[level]) << " on " << size[0] << 'x' << size[1] << ": " << mismatches[level] << " game steps differ" << endl;
+            CHECK(mismatches[level] == 0);
+        }
+    }
+}
+
+int main()
+{
+    testClearedRow();
+    testTinyBoards();
+    testSimdLevels();
+    return finishTest();
+}
@@ -0,0 +1,182 @@
+#include "game_service.hpp"
+#include "replay_archive.hpp"
+#include "score_journal.hpp"
+#include "config.hpp"
+#include "test_check.hpp"
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Points the game folder at the test's folder, before anything builds its path
+ *
+ */
+static void setGameHome(const string &home)
+{
+#if defined(_WIN32)
+    _putenv_s("HOMEDRIVE", "");
+    _putenv_s("HOMEPATH", home.c_str());
+#else
+    setenv("HOME", home.c_str(), 1);
+#endif
+    filesystem::create_directories(SnakeConfig::getGameDirectory());
+}
+
+/**
+ * @brief Picks a turn toward the apple, or none to keep going
+ *
+ */
+static optional<Directions::Direction> getTurnToApple(const Game &game)
+{
+    const Point head{game.getSnake().getBody().back()};
+    const Point apple{game.getApple()};
+    if (apple.x > head.x)
+        return Directions::Direction::RIGHT;
+    if (apple.x < head.x)
+        return Directions::Direction::LEFT;
+    if (apple.y > head.y)
+        return Directions::Direction::DOWN;
+    if (apple.y < head.y)
+        return Directions::Direction::UP;
+    return nullopt;
+}
+
+/**
+ * @brief Get the replays saved, none if the archive hasn't been created
+ *
+ */
+static size_t getReplayCount(const string &path)
+{
+    return filesystem::exists(path) ? ReplayArchive(path).getReplayCount() : 0;
+}
+
+/**
+ * @brief Plays games through the game service chasing apples and checks their replays are saved with their scores
+ *
+ */
+static void testRecordedGames(const string &gameDirectory)
+{
+    constexpr int GAME_COUNT{3};
+    GameService service;
+    for (int gameIndex{0}; gameIndex < GAME_COUNT; ++gameIndex)
+    {
+        service.setUpGame(12, 9, 3, 1.0);
+        Game &game{service.getGame()};
+        size_t tickCount{0};
+        while (!game.isGameOver())
+        {
+            // Chase the apple for a while, then run into a wall
+            if (const auto turn{getTurnToApple(game)}; turn && tickCount < 150)
+                service.queueDirection(*turn);
+            service.processLogic();
+            ++tickCount;
+        }
+        service.saveScore("Tester " + to_string(gameIndex));
+
+        CHECK(getReplayCount(gameDirectory + "replays.dat") == static_cast<size_t>(gameIndex) + 1);
+        if (getReplayCount(gameDirectory + "replays.dat") <= static_cast<size_t>(gameIndex))
+            continue;
+        Replay replay;
+        ReplayArchive(gameDirectory + "replays.dat").getReplay(static_cast<size_t>(gameIndex), replay);
+        CHECK(replay.moveCount == tickCount);
+        CHECK(replay.score == game.getScore());
+        CHECK(replay.seed == game.getSeed());
+
+        // Playing the replay again reaches the same end
+        const ReplayVerdict verdict{simulateReplay(replay)};
+        CHECK(verdict.isGameOver);
+        CHECK(!verdict.hasMovesAfterCrash);
+        CHECK(verdict.score == game.getScore());
+        CHECK(verdict.snakeLength == game.getSnake().getBody().size());
+    }
+
+    // Every score is linked to its replay
+    vector<ScoreRecord> records;
+    ScoreJournal::read(gameDirectory + "scores.dat", [&records](const ScoreRecord &record)
+                       {
+                           records.push_back(record);
+                           return true; });
+    CHECK(records.size() == GAME_COUNT);
+    for (size_t index{0}; index < records.size(); ++index)
+    {
+        CHECK(records[index].playerName == "Tester " + to_string(index));
+        CHECK(records[index].replayId == static_cast<int64_t>(index));
+    }
+    CHECK(records.size() < 2 || records.front().score > 0 || records.back().score > 0);
+}
+
+/**
+ * @brief Games the replay can't start, here on a board with obstacles, aren't recorded
+ *
+ */
+static void testUnrecordedGame(const string &gameDirectory)
+{
+    const size_t replayCount{getReplayCount(gameDirectory + "replays.dat")};
+
+    vector<uint8_t> obstacles(static_cast<size_t>(Board(12, 9).getCellCount()), 0);
+    obstacles[static_cast<size_t>(Board(12, 9).getCellIndex(Point{10, 2}))] = 1;
+    GameService service;
+    service.setUpGame(make_unique<Game>(make_unique<Board>(12, 9, BoardTopology::WALLED, obstacles), make_unique<Snake>(Point(3, 9), 3), 1.0));
+    while (!service.getGame().isGameOver())
+        service.processLogic();
+    service.saveScore("Obstacles");
+
+    CHECK(getReplayCount(gameDirectory + "replays.dat") == replayCount);
+    ScoreRecord last;
+    ScoreJournal::read(gameDirectory + "scores.dat", [&last](const ScoreRecord &record)
+                       {
+                           last = record;
+                           return true; });
+    CHECK(last.playerName == "Obstacles" && last.replayId == -1);
+}
+
+/**
+ * @brief A snake that fills the board wins instead of looking for a cell to put the next apple on
+ *
+ */
+static void testClearedBoard()
+{
+    GameService service;
+    service.setUpGame(make_unique<Game>(make_unique<Board>(2, 1), make_unique<Snake>(Point(1, 1), 1), 1.0));
+    const Game &game{service.getGame()};
+    for (int tick{0}; tick < 2 && !game.isGameOver(); ++tick)
+        service.processLogic();
+    CHECK(game.isGameOver() && game.getIsCleared());
+    CHECK(game.getMessage() == "YOU WIN!\n\nThe board is full");
+}
+
+/**
+ * @brief The scores saved while and after the leaderboard loads on the file thread rank new games
+ *
+ */
+static void testRankedGame(const string &gameDirectory)
+{
+    size_t scoresAbove{0};
+    ScoreJournal::read(gameDirectory + "scores.dat", [&scoresAbove](const ScoreRecord &record)
+                       {
+                           scoresAbove += record.width == 12 && record.height == 9 && record.score > 0;
+                           return true; });
+
+    GameService service;
+    service.setUpGame(12, 9, 3, 1.0);
+    CHECK(service.getGame().getRank() == scoresAbove + 1);
+}
+
+int main()
+{
+    const TestDirectory directory("game_replay_test");
+    setGameHome(directory.getPath());
+
+    // The leaderboard loads on the file thread at startup, before the games below are saved
+    FileService::loadLeaderboardTask();
+    testRecordedGames(SnakeConfig::getGameDirectory());
+    testUnrecordedGame(SnakeConfig::getGameDirectory());
+    testClearedBoard();
+    testRankedGame(SnakeConfig::getGameDirectory());
+    return finishTest();
+}
@@ -0,0 +1,145 @@
+#include "policy_kernels.hpp"
+#include "simd.hpp"
+#include "test_check.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Fills the values with random numbers in [-1, 1], making about a third of them zero
+ *
+ */
+static vector<float> createValues(mt19937 &random, size_t size)
+{
+    uniform_real_distribution<float> distribution(-1, 1);
+    vector<float> values(size);
+    for (float &value : values)
+        value = random() % 3 == 0 ? 0 : distribution(random);
+    return values;
+}
+
+/**
+ * @brief Fills the values with random numbers in [-127, 127], leaving the padding of each row zero
+ *
+ */
+static vector<int8_t> createInt8Values(mt19937 &random, int rows, int size, int paddedSize)
+{
+    vector<int8_t> values(static_cast<size_t>(rows) * paddedSize, 0);
+    for (int row{0}; row < rows; ++row)
+        for (int index{0}; index < size; ++index)
+            values[static_cast<size_t>(row) * paddedSize + index] = static_cast<int8_t>(static_cast<int>(random() % 255) - 127);
+    return values;
+}
+
+/**
+ * @brief Checks the values are the expected ones up to the rounding of summing in another order
+ *
+ */
+static void checkClose(const vector<float> &values, const vector<float> &expected, const string &kernel)
+{
+    int mismatches{0};
+    for (size_t index{0}; index < values.size(); ++index)
+        mismatches += !(abs(values[index] - expected[index]) <= 1e-4f * (1 + abs(expected[index])));
+    if (mismatches > 0)
+        cerr << kernel << ": " << mismatches << " of " << values.size() << " values differ" << endl;
+    CHECK(mismatches == 0);
+}
+
+/**
+ * @brief Runs every kernel of the instruction set and the scalar kernels on the same inputs and compares the outputs
+ *
+ * @note The sizes aren't multiples of the vector width or of the dot products computed at once, so the kernels'
+ * tails run too
+ */
+static void testKernels(SimdLevel level)
+{
+    const PolicyKernels &scalar{getPolicyKernels(SimdLevel::SCALAR)};
+    const PolicyKernels &kernels{getPolicyKernels(level)};
+    mt19937 random(7);
+
+    // Dense
+    {
+        constexpr int COUNT{5}, INPUTS{37}, OUTPUTS{11};
+        const auto inputs{createValues(random, COUNT * INPUTS)};
+        const auto weights{createValues(random, OUTPUTS * INPUTS)};
+        const auto biases{createValues(random, OUTPUTS)};
+        vector<float> outputs(COUNT * OUTPUTS), expected(COUNT * OUTPUTS);
+        kernels.dense(inputs.data(), COUNT, INPUTS, weights.data(), biases.data(), OUTPUTS, outputs.data());
+        scalar.dense(inputs.data(), COUNT, INPUTS, weights.data(), biases.data(), OUTPUTS, expected.data());
+        checkClose(outputs, expected, "dense");
+    }
+
+    // Dense on quantized values
+    {
+        constexpr int COUNT{5}, INPUTS{45}, PADDED{2 * POLICY_INT8_BLOCK}, OUTPUTS{7};
+        const auto inputs{createInt8Values(random, COUNT, INPUTS, PADDED)};
+        const auto weights{createInt8Values(random, OUTPUTS, INPUTS, PADDED)};
+        const auto inputScales{createValues(random, COUNT)};
+        const auto weightScales{createValues(random, OUTPUTS)};
+        const auto biases{createValues(random, OUTPUTS)};
+        vector<float> outputs(COUNT * OUTPUTS), expected(COUNT * OUTPUTS);
+        kernels.denseInt8(inputs.data(), inputScales.data(), COUNT, PADDED, weights.data(), weightScales.data(), biases.data(), OUTPUTS, outputs.data());
+        scalar.denseInt8(inputs.data(), inputScales.data(), COUNT, PADDED, weights.data(), weightScales.data(), biases.data(), OUTPUTS, expected.data());
+        checkClose(outputs, expected, "denseInt8");
+    }
+
+    // Quantizing
+    {
+        constexpr int SIZE{45}, PADDED{2 * POLICY_INT8_BLOCK};
+        const auto values{createValues(random, SIZE)};
+        vector<int8_t> quantized(PADDED, 1), expected(PADDED, 1);
+        CHECK(kernels.quantize(values.data(), SIZE, PADDED, quantized.data()) == scalar.quantize(values.data(), SIZE, PADDED, expected.data()));
+        CHECK(quantized == expected);
+    }
+
+    // 3x3 convolution
+    {
+        constexpr int CHANNELS{3}, ROWS{7}, COLUMNS{13}, OUTPUTS{5};
+        auto padded{createValues(random, CHANNELS * (ROWS + 2) * (COLUMNS + 2))};
+        for (int channel{0}; channel < CHANNELS; ++channel)
+            for (int y{0}; y < ROWS + 2; ++y)
+                for (int x{0}; x < COLUMNS + 2; ++x)
+                    if (y == 0 || x == 0 || y == ROWS + 1 || x == COLUMNS + 1)
+                        padded[(static_cast<size_t>(channel) * (ROWS + 2) + y) * (COLUMNS + 2) + x] = 0;
+        const auto weights{createValues(random, OUTPUTS * CHANNELS * 9)};
+        const auto biases{createValues(random, OUTPUTS)};
+        vector<float> outputs(OUTPUTS * ROWS * COLUMNS), expected(OUTPUTS * ROWS * COLUMNS);
+        kernels.conv3x3(padded.data(), CHANNELS, ROWS, COLUMNS, weights.data(), biases.data(), OUTPUTS, outputs.data());
+        scalar.conv3x3(padded.data(), CHANNELS, ROWS, COLUMNS, weights.data(), biases.data(), OUTPUTS, expected.data());
+        checkClose(outputs, expected, "conv3x3");
+    }
+
+    // Sparse inputs
+    {
+        constexpr int SIZE{77}, OUTPUTS{19};
+        const auto values{createValues(random, SIZE)};
+        vector<int32_t> indices(SIZE), expectedIndices(SIZE);
+        const int found{kernels.findNonZero(values.data(), SIZE, indices.data())};
+        CHECK(found == scalar.findNonZero(values.data(), SIZE, expectedIndices.data()));
+        CHECK(found > 0 && found < SIZE);
+        CHECK(equal(indices.begin(), indices.begin() + found, expectedIndices.begin()));
+
+        const auto columns{createValues(random, SIZE * OUTPUTS)};
+        auto outputs{createValues(random, OUTPUTS)};
+        auto expected{outputs};
+        kernels.addColumns(columns.data(), expectedIndices.data(), values.data(), found, OUTPUTS, outputs.data());
+        scalar.addColumns(columns.data(), expectedIndices.data(), values.data(), found, OUTPUTS, expected.data());
+        checkClose(outputs, expected, "addColumns");
+    }
+}
+
+int main()
+{
+    // SSE2 policies use the scalar kernels, so only AVX2 has kernels of its own
+    if (detectSimdLevel() == SimdLevel::AVX2)
+        testKernels(SimdLevel::AVX2);
+    else
+        cout << "AVX2 isn't supported, only the scalar kernels are available" << endl;
+    return finishTest();
+}
@@ -0,0 +1,160 @@
+#include "rewind_buffer.hpp"
+#include "game_service.hpp"
+#include "reachability.hpp"
+#include "config.hpp"
+#include "test_check.hpp"
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Everything a tick changes in a game
+ *
+ */
+struct GameState
+{
+    vector<Point> body;
+    Directions::Direction direction{Directions::Direction::RIGHT};
+    Point apple;
+    int score{0};
+    Pcg32 random;
+    bool isGameOver{false};
+
+    explicit GameState(const Game &game)
+        : body(game.getSnake().getBody().begin(), game.getSnake().getBody().end()), direction(game.getSnake().getDirection()),
+          apple(game.getApple()), score(game.getScore()), random(game.getRandom()), isGameOver(game.isGameOver())
+    {
+    }
+
+    bool operator==(const GameState &) const = default;
+};
+
+/**
+ * @brief Plays a game, checks rewinding restores every earlier state and that playing the same moves again repeats it
+ *
+ */
+static void testRoundTrips(size_t historyLength, uint32_t seed)
+{
+    Game game(make_unique<Board>(10, 8), make_unique<Snake>(Point(4, 8), 3), 200.0, "Captain", seed);
+    game.reserve();
+    const auto stepper{makeGameStepper(game)};
+    RewindBuffer buffer(game, *stepper, historyLength);
+    Reachability reachability(game.getBoard(), game.getSnake());
+    Pcg32 random{seed};
+
+    // The state before each tick and the move taken
+    vector<GameState> states;
+    vector<Directions::Direction> moves;
+    while (!game.isGameOver() && moves.size() < 400)
+    {
+        const Snake &snake{game.getSnake()};
+        const Directions::Direction direction{reachability.pickMove(snake, random).value_or(snake.getDirection())};
+        states.emplace_back(game);
+        moves.push_back(direction);
+        buffer.step(direction);
+        reachability.update(snake);
+    }
+    states.emplace_back(game);
+    CHECK(buffer.getTickCount() == min(historyLength, moves.size()));
+
+    // Take back a few ticks at a time down to the oldest one kept
+    size_t tick{moves.size()};
+    const size_t oldestTick{moves.size() - buffer.getTickCount()};
+    for (size_t step{1}; tick > oldestTick; ++step)
+    {
+        const size_t rewound{buffer.rewind(step)};
+        CHECK(rewound == min(step, tick - oldestTick));
+        tick -= rewound;
+        CHECK(GameState(game) == states[tick]);
+    }
+    CHECK(buffer.getTickCount() == 0);
+    CHECK(!buffer.undo());
+
+    // The same moves lead to the same game, apples included
+    for (; tick < moves.size(); ++tick)
+    {
+        buffer.step(moves[tick]);
+        CHECK(GameState(game) == states[tick + 1]);
+    }
+}
+
+/**
+ * @brief A rewind in practice mode drops the turns queued before it and validates the next ones against the
+ * restored snake
+ *
+ */
+static void testPracticeRewind()
+{
+    GameService service;
+    service.setPracticeHistoryLength(100);
+    service.setUpGame(20, 15, 3, 1.0);
+    const Game &game{service.getGame()};
+
+    // Turn up for a few ticks, then right for more than a rewind
+    CHECK(service.queueDirection(Directions::Direction::UP));
+    for (int tick{0}; tick < 3; ++tick)
+        service.processLogic();
+    const GameState turnedUp(game);
+    CHECK(service.queueDirection(Directions::Direction::RIGHT));
+    for (int tick{0}; tick < PRACTICE_REWIND_TICKS; ++tick)
+        service.processLogic();
+    CHECK(game.getSnake().getDirection() == Directions::Direction::RIGHT);
+
+    // Turns queued before the rewind aren't applied after it
+    CHECK(service.queueDirection(Directions::Direction::UP));
+    CHECK(service.queueDirection(Directions::Direction::LEFT));
+    service.requestRewind();
+    service.processLogic();
+    CHECK(GameState(game) == turnedUp);
+    service.processLogic();
+    service.processLogic();
+    CHECK(game.getSnake().getDirection() == Directions::Direction::UP);
+
+    // The snake faces up again, so turning right is a new turn and down is a reversal
+    CHECK(!service.queueDirection(Directions::Direction::DOWN));
+    CHECK(service.queueDirection(Directions::Direction::RIGHT));
+    service.processLogic();
+    CHECK(game.getSnake().getDirection() == Directions::Direction::RIGHT);
+
+    // Rewound games stay off the leaderboard
+    CHECK(!service.canSaveScore());
+    bool saveFailed{false};
+    try
+    {
+        service.saveScore("Practice");
+    }
+    catch (const runtime_error &)
+    {
+        saveFailed = true;
+    }
+    CHECK(saveFailed);
+    CHECK(!filesystem::exists(SnakeConfig::getGameDirectory() + "scores.dat"));
+
+    // Games played without practicing can be saved
+    GameService playedService;
+    playedService.setUpGame(20, 15, 3, 1.0);
+    CHECK(playedService.canSaveScore());
+}
+
+int main()
+{
+    // The game service ranks games against the scores in the game folder
+    const TestDirectory directory("rewind_test");
+#if defined(_WIN32)
+    _putenv_s("HOMEDRIVE", "");
+    _putenv_s("HOMEPATH", directory.getPath().c_str());
+#else
+    setenv("HOME", directory.getPath().c_str(), 1);
+#endif
+    filesystem::create_directories(SnakeConfig::getGameDirectory());
+
+    for (const size_t historyLength : {1, 7, 64, 1000})
+        for (uint32_t seed{1}; seed <= 5; ++seed)
+            testRoundTrips(historyLength, seed);
+    testPracticeRewind();
+    return finishTest();
+}
@@ -0,0 +1,183 @@
+#include "score_analytics.hpp"
+#include "score_record.hpp"
+#include "test_check.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+static bool operator==(const ScoreEntry &first, const ScoreEntry &second)
+{
+    return first.playerName == second.playerName && first.score == second.score && first.timestamp == second.timestamp && first.bucket == second.bucket;
+}
+
+static bool operator==(const BucketSummary &first, const BucketSummary &second)
+{
+    return first.bucket == second.bucket && first.count == second.count && first.meanScore == second.meanScore &&
+           first.percentiles == second.percentiles && first.topScores == second.topScores;
+}
+
+static bool operator==(const TimeBin &first, const TimeBin &second)
+{
+    return first.start == second.start && first.count == second.count && first.bestScore == second.bestScore;
+}
+
+/**
+ * @brief Writes a score file with few players, buckets and scores so ties are common, a few lines are malformed
+ *
+ */
+static string createContents(size_t lineCount, vector<ScoreRecord> &records, ScoreFileCounts &counts)
+{
+    mt19937 random(7);
+    string contents;
+    for (size_t index{0}; index < lineCount; ++index)
+    {
+        ScoreRecord record;
+        record.playerName = "player" + to_string(random() % 40);
+        record.width = 10 + static_cast<int>(random() % 3) * 10;
+        record.height = 10 + static_cast<int>(random() % 2) * 5;
+        record.gameSpeed = random() % 2 == 0 ? 200 : 100;
+        record.snakeLength = 3;
+        record.score = static_cast<int>(random() % 30);
+        if (random() % 50 == 0)
+            record.score = 2000000 + static_cast<int>(random() % 3);
+
+        const auto kind{random() % 20};
+        if (kind == 0)
+        {
+            contents += "not a score\n";
+            ++counts.malformed;
+            continue;
+        }
+        if (kind < 5)
+        {
+            // Legacy records have no timestamp
+            contents += record.playerName + '-' + to_string(record.width) + '-' + to_string(record.height) + '-' +
+                        to_string(static_cast<int>(record.gameSpeed)) + '-' + to_string(record.snakeLength) + '-' + to_string(record.score) + '\n';
+            ++counts.legacy;
+        }
+        else
+        {
+            record.timestamp = 1700000000 + static_cast<int64_t>(random() % 200) * 3600;
+            contents += encodeScoreLine(record);
+            ++counts.framed;
+        }
+        records.push_back(record);
+    }
+    return contents;
+}
+
+static bool isBetter(const ScoreEntry &first, const ScoreEntry &second)
+{
+    return tuple(-first.score, first.timestamp, first.playerName, first.bucket.width, first.bucket.height, first.bucket.gameSpeed, first.bucket.snakeLength) <
+           tuple(-second.score, second.timestamp, second.playerName, second.bucket.width, second.bucket.height, second.bucket.gameSpeed, second.bucket.snakeLength);
+}
+
+/**
+ * @brief Answers the query by sorting every score, the slow way
+ *
+ */
+static ScoreReport analyzeReference(const vector<ScoreRecord> &records, const ScoreFileCounts &counts, const ScoreQuery &query)
+{
+    ScoreReport report;
+    report.lines = counts;
+
+    map<string, ScoreEntry> bests;
+    map<tuple<int, int, double, int>, vector<ScoreEntry>> buckets;
+    map<int64_t, TimeBin> bins;
+    for (const auto &record : records)
+    {
+        const ScoreEntry entry{record.playerName, record.score, record.timestamp, ScoreBucket{record.width, record.height, record.gameSpeed, record.snakeLength}};
+        const auto [best, isNew]{bests.try_emplace(record.playerName, entry)};
+        if (!isNew && isBetter(entry, best->second))
+            best->second = entry;
+        buckets[tuple(record.width, record.height, record.gameSpeed, record.snakeLength)].push_back(entry);
+        if (record.timestamp > 0)
+        {
+            const int64_t start{record.timestamp - record.timestamp % query.binSeconds};
+            TimeBin &bin{bins[start]};
+            bin.bestScore = bin.count == 0 ? record.score : max(bin.bestScore, record.score);
+            bin.start = start;
+            ++bin.count;
+        }
+    }
+
+    for (const auto &[name, entry] : bests)
+        report.playerBests.push_back(entry);
+    sort(report.playerBests.begin(), report.playerBests.end(), isBetter);
+
+    for (auto &[key, entries] : buckets)
+    {
+        BucketSummary summary;
+        summary.bucket = entries.front().bucket;
+        summary.count = entries.size();
+        double scoreSum{0};
+        vector<int> scores;
+        for (const auto &entry : entries)
+        {
+            scoreSum += entry.score;
+            scores.push_back(entry.score);
+        }
+        summary.meanScore = scoreSum / static_cast<double>(entries.size());
+        sort(scores.begin(), scores.end());
+        for (const double percentile : query.percentiles)
+        {
+            const size_t rank{max<size_t>(1, static_cast<size_t>(ceil(percentile / 100.0 * static_cast<double>(scores.size()))))};
+            summary.percentiles.push_back(scores[rank - 1]);
+        }
+        sort(entries.begin(), entries.end(), isBetter);
+        entries.resize(min(entries.size(), static_cast<size_t>(query.topCount)));
+        summary.topScores = entries;
+        report.buckets.push_back(summary);
+    }
+    stable_sort(report.buckets.begin(), report.buckets.end(), [](const BucketSummary &first, const BucketSummary &second)
+                { return first.count > second.count; });
+
+    for (const auto &[start, bin] : bins)
+        report.timeBins.push_back(bin);
+    return report;
+}
+
+static void checkSameReport(const ScoreReport &report, const ScoreReport &expected)
+{
+    CHECK(report.lines.framed == expected.lines.framed);
+    CHECK(report.lines.legacy == expected.lines.legacy);
+    CHECK(report.lines.malformed == expected.lines.malformed);
+    CHECK(report.playerBests == expected.playerBests);
+    CHECK(report.buckets == expected.buckets);
+    CHECK(report.timeBins == expected.timeBins);
+}
+
+int main()
+{
+    vector<ScoreRecord> records;
+    ScoreFileCounts counts;
+    const string contents{createContents(20000, records, counts)};
+
+    ScoreQuery query;
+    query.topCount = 5;
+    query.percentiles = {0, 25, 50, 90, 99, 100};
+    query.binSeconds = 6 * 60 * 60;
+    query.threadCount = 1;
+    const ScoreReport expected{analyzeReference(records, counts, query)};
+    checkSameReport(ScoreAnalytics::analyze(string_view{contents}, query), expected);
+
+    // Every split of the file gives the single threaded answers, ties included
+    for (const int threadCount : {2, 3, 4, 7, 16, 64})
+    {
+        query.threadCount = threadCount;
+        checkSameReport(ScoreAnalytics::analyze(string_view{contents}, query), expected);
+    }
+
+    // A file that doesn't end with a newline keeps its last line
+    query.threadCount = 4;
+    const ScoreReport unterminated{ScoreAnalytics::analyze(string_view{contents}.substr(0, contents.size() - 1), query)};
+    CHECK(unterminated.lines.framed + unterminated.lines.legacy == counts.framed + counts.legacy);
+    return finishTest();
+}
@@ -0,0 +1,175 @@
+#include "score_journal.hpp"
+#include "score_record.hpp"
+#include "test_check.hpp"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static ScoreRecord createRecord(const string &playerName, int score)
+{
+    ScoreRecord record;
+    record.playerName = playerName;
+    record.width = 20;
+    record.height = 15;
+    record.gameSpeed = 200;
+    record.snakeLength = 3;
+    record.score = score;
+    record.timestamp = 1700000000 + score;
+    return record;
+}
+
+static string readFile(const string &path)
+{
+    ifstream file(path, ifstream::binary);
+    stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+static void writeFile(const string &path, const string &contents)
+{
+    ofstream file(path, ofstream::binary | ofstream::trunc);
+    file << contents;
+}
+
+static vector<ScoreRecord> readRecords(const string &path, ScoreFileCounts &counts)
+{
+    vector<ScoreRecord> records;
+    counts = ScoreJournal::read(path, [&records](const ScoreRecord &record)
+                                {
+                                    records.push_back(record);
+                                    return true; });
+    return records;
+}
+
+/**
+ * @brief A legacy file whose last score has no newline keeps it
+ *
+ */
+static void testUnterminatedLegacyLine(const TestDirectory &directory)
+{
+    const string path{directory.getFile("legacy.dat")};
+    writeFile(path, "alice-20-15-200-3-5\nbob-20-15-200.000000-3-7");
+    {
+        ScoreJournal journal(path);
+        CHECK(journal.getTruncatedBytes() == 0);
+        journal.append(createRecord("carol", 9));
+    }
+
+    ScoreFileCounts counts;
+    const auto records{readRecords(path, counts)};
+    CHECK(counts.legacy == 2);
+    CHECK(counts.framed == 1);
+    CHECK(counts.malformed == 0);
+    CHECK(records.size() == 3 && records[1].playerName == "bob" && records[1].score == 7);
+    CHECK(records.size() == 3 && records[2].playerName == "carol" && records[2].score == 9);
+}
+
+/**
+ * @brief A framed record written completely but without its newline is kept
+ *
+ */
+static void testUnterminatedFramedLine(const TestDirectory &directory)
+{
+    const string path{directory.getFile("framed.dat")};
+    string line{encodeScoreLine(createRecord("dave", 4))};
+    line.pop_back();
+    writeFile(path, encodeScoreLine(createRecord("erin", 3)) + line);
+    {
+        ScoreJournal journal(path);
+        CHECK(journal.getTruncatedBytes() == 0);
+    }
+
+    ScoreFileCounts counts;
+    const auto records{readRecords(path, counts)};
+    CHECK(counts.framed == 2 && counts.malformed == 0);
+    CHECK(records.size() == 2 && records[1].playerName == "dave");
+    CHECK(readFile(path).back() == '\n');
+}
+
+/**
+ * @brief Every prefix of a framed record left by a crashed writer is removed
+ *
+ */
+static void testTornRecord(const TestDirectory &directory)
+{
+    const string path{directory.getFile("torn.dat")};
+    const string complete{encodeScoreLine(createRecord("frank", 6))};
+    const string torn{encodeScoreLine(createRecord("grace", 8))};
+    for (size_t length{1}; length < torn.size() - 1; ++length)
+    {
+        writeFile(path, complete + torn.substr(0, length));
+        {
+            ScoreJournal journal(path);
+            CHECK(journal.getTruncatedBytes() == length);
+        }
+        CHECK(readFile(path) == complete);
+    }
+}
+
+/**
+ * @brief A framed record that fails its checksum at the end of the file is removed, a legacy one is never checked
+ *
+ */
+static void testCorruptLastRecord(const TestDirectory &directory)
+{
+    const string path{directory.getFile("corrupt.dat")};
+    const string complete{encodeScoreLine(createRecord("heidi", 2))};
+    string corrupt{encodeScoreLine(createRecord("ivan", 12))};
+    corrupt[corrupt.size() - 3] ^= 1;
+    writeFile(path, complete + corrupt);
+    {
+        ScoreJournal journal(path);
+        CHECK(journal.getTruncatedBytes() == corrupt.size());
+    }
+    CHECK(readFile(path) == complete);
+}
+
+/**
+ * @brief Records appended from many threads are all written once, each on its own line
+ *
+ */
+static void testConcurrentAppends(const TestDirectory &directory)
+{
+    constexpr int THREAD_COUNT{8};
+    constexpr int RECORDS_PER_THREAD{50};
+    const string path{directory.getFile("concurrent.dat")};
+    {
+        ScoreJournal journal(path, ScoreJournal::Options{ScoreJournal::SyncPolicy::NEVER});
+        vector<thread> threads;
+        for (int thread{0}; thread < THREAD_COUNT; ++thread)
+            threads.emplace_back([&journal, thread]
+                                 {
+                                     for (int index{0}; index < RECORDS_PER_THREAD; ++index)
+                                         journal.append(createRecord("thread" + to_string(thread), index)); });
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    ScoreFileCounts counts;
+    const auto records{readRecords(path, counts)};
+    CHECK(counts.framed == THREAD_COUNT * RECORDS_PER_THREAD && counts.malformed == 0);
+    vector<int> nextScores(THREAD_COUNT, 0);
+    for (const auto &record : records)
+    {
+        // Each thread's records keep their order
+        const int thread{stoi(record.playerName.substr(6))};
+        CHECK(record.score == nextScores[thread]);
+        nextScores[thread] = record.score + 1;
+    }
+}
+
+int main()
+{
+    const TestDirectory directory("score_journal_test");
+    testUnterminatedLegacyLine(directory);
+    testUnterminatedFramedLine(directory);
+    testTornRecord(directory);
+    testCorruptLastRecord(directory);
+    testConcurrentAppends(directory);
+    return finishTest();
+}
@@ -0,0 +1,176 @@
+#include "score_merge.hpp"
+#include "score_record.hpp"
+#include "test_check.hpp"
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static string readFile(const string &path)
+{
+    ifstream file(path, ifstream::binary);
+    stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+static void writeFile(const string &path, const string &contents)
+{
+    ofstream file(path, ofstream::binary | ofstream::trunc);
+    file << contents;
+}
+
+/**
+ * @brief Writes a score file with duplicated records and records only told apart by their replay
+ *
+ */
+static void writeScores(const string &path, unsigned seed, size_t recordCount)
+{
+    mt19937 random(seed);
+    string contents;
+    vector<ScoreRecord> written;
+    for (size_t index{0}; index < recordCount; ++index)
+    {
+        ScoreRecord record;
+        const auto kind{random() % 10};
+        if (kind < 2 && !written.empty())
+        {
+            // A duplicate, or the same game saved with another replay
+            record = written[random() % written.size()];
+            if (kind == 1)
+                record.replayId = record.replayId < 0 ? static_cast<int64_t>(random() % 100) : -1;
+        }
+        else
+        {
+            record.playerName = "player" + to_string(random() % 30);
+            record.width = 20;
+            record.height = 10 + static_cast<int>(random() % 2) * 5;
+            record.gameSpeed = 200;
+            record.snakeLength = 3;
+            record.score = static_cast<int>(random() % 40);
+            record.timestamp = 1700000000 + static_cast<int64_t>(random() % 50);
+            record.replayId = random() % 3 == 0 ? -1 : static_cast<int64_t>(random() % 1000);
+        }
+        contents += encodeScoreLine(record);
+        written.push_back(record);
+    }
+    writeFile(path, contents);
+}
+
+/**
+ * @brief Spilling to disk in several passes writes the same file as merging in memory
+ *
+ */
+static void testSpillMatchesMemory(const TestDirectory &directory, const vector<string> &inputs)
+{
+    for (const ScoreFormat format : {ScoreFormat::TEXT, ScoreFormat::CSV, ScoreFormat::BINARY})
+    {
+        for (const bool removeDuplicates : {true, false})
+        {
+            ScoreMergeOptions options;
+            options.format = format;
+            options.removeDuplicates = removeDuplicates;
+            options.spillDirectory = directory.getPath();
+            const string memoryPath{directory.getFile("memory.out")};
+            const ScoreMergeStats memoryStats{ScoreMerger::merge(inputs, memoryPath, options)};
+            CHECK(memoryStats.spillRuns == 0);
+
+            options.memoryLimit = 16 * 1024;
+            options.maxOpenRuns = 3;
+            const string spillPath{directory.getFile("spill.out")};
+            const ScoreMergeStats spillStats{ScoreMerger::merge(inputs, spillPath, options)};
+            CHECK(spillStats.spillRuns > options.maxOpenRuns);
+
+            CHECK(spillStats.written == memoryStats.written);
+            CHECK(spillStats.duplicates == memoryStats.duplicates);
+            CHECK(removeDuplicates == (memoryStats.duplicates > 0));
+            CHECK(readFile(spillPath) == readFile(memoryPath));
+        }
+    }
+}
+
+/**
+ * @brief A binary file read back merges into the same scores, replay ids included
+ *
+ */
+static void testBinaryRoundTrip(const TestDirectory &directory, const vector<string> &inputs)
+{
+    ScoreMergeOptions options;
+    const string textPath{directory.getFile("merged.dat")};
+    ScoreMerger::merge(inputs, textPath, options);
+
+    options.format = ScoreFormat::BINARY;
+    const string binaryPath{directory.getFile("merged.bin")};
+    ScoreMerger::merge(inputs, binaryPath, options);
+    CHECK(readFile(binaryPath).starts_with("SNKSCOR2"));
+
+    options.format = ScoreFormat::TEXT;
+    const string roundTripPath{directory.getFile("round_trip.dat")};
+    const ScoreMergeStats stats{ScoreMerger::merge({binaryPath}, roundTripPath, options)};
+    CHECK(stats.duplicates == 0);
+    CHECK(readFile(roundTripPath) == readFile(textPath));
+
+    size_t replayCount{0};
+    istringstream lines(readFile(roundTripPath));
+    string line;
+    ScoreRecord record;
+    while (getline(lines, line))
+        replayCount += parseScoreLine(line, record) == ScoreLineStatus::FRAMED && record.replayId >= 0;
+    CHECK(replayCount > 0);
+}
+
+/**
+ * @brief Binary files written before the replay id was stored are still read, their records have no replay
+ *
+ */
+static void testVersionOneBinary(const TestDirectory &directory)
+{
+    string contents{"SNKSCOR1"};
+    const string name{"alice"};
+    const auto putInteger = [&contents](uint64_t value, size_t size)
+    {
+        for (size_t byte{0}; byte < size; ++byte)
+            contents += static_cast<char>(value >> (8 * byte) & 0xFF);
+    };
+    putInteger(name.size(), 2);
+    contents += name;
+    putInteger(20, 4);
+    putInteger(15, 4);
+    const double speed{200};
+    uint64_t speedBits;
+    memcpy(&speedBits, &speed, sizeof(speedBits));
+    putInteger(speedBits, 8);
+    putInteger(3, 4);
+    putInteger(12, 4);
+    putInteger(1700000000, 8);
+    const string path{directory.getFile("version_one.bin")};
+    writeFile(path, contents);
+
+    const string outputPath{directory.getFile("version_one.dat")};
+    const ScoreMergeStats stats{ScoreMerger::merge({path}, outputPath, {})};
+    CHECK(stats.inputs.size() == 1 && stats.inputs.front().binaryRecords == 1);
+    ScoreRecord record;
+    string line{readFile(outputPath)};
+    CHECK(!line.empty() && line.back() == '\n');
+    if (!line.empty())
+        line.pop_back();
+    CHECK(parseScoreLine(line, record) == ScoreLineStatus::FRAMED);
+    CHECK(record.playerName == name && record.score == 12 && record.replayId == -1);
+}
+
+int main()
+{
+    const TestDirectory directory("score_merge_test");
+    const vector<string> inputs{directory.getFile("first.dat"), directory.getFile("second.dat")};
+    writeScores(inputs[0], 1, 3000);
+    writeScores(inputs[1], 2, 2000);
+
+    testSpillMatchesMemory(directory, inputs);
+    testBinaryRoundTrip(directory, inputs);
+    testVersionOneBinary(directory);
+    return finishTest();
+}
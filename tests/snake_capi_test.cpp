@@ -0,0 +1,51 @@
+#include "snake_capi.h"
+#include "test_check.hpp"
+#include <cstdint>
+
+/**
+ * @brief Eating the apples of a board with room for two ends the game instead of looking for a third cell
+ *
+ */
+static void testClearedBoard()
+{
+    for (uint32_t seed{1}; seed <= 8; ++seed)
+    {
+        snake_game *const game{snake_create(2, 1, 1, seed)};
+        CHECK(game != nullptr);
+        if (!game)
+            return;
+
+        // Walking right covers both cells of the row, eating the apple wherever it is
+        CHECK(snake_step(game, SNAKE_RIGHT) != SNAKE_ERROR);
+        CHECK(snake_is_over(game) == 0);
+        CHECK(snake_step(game, SNAKE_RIGHT) == SNAKE_ATE);
+        CHECK(snake_is_over(game) == 1);
+        CHECK(snake_get_score(game) >= 10);
+        CHECK(snake_get_length(game) == 1 + snake_get_score(game) / 10);
+        CHECK(snake_step(game, SNAKE_RIGHT) == SNAKE_ERROR);
+
+        // A new game starts over
+        CHECK(snake_reset(game, seed + 100) == 0);
+        CHECK(snake_is_over(game) == 0 && snake_get_length(game) == 1 && snake_get_score(game) == 0);
+        snake_destroy(game);
+    }
+}
+
+/**
+ * @brief A board with room for one apple ends on the first one
+ *
+ */
+static void testSingleCell()
+{
+    snake_game *const game{snake_create(1, 1, 1, 7)};
+    CHECK(snake_step(game, SNAKE_RIGHT) == SNAKE_ATE);
+    CHECK(snake_is_over(game) == 1);
+    snake_destroy(game);
+}
+
+int main()
+{
+    testClearedBoard();
+    testSingleCell();
+    return finishTest();
+}
@@ -0,0 +1,70 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+/**
+ * @brief The checks that failed in the test executable
+ *
+ */
+inline int testFailures{0};
+
+/**
+ * @brief Reports a failed condition and keeps running the test, so one run shows every failure
+ *
+ */
+#define CHECK(condition)                                                                                     \
+    do                                                                                                       \
+    {                                                                                                        \
+        if (!(condition))                                                                                    \
+        {                                                                                                    \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": check failed: " #condition << std::endl;           \
+            ++testFailures;                                                                                  \
+        }                                                                                                    \
+    } while (false)
+
+/**
+ * @brief A folder removed with everything in it when the test ends
+ *
+ */
+class TestDirectory
+{
+private:
+    std::filesystem::path path;
+
+public:
+    explicit TestDirectory(const std::string &name)
+        : path(std::filesystem::temp_directory_path() / (name + '-' + std::to_string(std::rand()) + '-' + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count())))
+    {
+        std::filesystem::create_directories(path);
+    }
+
+    ~TestDirectory()
+    {
+        std::error_code error;
+        std::filesystem::remove_all(path, error);
+    }
+
+    TestDirectory(const TestDirectory &) = delete;
+    TestDirectory &operator=(const TestDirectory &) = delete;
+
+    std::string getFile(const std::string &name) const { return (path / name).string(); }
+    std::string getPath() const { return path.string(); }
+};
+
+/**
+ * @brief Ends the test, failing it if a check failed
+ *
+ */
+inline int finishTest()
+{
+    if (testFailures > 0)
+        std::cerr << testFailures << " checks failed" << std::endl;
+    return testFailures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#include "game_service.hpp"
+#include "file_service.hpp"
+#include "allocation_counter.hpp"
+#include "config.hpp"
+#include "test_check.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+/**
+ * @brief The first ticks of each game, which warm up the storage and aren't counted
+ *
+ */
+constexpr int WARM_UP_TICKS{100};
+
+/**
+ * @brief Picks a serpentine path from the bottom row upward, it never revisits a cell so the game only ends at the top wall
+ *
+ */
+static Directions::Direction serpentineDirection(const Game &game)
+{
+    const Point &head{game.getSnake().getHead()};
+    const bool movingRight{(game.getBoard().getHeight() - head.y) % 2 == 0};
+    if (movingRight)
+        return head.x == game.getBoard().getWidth() ? Directions::Direction::UP : Directions::Direction::RIGHT;
+    return head.x == 0 ? Directions::Direction::UP : Directions::Direction::LEFT;
+}
+
+/**
+ * @brief Plays games through the game service's logic tick and checks the ticks after the warm up don't allocate
+ *
+ * @note Each tick queues the keyboard's turn and runs processLogic, which steps the game, updates the free regions,
+ * ranks it, records its move and dumps its observation. In practice mode the game is also rewound now and then.
+ * @param name The mode, shown with the counts
+ */
+static void checkTickAllocations(GameService &service, const string &name, bool isRewinding)
+{
+    constexpr int GAMES{3};
+    const int sizes[][2]{{10, 10}, {30, 20}, {50, 30}};
+    for (const auto &size : sizes)
+    {
+        uint64_t ticks{0};
+        uint64_t allocations{0};
+        for (int round{0}; round < GAMES; ++round)
+        {
+            service.setUpGame(size[0], size[1], 5, 1.0);
+            const Game &game{service.getGame()};
+
+            int tick{0};
+            uint64_t before{AllocationCounter::getThreadCount()};
+            while (!game.isGameOver())
+            {
+                if (tick++ == WARM_UP_TICKS)
+                    before = AllocationCounter::getThreadCount();
+                if (isRewinding && tick % 50 == 0)
+                    service.requestRewind();
+                else if (const Directions::Direction direction{serpentineDirection(game)}; direction != game.getSnake().getDirection())
+                    service.queueDirection(direction);
+                service.processLogic();
+            }
+            if (tick > WARM_UP_TICKS)
+            {
+                allocations += AllocationCounter::getThreadCount() - before;
+                ticks += static_cast<uint64_t>(tick - WARM_UP_TICKS);
+            }
+        }
+        cout << name << ' ' << size[0] << 'x' << size[1] << ": " << allocations << " allocations in " << ticks << " ticks" << endl;
+        CHECK(ticks > 0);
+        CHECK(allocations == 0);
+    }
+}
+
+int main()
+{
+    // The game service ranks games against the scores in the game folder
+    const TestDirectory directory("tick_allocation_test");
+#if defined(_WIN32)
+    _putenv_s("HOMEDRIVE", "");
+    _putenv_s("HOMEPATH", directory.getPath().c_str());
+#else
+    setenv("HOME", directory.getPath().c_str(), 1);
+#endif
+    filesystem::create_directories(SnakeConfig::getGameDirectory());
+    FileService::loadLeaderboardTask().get();
+
+    GameService service;
+    checkTickAllocations(service, "playing", false);
+
+    // Observations are dumped every tick
+    service.setObservationDumpDirectory(directory.getPath());
+    checkTickAllocations(service, "dumping", false);
+    service.setObservationDumpDirectory("");
+
+    // Practice games keep their last ticks and are rewound
+    service.setPracticeHistoryLength(200);
+    checkTickAllocations(service, "practicing", true);
+    return finishTest();
+}
@@ -0,0 +1,175 @@
+#include "heatmap.hpp"
+#include "game.hpp"
+#include "game_stepper.hpp"
+#include "board.hpp"
+#include "snake.hpp"
+#include "map_pack.hpp"
+#include "reachability.hpp"
+#include "pcg32.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief The settings of a simulation
+ *
+ */
+struct SimulationOptions
+{
+    uint64_t gameCount{10'000};
+    unsigned threadCount{0};
+    int width{30};
+    int height{20};
+    int snakeLength{4};
+    uint64_t maxSteps{10'000};
+    uint64_t seed{1};
+    string mapPackPath;
+    size_t mapIndex{0};
+};
+
+/**
+ * @brief Prints how to use the tool
+ *
+ */
+static void printUsage()
+{
+    cerr << "Usage: SnakeHeatmap <output prefix> [--games <count>] [--threads <count>] [--width <cells>] [--height <cells>]\n"
+            "                                    [--length <segments>] [--max-steps <steps>] [--seed <seed>]\n"
+            "                                    [--map-pack <file>] [--map <index>]\n"
+            "Writes <output prefix>.npy with the visit, apple and death counts and a .pgm image of each\n";
+}
+
+/**
+ * @brief Plays the games handed out by the counter, counting their events in the heatmap
+ *
+ * @note The snake picks random moves that don't lead into dead ends, so games end when it is trapped or runs out
+ * of steps
+ * @return uint64_t The number of steps played
+ */
+static uint64_t simulate(const SimulationOptions &options, const MapPack *mapPack, unsigned stream, atomic<uint64_t> &nextGame, Heatmap &heatmap)
+{
+    Pcg32 random(options.seed, stream);
+    uint64_t steps{0};
+    while (nextGame.fetch_add(1, memory_order_relaxed) < options.gameCount)
+    {
+        Game game(mapPack ? mapPack->createBoard(options.mapIndex) : make_unique<Board>(options.width, options.height),
+                  mapPack ? mapPack->createSnake(options.mapIndex, options.snakeLength) : make_unique<Snake>(Point(options.snakeLength, options.height), options.snakeLength),
+                  200.0, "Heatmap", random());
+        const Board &board{game.getBoard()};
+        const auto stepper{makeGameStepper(game)};
+        Reachability reachability(board, game.getSnake());
+        heatmap.recordStart(game);
+        for (uint64_t step{0}; step < options.maxSteps && !game.isGameOver(); ++step)
+        {
+            const Snake &snake{game.getSnake()};
+            const auto move{reachability.pickMove(snake, random)};
+            const int previousHeadCell{board.getCellIndex(snake.getHead())};
+            const StepOutcome outcome{stepper->step(move.value_or(snake.getDirection()))};
+            reachability.update(snake);
+            heatmap.recordStep(game, outcome, previousHeadCell);
+            ++steps;
+        }
+    }
+    return steps;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        if (argc < 2 || string{argv[1]}.starts_with("--"))
+        {
+            printUsage();
+            return 1;
+        }
+
+        SimulationOptions options;
+        for (int index{2}; index < argc; ++index)
+        {
+            const string option{argv[index]};
+            const bool hasValue{index + 1 < argc};
+            if (option == "--games" && hasValue)
+                options.gameCount = stoull(argv[++index]);
+            else if (option == "--threads" && hasValue)
+                options.threadCount = static_cast<unsigned>(stoul(argv[++index]));
+            else if (option == "--width" && hasValue)
+                options.width = stoi(argv[++index]);
+            else if (option == "--height" && hasValue)
+                options.height = stoi(argv[++index]);
+            else if (option == "--length" && hasValue)
+                options.snakeLength = stoi(argv[++index]);
+            else if (option == "--max-steps" && hasValue)
+                options.maxSteps = stoull(argv[++index]);
+            else if (option == "--seed" && hasValue)
+                options.seed = stoull(argv[++index]);
+            else if (option == "--map-pack" && hasValue)
+                options.mapPackPath = argv[++index];
+            else if (option == "--map" && hasValue)
+                options.mapIndex = stoul(argv[++index]);
+            else
+            {
+                printUsage();
+                return 1;
+            }
+        }
+
+        // The map sets the board size
+        unique_ptr<MapPack> mapPack;
+        if (!options.mapPackPath.empty())
+        {
+            mapPack = make_unique<MapPack>(options.mapPackPath);
+            const MapInfo info{mapPack->getMapInfo(options.mapIndex)};
+            options.width = info.width;
+            options.height = info.height;
+        }
+        if (options.width <= 0 || options.height <= 0 || options.snakeLength <= 0 || options.snakeLength > options.width)
+            throw invalid_argument("the snake must fit in a board of positive size");
+        if (options.threadCount == 0)
+            options.threadCount = max(thread::hardware_concurrency(), 1u);
+
+        // Each thread counts into its own heatmap, they are only merged once every game is played
+        vector<Heatmap> heatmaps(options.threadCount, Heatmap(options.width, options.height));
+        vector<uint64_t> steps(options.threadCount, 0);
+        atomic<uint64_t> nextGame{0};
+        const auto start{chrono::steady_clock::now()};
+        {
+            vector<jthread> threads;
+            for (unsigned index{0}; index < options.threadCount; ++index)
+                threads.emplace_back([&, index]
+                                     { steps[index] = simulate(options, mapPack.get(), index, nextGame, heatmaps[index]); });
+        }
+        const double simulateSeconds{chrono::duration<double>(chrono::steady_clock::now() - start).count()};
+        const Heatmap merged{Heatmap::merge(heatmaps, options.threadCount)};
+        const double mergeSeconds{chrono::duration<double>(chrono::steady_clock::now() - start).count() - simulateSeconds};
+
+        const string prefix{argv[1]};
+        merged.writeNpy(prefix + ".npy");
+        merged.writePgm(prefix + "_visits.pgm", HeatmapLayer::VISITS);
+        merged.writePgm(prefix + "_apples.pgm", HeatmapLayer::APPLES);
+        merged.writePgm(prefix + "_deaths.pgm", HeatmapLayer::DEATHS);
+
+        uint64_t totalSteps{0};
+        for (const auto count : steps)
+            totalSteps += count;
+        cout << "Played " << options.gameCount << " games of " << options.width << 'x' << options.height << " on " << options.threadCount << " threads in "
+             << simulateSeconds << "s (" << static_cast<double>(totalSteps) / simulateSeconds / 1e6 << "M steps/s), merged in " << mergeSeconds * 1e3 << "ms\n";
+        cout << "Counted " << merged.getTotal(HeatmapLayer::VISITS) << " visits, " << merged.getTotal(HeatmapLayer::APPLES) << " apples and "
+             << merged.getTotal(HeatmapLayer::DEATHS) << " deaths into " << prefix << ".npy\n";
+        return 0;
+    }
+    catch (const exception &exception)
+    {
+        cerr << exception.what() << '\n';
+        return -1;
+    }
+}
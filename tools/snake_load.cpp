@@ -0,0 +1,735 @@
+#include "pcg32.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+/**
+ * @brief The settings of a load test
+ *
+ */
+struct LoadOptions
+{
+    string socketPath;
+    size_t sessionCount{100};
+    unsigned threadCount{0};
+    double durationSeconds{30};
+
+    /**
+     * @brief The keys each session presses per second while playing
+     *
+     */
+    double keyRate{4};
+
+    int width{30};
+    int height{20};
+
+    /**
+     * @brief The speed picked at the session's speed prompt, 1 to 3
+     *
+     */
+    int speed{3};
+
+    /**
+     * @brief The direction keys pressed in turn, random keys if empty
+     *
+     */
+    string script;
+
+    /**
+     * @brief The Snake executable to host the sessions, empty if the host is already running
+     *
+     */
+    string serverPath;
+    pid_t serverPid{0};
+    string reportPath;
+    uint64_t seed{1};
+};
+
+/**
+ * @brief Prints how to use the tool
+ *
+ */
+static void printUsage()
+{
+    cerr << "Usage: SnakeLoad <socket path> [--sessions <count>] [--threads <count>] [--duration <seconds>]\n"
+            "                               [--key-rate <keys per second>] [--script <wasd keys>] [--width <cells>]\n"
+            "                               [--height <cells>] [--speed <1-3>] [--server <Snake executable> | --server-pid <pid>]\n"
+            "                               [--report <file>] [--seed <seed>]\n"
+            "Plays sessions on a session host (Snake --host) and reports percentiles of the input round trip, the\n"
+            "jitter of the intervals between game steps and the host's CPU use\n";
+}
+
+/**
+ * @brief Splits the bytes a session host sends a player into frames
+ *
+ * @note A whole frame clears the screen and is plain text lines. Any other frame moves the cursor to each changed
+ * line and rewrites its changed columns, then moves the cursor to the first column below the frame, so a frame
+ * with no changed lines is only that last move. The host writes whole frames, so a frame left open at the end of
+ * the bytes read is complete.
+ */
+class FrameReader
+{
+public:
+    struct Frame
+    {
+        bool isWhole{false};
+        int changedLines{0};
+        string text;
+    };
+
+private:
+    enum class State
+    {
+        TEXT,
+        ESCAPE,
+        SEQUENCE
+    };
+
+    State state{State::TEXT};
+    string parameters;
+    Frame frame;
+    bool isOpen{false};
+
+    /**
+     * @brief Whether the last move was to the first column, which ends the frame unless text follows it
+     *
+     */
+    bool isEndPending{false};
+
+    void finish(const function<void(const Frame &)> &onFrame)
+    {
+        if (isOpen)
+            onFrame(frame);
+        isOpen = false;
+    }
+
+    void start(bool isWhole)
+    {
+        frame.isWhole = isWhole;
+        frame.changedLines = 0;
+        frame.text.clear();
+        isOpen = true;
+    }
+
+    void onText(char character)
+    {
+        if (isEndPending)
+        {
+            isEndPending = false;
+            ++frame.changedLines;
+        }
+        if (isOpen)
+            frame.text += character;
+    }
+
+    void onSequence(char command, const function<void(const Frame &)> &onFrame)
+    {
+        // A line rewritten from the first column may be empty and cleared instead
+        if (isEndPending)
+        {
+            isEndPending = false;
+            if (command == 'K')
+            {
+                ++frame.changedLines;
+                return;
+            }
+            finish(onFrame);
+        }
+
+        // Clearing the screen starts a whole frame, the first move after one starts the next frame
+        if (command == 'H' && parameters.empty())
+        {
+            finish(onFrame);
+            start(true);
+            return;
+        }
+        if (command != 'H')
+            return;
+        if (isOpen && frame.isWhole)
+            finish(onFrame);
+        if (!isOpen)
+            start(false);
+        if (parameters.ends_with(";1"))
+            isEndPending = true;
+        else
+            ++frame.changedLines;
+    }
+
+public:
+    /**
+     * @brief Reads the bytes received, calling back with each frame they complete
+     *
+     */
+    void read(string_view bytes, const function<void(const Frame &)> &onFrame)
+    {
+        for (const char character : bytes)
+        {
+            switch (state)
+            {
+            case State::TEXT:
+                if (character == '\x1b')
+                    state = State::ESCAPE;
+                else
+                    onText(character);
+                break;
+            case State::ESCAPE:
+                state = character == '[' ? State::SEQUENCE : State::TEXT;
+                parameters.clear();
+                break;
+            case State::SEQUENCE:
+                if ((character >= '0' && character <= '9') || character == ';')
+                    parameters += character;
+                else
+                {
+                    state = State::TEXT;
+                    onSequence(character, onFrame);
+                }
+                break;
+            }
+        }
+        if (state != State::TEXT)
+            return;
+        if (isEndPending)
+        {
+            isEndPending = false;
+            finish(onFrame);
+        }
+        else if (isOpen && frame.isWhole)
+            finish(onFrame);
+    }
+};
+
+/**
+ * @brief The measurements of the sessions played by a thread
+ *
+ */
+struct LoadResults
+{
+    vector<double> roundTripMilliseconds;
+    vector<double> jitterMilliseconds;
+
+    /**
+     * @brief The 99th percentile jitter of each session's steps, to show whether some sessions fall behind
+     *
+     */
+    vector<double> sessionJitterMilliseconds;
+
+    uint64_t games{0};
+    uint64_t steps{0};
+    uint64_t keys{0};
+    uint64_t failedConnections{0};
+    uint64_t disconnections{0};
+
+    /**
+     * @brief The games the host stopped stepping before they were over
+     *
+     */
+    uint64_t stalls{0};
+};
+
+/**
+ * @brief A simulated player's connection
+ *
+ */
+struct LoadSession
+{
+    int descriptor{-1};
+    FrameReader reader;
+    bool isPlaying{false};
+    bool hasStep{false};
+    Clock::time_point lastStepTime;
+    Clock::time_point nextKeyTime;
+    Clock::time_point reconnectTime;
+    size_t scriptPosition{0};
+
+    /**
+     * @brief A key not yet answered by a frame that changes nothing
+     *
+     */
+    struct PendingKey
+    {
+        Clock::time_point sentTime;
+
+        /**
+         * @brief When the first step after the key was read, the step answers the key if the host ran both at once
+         *
+         */
+        Clock::time_point stepTime{Clock::time_point::max()};
+    };
+    vector<PendingKey> pendingKeys;
+    vector<double> jitterMilliseconds;
+};
+
+/**
+ * @brief Get the percentile of sorted samples
+ *
+ */
+static double getPercentile(const vector<double> &sorted, double percentile)
+{
+    if (sorted.empty())
+        return 0;
+    const auto rank{static_cast<size_t>(ceil(percentile / 100.0 * static_cast<double>(sorted.size())))};
+    return sorted[min(max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+/**
+ * @brief Connects to the host
+ *
+ * @return int The non blocking socket, -1 if the host can't be reached
+ */
+static int connectToHost(const string &socketPath)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+        throw invalid_argument("the socket path is too long: " + socketPath);
+    socketPath.copy(address.sun_path, socketPath.size());
+
+    const int descriptor{socket(AF_UNIX, SOCK_STREAM, 0)};
+    if (descriptor < 0)
+        return -1;
+    if (connect(descriptor, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        close(descriptor);
+        return -1;
+    }
+    fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL) | O_NONBLOCK);
+    return descriptor;
+}
+
+/**
+ * @brief Sends the bytes a player types
+ *
+ * @return true if the host took them all
+ */
+static bool sendKeys(int descriptor, string_view keys)
+{
+    while (!keys.empty())
+    {
+        const ssize_t written{write(descriptor, keys.data(), keys.size())};
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        keys.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+/**
+ * @brief Plays the sessions until the end of the test, reconnecting each session once its game is over
+ *
+ * @note The session picks its settings from the main menu as soon as it connects. A frame that changes lines while
+ * playing is a game step, and its interval from the last step is compared with the game speed. A frame that changes
+ * nothing answers the keys sent before it, since the host sends a frame after every input.
+ */
+static LoadResults playSessions(const LoadOptions &options, size_t firstSession, size_t sessionCount, Clock::time_point endTime)
+{
+    const auto stepInterval{chrono::duration<double, milli>(1.0 / (5.0 * options.speed) * 1000.0)};
+    const auto keyInterval{chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / options.keyRate))};
+    const auto reconnectDelay{chrono::milliseconds(100)};
+    const string startKeys{"\r" + to_string(options.width) + '\r' + to_string(options.height) + "\r1\r" + to_string(options.speed) + "\rd"};
+    constexpr string_view DIRECTION_KEYS{"wasd"};
+
+    Pcg32 random(options.seed, firstSession);
+    LoadResults results;
+    vector<LoadSession> sessions(sessionCount);
+    vector<pollfd> descriptors(sessionCount);
+
+    const auto connectSession = [&](LoadSession &session, Clock::time_point now)
+    {
+        session = LoadSession{};
+        session.descriptor = connectToHost(options.socketPath);
+        if (session.descriptor < 0 || !sendKeys(session.descriptor, startKeys))
+        {
+            if (session.descriptor >= 0)
+                close(session.descriptor);
+            session.descriptor = -1;
+            session.reconnectTime = now + reconnectDelay;
+            ++results.failedConnections;
+            return;
+        }
+        session.isPlaying = true;
+        session.nextKeyTime = now + chrono::duration_cast<Clock::duration>(keyInterval * random.between(0, 999) / 1000);
+    };
+    const auto closeSession = [&](LoadSession &session, Clock::time_point now)
+    {
+        if (!session.jitterMilliseconds.empty())
+        {
+            sort(session.jitterMilliseconds.begin(), session.jitterMilliseconds.end());
+            results.sessionJitterMilliseconds.push_back(getPercentile(session.jitterMilliseconds, 99));
+        }
+        close(session.descriptor);
+        session.descriptor = -1;
+        session.isPlaying = false;
+        session.reconnectTime = now;
+    };
+
+    for (auto &session : sessions)
+        connectSession(session, Clock::now());
+    while (Clock::now() < endTime)
+    {
+        // Sleep until a socket is readable or the next key is due
+        Clock::time_point wakeTime{min(endTime, Clock::now() + chrono::milliseconds(100))};
+        for (size_t index{0}; index < sessionCount; ++index)
+        {
+            const LoadSession &session{sessions[index]};
+            descriptors[index] = {session.descriptor, POLLIN, 0};
+            wakeTime = min(wakeTime, session.descriptor < 0 ? session.reconnectTime : session.nextKeyTime);
+        }
+        const auto timeout{chrono::duration_cast<chrono::milliseconds>(wakeTime - Clock::now()).count()};
+        if (poll(descriptors.data(), descriptors.size(), static_cast<int>(max<int64_t>(timeout, 0))) < 0 && errno != EINTR)
+            throw runtime_error(string{"poll failed: "} + strerror(errno));
+
+        for (size_t index{0}; index < sessionCount; ++index)
+        {
+            LoadSession &session{sessions[index]};
+            Clock::time_point now{Clock::now()};
+            if (session.descriptor < 0)
+            {
+                if (now >= session.reconnectTime)
+                    connectSession(session, now);
+                continue;
+            }
+
+            // Read the frames, timing them by when they were read
+            bool isOver{false};
+            if (descriptors[index].revents != 0)
+            {
+                char buffer[64 * 1024];
+                while (true)
+                {
+                    const ssize_t received{read(session.descriptor, buffer, sizeof(buffer))};
+                    if (received < 0 && errno == EINTR)
+                        continue;
+                    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                        break;
+                    if (received <= 0)
+                    {
+                        ++results.disconnections;
+                        isOver = true;
+                        break;
+                    }
+                    now = Clock::now();
+                    session.reader.read(string_view{buffer, static_cast<size_t>(received)}, [&](const FrameReader::Frame &frame)
+                                        {
+                                            if (!session.isPlaying)
+                                                return;
+                                            if (frame.isWhole)
+                                            {
+                                                session.hasStep = false;
+                                                return;
+                                            }
+                                            if (frame.changedLines == 0)
+                                            {
+                                                // Keys left before the last one were answered by the step after them
+                                                for (size_t key{0}; key < session.pendingKeys.size(); ++key)
+                                                {
+                                                    const auto &pending{session.pendingKeys[key]};
+                                                    const auto answerTime{key + 1 < session.pendingKeys.size() ? min(pending.stepTime, now) : now};
+                                                    results.roundTripMilliseconds.push_back(chrono::duration<double, milli>(answerTime - pending.sentTime).count());
+                                                }
+                                                session.pendingKeys.clear();
+                                                return;
+                                            }
+                                            for (auto &pending : session.pendingKeys)
+                                                pending.stepTime = min(pending.stepTime, now);
+                                            if (session.hasStep)
+                                            {
+                                                const double jitter{abs(chrono::duration<double, milli>(now - session.lastStepTime - stepInterval).count())};
+                                                results.jitterMilliseconds.push_back(jitter);
+                                                session.jitterMilliseconds.push_back(jitter);
+                                                ++results.steps;
+                                            }
+                                            session.hasStep = true;
+                                            session.lastStepTime = now;
+                                            if (frame.text.find("GAMEOVER") != string::npos)
+                                            {
+                                                session.isPlaying = false;
+                                                ++results.games;
+                                            } });
+                }
+            }
+
+            // A host that stops stepping without a game over has lost the session
+            if (session.isPlaying && session.hasStep && now - session.lastStepTime > stepInterval * 5 + chrono::seconds(1))
+            {
+                ++results.stalls;
+                isOver = true;
+            }
+
+            // Press the next key, a new game starts on a new connection
+            if (!isOver && !session.isPlaying)
+            {
+                sendKeys(session.descriptor, "\x03");
+                isOver = true;
+            }
+            if (isOver)
+            {
+                closeSession(session, now);
+                continue;
+            }
+            if (session.hasStep && now >= session.nextKeyTime)
+            {
+                const char key{options.script.empty() ? DIRECTION_KEYS[random.bounded(4)] : options.script[session.scriptPosition++ % options.script.size()]};
+                if (sendKeys(session.descriptor, string_view{&key, 1}))
+                {
+                    session.pendingKeys.push_back({now});
+                    ++results.keys;
+                }
+                session.nextKeyTime = max(session.nextKeyTime + keyInterval, now);
+            }
+        }
+    }
+    for (auto &session : sessions)
+        if (session.descriptor >= 0)
+            closeSession(session, endTime);
+    return results;
+}
+
+/**
+ * @brief Get the CPU time the process has used, or a negative time if it can't be read
+ *
+ * @note Only available on Linux, where it is read from /proc
+ */
+static double getProcessCpuSeconds(pid_t pid)
+{
+#if defined(__linux__)
+    ifstream file("/proc/" + to_string(pid) + "/stat");
+    string stat;
+    if (!getline(file, stat))
+        return -1;
+
+    // The name in parentheses may hold spaces, the user and system times are the 12th and 13th fields after it
+    const size_t nameEnd{stat.rfind(')')};
+    if (nameEnd == string::npos)
+        return -1;
+    size_t position{nameEnd + 1};
+    long long userTicks{0};
+    long long systemTicks{0};
+    for (int field{0}; field < 13; ++field)
+    {
+        position = stat.find(' ', position);
+        if (position == string::npos)
+            return -1;
+        ++position;
+        if (field == 11)
+            userTicks = stoll(stat.substr(position));
+        else if (field == 12)
+            systemTicks = stoll(stat.substr(position));
+    }
+    return static_cast<double>(userTicks + systemTicks) / static_cast<double>(sysconf(_SC_CLK_TCK));
+#else
+    return -1;
+#endif
+}
+
+/**
+ * @brief Starts the host and waits until it takes connections
+ *
+ * @return pid_t The host's process
+ */
+static pid_t startServer(const LoadOptions &options)
+{
+    const pid_t pid{fork()};
+    if (pid < 0)
+        throw runtime_error(string{"unable to start the host: "} + strerror(errno));
+    if (pid == 0)
+    {
+        execl(options.serverPath.c_str(), options.serverPath.c_str(), "--host", options.socketPath.c_str(), static_cast<char *>(nullptr));
+        _exit(127);
+    }
+
+    for (int attempt{0}; attempt < 100; ++attempt)
+    {
+        if (const int descriptor{connectToHost(options.socketPath)}; descriptor >= 0)
+        {
+            // The probe's session closes once it types ctrl+c
+            sendKeys(descriptor, "\x03");
+            close(descriptor);
+            return pid;
+        }
+        if (waitpid(pid, nullptr, WNOHANG) == pid)
+            throw runtime_error("the host exited before taking connections: " + options.serverPath);
+        this_thread::sleep_for(chrono::milliseconds(100));
+    }
+    kill(pid, SIGTERM);
+    waitpid(pid, nullptr, 0);
+    throw runtime_error("the host didn't take connections on " + options.socketPath);
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        if (argc < 2 || string{argv[1]}.starts_with("--"))
+        {
+            printUsage();
+            return 1;
+        }
+
+        LoadOptions options;
+        options.socketPath = argv[1];
+        for (int index{2}; index < argc; ++index)
+        {
+            const string option{argv[index]};
+            const bool hasValue{index + 1 < argc};
+            if (option == "--sessions" && hasValue)
+                options.sessionCount = stoul(argv[++index]);
+            else if (option == "--threads" && hasValue)
+                options.threadCount = static_cast<unsigned>(stoul(argv[++index]));
+            else if (option == "--duration" && hasValue)
+                options.durationSeconds = stod(argv[++index]);
+            else if (option == "--key-rate" && hasValue)
+                options.keyRate = stod(argv[++index]);
+            else if (option == "--script" && hasValue)
+                options.script = argv[++index];
+            else if (option == "--width" && hasValue)
+                options.width = stoi(argv[++index]);
+            else if (option == "--height" && hasValue)
+                options.height = stoi(argv[++index]);
+            else if (option == "--speed" && hasValue)
+                options.speed = stoi(argv[++index]);
+            else if (option == "--server" && hasValue)
+                options.serverPath = argv[++index];
+            else if (option == "--server-pid" && hasValue)
+                options.serverPid = static_cast<pid_t>(stol(argv[++index]));
+            else if (option == "--report" && hasValue)
+                options.reportPath = argv[++index];
+            else if (option == "--seed" && hasValue)
+                options.seed = stoull(argv[++index]);
+            else
+            {
+                printUsage();
+                return 1;
+            }
+        }
+
+        // The settings must be ones the session's prompts accept
+        if (options.width < 30 || options.width > 200 || options.height < 20 || options.height > 200)
+            throw invalid_argument("the board must be 30 to 200 wide and 20 to 200 high");
+        if (options.speed < 1 || options.speed > 3)
+            throw invalid_argument("the speed must be 1, 2 or 3");
+        if (options.keyRate <= 0 || options.sessionCount == 0 || options.durationSeconds <= 0)
+            throw invalid_argument("the key rate, sessions and duration must be positive");
+        if (options.script.find_first_not_of("wasd") != string::npos)
+            throw invalid_argument("the script may only hold the keys w, a, s and d");
+        if (options.threadCount == 0)
+            options.threadCount = max(thread::hardware_concurrency(), 1u);
+        options.threadCount = static_cast<unsigned>(min<size_t>(options.threadCount, options.sessionCount));
+
+        // A session closed by the host mustn't end the test
+        signal(SIGPIPE, SIG_IGN);
+        if (!options.serverPath.empty())
+            options.serverPid = startServer(options);
+
+        // Each thread plays its share of the sessions while the host's CPU use is sampled every second
+        vector<LoadResults> threadResults(options.threadCount);
+        vector<double> cpuPercents;
+        const auto start{Clock::now()};
+        const auto endTime{start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(options.durationSeconds))};
+        {
+            vector<jthread> threads;
+            for (unsigned index{0}; index < options.threadCount; ++index)
+            {
+                const size_t first{options.sessionCount * index / options.threadCount};
+                const size_t last{options.sessionCount * (index + 1) / options.threadCount};
+                threads.emplace_back([&, index, first, last]
+                                     { threadResults[index] = playSessions(options, first, last - first, endTime); });
+            }
+            double lastCpuSeconds{options.serverPid > 0 ? getProcessCpuSeconds(options.serverPid) : -1};
+            auto lastSampleTime{Clock::now()};
+            while (lastCpuSeconds >= 0 && lastSampleTime + chrono::seconds(1) <= endTime)
+            {
+                this_thread::sleep_until(lastSampleTime + chrono::seconds(1));
+                const double cpuSeconds{getProcessCpuSeconds(options.serverPid)};
+                const auto now{Clock::now()};
+                if (cpuSeconds >= 0)
+                    cpuPercents.push_back((cpuSeconds - lastCpuSeconds) / chrono::duration<double>(now - lastSampleTime).count() * 100.0);
+                lastCpuSeconds = cpuSeconds;
+                lastSampleTime = now;
+            }
+        }
+        const double seconds{chrono::duration<double>(Clock::now() - start).count()};
+
+        if (!options.serverPath.empty())
+        {
+            kill(options.serverPid, SIGTERM);
+            waitpid(options.serverPid, nullptr, 0);
+        }
+
+        // Merge the threads' samples
+        LoadResults results;
+        for (auto &threadResult : threadResults)
+        {
+            results.roundTripMilliseconds.insert(results.roundTripMilliseconds.end(), threadResult.roundTripMilliseconds.begin(), threadResult.roundTripMilliseconds.end());
+            results.jitterMilliseconds.insert(results.jitterMilliseconds.end(), threadResult.jitterMilliseconds.begin(), threadResult.jitterMilliseconds.end());
+            results.sessionJitterMilliseconds.insert(results.sessionJitterMilliseconds.end(), threadResult.sessionJitterMilliseconds.begin(), threadResult.sessionJitterMilliseconds.end());
+            results.games += threadResult.games;
+            results.steps += threadResult.steps;
+            results.keys += threadResult.keys;
+            results.failedConnections += threadResult.failedConnections;
+            results.disconnections += threadResult.disconnections;
+            results.stalls += threadResult.stalls;
+        }
+
+        cout << "Played " << options.sessionCount << " sessions on " << options.threadCount << " threads for " << seconds << "s: " << results.games << " games, "
+             << results.steps << " steps, " << results.keys << " keys, " << results.failedConnections << " failed connections, "
+             << results.disconnections << " disconnections, " << results.stalls << " stalled games\n";
+
+        // One line of percentiles per measurement, in the console and the report
+        const pair<const char *, vector<double> *> metrics[]{{"input_round_trip_ms", &results.roundTripMilliseconds},
+                                                             {"step_jitter_ms", &results.jitterMilliseconds},
+                                                             {"session_p99_step_jitter_ms", &results.sessionJitterMilliseconds},
+                                                             {"server_cpu_percent", &cpuPercents}};
+        ofstream report;
+        if (!options.reportPath.empty())
+        {
+            report.open(options.reportPath, ofstream::trunc);
+            if (report.fail())
+                throw invalid_argument("Failed to create report file at: " + options.reportPath);
+            report << "metric,samples,p50,p90,p99,p99.9,max\n";
+        }
+        for (const auto &[name, samples] : metrics)
+        {
+            sort(samples->begin(), samples->end());
+            const double percentiles[]{getPercentile(*samples, 50), getPercentile(*samples, 90), getPercentile(*samples, 99), getPercentile(*samples, 99.9),
+                                       samples->empty() ? 0.0 : samples->back()};
+            cout << "  " << name << " samples=" << samples->size() << " p50=" << percentiles[0] << " p90=" << percentiles[1] << " p99=" << percentiles[2]
+                 << " p99.9=" << percentiles[3] << " max=" << percentiles[4] << '\n';
+            if (report.is_open())
+                report << name << ',' << samples->size() << ',' << percentiles[0] << ',' << percentiles[1] << ',' << percentiles[2] << ','
+                       << percentiles[3] << ',' << percentiles[4] << '\n';
+        }
+        if (options.serverPid <= 0)
+            cout << "  server CPU not measured, pass --server or --server-pid\n";
+        return 0;
+    }
+    catch (const exception &exception)
+    {
+        cerr << exception.what() << '\n';
+        return -1;
+    }
+}
@@ -0,0 +1,108 @@
+#include "map_pack.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Prints how to use the tool
+ *
+ */
+static void printUsage()
+{
+    cerr << "Usage: SnakeMaps pack <output file> <map file>...\n"
+            "       SnakeMaps list <map pack>\n"
+            "       SnakeMaps show <map pack> <index>\n";
+}
+
+/**
+ * @brief Packs the text maps into a map pack, each named after its file
+ *
+ */
+static int pack(int argc, char *argv[])
+{
+    if (argc < 4)
+    {
+        printUsage();
+        return 1;
+    }
+
+    vector<MapDefinition> maps;
+    for (int index{3}; index < argc; ++index)
+    {
+        ifstream file(argv[index], ios::binary);
+        if (!file)
+            throw invalid_argument("Failed to open map at: " + string{argv[index]});
+        stringstream text;
+        text << file.rdbuf();
+        maps.push_back(MapPack::parseMap(text.str(), filesystem::path(argv[index]).stem().string()));
+    }
+
+    MapPack::write(argv[2], maps);
+    cout << "Packed " << maps.size() << " maps into " << argv[2] << '\n';
+    return 0;
+}
+
+/**
+ * @brief Prints the index, name, size and topology of every map in the pack
+ *
+ */
+static int list(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+
+    const MapPack mapPack(argv[2]);
+    for (size_t index{0}; index < mapPack.getMapCount(); ++index)
+    {
+        const MapInfo info{mapPack.getMapInfo(index)};
+        cout << index << '\t' << info.name << '\t' << info.width << 'x' << info.height << '\t'
+             << (info.topology == BoardTopology::WRAPPED ? "wrapped" : "walled") << '\n';
+    }
+    return 0;
+}
+
+/**
+ * @brief Prints the board of a map
+ *
+ */
+static int show(int argc, char *argv[])
+{
+    if (argc < 4)
+    {
+        printUsage();
+        return 1;
+    }
+
+    const MapPack mapPack(argv[2]);
+    cout << mapPack.createBoard(stoul(argv[3]))->toString();
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        if (argc >= 2 && string{argv[1]} == "pack")
+            return pack(argc, argv);
+        if (argc >= 2 && string{argv[1]} == "list")
+            return list(argc, argv);
+        if (argc >= 2 && string{argv[1]} == "show")
+            return show(argc, argv);
+        printUsage();
+        return 1;
+    }
+    catch (const exception &exception)
+    {
+        cerr << exception.what() << '\n';
+        return -1;
+    }
+}
@@ -0,0 +1,181 @@
+#include "replay_archive.hpp"
+#include "score_journal.hpp"
+#include "score_record.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief What playing a replay again found
+ *
+ */
+struct ReplayCheck
+{
+    ReplayVerdict verdict;
+    int recordedScore{0};
+    int width{0};
+    int height{0};
+    double gameSpeed{0};
+    string problem;
+};
+
+/**
+ * @brief Prints how to use the tool
+ *
+ */
+static void printUsage()
+{
+    cerr << "Usage: SnakeReplayVerify <replays.dat> [--scores <scores.dat>] [--threads <count>]\n"
+            "Plays every replay again and reports the ones whose recorded score the game rules don't reach, and the\n"
+            "saved scores that don't match their replay\n";
+}
+
+/**
+ * @brief Plays the replays handed out by the counter again, filling in their checks
+ *
+ * @return uint64_t The number of moves played
+ */
+static uint64_t verifyReplays(const ReplayArchive &archive, atomic<size_t> &nextReplay, vector<ReplayCheck> &checks)
+{
+    // The replay's storage is reused, so playing a replay doesn't allocate for its moves
+    Replay replay;
+    uint64_t moves{0};
+    for (size_t index{nextReplay.fetch_add(1, memory_order_relaxed)}; index < checks.size(); index = nextReplay.fetch_add(1, memory_order_relaxed))
+    {
+        ReplayCheck &check{checks[index]};
+        try
+        {
+            archive.getReplay(index, replay);
+            check.recordedScore = replay.score;
+            check.width = replay.width;
+            check.height = replay.height;
+            check.gameSpeed = replay.gameSpeed;
+            check.verdict = simulateReplay(replay);
+            moves += replay.moveCount;
+        }
+        catch (const exception &exception)
+        {
+            check.problem = exception.what();
+            continue;
+        }
+
+        if (check.verdict.hasMovesAfterCrash)
+            check.problem = "has moves after the snake crashed";
+        else if (!check.verdict.isGameOver)
+            check.problem = "ends before the snake crashed";
+        else if (check.verdict.score != check.recordedScore)
+            check.problem = "recorded score " + to_string(check.recordedScore) + " but the moves score " + to_string(check.verdict.score);
+    }
+    return moves;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        if (argc < 2 || string{argv[1]}.starts_with("--"))
+        {
+            printUsage();
+            return 1;
+        }
+
+        string scoresPath;
+        unsigned threadCount{0};
+        for (int index{2}; index < argc; ++index)
+        {
+            const string option{argv[index]};
+            const bool hasValue{index + 1 < argc};
+            if (option == "--scores" && hasValue)
+                scoresPath = argv[++index];
+            else if (option == "--threads" && hasValue)
+                threadCount = static_cast<unsigned>(stoul(argv[++index]));
+            else
+            {
+                printUsage();
+                return 1;
+            }
+        }
+        if (threadCount == 0)
+            threadCount = max(thread::hardware_concurrency(), 1u);
+
+        const ReplayArchive archive(argv[1]);
+        if (!archive.isIndexed())
+            cerr << "The archive has no index, its writer crashed, scanned " << archive.getReplayCount() << " replays\n";
+
+        // Each replay is played on whichever thread takes it next, games differ a lot in length
+        vector<ReplayCheck> checks(archive.getReplayCount());
+        vector<uint64_t> moves(threadCount, 0);
+        atomic<size_t> nextReplay{0};
+        const auto start{chrono::steady_clock::now()};
+        {
+            vector<jthread> threads;
+            for (unsigned index{0}; index < threadCount; ++index)
+                threads.emplace_back([&, index]
+                                     { moves[index] = verifyReplays(archive, nextReplay, checks); });
+        }
+        const double seconds{chrono::duration<double>(chrono::steady_clock::now() - start).count()};
+
+        size_t tamperedCount{0};
+        for (size_t index{0}; index < checks.size(); ++index)
+            if (!checks[index].problem.empty())
+            {
+                cout << "Replay " << index << ' ' << checks[index].problem << '\n';
+                ++tamperedCount;
+            }
+
+        uint64_t totalMoves{0};
+        for (const auto count : moves)
+            totalMoves += count;
+        const double gamesPerHour{seconds > 0 ? static_cast<double>(checks.size()) / seconds * 3600.0 : 0.0};
+        cout << "Verified " << checks.size() << " replays on " << threadCount << " threads in " << seconds << "s ("
+             << gamesPerHour / 1e6 << "M games/h, " << static_cast<double>(totalMoves) / max(seconds, 1e-9) / 1e6 << "M moves/s), "
+             << tamperedCount << " tampered\n";
+
+        // Saved scores must match the game their replay plays
+        if (!scoresPath.empty())
+        {
+            size_t linkedCount{0};
+            size_t mismatchCount{0};
+            ScoreJournal::read(scoresPath, [&](const ScoreRecord &record)
+                               {
+                                   if (record.replayId < 0)
+                                       return true;
+                                   ++linkedCount;
+                                   string problem;
+                                   if (static_cast<uint64_t>(record.replayId) >= checks.size())
+                                       problem = "links to a missing replay";
+                                   else
+                                   {
+                                       const ReplayCheck &check{checks[static_cast<size_t>(record.replayId)]};
+                                       if (!check.problem.empty())
+                                           problem = "links to a tampered replay";
+                                       else if (record.width != check.width || record.height != check.height || record.gameSpeed != check.gameSpeed)
+                                           problem = "doesn't have its replay's settings";
+                                       else if (record.score != check.verdict.score || static_cast<size_t>(record.snakeLength) != check.verdict.snakeLength)
+                                           problem = "saved score " + to_string(record.score) + " but its replay scores " + to_string(check.verdict.score);
+                                   }
+                                   if (!problem.empty())
+                                   {
+                                       cout << "Score of " << record.playerName << " (replay " << record.replayId << ") " << problem << '\n';
+                                       ++mismatchCount;
+                                   }
+                                   return true; });
+            cout << "Checked " << linkedCount << " scores linked to replays, " << mismatchCount << " don't match\n";
+            tamperedCount += mismatchCount;
+        }
+        return tamperedCount == 0 ? 0 : 2;
+    }
+    catch (const exception &exception)
+    {
+        cerr << exception.what() << '\n';
+        return -1;
+    }
+}
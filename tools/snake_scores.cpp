@@ -0,0 +1,214 @@
+#include "score_analytics.hpp"
+#include "score_record.hpp"
+#include "score_merge.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Prints how to use the tool
+ *
+ */
+static void printUsage()
+{
+    cerr << "Usage: SnakeScores analyze <scores file> [--top <count>] [--percentiles <p,p,...>] [--bin-seconds <seconds>]\n"
+            "                                       [--threads <count>] [--players <count>] [--no-checksums]\n"
+            "       SnakeScores merge <output file> <scores file>... [--format text|csv|binary] [--memory <megabytes>]\n"
+            "                                       [--spill-directory <folder>] [--keep-duplicates]\n";
+}
+
+/**
+ * @brief Formats the bucket as width x height, speed and starting length
+ *
+ */
+static string formatBucket(const ScoreBucket &bucket)
+{
+    ostringstream stream;
+    stream << bucket.width << 'x' << bucket.height << " speed " << bucket.gameSpeed << " length " << bucket.snakeLength;
+    return stream.str();
+}
+
+/**
+ * @brief Parses the comma separated percentiles
+ *
+ */
+static vector<double> parsePercentiles(const string &text)
+{
+    vector<double> percentiles;
+    size_t start{0};
+    while (start <= text.size())
+    {
+        const size_t end{min(text.find(',', start), text.size())};
+        percentiles.push_back(stod(text.substr(start, end - start)));
+        start = end + 1;
+    }
+    return percentiles;
+}
+
+/**
+ * @brief Answers the leaderboard queries for a score file and prints the report
+ *
+ */
+static int analyze(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+
+    ScoreQuery query;
+    size_t playerCount{20};
+    for (int index{3}; index < argc; ++index)
+    {
+        const string option{argv[index]};
+        const bool hasValue{index + 1 < argc};
+        if (option == "--top" && hasValue)
+            query.topCount = stoi(argv[++index]);
+        else if (option == "--percentiles" && hasValue)
+            query.percentiles = parsePercentiles(argv[++index]);
+        else if (option == "--bin-seconds" && hasValue)
+            query.binSeconds = stoll(argv[++index]);
+        else if (option == "--threads" && hasValue)
+            query.threadCount = stoi(argv[++index]);
+        else if (option == "--players" && hasValue)
+            playerCount = stoul(argv[++index]);
+        else if (option == "--no-checksums")
+            query.verifyChecksums = false;
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    const auto start{chrono::steady_clock::now()};
+    const ScoreReport report{ScoreAnalytics::analyze(string{argv[2]}, query)};
+    const double seconds{chrono::duration<double>(chrono::steady_clock::now() - start).count()};
+
+    const size_t rows{report.lines.framed + report.lines.legacy};
+    cout << "Read " << rows << " scores in " << seconds << "s (" << report.lines.framed << " framed, " << report.lines.legacy << " legacy, "
+         << report.lines.malformed << " malformed lines skipped)\n";
+
+    cout << "\nPlayer bests\n";
+    for (size_t index{0}; index < report.playerBests.size() && index < playerCount; ++index)
+    {
+        const auto &entry{report.playerBests[index]};
+        cout << "  " << setw(3) << index + 1 << ' ' << entry.playerName << ' ' << entry.score << " (" << formatBucket(entry.bucket) << ")\n";
+    }
+
+    cout << "\nBuckets\n";
+    for (const auto &bucket : report.buckets)
+    {
+        cout << "  " << formatBucket(bucket.bucket) << ": " << bucket.count << " scores, mean " << bucket.meanScore;
+        for (size_t index{0}; index < bucket.percentiles.size(); ++index)
+            cout << ", p" << query.percentiles[index] << ' ' << bucket.percentiles[index];
+        cout << '\n';
+        for (const auto &entry : bucket.topScores)
+            cout << "    " << entry.playerName << ' ' << entry.score << '\n';
+    }
+
+    cout << "\nScores over time\n";
+    for (const auto &bin : report.timeBins)
+        cout << "  " << bin.start << ' ' << bin.count << " scores, best " << bin.bestScore << '\n';
+    return 0;
+}
+
+/**
+ * @brief Merges score files into one sorted file and reports the lines that were skipped
+ *
+ */
+static int merge(int argc, char *argv[])
+{
+    if (argc < 4)
+    {
+        printUsage();
+        return 1;
+    }
+
+    ScoreMergeOptions options;
+    vector<string> inputs;
+    for (int index{3}; index < argc; ++index)
+    {
+        const string option{argv[index]};
+        const bool hasValue{index + 1 < argc};
+        if (option == "--format" && hasValue)
+        {
+            const string format{argv[++index]};
+            if (format == "text")
+                options.format = ScoreFormat::TEXT;
+            else if (format == "csv")
+                options.format = ScoreFormat::CSV;
+            else if (format == "binary")
+                options.format = ScoreFormat::BINARY;
+            else
+                throw invalid_argument("Unknown format " + format);
+        }
+        else if (option == "--memory" && hasValue)
+            options.memoryLimit = stoull(argv[++index]) * 1024 * 1024;
+        else if (option == "--spill-directory" && hasValue)
+            options.spillDirectory = argv[++index];
+        else if (option == "--keep-duplicates")
+            options.removeDuplicates = false;
+        else if (option.rfind("--", 0) == 0)
+        {
+            printUsage();
+            return 1;
+        }
+        else
+            inputs.push_back(option);
+    }
+    if (inputs.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    const auto start{chrono::steady_clock::now()};
+    const ScoreMergeStats stats{ScoreMerger::merge(inputs, argv[2], options)};
+    const double seconds{chrono::duration<double>(chrono::steady_clock::now() - start).count()};
+
+    size_t malformed{0};
+    for (const auto &input : stats.inputs)
+    {
+        cout << input.path << ": ";
+        if (input.binaryRecords > 0)
+            cout << input.binaryRecords << " binary records\n";
+        else
+            cout << input.lines.framed << " framed, " << input.lines.legacy << " legacy, " << input.lines.malformed << " malformed lines skipped\n";
+        malformed += input.lines.malformed;
+    }
+    cout << "Wrote " << stats.written << " scores to " << argv[2] << " in " << seconds << "s, removed " << stats.duplicates << " duplicates, skipped "
+         << malformed << " malformed lines, spilled " << stats.spillRuns << " runs\n";
+    return 0;
+}
+
+/**
+ * @brief The main method of the score tool
+ *
+ * @return int The exit status code
+ */
+int main(int argc, char *argv[])
+{
+    try
+    {
+        if (argc >= 2 && string{argv[1]} == "analyze")
+            return analyze(argc, argv);
+        if (argc >= 2 && string{argv[1]} == "merge")
+            return merge(argc, argv);
+        printUsage();
+        return 1;
+    }
+    catch (const exception &exception)
+    {
+        cerr << exception.what() << '\n';
+        return -1;
+    }
+}
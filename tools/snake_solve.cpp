@@ -0,0 +1,188 @@
+#include "small_board_solver.hpp"
+#include "transposition_table.hpp"
+#include "replay_archive.hpp"
+#include "direction.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+/**
+ * @brief The settings of a solve
+ *
+ */
+struct SolveOptions
+{
+    int depth{0};
+    unsigned threadCount{0};
+    int width{6};
+    int height{6};
+    int snakeLength{3};
+    uint32_t seed{1};
+    size_t tableMegabytes{256};
+    ReplacementPolicy policy{ReplacementPolicy::TWO_TIER};
+    double seconds{0};
+    string replayPath;
+    size_t replayIndex{0};
+    size_t moveIndex{0};
+};
+
+/**
+ * @brief Prints how to use the tool
+ *
+ */
+static void printUsage()
+{
+    cerr << "Usage: SnakeSolve <depth> [--width <cells>] [--height <cells>] [--length <segments>] [--seed <seed>]\n"
+            "                          [--threads <count>] [--table-mb <megabytes>] [--policy always|depth|two-tier]\n"
+            "                          [--seconds <limit>] [--replay <replays.dat> [--index <replay>] [--at <move>]]\n"
+            "Finds the most apples the snake can eat in <depth> moves of a game, or of a replay after its first moves,\n"
+            "searching deeper until the depth or the time limit is reached\n";
+}
+
+static const char *getDirectionName(Directions::Direction direction)
+{
+    constexpr const char *NAMES[]{"up", "right", "down", "left"};
+    return NAMES[static_cast<int>(direction)];
+}
+
+static ReplacementPolicy parsePolicy(const string &name)
+{
+    if (name == "always")
+        return ReplacementPolicy::ALWAYS;
+    if (name == "depth")
+        return ReplacementPolicy::DEPTH_PREFERRED;
+    if (name == "two-tier")
+        return ReplacementPolicy::TWO_TIER;
+    throw invalid_argument("unknown replacement policy " + name);
+}
+
+/**
+ * @brief Prints the work done so far
+ *
+ */
+static void printStatistics(const SolverStatistics &statistics, double seconds, double tableFill)
+{
+    cout << statistics.nodes << " nodes (" << static_cast<double>(statistics.nodes) / max(seconds, 1e-9) / 1e6 << "M/s), "
+         << statistics.getHitRate() * 100 << "% hits, " << statistics.getCutoffRate() * 100 << "% cutoffs, "
+         << tableFill * 100 << "% full";
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        if (argc < 2 || string{argv[1]}.starts_with("--"))
+        {
+            printUsage();
+            return 1;
+        }
+
+        SolveOptions options;
+        options.depth = stoi(argv[1]);
+        for (int index{2}; index < argc; ++index)
+        {
+            const string option{argv[index]};
+            const bool hasValue{index + 1 < argc};
+            if (option == "--width" && hasValue)
+                options.width = stoi(argv[++index]);
+            else if (option == "--height" && hasValue)
+                options.height = stoi(argv[++index]);
+            else if (option == "--length" && hasValue)
+                options.snakeLength = stoi(argv[++index]);
+            else if (option == "--seed" && hasValue)
+                options.seed = static_cast<uint32_t>(stoul(argv[++index]));
+            else if (option == "--threads" && hasValue)
+                options.threadCount = static_cast<unsigned>(stoul(argv[++index]));
+            else if (option == "--table-mb" && hasValue)
+                options.tableMegabytes = stoul(argv[++index]);
+            else if (option == "--policy" && hasValue)
+                options.policy = parsePolicy(argv[++index]);
+            else if (option == "--seconds" && hasValue)
+                options.seconds = stod(argv[++index]);
+            else if (option == "--replay" && hasValue)
+                options.replayPath = argv[++index];
+            else if (option == "--index" && hasValue)
+                options.replayIndex = stoul(argv[++index]);
+            else if (option == "--at" && hasValue)
+                options.moveIndex = stoul(argv[++index]);
+            else
+            {
+                printUsage();
+                return 1;
+            }
+        }
+
+        // A replay is solved after its first moves, and the move it played next is checked against the best
+        Replay root;
+        root.seed = options.seed;
+        root.width = options.width;
+        root.height = options.height;
+        root.gameSpeed = 200.0;
+        root.snakeLength = options.snakeLength;
+        optional<Directions::Direction> playedMove;
+        if (!options.replayPath.empty())
+        {
+            const ReplayArchive archive(options.replayPath);
+            archive.getReplay(options.replayIndex, root);
+            if (options.moveIndex >= root.moveCount)
+                throw invalid_argument("the replay has " + to_string(root.moveCount) + " moves");
+            playedMove = root.getMove(options.moveIndex);
+            root.truncateMoves(options.moveIndex);
+        }
+
+        SmallBoardSolver solver(root, options.tableMegabytes << 20, options.policy);
+        cout << "Solving " << root.width << 'x' << root.height << " seed " << root.seed << " after " << root.moveCount << " moves, "
+             << (solver.getTable().getMemoryUsage() >> 20) << "MB table\n";
+        const auto result{solver.solve(options.depth, options.threadCount, [&options](const SolverProgress &progress)
+                                       {
+                                           if (progress.isDepthComplete)
+                                               cout << "Depth " << progress.depth << ": " << progress.apples << " apples";
+                                           else
+                                               cout << "  depth " << progress.depth << ": " << progress.finishedTasks << '/' << progress.taskCount << " sequences";
+                                           cout << ", ";
+                                           printStatistics(progress.statistics, progress.seconds, progress.tableFill);
+                                           cout << endl;
+                                           return options.seconds <= 0 || progress.seconds < options.seconds; })};
+
+        if (result.depth == 0)
+        {
+            cout << "Stopped before searching a depth\n";
+            return 0;
+        }
+        if (!result.bestMove)
+        {
+            cout << "The game is over\n";
+            return 0;
+        }
+        cout << "In " << result.depth << " moves the snake eats at most " << result.apples << " apples, moving " << getDirectionName(*result.bestMove) << '\n';
+        for (int direction{0}; direction < static_cast<int>(result.moveApples.size()); ++direction)
+            if (result.moveApples[direction] >= 0)
+                cout << "  " << getDirectionName(static_cast<Directions::Direction>(direction)) << ": " << result.moveApples[direction] << " apples\n";
+        if (playedMove)
+        {
+            // A move reversing into the snake keeps it going straight, the opposite way
+            int played{static_cast<int>(*playedMove)};
+            if (result.moveApples[played] < 0)
+                played = (played + 2) & 3;
+            const int apples{result.moveApples[played]};
+            cout << "The replay moved " << getDirectionName(*playedMove) << ", "
+                 << (apples == result.apples ? "an optimal move" : "losing " + to_string(result.apples - apples) + " apples") << '\n';
+        }
+        cout << "Searched in " << result.seconds << "s, ";
+        printStatistics(result.statistics, result.seconds, solver.getTable().getFill());
+        cout << ", " << result.statistics.tableStores << " stores, " << result.statistics.tableReplacements << " replaced, "
+             << result.statistics.tableRejections << " rejected\n";
+        return 0;
+    }
+    catch (const exception &exception)
+    {
+        cerr << exception.what() << '\n';
+        return -1;
+    }
+}